@@ -0,0 +1,840 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bolt/bolt-private.h"
+#include "bolt/buffering.h"
+#include "bolt/communication-capture.h"
+#include "bolt/communication-mock.h"
+#include "bolt/connection-private.h"
+#include "bolt/mem.h"
+#include "bolt/packstream.h"
+#include "bolt/protocol.h"
+#include "bolt/statement-private.h"
+#include "bolt/time.h"
+#include "bolt/v3.h"
+#include "bolt/writer-private.h"
+#include "bolt/address-private.h"
+
+#define DEFAULT_DURATION 200
+#define MAX_CHUNK_SIZE 0xFFFF
+#define BLOCK_SIZE 1024
+#define PARAMETER_ROWS 100
+#define RECEIVE_STREAM_SIZE (512*1024)
+#define RUN_CYPHER "UNWIND $rows AS row MERGE (p:Person {id: row.id}) ON CREATE SET p.name = row.name, " \
+        "p.score = row.score ON MATCH SET p.score = p.score + row.score WITH p MATCH (t:Team {id: p.team}) " \
+        "MERGE (p)-[:MEMBER_OF]->(t) RETURN count(p) AS updated"
+
+struct Fixture {
+    struct BoltValue* value;
+    struct BoltValue* target;
+    struct BoltBuffer* buffer;
+    struct BoltBuffer* stream;
+    struct BoltBuffer* rx_buffer;
+    struct BoltWriter* writer;
+    struct BoltMessage* run;
+    struct BoltStatement* statement;
+    /// Mocked connection replaying receive_stream, created by the receive benchmarks
+    struct BoltConnection* connection;
+    char* receive_stream;
+    int encoded_size;
+    int stream_size;
+    char block[BLOCK_SIZE];
+};
+
+// Returns the number of bytes processed by one operation
+typedef int64_t (*bench_func)(struct Fixture*);
+
+typedef void (*sample_func)(struct BoltValue*);
+
+struct Benchmark {
+    const char* name;
+    sample_func sample;
+    bench_func run;
+};
+
+struct Result {
+    int64_t operations;
+    int64_t nanoseconds;
+    int64_t bytes;
+    int64_t allocations;
+};
+
+int _any_structure(int16_t code)
+{
+    UNUSED(code);
+    return 1;
+}
+
+void sample_string_of(struct BoltValue* value, int32_t size)
+{
+    char* data = malloc((size_t) size);
+    for (int32_t i = 0; i<size; i++) {
+        data[i] = (char) ('A'+i%26);
+    }
+    BoltValue_format_as_String(value, data, size);
+    free(data);
+}
+
+void sample_map_of(struct BoltValue* value, int32_t size)
+{
+    BoltValue_format_as_Dictionary(value, size);
+    for (int32_t i = 0; i<size; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%d", i);
+        BoltDictionary_set_key(value, i, key, strlen(key));
+        BoltValue_format_as_Integer(BoltDictionary_value(value, i), i*1000);
+    }
+}
+
+void sample_null(struct BoltValue* value)
+{
+    BoltValue_format_as_Null(value);
+}
+
+void sample_boolean(struct BoltValue* value)
+{
+    BoltValue_format_as_Boolean(value, 1);
+}
+
+void sample_tiny_integer(struct BoltValue* value)
+{
+    BoltValue_format_as_Integer(value, 42);
+}
+
+void sample_integer(struct BoltValue* value)
+{
+    BoltValue_format_as_Integer(value, INT64_C(0x123456789ABCDEF));
+}
+
+void sample_float(struct BoltValue* value)
+{
+    BoltValue_format_as_Float(value, 3.14159);
+}
+
+void sample_short_string(struct BoltValue* value)
+{
+    sample_string_of(value, 12);
+}
+
+void sample_long_string(struct BoltValue* value)
+{
+    sample_string_of(value, 1024);
+}
+
+void sample_bytes(struct BoltValue* value)
+{
+    char data[1024];
+    for (int i = 0; i<1024; i++) {
+        data[i] = (char) i;
+    }
+    BoltValue_format_as_Bytes(value, data, sizeof(data));
+}
+
+void sample_list(struct BoltValue* value)
+{
+    BoltValue_format_as_List(value, 100);
+    for (int32_t i = 0; i<100; i++) {
+        BoltValue_format_as_Integer(BoltList_value(value, i), i*1000);
+    }
+}
+
+void sample_large_list(struct BoltValue* value)
+{
+    BoltValue_format_as_List(value, 100000);
+    for (int32_t i = 0; i<100000; i++) {
+        BoltValue_format_as_Integer(BoltList_value(value, i), i*1000);
+    }
+}
+
+void sample_map(struct BoltValue* value)
+{
+    sample_map_of(value, 16);
+}
+
+void sample_nested(struct BoltValue* value)
+{
+    BoltValue_format_as_Dictionary(value, 8);
+    for (int32_t i = 0; i<8; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "list%d", i);
+        BoltDictionary_set_key(value, i, key, strlen(key));
+        struct BoltValue* list = BoltDictionary_value(value, i);
+        BoltValue_format_as_List(list, 8);
+        for (int32_t j = 0; j<8; j++) {
+            sample_map_of(BoltList_value(list, j), 4);
+        }
+    }
+}
+
+void sample_node(struct BoltValue* value)
+{
+    BoltValue_format_as_Structure(value, BOLT_V3_NODE, 3);
+    BoltValue_format_as_Integer(BoltStructure_value(value, 0), 1234);
+    struct BoltValue* labels = BoltStructure_value(value, 1);
+    BoltValue_format_as_List(labels, 2);
+    BoltValue_format_as_String(BoltList_value(labels, 0), "Person", 6);
+    BoltValue_format_as_String(BoltList_value(labels, 1), "Employee", 8);
+    sample_map_of(BoltStructure_value(value, 2), 4);
+}
+
+// A node with many properties, of which typically only a few are read
+void sample_wide_node(struct BoltValue* value)
+{
+    sample_node(value);
+    struct BoltValue* properties = BoltStructure_value(value, 2);
+    BoltValue_format_as_Dictionary(properties, 32);
+    for (int32_t i = 0; i<32; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "property%d", i);
+        BoltDictionary_set_key(properties, i, key, strlen(key));
+        sample_short_string(BoltDictionary_value(properties, i));
+    }
+}
+
+// A series of points, as typically returned by geo queries
+void sample_points(struct BoltValue* value)
+{
+    BoltValue_format_as_List(value, 100);
+    for (int32_t i = 0; i<100; i++) {
+        struct BoltValue* point = BoltList_value(value, i);
+        BoltValue_format_as_Structure(point, BOLT_V3_POINT_2D, 3);
+        BoltValue_format_as_Integer(BoltStructure_value(point, 0), 7203);
+        BoltValue_format_as_Float(BoltStructure_value(point, 1), i*0.25);
+        BoltValue_format_as_Float(BoltStructure_value(point, 2), i*0.5);
+    }
+}
+
+void sample_record(struct BoltValue* value)
+{
+    BoltValue_format_as_Structure(value, BOLT_V3_RECORD, 1);
+    struct BoltValue* fields = BoltStructure_value(value, 0);
+    BoltValue_format_as_List(fields, 4);
+    BoltValue_format_as_Integer(BoltList_value(fields, 0), 1);
+    sample_short_string(BoltList_value(fields, 1));
+    sample_float(BoltList_value(fields, 2));
+    sample_node(BoltList_value(fields, 3));
+}
+
+void sample_large_record(struct BoltValue* value)
+{
+    BoltValue_format_as_Structure(value, BOLT_V3_RECORD, 1);
+    struct BoltValue* fields = BoltStructure_value(value, 0);
+    BoltValue_format_as_List(fields, 1);
+    sample_string_of(BoltList_value(fields, 0), 3*MAX_CHUNK_SIZE);
+}
+
+int64_t bench_load(struct Fixture* fixture)
+{
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = 0;
+    load(&_any_structure, fixture->buffer, fixture->value, NULL);
+    return fixture->buffer->extent;
+}
+
+int64_t bench_unload(struct Fixture* fixture)
+{
+    // Fully unloaded buffers reset themselves, so the encoded value is restored before each run
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = fixture->encoded_size;
+    unload(&_any_structure, fixture->buffer, fixture->target, NULL);
+    return fixture->encoded_size;
+}
+
+// Unloads long lists of scalars as packed lists
+int64_t bench_unload_packed(struct Fixture* fixture)
+{
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = fixture->encoded_size;
+    unload_lazy(&_any_structure, NULL, NULL, 1, fixture->buffer, fixture->target, NULL);
+    return fixture->encoded_size;
+}
+
+// Unloads graph structures lazily and reads the id of the node
+int64_t bench_unload_lazy(struct Fixture* fixture)
+{
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = fixture->encoded_size;
+    unload_lazy(&_any_structure, &BoltProtocolV3_check_lazy_struct_signature, NULL, 0, fixture->buffer,
+            fixture->target, NULL);
+    BoltInteger_get(BoltStructure_value(fixture->target, 0));
+    return fixture->encoded_size;
+}
+
+// Reads the coordinates of the points of a list, unloaded as ordinary structures
+int64_t bench_unload_points(struct Fixture* fixture)
+{
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = fixture->encoded_size;
+    unload(&_any_structure, fixture->buffer, fixture->target, NULL);
+    double sum = 0.0;
+    for (int32_t i = 0; i<BoltValue_size(fixture->target); i++) {
+        struct BoltValue* point = BoltList_value(fixture->target, i);
+        sum += BoltFloat_get(BoltStructure_value(point, 1))+BoltFloat_get(BoltStructure_value(point, 2));
+    }
+    return sum>=0.0 ? fixture->encoded_size : 0;
+}
+
+// Reads the coordinates of the points of a list, unloaded as packed structures
+int64_t bench_unload_packed_points(struct Fixture* fixture)
+{
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = fixture->encoded_size;
+    unload_lazy(&_any_structure, NULL, &BoltProtocolV3_check_packed_struct_signature, 0, fixture->buffer,
+            fixture->target, NULL);
+    double sum = 0.0;
+    for (int32_t i = 0; i<BoltValue_size(fixture->target); i++) {
+        struct BoltValue* point = BoltList_value(fixture->target, i);
+        sum += BoltStructure_float(point, 1)+BoltStructure_float(point, 2);
+    }
+    return sum>=0.0 ? fixture->encoded_size : 0;
+}
+
+// Reads the coordinates of the points of a list, unloaded as packed structures, as existing callers would
+int64_t bench_unload_packed_points_by_value(struct Fixture* fixture)
+{
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = fixture->encoded_size;
+    unload_lazy(&_any_structure, NULL, &BoltProtocolV3_check_packed_struct_signature, 0, fixture->buffer,
+            fixture->target, NULL);
+    double sum = 0.0;
+    for (int32_t i = 0; i<BoltValue_size(fixture->target); i++) {
+        struct BoltValue* point = BoltList_value(fixture->target, i);
+        sum += BoltFloat_get(BoltStructure_value(point, 1))+BoltFloat_get(BoltStructure_value(point, 2));
+    }
+    return sum>=0.0 ? fixture->encoded_size : 0;
+}
+
+int64_t bench_copy(struct Fixture* fixture)
+{
+    BoltValue_copy(fixture->target, fixture->value);
+    return fixture->encoded_size;
+}
+
+// Builds a fresh value tree and tears it down again, the way decoded results are usually consumed
+int64_t bench_duplicate(struct Fixture* fixture)
+{
+    BoltValue_destroy(BoltValue_duplicate(fixture->value));
+    return fixture->encoded_size;
+}
+
+// Builds and encodes {rows: [{id, name, score}, ...]} the way bulk UNWIND parameters are usually sent
+int64_t bench_params_tree(struct Fixture* fixture)
+{
+    BoltValue_format_as_Dictionary(fixture->target, 1);
+    BoltDictionary_set_key(fixture->target, 0, "rows", 4);
+    struct BoltValue* rows = BoltDictionary_value(fixture->target, 0);
+    BoltValue_format_as_List(rows, PARAMETER_ROWS);
+    for (int32_t i = 0; i<PARAMETER_ROWS; i++) {
+        struct BoltValue* row = BoltList_value(rows, i);
+        BoltValue_format_as_Dictionary(row, 3);
+        BoltDictionary_set_key(row, 0, "id", 2);
+        BoltValue_format_as_Integer(BoltDictionary_value(row, 0), 100000+i);
+        BoltDictionary_set_key(row, 1, "name", 4);
+        BoltValue_format_as_String(BoltDictionary_value(row, 1), "Alice Smith", 11);
+        BoltDictionary_set_key(row, 2, "score", 5);
+        BoltValue_format_as_Float(BoltDictionary_value(row, 2), i*0.5);
+    }
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = 0;
+    load(&_any_structure, fixture->buffer, fixture->target, NULL);
+    return fixture->buffer->extent;
+}
+
+int64_t bench_params_writer(struct Fixture* fixture)
+{
+    struct BoltWriter* writer = fixture->writer;
+    BoltWriter_reset(writer);
+    BoltWriter_begin_map(writer, 1);
+    BoltWriter_key(writer, "rows", 4);
+    BoltWriter_begin_list(writer, PARAMETER_ROWS);
+    for (int32_t i = 0; i<PARAMETER_ROWS; i++) {
+        BoltWriter_begin_map(writer, 3);
+        BoltWriter_key(writer, "id", 2);
+        BoltWriter_integer(writer, 100000+i);
+        BoltWriter_key(writer, "name", 4);
+        BoltWriter_string(writer, "Alice Smith", 11);
+        BoltWriter_key(writer, "score", 5);
+        BoltWriter_float(writer, i*0.5);
+        BoltWriter_end(writer);
+    }
+    BoltWriter_end(writer);
+    BoltWriter_end(writer);
+    // the written parameters are copied into the message buffer once, like an encoded tree
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = 0;
+    BoltBuffer_load(fixture->buffer, BoltWriter_data(writer), BoltWriter_size(writer));
+    return fixture->buffer->extent;
+}
+
+// Encodes a RUN message the way BoltConnection_set_run_cypher does, copying and encoding the cypher every time
+int64_t bench_run_cypher(struct Fixture* fixture)
+{
+    BoltValue_format_as_String(BoltMessage_param(fixture->run, 0), RUN_CYPHER, (int32_t) strlen(RUN_CYPHER));
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = 0;
+    write_message(fixture->run, &_any_structure, fixture->buffer, NULL, NULL);
+    return fixture->buffer->extent;
+}
+
+int64_t bench_run_statement(struct Fixture* fixture)
+{
+    BoltMessage_set_encoded_param(fixture->run, 0, fixture->statement->encoded, fixture->statement->encoded_size);
+    fixture->buffer->cursor = 0;
+    fixture->buffer->extent = 0;
+    write_message(fixture->run, &_any_structure, fixture->buffer, NULL, NULL);
+    return fixture->buffer->extent;
+}
+
+int64_t bench_buffer_load_scalars(struct Fixture* fixture)
+{
+    struct BoltBuffer* buffer = fixture->buffer;
+    buffer->cursor = 0;
+    buffer->extent = 0;
+    for (int i = 0; i<32; i++) {
+        BoltBuffer_load_u8(buffer, (uint8_t) i);
+        BoltBuffer_load_i16be(buffer, (int16_t) i);
+        BoltBuffer_load_i32be(buffer, i);
+        BoltBuffer_load_i64be(buffer, i);
+        BoltBuffer_load_f64be(buffer, i);
+    }
+    return buffer->extent;
+}
+
+int64_t bench_buffer_unload_scalars(struct Fixture* fixture)
+{
+    struct BoltBuffer* buffer = fixture->buffer;
+    bench_buffer_load_scalars(fixture);
+    uint8_t u8;
+    int16_t i16;
+    int32_t i32;
+    int64_t i64;
+    double f64;
+    for (int i = 0; i<32; i++) {
+        BoltBuffer_unload_u8(buffer, &u8);
+        BoltBuffer_unload_i16be(buffer, &i16);
+        BoltBuffer_unload_i32be(buffer, &i32);
+        BoltBuffer_unload_i64be(buffer, &i64);
+        BoltBuffer_unload_f64be(buffer, &f64);
+    }
+    return buffer->extent;
+}
+
+int64_t bench_buffer_load_unload_block(struct Fixture* fixture)
+{
+    struct BoltBuffer* buffer = fixture->buffer;
+    buffer->cursor = 0;
+    buffer->extent = 0;
+    BoltBuffer_load(buffer, fixture->block, BLOCK_SIZE);
+    BoltBuffer_unload(buffer, fixture->block, BLOCK_SIZE);
+    return BLOCK_SIZE;
+}
+
+int64_t bench_buffer_compact(struct Fixture* fixture)
+{
+    struct BoltBuffer* buffer = fixture->buffer;
+    buffer->cursor = 0;
+    buffer->extent = 0;
+    for (int i = 0; i<4; i++) {
+        BoltBuffer_load(buffer, fixture->block, BLOCK_SIZE);
+    }
+    for (int i = 0; i<3; i++) {
+        BoltBuffer_unload(buffer, fixture->block, BLOCK_SIZE);
+    }
+    BoltBuffer_compact(buffer);
+    return BLOCK_SIZE;
+}
+
+int64_t bench_buffer_grow(struct Fixture* fixture)
+{
+    UNUSED(fixture);
+    struct BoltBuffer* buffer = BoltBuffer_create(256);
+    for (int i = 0; i<65536; i++) {
+        BoltBuffer_load_u8(buffer, (uint8_t) i);
+    }
+    int64_t size = buffer->extent;
+    BoltBuffer_destroy(buffer);
+    return size;
+}
+
+// Receives the stream through BoltConnection_receive in chunk header and body sized pieces, like a protocol fetch
+int64_t bench_receive(struct Fixture* fixture, int body_size)
+{
+    if (fixture->connection==NULL) {
+        fixture->receive_stream = BoltMem_allocate(RECEIVE_STREAM_SIZE+4);
+        memset(fixture->receive_stream, 0, RECEIVE_STREAM_SIZE+4);
+        fixture->receive_stream[3] = 3;
+        struct BoltAddress* address = BoltAddress_create("localhost", "7687");
+        BoltAddress_resolve(address, NULL, NULL);
+        fixture->connection = BoltConnection_create();
+        fixture->connection->comm = BoltCommunication_create_replay(fixture->receive_stream, RECEIVE_STREAM_SIZE+4,
+                NULL, NULL);
+        BoltConnection_open(fixture->connection, BOLT_TRANSPORT_MOCKED, address, NULL, NULL, NULL);
+        BoltAddress_destroy(address);
+    }
+
+    ((MockCommunicationContext*) fixture->connection->comm->context)->replay_cursor = 4;
+    char* body = BoltMem_allocate((size_t) body_size);
+    char header[2];
+    int64_t received = 0;
+    while (received+2+body_size<=RECEIVE_STREAM_SIZE) {
+        BoltConnection_receive(fixture->connection, header, 2);
+        BoltConnection_receive(fixture->connection, body, body_size);
+        received += 2+body_size;
+    }
+    BoltConnection_receive(fixture->connection, body, (int) (RECEIVE_STREAM_SIZE-received));
+    BoltMem_deallocate(body, (size_t) body_size);
+    return RECEIVE_STREAM_SIZE;
+}
+
+int64_t bench_receive_records(struct Fixture* fixture)
+{
+    return bench_receive(fixture, 120);
+}
+
+int64_t bench_receive_chunks(struct Fixture* fixture)
+{
+    return bench_receive(fixture, MAX_CHUNK_SIZE);
+}
+
+// Reassembles a chunked message the same way the protocol receive path does and decodes it
+int64_t bench_dechunk(struct Fixture* fixture)
+{
+    struct BoltBuffer* stream = fixture->stream;
+    struct BoltBuffer* rx_buffer = fixture->rx_buffer;
+    stream->cursor = 0;
+    stream->extent = fixture->stream_size;
+    uint16_t chunk_size;
+    BoltBuffer_unload_u16be(stream, &chunk_size);
+    BoltBuffer_compact(rx_buffer);
+    while (chunk_size!=0) {
+        BoltBuffer_unload(stream, BoltBuffer_load_pointer(rx_buffer, chunk_size), chunk_size);
+        BoltBuffer_unload_u16be(stream, &chunk_size);
+    }
+    unload(&_any_structure, rx_buffer, fixture->target, NULL);
+    return fixture->stream_size;
+}
+
+void chunk(struct BoltBuffer* source, struct BoltBuffer* stream)
+{
+    while (BoltBuffer_unloadable(source)>0) {
+        int size = BoltBuffer_unloadable(source)<MAX_CHUNK_SIZE ? BoltBuffer_unloadable(source) : MAX_CHUNK_SIZE;
+        BoltBuffer_load_u16be(stream, (uint16_t) size);
+        BoltBuffer_load(stream, BoltBuffer_unload_pointer(source, size), size);
+    }
+    BoltBuffer_load_u16be(stream, 0);
+}
+
+static const struct Benchmark BENCHMARKS[] = {
+        {"load/null", &sample_null, &bench_load},
+        {"load/boolean", &sample_boolean, &bench_load},
+        {"load/tiny_integer", &sample_tiny_integer, &bench_load},
+        {"load/integer", &sample_integer, &bench_load},
+        {"load/float", &sample_float, &bench_load},
+        {"load/short_string", &sample_short_string, &bench_load},
+        {"load/long_string", &sample_long_string, &bench_load},
+        {"load/bytes", &sample_bytes, &bench_load},
+        {"load/list", &sample_list, &bench_load},
+        {"load/large_list", &sample_large_list, &bench_load},
+        {"load/map", &sample_map, &bench_load},
+        {"load/nested", &sample_nested, &bench_load},
+        {"load/node", &sample_node, &bench_load},
+        {"load/record", &sample_record, &bench_load},
+        {"unload/null", &sample_null, &bench_unload},
+        {"unload/boolean", &sample_boolean, &bench_unload},
+        {"unload/tiny_integer", &sample_tiny_integer, &bench_unload},
+        {"unload/integer", &sample_integer, &bench_unload},
+        {"unload/float", &sample_float, &bench_unload},
+        {"unload/short_string", &sample_short_string, &bench_unload},
+        {"unload/long_string", &sample_long_string, &bench_unload},
+        {"unload/bytes", &sample_bytes, &bench_unload},
+        {"unload/list", &sample_list, &bench_unload},
+        {"unload/large_list", &sample_large_list, &bench_unload},
+        {"unload_packed/large_list", &sample_large_list, &bench_unload_packed},
+        {"unload/map", &sample_map, &bench_unload},
+        {"unload/nested", &sample_nested, &bench_unload},
+        {"unload/node", &sample_node, &bench_unload},
+        {"unload/record", &sample_record, &bench_unload},
+        {"unload/wide_node", &sample_wide_node, &bench_unload},
+        {"unload_lazy/wide_node", &sample_wide_node, &bench_unload_lazy},
+        {"unload/points", &sample_points, &bench_unload_points},
+        {"unload_packed/points", &sample_points, &bench_unload_packed_points},
+        {"unload_packed/point_values", &sample_points, &bench_unload_packed_points_by_value},
+        {"copy/short_string", &sample_short_string, &bench_copy},
+        {"copy/list", &sample_list, &bench_copy},
+        {"copy/large_list", &sample_large_list, &bench_copy},
+        {"copy/map", &sample_map, &bench_copy},
+        {"copy/nested", &sample_nested, &bench_copy},
+        {"copy/record", &sample_record, &bench_copy},
+        {"duplicate/map", &sample_map, &bench_duplicate},
+        {"duplicate/nested", &sample_nested, &bench_duplicate},
+        {"duplicate/record", &sample_record, &bench_duplicate},
+        {"params/tree", &sample_null, &bench_params_tree},
+        {"params/writer", &sample_null, &bench_params_writer},
+        {"run/cypher", &sample_null, &bench_run_cypher},
+        {"run/statement", &sample_null, &bench_run_statement},
+        {"buffer/load_scalars", &sample_null, &bench_buffer_load_scalars},
+        {"buffer/unload_scalars", &sample_null, &bench_buffer_unload_scalars},
+        {"buffer/load_unload_block", &sample_null, &bench_buffer_load_unload_block},
+        {"buffer/compact", &sample_null, &bench_buffer_compact},
+        {"buffer/grow", &sample_null, &bench_buffer_grow},
+        {"receive/records", &sample_null, &bench_receive_records},
+        {"receive/chunks", &sample_null, &bench_receive_chunks},
+        {"dechunk/record", &sample_record, &bench_dechunk},
+        {"dechunk/large_record", &sample_large_record, &bench_dechunk},
+};
+
+#define BENCHMARK_COUNT (sizeof(BENCHMARKS)/sizeof(BENCHMARKS[0]))
+
+void fixture_init(struct Fixture* fixture, const struct Benchmark* benchmark)
+{
+    fixture->value = BoltValue_create();
+    fixture->target = BoltValue_create();
+    fixture->buffer = BoltBuffer_create(8192);
+    fixture->stream = BoltBuffer_create(8192);
+    fixture->rx_buffer = BoltBuffer_create(8192);
+    fixture->writer = BoltWriter_create_with_check(&_any_structure);
+    fixture->run = BoltMessage_create(0x10, 2);
+    BoltValue_format_as_Dictionary(BoltMessage_param(fixture->run, 1), 0);
+    fixture->statement = BoltStatement_create(RUN_CYPHER, strlen(RUN_CYPHER));
+    fixture->connection = NULL;
+    fixture->receive_stream = NULL;
+    memset(fixture->block, 'x', BLOCK_SIZE);
+
+    benchmark->sample(fixture->value);
+    load(&_any_structure, fixture->buffer, fixture->value, NULL);
+    fixture->encoded_size = fixture->buffer->extent;
+    chunk(fixture->buffer, fixture->stream);
+    fixture->stream_size = fixture->stream->extent;
+    bench_unload(fixture);
+}
+
+void fixture_cleanup(struct Fixture* fixture)
+{
+    BoltValue_destroy(fixture->value);
+    BoltValue_destroy(fixture->target);
+    BoltBuffer_destroy(fixture->buffer);
+    BoltBuffer_destroy(fixture->stream);
+    BoltBuffer_destroy(fixture->rx_buffer);
+    BoltWriter_destroy(fixture->writer);
+    BoltMessage_destroy(fixture->run);
+    BoltStatement_destroy(fixture->statement);
+    if (fixture->connection!=NULL) {
+        BoltConnection_close(fixture->connection);
+        BoltConnection_destroy(fixture->connection);
+        BoltMem_deallocate(fixture->receive_stream, RECEIVE_STREAM_SIZE+4);
+    }
+}
+
+int64_t elapsed_ns(struct timespec* start)
+{
+    struct timespec now, diff;
+    BoltTime_get_time(&now);
+    BoltTime_diff_time(&diff, &now, start);
+    return (int64_t) diff.tv_sec*1000000000+diff.tv_nsec;
+}
+
+// Runs batches of doubling size until the requested duration has elapsed
+void measure(const struct Benchmark* benchmark, int64_t duration_ms, struct Result* result)
+{
+    struct Fixture fixture;
+    fixture_init(&fixture, benchmark);
+
+    for (int i = 0; i<100; i++) {
+        benchmark->run(&fixture);
+    }
+
+    memset(result, 0, sizeof(struct Result));
+    int64_t allocations = BoltMem_allocation_events();
+    int64_t batch = 1;
+    while (result->nanoseconds<duration_ms*1000000) {
+        struct timespec start;
+        BoltTime_get_time(&start);
+        for (int64_t i = 0; i<batch; i++) {
+            result->bytes += benchmark->run(&fixture);
+        }
+        result->nanoseconds += elapsed_ns(&start);
+        result->operations += batch;
+        batch *= 2;
+    }
+    result->allocations = BoltMem_allocation_events()-allocations;
+
+    fixture_cleanup(&fixture);
+}
+
+// Replays a recorded server stream through a mocked connection, fetching every response it holds
+int64_t replay(const char* stream, int64_t size, struct BoltAddress* address, struct BoltValue* auth_token,
+        int64_t* records)
+{
+    BoltConnection* connection = BoltConnection_create();
+    connection->comm = BoltCommunication_create_replay(stream, size, NULL, NULL);
+    BoltConnection_open(connection, BOLT_TRANSPORT_MOCKED, address, NULL, NULL, NULL);
+    if (connection->protocol==NULL || BoltConnection_init(connection, "seabolt-bench", auth_token)!=0) {
+        BoltConnection_close(connection);
+        BoltConnection_destroy(connection);
+        return -1;
+    }
+
+    BoltRequest request = BoltConnection_last_request(connection)+1;
+    int fetched;
+    while ((fetched = BoltConnection_fetch(connection, request))>=0) {
+        if (fetched) {
+            *records += 1;
+        }
+        else {
+            request += 1;
+        }
+    }
+
+    BoltConnection_close(connection);
+    BoltConnection_destroy(connection);
+    return size;
+}
+
+int measure_replay(const char* path, int64_t duration_ms, struct Result* result, int64_t* records)
+{
+    char* stream = NULL;
+    int64_t size = BoltCapture_load(path, BOLT_CAPTURE_SERVER, &stream);
+    if (size<=0) {
+        fprintf(stderr, "Unable to load capture %s\n", path);
+        return 0;
+    }
+
+    struct BoltAddress* address = BoltAddress_create("localhost", "7687");
+    BoltAddress_resolve(address, NULL, NULL);
+    struct BoltValue* auth_token = BoltAuth_none();
+
+    memset(result, 0, sizeof(struct Result));
+    int status = 1;
+    int64_t allocations = BoltMem_allocation_events();
+    while (status && result->nanoseconds<duration_ms*1000000) {
+        *records = 0;
+        struct timespec start;
+        BoltTime_get_time(&start);
+        status = replay(stream, size, address, auth_token, records)>=0;
+        result->nanoseconds += elapsed_ns(&start);
+        result->bytes += size;
+        result->operations += 1;
+    }
+    result->allocations = BoltMem_allocation_events()-allocations;
+
+    if (!status) {
+        fprintf(stderr, "Capture %s does not start with a handshake and an initialisation response\n", path);
+    }
+
+    BoltValue_destroy(auth_token);
+    BoltAddress_destroy(address);
+    BoltMem_deallocate(stream, size);
+    return status;
+}
+
+void print_result(const char* name, const struct Result* result, int64_t records, int json, int first)
+{
+    double ns_per_op = (double) result->nanoseconds/(double) result->operations;
+    double bytes_per_second = (double) result->bytes*1e9/(double) result->nanoseconds;
+    double allocations_per_op = (double) result->allocations/(double) result->operations;
+    if (json) {
+        printf("%s    {\"name\": \"%s\", \"operations\": %" PRId64 ", \"ns_per_op\": %.2f, \"bytes_per_second\": %.0f, "
+               "\"allocations_per_op\": %.2f", first ? "" : ",\n", name, result->operations, ns_per_op,
+                bytes_per_second, allocations_per_op);
+        if (records>=0) {
+            printf(", \"records_per_op\": %" PRId64, records);
+        }
+        printf("}");
+    }
+    else {
+        printf("%-28s %14.2f %14.2f %14.2f\n", name, ns_per_op, bytes_per_second/1e6, allocations_per_op);
+    }
+}
+
+void app_help()
+{
+    fprintf(stderr, "seabolt-bench [options] [filter]\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Runs PackStream, BoltValue and BoltBuffer microbenchmarks whose names contain the filter.\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  %-16s: Minimum measurement time per benchmark (Default: %d)\n", "-d <ms>", DEFAULT_DURATION);
+    fprintf(stderr, "  %-16s: Print results as JSON\n", "-j");
+    fprintf(stderr, "  %-16s: Only replay the server side of a wire capture, fetching all its responses\n",
+            "-r <capture>");
+}
+
+int main(int argc, char** argv)
+{
+    int64_t duration = DEFAULT_DURATION;
+    int json = 0;
+    const char* filter = "";
+    const char* capture = NULL;
+    for (int i = 1; i<argc; i++) {
+        if (strcmp(argv[i], "-j")==0) {
+            json = 1;
+        }
+        else if (strcmp(argv[i], "-d")==0 && i+1<argc) {
+            duration = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-r")==0 && i+1<argc) {
+            capture = argv[++i];
+        }
+        else if (argv[i][0]!='-') {
+            filter = argv[i];
+        }
+        else {
+            app_help();
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    Bolt_startup();
+
+    if (json) {
+        printf("{\n  \"benchmarks\": [\n");
+    }
+    else {
+        printf("%-28s %14s %14s %14s\n", "benchmark", "ns/op", "MB/s", "allocs/op");
+    }
+    int first = 1;
+    if (capture!=NULL) {
+        struct Result result;
+        int64_t records = 0;
+        if (!measure_replay(capture, duration, &result, &records)) {
+            exit(EXIT_FAILURE);
+        }
+        print_result("replay", &result, records, json, first);
+        filter = NULL;
+    }
+    for (size_t i = 0; filter!=NULL && i<BENCHMARK_COUNT; i++) {
+        const struct Benchmark* benchmark = &BENCHMARKS[i];
+        if (strstr(benchmark->name, filter)==NULL) {
+            continue;
+        }
+        struct Result result;
+        measure(benchmark, duration, &result);
+        print_result(benchmark->name, &result, -1, json, first);
+        first = 0;
+    }
+    if (json) {
+        printf("\n  ]\n}\n");
+    }
+
+    Bolt_shutdown();
+    return EXIT_SUCCESS;
+}
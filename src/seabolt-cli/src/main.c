@@ -26,6 +26,9 @@
 #include <inttypes.h>
 
 #include "bolt/bolt.h"
+#include "bolt/atomic.h"
+#include "bolt/histogram.h"
+#include "bolt/sync.h"
 #include "bolt/time.h"
 
 #ifdef WIN32
@@ -77,6 +80,13 @@ struct Application {
     } stats;
     int with_allocation_report;
     int with_header;
+    struct {
+        int threads;
+        double rate;
+        double duration;
+        const char* parameter_file;
+        int pipeline;
+    } perf;
     enum Command command;
     int first_arg_index;
     int argc;
@@ -126,6 +136,15 @@ void app_help()
     fprintf(stderr, "seabolt perf <warmup_times> <actual_times> <cypher>\n");
     fprintf(stderr, "seabolt run <cypher>\n");
     fprintf(stderr, "\n");
+    fprintf(stderr, "perf options, results are printed as JSON\n");
+    fprintf(stderr, "  %-16s: Number of worker threads sharing the connector (Default: 1)\n", "-c <threads>");
+    fprintf(stderr, "  %-16s: Target rate in queries per second across all workers (Default: unlimited)\n",
+            "-r <rate>");
+    fprintf(stderr, "  %-16s: Run for this many seconds instead of <actual_times> queries\n", "-d <seconds>");
+    fprintf(stderr, "  %-16s: Tab separated parameter file, names on the first line, one query per line\n",
+            "-f <file>");
+    fprintf(stderr, "  %-16s: Number of queries sent together on one connection (Default: 1)\n", "-p <depth>");
+    fprintf(stderr, "\n");
     fprintf(stderr, "supported environment variables\n");
     fprintf(stderr, "  %-16s: 0 for Direct Driver, 1 for Routing (Default: 0)\n", "BOLT_ROUTING");
     fprintf(stderr, "  %-16s: WRITE for write mode, READ for read mode (Default: WRITE)\n", "BOLT_ACCESS_MODE");
@@ -134,6 +153,8 @@ void app_help()
     fprintf(stderr, "  %-16s: Port to connect to (Default: 7687)\n", "BOLT_PORT");
     fprintf(stderr, "  %-16s: Username, set to empty to disable authentication token (Default: neo4j)\n", "BOLT_USER");
     fprintf(stderr, "  %-16s: Password\n", "BOLT_PASSWORD");
+    fprintf(stderr, "  %-16s: Directory to record the wire traffic of each connection to (Default: none)\n",
+            "BOLT_CAPTURE");
 }
 
 struct Application* app_create(int argc, char** argv)
@@ -145,6 +166,7 @@ struct Application* app_create(int argc, char** argv)
     const char* BOLT_CONFIG_PORT = getenv_or_default("BOLT_PORT", "7687");
     const char* BOLT_CONFIG_USER = getenv_or_default("BOLT_USER", "neo4j");
     const char* BOLT_CONFIG_PASSWORD = getenv("BOLT_PASSWORD");
+    const char* BOLT_CONFIG_CAPTURE = getenv("BOLT_CAPTURE");
 
     // Verify environment variables
     int valid_config = strcmp(BOLT_CONFIG_ROUTING, "")!=0 && strcmp(BOLT_CONFIG_ACCESS_MODE, "")!=0
@@ -165,6 +187,11 @@ struct Application* app_create(int argc, char** argv)
     app->access_mode = (strcmp(BOLT_CONFIG_ACCESS_MODE, "WRITE")==0 ? BOLT_ACCESS_MODE_WRITE : BOLT_ACCESS_MODE_READ);
     app->with_allocation_report = 0;
     app->with_header = 0;
+    app->perf.threads = 1;
+    app->perf.rate = 0;
+    app->perf.duration = 0;
+    app->perf.parameter_file = NULL;
+    app->perf.pipeline = 1;
     app->command = CMD_NONE;
     app->first_arg_index = -1;
     app->argv = argv;
@@ -180,6 +207,21 @@ struct Application* app_create(int argc, char** argv)
             else if (strcmp(arg, "-h")==0) {
                 app->with_header = 1;
             }
+            else if (strcmp(arg, "-c")==0 && i+1<argc) {
+                app->perf.threads = atoi(argv[++i]);
+            }
+            else if (strcmp(arg, "-r")==0 && i+1<argc) {
+                app->perf.rate = atof(argv[++i]);
+            }
+            else if (strcmp(arg, "-d")==0 && i+1<argc) {
+                app->perf.duration = atof(argv[++i]);
+            }
+            else if (strcmp(arg, "-f")==0 && i+1<argc) {
+                app->perf.parameter_file = argv[++i];
+            }
+            else if (strcmp(arg, "-p")==0 && i+1<argc) {
+                app->perf.pipeline = atoi(argv[++i]);
+            }
             else {
                 fprintf(stderr, "Unknown option %s\n", arg);
                 exit(EXIT_FAILURE);
@@ -217,8 +259,11 @@ struct Application* app_create(int argc, char** argv)
     BoltConfig_set_transport(config,
             (strcmp(BOLT_CONFIG_SECURE, "1")==0) ? BOLT_TRANSPORT_ENCRYPTED : BOLT_TRANSPORT_PLAINTEXT);
     BoltConfig_set_user_agent(config, "seabolt/" SEABOLT_VERSION);
-    BoltConfig_set_max_pool_size(config, 10);
+    BoltConfig_set_max_pool_size(config, app->perf.threads>10 ? app->perf.threads : 10);
     BoltConfig_set_log(config, log);
+    if (BOLT_CONFIG_CAPTURE!=NULL && strcmp(BOLT_CONFIG_CAPTURE, "")!=0) {
+        BoltConfig_set_wire_capture_directory(config, BOLT_CONFIG_CAPTURE);
+    }
 
     struct BoltValue* auth_token = NULL;
     if (strcmp(BOLT_CONFIG_USER, "")!=0) {
@@ -383,58 +428,350 @@ int app_run(struct Application* app, const char* cypher)
     return 0;
 }
 
-long run_fetch(const struct Application* app, const char* cypher)
+struct ParameterSet {
+    int32_t size;
+    char** names;
+    int64_t row_count;
+    struct BoltValue** rows;
+};
+
+struct PerfWorker {
+    struct Application* app;
+    struct PerfRun* run;
+    thread_t thread;
+    BoltHistogram connect;
+    BoltHistogram first_record;
+    BoltHistogram result;
+    int64_t queries;
+    int64_t records;
+    int64_t failures;
+};
+
+struct PerfRun {
+    const char* cypher;
+    struct ParameterSet* parameters;
+    volatile int64_t next_row;
+    volatile int64_t remaining;
+    struct timespec start;
+    int64_t duration_ns;
+    int64_t interval_ns;
+    int pipeline;
+};
+
+#define MAX_PARAMETER_LINE 65536
+
+int64_t elapsed_ns(const struct timespec* t0)
 {
-    long record_count = 0;
-    BoltConnection_load_begin_request(app->connection);
-    BoltConnection_set_run_cypher(app->connection, cypher, strlen(cypher), 0);
-    BoltConnection_load_run_request(app->connection);
-    BoltRequest run = BoltConnection_last_request(app->connection);
-    BoltConnection_load_pull_request(app->connection, -1);
-    BoltRequest pull = BoltConnection_last_request(app->connection);
-    BoltConnection_load_commit_request(app->connection);
-    BoltRequest commit = BoltConnection_last_request(app->connection);
+    struct timespec now, diff;
+    BoltTime_get_time(&now);
+    timespec_diff(&diff, &now, (struct timespec*) t0);
+    return (int64_t) diff.tv_sec*1000000000+diff.tv_nsec;
+}
 
-    BoltConnection_send(app->connection);
+char* next_field(char** cursor)
+{
+    char* field = *cursor;
+    if (field==NULL) {
+        return NULL;
+    }
+    char* end = field+strcspn(field, "\t\r\n");
+    *cursor = *end=='\t' ? end+1 : NULL;
+    *end = '\0';
+    return field;
+}
 
-    BoltConnection_fetch_summary(app->connection, run);
+void parse_parameter(struct BoltValue* value, const char* text)
+{
+    char* end;
+    long long integer = strtoll(text, &end, 10);
+    if (*text!='\0' && *end=='\0') {
+        BoltValue_format_as_Integer(value, integer);
+        return;
+    }
+    double number = strtod(text, &end);
+    if (*text!='\0' && *end=='\0') {
+        BoltValue_format_as_Float(value, number);
+        return;
+    }
+    BoltValue_format_as_String(value, text, (int32_t) strlen(text));
+}
 
-    while (BoltConnection_fetch(app->connection, pull)) {
-        record_count += 1;
+struct ParameterSet* parameters_load(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file==NULL) {
+        return NULL;
     }
+    char* line = malloc(MAX_PARAMETER_LINE);
+    struct ParameterSet* parameters = calloc(1, sizeof(struct ParameterSet));
+    if (fgets(line, MAX_PARAMETER_LINE, file)!=NULL) {
+        char* cursor = line;
+        char* name;
+        while ((name = next_field(&cursor))!=NULL) {
+            parameters->names = realloc(parameters->names, (parameters->size+1)*sizeof(char*));
+            parameters->names[parameters->size] = malloc(strlen(name)+1);
+            strcpy(parameters->names[parameters->size++], name);
+        }
+    }
+    int64_t capacity = 0;
+    while (fgets(line, MAX_PARAMETER_LINE, file)!=NULL) {
+        if (line[0]=='\n' || line[0]=='\r') {
+            continue;
+        }
+        if (parameters->row_count==capacity) {
+            capacity = capacity==0 ? 64 : capacity*2;
+            parameters->rows = realloc(parameters->rows, capacity*sizeof(struct BoltValue*));
+        }
+        struct BoltValue* row = BoltValue_create();
+        BoltValue_format_as_List(row, parameters->size);
+        char* cursor = line;
+        for (int32_t i = 0; i<parameters->size; i++) {
+            char* field = next_field(&cursor);
+            parse_parameter(BoltList_value(row, i), field==NULL ? "" : field);
+        }
+        parameters->rows[parameters->row_count++] = row;
+    }
+    free(line);
+    fclose(file);
+    return parameters;
+}
 
-    BoltConnection_fetch_summary(app->connection, commit);
-    return record_count;
+void parameters_destroy(struct ParameterSet* parameters)
+{
+    for (int32_t i = 0; i<parameters->size; i++) {
+        free(parameters->names[i]);
+    }
+    for (int64_t i = 0; i<parameters->row_count; i++) {
+        BoltValue_destroy(parameters->rows[i]);
+    }
+    free(parameters->names);
+    free(parameters->rows);
+    free(parameters);
 }
 
-int app_perf(struct Application* app, long warmup_times, long actual_times, const char* cypher)
+void load_query(BoltConnection* connection, struct PerfRun* run)
 {
-    struct timespec t[3];
+    struct ParameterSet* parameters = run->parameters;
+    if (parameters==NULL || parameters->row_count==0) {
+        BoltConnection_set_run_cypher(connection, run->cypher, strlen(run->cypher), 0);
+    }
+    else {
+        struct BoltValue* row = parameters->rows[BoltAtomic_increment(&run->next_row)%parameters->row_count];
+        BoltConnection_set_run_cypher(connection, run->cypher, strlen(run->cypher), parameters->size);
+        for (int32_t i = 0; i<parameters->size; i++) {
+            struct BoltValue* value = BoltConnection_set_run_cypher_parameter(connection, i, parameters->names[i],
+                    strlen(parameters->names[i]));
+            BoltValue_copy(value, BoltList_value(row, i));
+        }
+    }
+    BoltConnection_load_run_request(connection);
+    BoltConnection_load_pull_request(connection, -1);
+}
 
-    app_connect(app);
+// Runs one pipelined batch of _count_ queries, each in its own explicit transaction, recording latencies from
+// _start_ unless worker is NULL (warm up)
+int run_batch(struct Application* app, struct PerfRun* run, struct PerfWorker* worker, const struct timespec* start,
+        int count)
+{
+    BoltStatus* status = BoltStatus_create();
+    BoltConnection* connection = BoltConnector_acquire(app->connector, app->access_mode, status);
+    BoltStatus_destroy(status);
+    if (worker!=NULL) {
+        BoltHistogram_record(&worker->connect, elapsed_ns(start)/1000);
+    }
+    if (connection==NULL) {
+        if (worker!=NULL) {
+            worker->failures += count;
+        }
+        return 0;
+    }
 
-    for (int i = 0; i<warmup_times; i++) {
-        run_fetch(app, cypher);
+    BoltRequest* pulls = malloc(2*count*sizeof(BoltRequest));
+    BoltRequest* commits = pulls+count;
+    for (int i = 0; i<count; i++) {
+        BoltConnection_load_begin_request(connection);
+        load_query(connection, run);
+        pulls[i] = BoltConnection_last_request(connection);
+        BoltConnection_load_commit_request(connection);
+        commits[i] = BoltConnection_last_request(connection);
+    }
+    BoltConnection_send(connection);
+
+    for (int i = 0; i<count; i++) {
+        int fetched;
+        int64_t records = 0;
+        while ((fetched = BoltConnection_fetch(connection, pulls[i]))>0) {
+            if (records==0 && worker!=NULL) {
+                BoltHistogram_record(&worker->first_record, elapsed_ns(start)/1000);
+            }
+            records += 1;
+        }
+        int failed = fetched<0 || !BoltConnection_summary_success(connection);
+        if (BoltConnection_fetch_summary(connection, commits[i])<0 || !BoltConnection_summary_success(connection)) {
+            failed = 1;
+        }
+        if (worker==NULL) {
+            continue;
+        }
+        worker->queries += 1;
+        worker->records += records;
+        if (failed) {
+            worker->failures += 1;
+        }
+        else {
+            if (records==0) {
+                BoltHistogram_record(&worker->first_record, elapsed_ns(start)/1000);
+            }
+            BoltHistogram_record(&worker->result, elapsed_ns(start)/1000);
+        }
     }
 
-    BoltTime_get_time(&t[1]);    // Checkpoint 1 - before run
-    long record_count = 0;
-    for (int i = 0; i<actual_times; i++) {
-        record_count += run_fetch(app, cypher);
+    free(pulls);
+    BoltConnector_release(app->connector, connection);
+    return 1;
+}
+
+void perf_worker(void* arg)
+{
+    struct PerfWorker* worker = (struct PerfWorker*) arg;
+    struct PerfRun* run = worker->run;
+    int64_t scheduled = 0;
+    while (1) {
+        int count = run->pipeline;
+        if (run->duration_ns>0) {
+            if (elapsed_ns(&run->start)>=run->duration_ns) {
+                break;
+            }
+        }
+        else {
+            // The last batch only takes the queries that are left
+            int64_t left = BoltAtomic_add(&run->remaining, -run->pipeline)+run->pipeline;
+            if (left<=0) {
+                break;
+            }
+            if (left<count) {
+                count = (int) left;
+            }
+        }
+
+        // When rate limited latencies are measured from the scheduled start, so a server that falls behind
+        // shows up as queueing delay rather than as a lower send rate
+        struct timespec start;
+        if (run->interval_ns>0) {
+            int64_t wait_ns = scheduled-elapsed_ns(&run->start);
+            if (wait_ns>0) {
+                BoltThread_sleep(wait_ns/1000);
+            }
+            start = run->start;
+            start.tv_sec += (scheduled+start.tv_nsec)/1000000000;
+            start.tv_nsec = (long) ((scheduled+start.tv_nsec)%1000000000);
+            scheduled += run->interval_ns;
+        }
+        else {
+            BoltTime_get_time(&start);
+        }
+        run_batch(worker->app, run, worker, &start, count);
     }
-    BoltTime_get_time(&t[2]);    // Checkpoint 2 - after run
+}
 
-    BoltConnector_release(app->connector, app->connection);
+void print_json_string(const char* value)
+{
+    putc('"', stdout);
+    for (const char* c = value; *c!='\0'; c++) {
+        if (*c=='"' || *c=='\\') {
+            printf("\\%c", *c);
+        }
+        else if ((unsigned char) *c<0x20) {
+            printf("\\u%04x", (unsigned char) *c);
+        }
+        else {
+            putc(*c, stdout);
+        }
+    }
+    putc('"', stdout);
+}
 
-    ///////////////////////////////////////////////////////////////////
+void print_latency(const char* name, const BoltHistogram* histogram, int last)
+{
+    printf("    \"%s\": {\"count\": %" PRId64 ", \"mean\": %.1f, \"p50\": %" PRId64 ", \"p90\": %" PRId64
+           ", \"p99\": %" PRId64 ", \"p99.9\": %" PRId64 ", \"max\": %" PRId64 "}%s\n", name, histogram->count,
+            histogram->count>0 ? (double) histogram->sum/(double) histogram->count : 0.0,
+            BoltHistogram_value_at_percentile(histogram, 50.0), BoltHistogram_value_at_percentile(histogram, 90.0),
+            BoltHistogram_value_at_percentile(histogram, 99.0), BoltHistogram_value_at_percentile(histogram, 99.9),
+            histogram->count>0 ? histogram->max : 0, last ? "" : ",");
+}
 
-    fprintf(stderr, "query                : %s\n", cypher);
-    fprintf(stderr, "record count         : %ld\n", record_count);
+int app_perf(struct Application* app, long warmup_times, long actual_times, const char* cypher)
+{
+    struct PerfRun run;
+    run.cypher = cypher;
+    run.parameters = NULL;
+    run.next_row = -1;
+    run.pipeline = app->perf.pipeline>0 ? app->perf.pipeline : 1;
+    run.remaining = actual_times;
+    run.duration_ns = (int64_t) (app->perf.duration*1e9);
+    int threads = app->perf.threads>0 ? app->perf.threads : 1;
+    run.interval_ns = app->perf.rate>0 ? (int64_t) (1e9*threads*run.pipeline/app->perf.rate) : 0;
+
+    if (app->perf.parameter_file!=NULL) {
+        run.parameters = parameters_load(app->perf.parameter_file);
+        if (run.parameters==NULL) {
+            fprintf(stderr, "FATAL: Failed to read parameter file %s\n", app->perf.parameter_file);
+            return 1;
+        }
+    }
 
-    timespec_diff(&t[0], &t[2], &t[1]);
-    fprintf(stderr, "=====================================\n");
-    fprintf(stderr, "TOTAL TIME           : %lds %09ldns\n", (long) t[0].tv_sec, t[0].tv_nsec);
+    for (long i = 0; i<warmup_times; i += run.pipeline) {
+        run_batch(app, &run, NULL, NULL, warmup_times-i<run.pipeline ? (int) (warmup_times-i) : run.pipeline);
+    }
 
+    struct PerfWorker* workers = calloc((size_t) threads, sizeof(struct PerfWorker));
+    BoltTime_get_time(&run.start);
+    for (int i = 0; i<threads; i++) {
+        workers[i].app = app;
+        workers[i].run = &run;
+        BoltHistogram_init(&workers[i].connect);
+        BoltHistogram_init(&workers[i].first_record);
+        BoltHistogram_init(&workers[i].result);
+        BoltThread_create(&workers[i].thread, &perf_worker, &workers[i]);
+    }
+
+    struct PerfWorker total;
+    memset(&total, 0, sizeof(total));
+    BoltHistogram_init(&total.connect);
+    BoltHistogram_init(&total.first_record);
+    BoltHistogram_init(&total.result);
+    for (int i = 0; i<threads; i++) {
+        BoltThread_join(&workers[i].thread);
+        BoltHistogram_add(&total.connect, &workers[i].connect);
+        BoltHistogram_add(&total.first_record, &workers[i].first_record);
+        BoltHistogram_add(&total.result, &workers[i].result);
+        total.queries += workers[i].queries;
+        total.records += workers[i].records;
+        total.failures += workers[i].failures;
+    }
+    double elapsed = (double) elapsed_ns(&run.start)/1e9;
+    free(workers);
+
+    ///////////////////////////////////////////////////////////////////
+
+    printf("{\n  \"query\": ");
+    print_json_string(cypher);
+    printf(",\n  \"threads\": %d,\n  \"pipeline\": %d,\n  \"target_rate\": %.1f,\n", threads, run.pipeline,
+            app->perf.rate);
+    printf("  \"elapsed_seconds\": %.3f,\n  \"queries\": %" PRId64 ",\n  \"records\": %" PRId64 ",\n"
+           "  \"failures\": %" PRId64 ",\n", elapsed, total.queries, total.records, total.failures);
+    printf("  \"queries_per_second\": %.1f,\n  \"records_per_second\": %.1f,\n", total.queries/elapsed,
+            total.records/elapsed);
+    printf("  \"latency_us\": {\n");
+    print_latency("connect", &total.connect, 0);
+    print_latency("first_record", &total.first_record, 0);
+    print_latency("result", &total.result, 1);
+    printf("  }\n}\n");
+
+    if (run.parameters!=NULL) {
+        parameters_destroy(run.parameters);
+    }
     return 0;
 }
 
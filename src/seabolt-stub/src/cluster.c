@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bolt/atomic.h"
+
+#include "cluster.h"
+
+#define ROUTING_PROCEDURE "CALL dbms.cluster.routing.getRoutingTable"
+
+void _format_role(struct BoltValue* server, const char* role, const struct StubCluster* cluster, int32_t* indexes,
+        int32_t count)
+{
+    BoltValue_format_as_Dictionary(server, 2);
+    BoltDictionary_set_key(server, 0, "role", 4);
+    BoltValue_format_as_String(BoltDictionary_value(server, 0), role, (int32_t) strlen(role));
+    BoltDictionary_set_key(server, 1, "addresses", 9);
+    struct BoltValue* addresses = BoltDictionary_value(server, 1);
+    BoltValue_format_as_List(addresses, count);
+    for (int32_t i = 0; i<count; i++) {
+        char address[32];
+        snprintf(address, sizeof(address), "127.0.0.1:%d", cluster->members[indexes[i]].port);
+        BoltValue_format_as_String(BoltList_value(addresses, i), address, (int32_t) strlen(address));
+    }
+}
+
+int _answer_routing(void* state, const char* statement, struct BoltValue* fields, struct BoltValue* record)
+{
+    struct StubCluster* cluster = (struct StubCluster*) state;
+    if (strncmp(statement, ROUTING_PROCEDURE, strlen(ROUTING_PROCEDURE))!=0) {
+        return 0;
+    }
+    BoltAtomic_increment(&cluster->routing_requests);
+
+    BoltList_resize(fields, 2);
+    BoltValue_format_as_String(BoltList_value(fields, 0), "ttl", 3);
+    BoltValue_format_as_String(BoltList_value(fields, 1), "servers", 7);
+
+    pthread_mutex_lock(&cluster->mutex);
+    int32_t* writers = malloc(cluster->size*sizeof(int32_t));
+    int32_t* readers = malloc(cluster->size*sizeof(int32_t));
+    int32_t* routers = malloc(cluster->size*sizeof(int32_t));
+    int32_t writer_count = 0, reader_count = 0, router_count = 0;
+    for (int32_t i = 0; i<cluster->size; i++) {
+        if (!cluster->members[i].alive) {
+            continue;
+        }
+        routers[router_count++] = i;
+        if (i==cluster->leader) {
+            writers[writer_count++] = i;
+        }
+        else {
+            readers[reader_count++] = i;
+        }
+    }
+    if (reader_count==0 && writer_count>0) {
+        readers[reader_count++] = writers[0];
+    }
+
+    BoltList_resize(record, 2);
+    BoltValue_format_as_Integer(BoltList_value(record, 0), cluster->ttl);
+    struct BoltValue* servers = BoltList_value(record, 1);
+    BoltValue_format_as_List(servers, 3);
+    _format_role(BoltList_value(servers, 0), "WRITE", cluster, writers, writer_count);
+    _format_role(BoltList_value(servers, 1), "READ", cluster, readers, reader_count);
+    _format_role(BoltList_value(servers, 2), "ROUTE", cluster, routers, router_count);
+    pthread_mutex_unlock(&cluster->mutex);
+
+    free(writers);
+    free(readers);
+    free(routers);
+    return 1;
+}
+
+int _start_member(struct StubCluster* cluster, int32_t index)
+{
+    struct StubClusterMember* member = &cluster->members[index];
+    member->server = StubServer_create(member->script, member->port, 0);
+    if (member->server==NULL) {
+        return 0;
+    }
+    StubServer_set_handler(member->server, _answer_routing, cluster);
+    member->port = member->server->port;
+    member->alive = StubServer_start(member->server);
+    return member->alive;
+}
+
+struct StubCluster* StubCluster_create(int32_t size, int64_t ttl)
+{
+    struct StubCluster* cluster = calloc(1, sizeof(struct StubCluster));
+    pthread_mutex_init(&cluster->mutex, NULL);
+    cluster->size = size;
+    cluster->ttl = ttl;
+    cluster->leader = 0;
+    cluster->members = calloc((size_t) size, sizeof(struct StubClusterMember));
+    for (int32_t i = 0; i<size; i++) {
+        cluster->members[i].script = StubScript_create();
+        if (!_start_member(cluster, i)) {
+            StubCluster_destroy(cluster);
+            return NULL;
+        }
+    }
+    return cluster;
+}
+
+void StubCluster_destroy(struct StubCluster* cluster)
+{
+    for (int32_t i = 0; i<cluster->size; i++) {
+        StubCluster_kill(cluster, i);
+        if (cluster->members[i].script!=NULL) {
+            StubScript_destroy(cluster->members[i].script);
+        }
+    }
+    free(cluster->members);
+    pthread_mutex_destroy(&cluster->mutex);
+    free(cluster);
+}
+
+void StubCluster_set_leader(struct StubCluster* cluster, int32_t index)
+{
+    pthread_mutex_lock(&cluster->mutex);
+    cluster->leader = index;
+    pthread_mutex_unlock(&cluster->mutex);
+}
+
+void StubCluster_set_ttl(struct StubCluster* cluster, int64_t ttl)
+{
+    pthread_mutex_lock(&cluster->mutex);
+    cluster->ttl = ttl;
+    pthread_mutex_unlock(&cluster->mutex);
+}
+
+void StubCluster_set_latency(struct StubCluster* cluster, int32_t index, int32_t latency)
+{
+    cluster->members[index].script->latency = latency;
+}
+
+void StubCluster_kill(struct StubCluster* cluster, int32_t index)
+{
+    struct StubClusterMember* member = &cluster->members[index];
+    pthread_mutex_lock(&cluster->mutex);
+    member->alive = 0;
+    pthread_mutex_unlock(&cluster->mutex);
+    if (member->server!=NULL) {
+        StubServer_destroy(member->server);
+        member->server = NULL;
+    }
+}
+
+int StubCluster_revive(struct StubCluster* cluster, int32_t index)
+{
+    if (cluster->members[index].server!=NULL) {
+        return 1;
+    }
+    pthread_mutex_lock(&cluster->mutex);
+    int status = _start_member(cluster, index);
+    pthread_mutex_unlock(&cluster->mutex);
+    return status;
+}
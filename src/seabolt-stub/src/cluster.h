@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_STUB_CLUSTER_H
+#define SEABOLT_STUB_CLUSTER_H
+
+#include "stub-server.h"
+
+struct StubClusterMember {
+    int port;
+    int alive;
+    struct StubScript* script;
+    struct StubServer* server;
+};
+
+/**
+ * Simulates a causal cluster with a set of local \ref StubServer members answering the routing procedure.
+ *
+ * Every live member reports the leader as writer, the other live members as readers (or the leader when it is
+ * the only live member) and all live members as routers.
+ */
+struct StubCluster {
+    pthread_mutex_t mutex;
+    int32_t size;
+    struct StubClusterMember* members;
+    int32_t leader;
+    /// Routing table time to live in seconds
+    int64_t ttl;
+    volatile int64_t routing_requests;
+};
+
+struct StubCluster* StubCluster_create(int32_t size, int64_t ttl);
+
+void StubCluster_destroy(struct StubCluster* cluster);
+
+void StubCluster_set_leader(struct StubCluster* cluster, int32_t index);
+
+void StubCluster_set_ttl(struct StubCluster* cluster, int64_t ttl);
+
+void StubCluster_set_latency(struct StubCluster* cluster, int32_t index, int32_t latency);
+
+/**
+ * Stops a member, closing all of its connections.
+ */
+void StubCluster_kill(struct StubCluster* cluster, int32_t index);
+
+/**
+ * Restarts a stopped member on its original port.
+ */
+int StubCluster_revive(struct StubCluster* cluster, int32_t index);
+
+#endif //SEABOLT_STUB_CLUSTER_H
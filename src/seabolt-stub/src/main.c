@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stub-server.h"
+
+static struct StubServer* server = NULL;
+
+void stop(int signal)
+{
+    (void) signal;
+    if (server!=NULL) {
+        server->stopping = 1;
+    }
+}
+
+void app_help()
+{
+    fprintf(stderr, "seabolt-stub [options]\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Serves Bolt v3 on localhost, answering every RUN from a script.\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  %-16s: Port to listen on, 0 picks a free port (Default: 7687)\n", "-p <port>");
+    fprintf(stderr, "  %-16s: Serve TLS with a generated self-signed certificate\n", "-t");
+    fprintf(stderr, "  %-16s: Delay in milliseconds before answering RUN (Default: 0)\n", "-l <ms>");
+    fprintf(stderr, "  %-16s: Records returned when no script rule matches (Default: 1)\n", "-r <count>");
+    fprintf(stderr, "  %-16s: Script file with response rules, see stub-server.h\n", "-s <file>");
+}
+
+int main(int argc, char** argv)
+{
+    int port = 7687;
+    int secure = 0;
+    struct StubScript* script = StubScript_create();
+
+    for (int i = 1; i<argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i+1<argc ? argv[i+1] : NULL;
+        if (strcmp(arg, "-t")==0) {
+            secure = 1;
+            continue;
+        }
+        if (value==NULL) {
+            app_help();
+            StubScript_destroy(script);
+            exit(EXIT_FAILURE);
+        }
+        i++;
+        if (strcmp(arg, "-p")==0) {
+            port = atoi(value);
+        }
+        else if (strcmp(arg, "-l")==0) {
+            script->latency = atoi(value);
+        }
+        else if (strcmp(arg, "-r")==0) {
+            script->fallback->record_count = atoll(value);
+        }
+        else if (strcmp(arg, "-s")==0) {
+            int status = StubScript_load(script, value);
+            if (status!=0) {
+                fprintf(stderr, "Invalid script %s at line %d\n", value, status);
+                StubScript_destroy(script);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else {
+            fprintf(stderr, "Unknown option %s\n", arg);
+            app_help();
+            StubScript_destroy(script);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    server = StubServer_create(script, port, secure);
+    if (server==NULL) {
+        StubScript_destroy(script);
+        exit(EXIT_FAILURE);
+    }
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    // the port is reported on stdout so that scripts can pick it up when started with -p 0
+    printf("%d\n", server->port);
+    fflush(stdout);
+
+    StubServer_run(server);
+
+    StubServer_destroy(server);
+    StubScript_destroy(script);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bolt/bolt-private.h"
+#include "bolt/connector-private.h"
+#include "bolt/direct-pool.h"
+#include "bolt/histogram.h"
+#include "bolt/routing-pool.h"
+#include "bolt/status-private.h"
+#include "bolt/sync.h"
+#include "bolt/time.h"
+
+#include "cluster.h"
+
+#define FAILOVER_DEADLINE_MS 60000
+
+struct Benchmark {
+    int32_t members;
+    int64_t iterations;
+    int64_t refreshes;
+    int32_t failovers;
+    int64_t ttl;
+    int32_t latency;
+    int32_t breaker_threshold;
+};
+
+int64_t elapsed_ns(const struct timespec* start)
+{
+    struct timespec now, diff;
+    BoltTime_get_time(&now);
+    BoltTime_diff_time(&diff, &now, (struct timespec*) start);
+    return (int64_t) diff.tv_sec*1000000000+diff.tv_nsec;
+}
+
+void print_result(const char* name, const char* unit, const BoltHistogram* histogram, int first)
+{
+    printf("%s    {\"name\": \"%s\", \"unit\": \"%s\", \"count\": %" PRId64 ", \"mean\": %.1f, \"p50\": %" PRId64
+                    ", \"p99\": %" PRId64 ", \"max\": %" PRId64 "}", first ? "" : ",\n", name, unit, histogram->count,
+            histogram->count>0 ? (double) histogram->sum/(double) histogram->count : 0.0,
+            BoltHistogram_value_at_percentile(histogram, 50.0), BoltHistogram_value_at_percentile(histogram, 99.0),
+            histogram->max);
+}
+
+BoltConnection* acquire(struct BoltRoutingPool* pool, BoltAccessMode mode, BoltStatus* status)
+{
+    return BoltRoutingPool_acquire(pool, mode, status);
+}
+
+// Runs a trivial statement so that stale pooled connections towards dead members are detected
+int probe(BoltConnection* connection)
+{
+    const char* cypher = "RETURN 1";
+    BoltConnection_set_run_cypher(connection, cypher, strlen(cypher), 0);
+    BoltConnection_load_run_request(connection);
+    BoltConnection_load_pull_request(connection, -1);
+    BoltRequest pull = BoltConnection_last_request(connection);
+    return BoltConnection_send(connection)==BOLT_SUCCESS && BoltConnection_fetch_summary(connection, pull)>=0;
+}
+
+int bench_acquire(struct BoltRoutingPool* pool, BoltAccessMode mode, int64_t iterations, BoltHistogram* histogram)
+{
+    BoltStatus* status = BoltStatus_create();
+    for (int64_t i = 0; i<iterations; i++) {
+        struct timespec start;
+        BoltTime_get_time(&start);
+        BoltConnection* connection = acquire(pool, mode, status);
+        if (connection==NULL) {
+            fprintf(stderr, "acquire failed: %s\n", BoltError_get_string(status->error));
+            BoltStatus_destroy(status);
+            return 0;
+        }
+        BoltRoutingPool_release(pool, connection);
+        BoltHistogram_record(histogram, elapsed_ns(&start));
+    }
+    BoltStatus_destroy(status);
+    return 1;
+}
+
+void expire_routing_table(struct BoltRoutingPool* pool)
+{
+    BoltSync_rwlock_wrlock(&pool->rwlock);
+    pool->routing_table->expires = 0;
+    BoltSync_rwlock_wrunlock(&pool->rwlock);
+}
+
+int bench_refresh(struct BoltRoutingPool* pool, int64_t iterations, BoltHistogram* histogram)
+{
+    BoltStatus* status = BoltStatus_create();
+    for (int64_t i = 0; i<iterations; i++) {
+        expire_routing_table(pool);
+        struct timespec start;
+        BoltTime_get_time(&start);
+        BoltConnection* connection = acquire(pool, BOLT_ACCESS_MODE_READ, status);
+        if (connection==NULL) {
+            fprintf(stderr, "acquire failed: %s\n", BoltError_get_string(status->error));
+            BoltStatus_destroy(status);
+            return 0;
+        }
+        BoltRoutingPool_release(pool, connection);
+        BoltHistogram_record(histogram, elapsed_ns(&start));
+    }
+    BoltStatus_destroy(status);
+    return 1;
+}
+
+// Kills the leader, elects the next member and measures the time until a writer is usable again
+int bench_failover(struct StubCluster* cluster, struct BoltRoutingPool* pool, int32_t rounds, BoltHistogram* time,
+        BoltHistogram* attempts)
+{
+    BoltStatus* status = BoltStatus_create();
+    for (int32_t round = 0; round<rounds; round++) {
+        BoltConnection* connection = acquire(pool, BOLT_ACCESS_MODE_WRITE, status);
+        if (connection!=NULL) {
+            BoltRoutingPool_release(pool, connection);
+        }
+
+        int32_t old_leader = cluster->leader;
+        StubCluster_kill(cluster, old_leader);
+        StubCluster_set_leader(cluster, (old_leader+1)%cluster->size);
+        struct timespec start;
+        BoltTime_get_time(&start);
+
+        int64_t count = 0;
+        connection = NULL;
+        while (connection==NULL && elapsed_ns(&start)<(int64_t) FAILOVER_DEADLINE_MS*1000000) {
+            count++;
+            connection = acquire(pool, BOLT_ACCESS_MODE_WRITE, status);
+            if (connection!=NULL && !probe(connection)) {
+                BoltRoutingPool_release(pool, connection);
+                connection = NULL;
+            }
+        }
+        if (connection==NULL) {
+            fprintf(stderr, "failover did not complete: %s\n", BoltError_get_string(status->error));
+            BoltStatus_destroy(status);
+            return 0;
+        }
+        BoltHistogram_record(time, elapsed_ns(&start)/1000);
+        BoltHistogram_record(attempts, count);
+        BoltRoutingPool_release(pool, connection);
+
+        StubCluster_revive(cluster, old_leader);
+    }
+    BoltStatus_destroy(status);
+    return 1;
+}
+
+void app_help()
+{
+    fprintf(stderr, "seabolt-routing-bench [options]\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Measures routing pool acquisition against a simulated local cluster, printing JSON.\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  %-16s: Number of cluster members (Default: 3)\n", "-m <count>");
+    fprintf(stderr, "  %-16s: Acquisitions per access mode (Default: 10000)\n", "-n <count>");
+    fprintf(stderr, "  %-16s: Forced routing table refreshes (Default: 100)\n", "-r <count>");
+    fprintf(stderr, "  %-16s: Leader failovers (Default: 5)\n", "-f <count>");
+    fprintf(stderr, "  %-16s: Routing table time to live in seconds (Default: 300)\n", "-t <seconds>");
+    fprintf(stderr, "  %-16s: Member response latency in milliseconds (Default: 0)\n", "-l <ms>");
+    fprintf(stderr, "  %-16s: Circuit breaker failure threshold, 0 disables (Default: that of BoltConfig)\n", "-b <count>");
+}
+
+int main(int argc, char** argv)
+{
+    struct Benchmark bench = {3, 10000, 100, 5, 300, 0, -1};
+    for (int i = 1; i<argc; i++) {
+        if (i+1>=argc || argv[i][0]!='-' || strlen(argv[i])!=2) {
+            app_help();
+            exit(EXIT_FAILURE);
+        }
+        int64_t value = atoll(argv[++i]);
+        switch (argv[i-1][1]) {
+        case 'm':
+            bench.members = (int32_t) value;
+            break;
+        case 'n':
+            bench.iterations = value;
+            break;
+        case 'r':
+            bench.refreshes = value;
+            break;
+        case 'f':
+            bench.failovers = (int32_t) value;
+            break;
+        case 't':
+            bench.ttl = value;
+            break;
+        case 'l':
+            bench.latency = (int32_t) value;
+            break;
+        case 'b':
+            bench.breaker_threshold = (int32_t) value;
+            break;
+        default:
+            app_help();
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (bench.members<2) {
+        fprintf(stderr, "At least 2 members are required\n");
+        exit(EXIT_FAILURE);
+    }
+
+    struct StubCluster* cluster = StubCluster_create(bench.members, bench.ttl);
+    if (cluster==NULL) {
+        exit(EXIT_FAILURE);
+    }
+    for (int32_t i = 0; i<bench.members; i++) {
+        StubCluster_set_latency(cluster, i, bench.latency);
+    }
+
+    char port[16];
+    snprintf(port, sizeof(port), "%d", cluster->members[0].port);
+    BoltAddress* address = BoltAddress_create("127.0.0.1", port);
+    BoltValue* auth_token = BoltAuth_none();
+    BoltConfig* config = BoltConfig_create();
+    BoltConfig_set_scheme(config, BOLT_SCHEME_NEO4J);
+    BoltConfig_set_transport(config, BOLT_TRANSPORT_PLAINTEXT);
+    BoltConfig_set_user_agent(config, "seabolt-routing-bench/" SEABOLT_VERSION);
+    BoltConfig_set_max_pool_size(config, 10);
+    if (bench.breaker_threshold>=0) {
+        BoltConfig_set_circuit_breaker_threshold(config, bench.breaker_threshold);
+    }
+    BoltConnector* connector = BoltConnector_create(address, auth_token, config);
+    struct BoltRoutingPool* pool = (struct BoltRoutingPool*) connector->pool_state;
+
+    BoltHistogram acquire_read, acquire_write, refresh, failover_time, failover_attempts;
+    BoltHistogram_init(&acquire_read);
+    BoltHistogram_init(&acquire_write);
+    BoltHistogram_init(&refresh);
+    BoltHistogram_init(&failover_time);
+    BoltHistogram_init(&failover_attempts);
+
+    int status = bench_acquire(pool, BOLT_ACCESS_MODE_READ, 1, &refresh)
+            && bench_acquire(pool, BOLT_ACCESS_MODE_READ, bench.iterations, &acquire_read)
+            && bench_acquire(pool, BOLT_ACCESS_MODE_WRITE, bench.iterations, &acquire_write);
+    BoltHistogram_init(&refresh);
+    status = status && bench_refresh(pool, bench.refreshes, &refresh)
+            && bench_failover(cluster, pool, bench.failovers, &failover_time, &failover_attempts);
+
+    if (status) {
+        printf("{\n  \"members\": %d,\n  \"latency_ms\": %d,\n  \"routing_requests\": %" PRId64 ",\n"
+               "  \"results\": [\n", bench.members, bench.latency, cluster->routing_requests);
+        print_result("acquire_read", "ns", &acquire_read, 1);
+        print_result("acquire_write", "ns", &acquire_write, 0);
+        print_result("refresh_acquire", "ns", &refresh, 0);
+        print_result("failover_time", "us", &failover_time, 0);
+        print_result("failover_attempts", "acquisitions", &failover_attempts, 0);
+        printf("\n  ]\n}\n");
+    }
+
+    BoltConnector_destroy(connector);
+    BoltConfig_destroy(config);
+    BoltValue_destroy(auth_token);
+    BoltAddress_destroy(address);
+    StubCluster_destroy(cluster);
+    return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
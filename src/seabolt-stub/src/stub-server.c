@@ -0,0 +1,904 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#if USE_OPENSSL
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
+
+#include "bolt/atomic.h"
+#include "bolt/buffering.h"
+#include "bolt/packstream.h"
+#include "bolt/v3.h"
+
+#include "stub-server.h"
+
+#define UNUSED(x) (void)(x)
+
+#define STUB_MAX_CHUNK_SIZE 0xFFFF
+#define STUB_FLUSH_THRESHOLD 65536
+#define STUB_POLL_INTERVAL 100
+#define STUB_MAX_LINE 4096
+
+struct StubConnection {
+    struct StubServer* server;
+    int socket;
+#if USE_OPENSSL
+    SSL* ssl;
+#endif
+    int64_t id;
+    int failed;
+    const struct StubRule* rule;
+    /// Record produced by the server's handler, sent on the next PULL_ALL
+    struct BoltValue* handled_record;
+    struct BoltBuffer* message;
+    struct BoltBuffer* tx;
+};
+
+char* _duplicate(const char* string, size_t length)
+{
+    char* copy = malloc(length+1);
+    memcpy(copy, string, length);
+    copy[length] = 0;
+    return copy;
+}
+
+void _destroy_fields(struct StubRule* rule)
+{
+    for (int32_t i = 0; i<rule->field_count; i++) {
+        free(rule->fields[i].name);
+    }
+    free(rule->fields);
+    rule->fields = NULL;
+    rule->field_count = 0;
+}
+
+struct StubRule* _rule_create(const char* statement)
+{
+    struct StubRule* rule = calloc(1, sizeof(struct StubRule));
+    rule->statement = statement==NULL ? NULL : _duplicate(statement, strlen(statement));
+    rule->record_count = 1;
+    rule->latency = -1;
+    StubRule_set_fields(rule, 1);
+    return rule;
+}
+
+void _rule_destroy(struct StubRule* rule)
+{
+    _destroy_fields(rule);
+    free(rule->statement);
+    free(rule->failure);
+    free(rule);
+}
+
+void StubRule_set_fields(struct StubRule* rule, int32_t count)
+{
+    _destroy_fields(rule);
+    rule->field_count = count;
+    rule->fields = calloc((size_t) count, sizeof(struct StubField));
+    for (int32_t i = 0; i<count; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), count==1 ? "x" : "x%d", i);
+        rule->fields[i].name = _duplicate(name, strlen(name));
+        rule->fields[i].type = STUB_INTEGER;
+    }
+}
+
+struct StubScript* StubScript_create()
+{
+    struct StubScript* script = calloc(1, sizeof(struct StubScript));
+    script->fallback = _rule_create(NULL);
+    return script;
+}
+
+void StubScript_destroy(struct StubScript* script)
+{
+    struct StubRule* rule = script->rules;
+    while (rule!=NULL) {
+        struct StubRule* next = rule->next;
+        _rule_destroy(rule);
+        rule = next;
+    }
+    _rule_destroy(script->fallback);
+    free(script);
+}
+
+struct StubRule* StubScript_add_rule(struct StubScript* script, const char* statement)
+{
+    struct StubRule* rule = _rule_create(statement);
+    if (script->last==NULL) {
+        script->rules = rule;
+    }
+    else {
+        script->last->next = rule;
+    }
+    script->last = rule;
+    return rule;
+}
+
+const struct StubRule* StubScript_match(const struct StubScript* script, const char* statement)
+{
+    for (const struct StubRule* rule = script->rules; rule!=NULL; rule = rule->next) {
+        if (rule->statement==NULL || strncmp(statement, rule->statement, strlen(rule->statement))==0) {
+            return rule;
+        }
+    }
+    return script->fallback;
+}
+
+// Splits the next whitespace separated, optionally double quoted, token off the line
+char* _next_token(char** line)
+{
+    char* cursor = *line;
+    while (isspace((unsigned char) *cursor)) {
+        cursor++;
+    }
+    if (*cursor==0) {
+        return NULL;
+    }
+
+    char* token = cursor;
+    if (*cursor=='"') {
+        token = ++cursor;
+        while (*cursor!=0 && *cursor!='"') {
+            cursor++;
+        }
+    }
+    else {
+        while (*cursor!=0 && !isspace((unsigned char) *cursor)) {
+            cursor++;
+        }
+    }
+    if (*cursor!=0) {
+        *cursor++ = 0;
+    }
+    *line = cursor;
+    return token;
+}
+
+int32_t _count_items(const char* list)
+{
+    int32_t count = 1;
+    for (const char* cursor = list; *cursor!=0; cursor++) {
+        count += *cursor==',';
+    }
+    return count;
+}
+
+int _parse_value_type(const char* type, struct StubField* field)
+{
+    if (strcmp(type, "null")==0) {
+        field->type = STUB_NULL;
+    }
+    else if (strcmp(type, "bool")==0) {
+        field->type = STUB_BOOLEAN;
+    }
+    else if (strcmp(type, "int")==0) {
+        field->type = STUB_INTEGER;
+    }
+    else if (strcmp(type, "float")==0) {
+        field->type = STUB_FLOAT;
+    }
+    else if (strncmp(type, "string", 6)==0) {
+        field->type = STUB_STRING;
+        field->size = type[6]==':' ? atoi(type+7) : 8;
+    }
+    else {
+        return 0;
+    }
+    return 1;
+}
+
+int _parse_rule(struct StubScript* script, char* line)
+{
+    char* statement = _next_token(&line);
+    if (statement==NULL) {
+        return 0;
+    }
+    struct StubRule* rule = StubScript_add_rule(script, strcmp(statement, "*")==0 ? NULL : statement);
+
+    char* option;
+    while ((option = _next_token(&line))!=NULL) {
+        char* value = strchr(option, '=');
+        if (value==NULL) {
+            return 0;
+        }
+        *value++ = 0;
+        if (strcmp(option, "fields")==0) {
+            int32_t count = _count_items(value);
+            struct StubField* previous = rule->fields;
+            int32_t previous_count = rule->field_count;
+            rule->fields = NULL;
+            rule->field_count = 0;
+            StubRule_set_fields(rule, count);
+            for (int32_t i = 0; i<count; i++) {
+                char* end = strchr(value, ',');
+                size_t length = end==NULL ? strlen(value) : (size_t) (end-value);
+                free(rule->fields[i].name);
+                rule->fields[i].name = _duplicate(value, length);
+                if (i<previous_count) {
+                    rule->fields[i].type = previous[i].type;
+                    rule->fields[i].size = previous[i].size;
+                }
+                value = end==NULL ? value+length : end+1;
+            }
+            for (int32_t i = 0; i<previous_count; i++) {
+                free(previous[i].name);
+            }
+            free(previous);
+        }
+        else if (strcmp(option, "values")==0) {
+            if (_count_items(value)!=rule->field_count) {
+                StubRule_set_fields(rule, _count_items(value));
+            }
+            for (int32_t i = 0; i<rule->field_count; i++) {
+                char* end = strchr(value, ',');
+                if (end!=NULL) {
+                    *end = 0;
+                }
+                if (!_parse_value_type(value, &rule->fields[i])) {
+                    return 0;
+                }
+                value = end==NULL ? value+strlen(value) : end+1;
+            }
+        }
+        else if (strcmp(option, "records")==0) {
+            rule->record_count = atoll(value);
+        }
+        else if (strcmp(option, "latency")==0) {
+            rule->latency = atoi(value);
+        }
+        else if (strcmp(option, "failure")==0) {
+            free(rule->failure);
+            rule->failure = _duplicate(value, strlen(value));
+        }
+        else {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int StubScript_load(struct StubScript* script, const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file==NULL) {
+        return -1;
+    }
+
+    char line[STUB_MAX_LINE];
+    int line_number = 0;
+    int status = 0;
+    while (status==0 && fgets(line, sizeof(line), file)!=NULL) {
+        line_number++;
+        char* cursor = line;
+        char* keyword = _next_token(&cursor);
+        if (keyword==NULL || keyword[0]=='#') {
+            continue;
+        }
+        if (strcmp(keyword, "latency")==0) {
+            char* value = _next_token(&cursor);
+            if (value==NULL) {
+                status = line_number;
+            }
+            else {
+                script->latency = atoi(value);
+            }
+        }
+        else if (strcmp(keyword, "on")!=0 || !_parse_rule(script, cursor)) {
+            status = line_number;
+        }
+    }
+    fclose(file);
+    return status;
+}
+
+int _any_structure(int16_t code)
+{
+    UNUSED(code);
+    return 1;
+}
+
+int _write_all(struct StubConnection* connection, const char* data, int size)
+{
+    while (size>0) {
+        int sent;
+#if USE_OPENSSL
+        if (connection->ssl!=NULL) {
+            sent = SSL_write(connection->ssl, data, size);
+        }
+        else
+#endif
+        {
+            sent = (int) send(connection->socket, data, (size_t) size, MSG_NOSIGNAL);
+        }
+        if (sent<=0) {
+            return 0;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return 1;
+}
+
+// Waits for data to arrive, returning 0 when the server is stopping
+int _wait_readable(struct StubConnection* connection)
+{
+#if USE_OPENSSL
+    if (connection->ssl!=NULL && SSL_pending(connection->ssl)>0) {
+        return 1;
+    }
+#endif
+    struct pollfd fd = {connection->socket, POLLIN, 0};
+    while (!connection->server->stopping) {
+        int ready = poll(&fd, 1, STUB_POLL_INTERVAL);
+        if (ready!=0) {
+            return ready>0 || errno==EINTR;
+        }
+    }
+    return 0;
+}
+
+int _has_pending_input(struct StubConnection* connection)
+{
+#if USE_OPENSSL
+    if (connection->ssl!=NULL && SSL_pending(connection->ssl)>0) {
+        return 1;
+    }
+#endif
+    struct pollfd fd = {connection->socket, POLLIN, 0};
+    return poll(&fd, 1, 0)>0;
+}
+
+int _read_exactly(struct StubConnection* connection, char* data, int size)
+{
+    while (size>0) {
+        if (!_wait_readable(connection)) {
+            return 0;
+        }
+        int received;
+#if USE_OPENSSL
+        if (connection->ssl!=NULL) {
+            received = SSL_read(connection->ssl, data, size);
+        }
+        else
+#endif
+        {
+            received = (int) recv(connection->socket, data, (size_t) size, 0);
+        }
+        if (received<=0) {
+            return 0;
+        }
+        data += received;
+        size -= received;
+    }
+    return 1;
+}
+
+int _flush(struct StubConnection* connection)
+{
+    int status = 1;
+    int size = BoltBuffer_unloadable(connection->tx);
+    if (size>0) {
+        status = _write_all(connection, BoltBuffer_unload_pointer(connection->tx, size), size);
+    }
+    BoltBuffer_compact(connection->tx);
+    return status;
+}
+
+// Appends the message held by the message buffer to the transmit buffer, split into chunks
+void _chunk_message(struct StubConnection* connection)
+{
+    int size;
+    while ((size = BoltBuffer_unloadable(connection->message))>0) {
+        int chunk_size = size>STUB_MAX_CHUNK_SIZE ? STUB_MAX_CHUNK_SIZE : size;
+        BoltBuffer_load_u16be(connection->tx, (uint16_t) chunk_size);
+        BoltBuffer_load(connection->tx, BoltBuffer_unload_pointer(connection->message, chunk_size), chunk_size);
+    }
+    BoltBuffer_load_u16be(connection->tx, 0);
+    BoltBuffer_compact(connection->message);
+}
+
+void _send_message(struct StubConnection* connection, int16_t code, struct BoltValue* field)
+{
+    load_structure_header(connection->message, code, (int8_t) (field==NULL ? 0 : 1));
+    if (field!=NULL) {
+        load(_any_structure, connection->message, field, NULL);
+    }
+    _chunk_message(connection);
+}
+
+void _send_success(struct StubConnection* connection, struct BoltValue* metadata)
+{
+    if (metadata==NULL) {
+        struct BoltValue* empty = BoltValue_create();
+        BoltValue_format_as_Dictionary(empty, 0);
+        _send_message(connection, BOLT_V3_SUCCESS, empty);
+        BoltValue_destroy(empty);
+    }
+    else {
+        _send_message(connection, BOLT_V3_SUCCESS, metadata);
+    }
+}
+
+void _set_entry(struct BoltValue* dictionary, int32_t index, const char* key, const char* value)
+{
+    BoltDictionary_set_key(dictionary, index, key, (int32_t) strlen(key));
+    BoltValue_format_as_String(BoltDictionary_value(dictionary, index), value, (int32_t) strlen(value));
+}
+
+void _generate_value(const struct StubField* field, int64_t seed, struct BoltValue* value)
+{
+    switch (field->type) {
+    case STUB_NULL:
+        BoltValue_format_as_Null(value);
+        break;
+    case STUB_BOOLEAN:
+        BoltValue_format_as_Boolean(value, (char) (seed%2));
+        break;
+    case STUB_INTEGER:
+        BoltValue_format_as_Integer(value, seed);
+        break;
+    case STUB_FLOAT:
+        BoltValue_format_as_Float(value, (double) seed/3.0);
+        break;
+    case STUB_STRING: {
+        char* string = malloc((size_t) field->size+1);
+        for (int32_t i = 0; i<field->size; i++) {
+            string[i] = (char) ('a'+(seed+i)%26);
+        }
+        BoltValue_format_as_String(value, string, field->size);
+        free(string);
+        break;
+    }
+    }
+}
+
+void _delay(const struct StubConnection* connection, const struct StubRule* rule)
+{
+    int latency = rule->latency>=0 ? rule->latency : connection->server->script->latency;
+    if (latency>0) {
+        usleep((useconds_t) latency*1000);
+    }
+}
+
+void _clear_result(struct StubConnection* connection)
+{
+    connection->rule = NULL;
+    BoltValue_destroy(connection->handled_record);
+    connection->handled_record = NULL;
+}
+
+int _handle_run_by_handler(struct StubConnection* connection, const char* statement)
+{
+    struct StubServer* server = connection->server;
+    if (server->handler==NULL) {
+        return 0;
+    }
+
+    struct BoltValue* fields = BoltValue_create();
+    struct BoltValue* record = BoltValue_create();
+    BoltValue_format_as_List(fields, 0);
+    BoltValue_format_as_List(record, 0);
+    if (!server->handler(server->handler_state, statement, fields, record)) {
+        BoltValue_destroy(fields);
+        BoltValue_destroy(record);
+        return 0;
+    }
+
+    _delay(connection, server->script->fallback);
+    struct BoltValue* metadata = BoltValue_create();
+    BoltValue_format_as_Dictionary(metadata, 1);
+    BoltDictionary_set_key(metadata, 0, "fields", 6);
+    BoltValue_copy(BoltDictionary_value(metadata, 0), fields);
+    _send_success(connection, metadata);
+    BoltValue_destroy(metadata);
+    BoltValue_destroy(fields);
+
+    _clear_result(connection);
+    connection->handled_record = record;
+    return 1;
+}
+
+void _handle_run(struct StubConnection* connection, struct BoltValue* request)
+{
+    struct BoltValue* statement = BoltStructure_value(request, 0);
+    char* text = _duplicate(BoltString_get(statement), (size_t) BoltValue_size(statement));
+    if (_handle_run_by_handler(connection, text)) {
+        free(text);
+        return;
+    }
+    const struct StubRule* rule = StubScript_match(connection->server->script, text);
+    free(text);
+    _clear_result(connection);
+
+    _delay(connection, rule);
+    if (rule->failure!=NULL) {
+        struct BoltValue* metadata = BoltValue_create();
+        BoltValue_format_as_Dictionary(metadata, 2);
+        _set_entry(metadata, 0, "code", rule->failure);
+        _set_entry(metadata, 1, "message", "failure requested by stub script");
+        _send_message(connection, BOLT_V3_FAILURE, metadata);
+        BoltValue_destroy(metadata);
+        connection->failed = 1;
+        return;
+    }
+
+    struct BoltValue* metadata = BoltValue_create();
+    BoltValue_format_as_Dictionary(metadata, 2);
+    BoltDictionary_set_key(metadata, 0, "fields", 6);
+    struct BoltValue* fields = BoltDictionary_value(metadata, 0);
+    BoltValue_format_as_List(fields, rule->field_count);
+    for (int32_t i = 0; i<rule->field_count; i++) {
+        BoltValue_format_as_String(BoltList_value(fields, i), rule->fields[i].name,
+                (int32_t) strlen(rule->fields[i].name));
+    }
+    BoltDictionary_set_key(metadata, 1, "t_first", 7);
+    BoltValue_format_as_Integer(BoltDictionary_value(metadata, 1), 0);
+    _send_success(connection, metadata);
+    BoltValue_destroy(metadata);
+    connection->rule = rule;
+}
+
+void _handle_pull_all(struct StubConnection* connection)
+{
+    const struct StubRule* rule = connection->rule;
+    connection->rule = NULL;
+    if (connection->handled_record!=NULL) {
+        _send_message(connection, BOLT_V3_RECORD, connection->handled_record);
+        BoltValue_destroy(connection->handled_record);
+        connection->handled_record = NULL;
+    }
+    else if (rule!=NULL && rule->record_count>0) {
+        // every record carries identical values, so the encoded message is built once and replayed
+        struct BoltValue* record = BoltValue_create();
+        BoltValue_format_as_List(record, rule->field_count);
+        for (int32_t i = 0; i<rule->field_count; i++) {
+            _generate_value(&rule->fields[i], i+1, BoltList_value(record, i));
+        }
+        int offset = BoltBuffer_unloadable(connection->tx);
+        _send_message(connection, BOLT_V3_RECORD, record);
+        BoltValue_destroy(record);
+
+        int record_size = BoltBuffer_unloadable(connection->tx)-offset;
+        char* encoded = malloc((size_t) record_size);
+        memcpy(encoded, connection->tx->data+connection->tx->cursor+offset, (size_t) record_size);
+        for (int64_t i = 1; i<rule->record_count; i++) {
+            if (BoltBuffer_unloadable(connection->tx)>=STUB_FLUSH_THRESHOLD && !_flush(connection)) {
+                break;
+            }
+            BoltBuffer_load(connection->tx, encoded, record_size);
+        }
+        free(encoded);
+    }
+
+    struct BoltValue* metadata = BoltValue_create();
+    BoltValue_format_as_Dictionary(metadata, 2);
+    BoltDictionary_set_key(metadata, 0, "t_last", 6);
+    BoltValue_format_as_Integer(BoltDictionary_value(metadata, 0), 0);
+    _set_entry(metadata, 1, "type", "rw");
+    _send_success(connection, metadata);
+    BoltValue_destroy(metadata);
+}
+
+// Handles a single request, returning 0 when the connection should be closed
+int _handle_request(struct StubConnection* connection, struct BoltValue* request)
+{
+    int16_t code = BoltStructure_code(request);
+    if (code==BOLT_V3_GOODBYE) {
+        return 0;
+    }
+    if (code==BOLT_V3_RESET) {
+        connection->failed = 0;
+        _clear_result(connection);
+        _send_success(connection, NULL);
+        return 1;
+    }
+    if (connection->failed) {
+        _send_message(connection, BOLT_V3_IGNORED, NULL);
+        return 1;
+    }
+
+    switch (code) {
+    case BOLT_V3_HELLO: {
+        char id[32];
+        snprintf(id, sizeof(id), "bolt-%" PRId64, connection->id);
+        struct BoltValue* metadata = BoltValue_create();
+        BoltValue_format_as_Dictionary(metadata, 2);
+        _set_entry(metadata, 0, "server", "Neo4j/3.5.0");
+        _set_entry(metadata, 1, "connection_id", id);
+        _send_success(connection, metadata);
+        BoltValue_destroy(metadata);
+        break;
+    }
+    case BOLT_V3_RUN:
+        _handle_run(connection, request);
+        break;
+    case BOLT_V3_PULL_ALL:
+        _handle_pull_all(connection);
+        break;
+    case BOLT_V3_DISCARD_ALL:
+        _clear_result(connection);
+        _send_success(connection, NULL);
+        break;
+    case BOLT_V3_COMMIT: {
+        struct BoltValue* metadata = BoltValue_create();
+        BoltValue_format_as_Dictionary(metadata, 1);
+        _set_entry(metadata, 0, "bookmark", "stub:1");
+        _send_success(connection, metadata);
+        BoltValue_destroy(metadata);
+        break;
+    }
+    case BOLT_V3_BEGIN:
+    case BOLT_V3_ROLLBACK:
+        _send_success(connection, NULL);
+        break;
+    default:
+        return 0;
+    }
+    return 1;
+}
+
+// Reads the next complete message into the message buffer
+int _read_message(struct StubConnection* connection)
+{
+    while (1) {
+        char header[2];
+        if (!_read_exactly(connection, header, 2)) {
+            return 0;
+        }
+        int size = ((uint8_t) header[0]) << 8 | (uint8_t) header[1];
+        if (size==0) {
+            if (BoltBuffer_unloadable(connection->message)>0) {
+                return 1;
+            }
+            continue;
+        }
+        if (!_read_exactly(connection, BoltBuffer_load_pointer(connection->message, size), size)) {
+            return 0;
+        }
+    }
+}
+
+int _handshake(struct StubConnection* connection)
+{
+    char handshake[20];
+    if (!_read_exactly(connection, handshake, sizeof(handshake))) {
+        return 0;
+    }
+
+    const char magic[4] = {0x60, 0x60, (char) 0xB0, 0x17};
+    int supported = memcmp(handshake, magic, sizeof(magic))==0;
+    int agreed = 0;
+    for (int i = 1; supported && i<5; i++) {
+        if (handshake[4*i]==0 && handshake[4*i+1]==0 && handshake[4*i+2]==0 && handshake[4*i+3]==3) {
+            agreed = 3;
+            break;
+        }
+    }
+    const char response[4] = {0, 0, 0, (char) agreed};
+    return _write_all(connection, response, sizeof(response)) && agreed!=0;
+}
+
+void* _serve(void* arg)
+{
+    struct StubConnection* connection = (struct StubConnection*) arg;
+    struct BoltValue* request = BoltValue_create();
+
+    int open = 1;
+#if USE_OPENSSL
+    if (connection->ssl!=NULL) {
+        open = SSL_accept(connection->ssl)==1;
+    }
+#endif
+    open = open && _handshake(connection);
+    while (open && _read_message(connection)) {
+        if (unload(_any_structure, connection->message, request, NULL)!=BOLT_SUCCESS
+                || BoltValue_type(request)!=BOLT_STRUCTURE) {
+            break;
+        }
+        BoltBuffer_compact(connection->message);
+        open = _handle_request(connection, request);
+        // keep replies to pipelined requests together
+        if (!open || BoltBuffer_unloadable(connection->tx)>=STUB_FLUSH_THRESHOLD || !_has_pending_input(connection)) {
+            open = _flush(connection) && open;
+        }
+    }
+    _flush(connection);
+
+    BoltValue_destroy(request);
+    _clear_result(connection);
+#if USE_OPENSSL
+    if (connection->ssl!=NULL) {
+        SSL_shutdown(connection->ssl);
+        SSL_free(connection->ssl);
+    }
+#endif
+    close(connection->socket);
+    BoltBuffer_destroy(connection->message);
+    BoltBuffer_destroy(connection->tx);
+    BoltAtomic_decrement(&connection->server->active_connections);
+    free(connection);
+    return NULL;
+}
+
+#if USE_OPENSSL
+
+// Creates a server context with a freshly generated key and self-signed certificate for localhost
+SSL_CTX* _create_tls_context()
+{
+    SSL_CTX* context = SSL_CTX_new(TLS_server_method());
+    EVP_PKEY* key = NULL;
+    EVP_PKEY_CTX* key_context = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, NULL);
+    X509* certificate = X509_new();
+    int status = context!=NULL && key_context!=NULL && certificate!=NULL
+            && EVP_PKEY_keygen_init(key_context)>0
+            && EVP_PKEY_CTX_set_rsa_keygen_bits(key_context, 2048)>0
+            && EVP_PKEY_keygen(key_context, &key)>0;
+    if (status) {
+        X509_set_version(certificate, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 365L*24*60*60);
+        X509_set_pubkey(certificate, key);
+        X509_NAME* name = X509_get_subject_name(certificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*) "localhost", -1, -1, 0);
+        X509_set_issuer_name(certificate, name);
+        status = X509_sign(certificate, key, EVP_sha256())>0
+                && SSL_CTX_use_certificate(context, certificate)==1
+                && SSL_CTX_use_PrivateKey(context, key)==1;
+    }
+
+    X509_free(certificate);
+    EVP_PKEY_free(key);
+    EVP_PKEY_CTX_free(key_context);
+    if (!status) {
+        ERR_print_errors_fp(stderr);
+        SSL_CTX_free(context);
+        return NULL;
+    }
+    return context;
+}
+
+#endif
+
+struct StubServer* StubServer_create(const struct StubScript* script, int port, int secure)
+{
+    struct StubServer* server = calloc(1, sizeof(struct StubServer));
+    server->script = script;
+    server->socket = -1;
+
+    if (secure) {
+#if USE_OPENSSL
+        server->tls_context = _create_tls_context();
+#endif
+        if (server->tls_context==NULL) {
+            fprintf(stderr, "Unable to set up TLS\n");
+            StubServer_destroy(server);
+            return NULL;
+        }
+    }
+
+    server->socket = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(server->socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t) port);
+    socklen_t address_size = sizeof(address);
+    if (bind(server->socket, (struct sockaddr*) &address, address_size)!=0 || listen(server->socket, 128)!=0
+            || getsockname(server->socket, (struct sockaddr*) &address, &address_size)!=0) {
+        fprintf(stderr, "Unable to listen on port %d: %s\n", port, strerror(errno));
+        StubServer_destroy(server);
+        return NULL;
+    }
+    server->port = ntohs(address.sin_port);
+    return server;
+}
+
+void StubServer_run(struct StubServer* server)
+{
+    struct pollfd fd = {server->socket, POLLIN, 0};
+    while (!server->stopping) {
+        if (poll(&fd, 1, STUB_POLL_INTERVAL)<=0) {
+            continue;
+        }
+        int socket = accept(server->socket, NULL, NULL);
+        if (socket<0) {
+            continue;
+        }
+        int no_delay = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+        struct StubConnection* connection = calloc(1, sizeof(struct StubConnection));
+        connection->server = server;
+        connection->socket = socket;
+        connection->id = BoltAtomic_increment(&server->connection_seq);
+        connection->message = BoltBuffer_create(8192);
+        connection->tx = BoltBuffer_create(STUB_FLUSH_THRESHOLD);
+#if USE_OPENSSL
+        if (server->tls_context!=NULL) {
+            connection->ssl = SSL_new((SSL_CTX*) server->tls_context);
+            SSL_set_fd(connection->ssl, socket);
+        }
+#endif
+
+        BoltAtomic_increment(&server->active_connections);
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, _serve, connection)!=0) {
+            _serve(connection);
+        }
+        else {
+            pthread_detach(thread);
+        }
+    }
+}
+
+void StubServer_set_handler(struct StubServer* server, stub_run_handler handler, void* state)
+{
+    server->handler_state = state;
+    server->handler = handler;
+}
+
+void* _run(void* arg)
+{
+    StubServer_run((struct StubServer*) arg);
+    return NULL;
+}
+
+int StubServer_start(struct StubServer* server)
+{
+    server->started = pthread_create(&server->thread, NULL, _run, server)==0;
+    return server->started;
+}
+
+void StubServer_destroy(struct StubServer* server)
+{
+    server->stopping = 1;
+    if (server->started) {
+        pthread_join(server->thread, NULL);
+    }
+    // connection threads notice the stop flag within a poll interval
+    while (BoltAtomic_add(&server->active_connections, 0)>0) {
+        usleep(STUB_POLL_INTERVAL*1000);
+    }
+    if (server->socket>=0) {
+        close(server->socket);
+    }
+#if USE_OPENSSL
+    SSL_CTX_free((SSL_CTX*) server->tls_context);
+#endif
+    free(server);
+}
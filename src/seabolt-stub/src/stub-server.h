@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_STUB_SERVER_H
+#define SEABOLT_STUB_SERVER_H
+
+#include "bolt/bolt.h"
+#include <pthread.h>
+
+enum StubValueType {
+    STUB_NULL,
+    STUB_BOOLEAN,
+    STUB_INTEGER,
+    STUB_FLOAT,
+    STUB_STRING,
+};
+
+/**
+ * A result column, with the type of the value generated for it in each record.
+ */
+struct StubField {
+    char* name;
+    enum StubValueType type;
+    /// Length of generated string values
+    int32_t size;
+};
+
+/**
+ * Describes the response to RUN messages whose statement starts with a given prefix.
+ */
+struct StubRule {
+    /// Statement prefix to match, NULL matches any statement
+    char* statement;
+    int32_t field_count;
+    struct StubField* fields;
+    int64_t record_count;
+    /// Delay in milliseconds before responding to RUN, -1 to use the script's default
+    int32_t latency;
+    /// Neo4j status code to fail with, NULL to succeed
+    char* failure;
+    struct StubRule* next;
+};
+
+/**
+ * Ordered list of rules, the first matching rule wins.
+ */
+struct StubScript {
+    int32_t latency;
+    struct StubRule* rules;
+    struct StubRule* last;
+    /// Response to statements no rule matches
+    struct StubRule* fallback;
+};
+
+struct StubScript* StubScript_create();
+
+void StubScript_destroy(struct StubScript* script);
+
+/**
+ * Appends a rule which, by default, returns a single record with a single integer column named "x".
+ */
+struct StubRule* StubScript_add_rule(struct StubScript* script, const char* statement);
+
+void StubRule_set_fields(struct StubRule* rule, int32_t count);
+
+/**
+ * Loads rules from a script file. Each non-empty line not starting with '#' is either
+ *
+ *     latency <ms>
+ *
+ * setting the default latency, or a rule
+ *
+ *     on <statement prefix>|* [fields=a,b,...] [values=int,float,bool,null,string:<size>,...]
+ *        [records=<count>] [latency=<ms>] [failure=<code>]
+ *
+ * where a statement prefix containing spaces is given in double quotes.
+ *
+ * @returns 0 on success, or the number of the offending line.
+ */
+int StubScript_load(struct StubScript* script, const char* path);
+
+const struct StubRule* StubScript_match(const struct StubScript* script, const char* statement);
+
+/**
+ * Callback answering a RUN outside of the script, with a single record.
+ *
+ * Invoked on connection threads concurrently, implementations synchronise access to their state.
+ *
+ * @param state the state passed to \ref StubServer_set_handler.
+ * @param statement the statement of the RUN message.
+ * @param fields the list of result column names to be filled in.
+ * @param record the list of values of the single result record to be filled in.
+ * @returns 1 if the statement was answered, 0 to answer from the script.
+ */
+typedef int (* stub_run_handler)(void* state, const char* statement, struct BoltValue* fields,
+        struct BoltValue* record);
+
+/**
+ * A Bolt v3 server answering from a \ref StubScript, serving each connection on its own thread.
+ */
+struct StubServer {
+    const struct StubScript* script;
+    stub_run_handler handler;
+    void* handler_state;
+    int port;
+    int socket;
+    void* tls_context;
+    pthread_t thread;
+    int started;
+    volatile int64_t active_connections;
+    volatile int stopping;
+    volatile int64_t connection_seq;
+};
+
+/**
+ * Creates a server listening on localhost.
+ *
+ * @param script the script to answer from, must outlive the server.
+ * @param port the port to listen on, 0 to pick a free port.
+ * @param secure non-zero to serve TLS with a generated self-signed certificate.
+ */
+struct StubServer* StubServer_create(const struct StubScript* script, int port, int secure);
+
+void StubServer_set_handler(struct StubServer* server, stub_run_handler handler, void* state);
+
+/**
+ * Starts accepting connections on a background thread.
+ */
+int StubServer_start(struct StubServer* server);
+
+/**
+ * Accepts and serves connections on the calling thread, until stopped.
+ */
+void StubServer_run(struct StubServer* server);
+
+void StubServer_destroy(struct StubServer* server);
+
+#endif //SEABOLT_STUB_SERVER_H
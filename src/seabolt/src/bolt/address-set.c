@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_ROUTING
+
 #include "bolt-private.h"
 #include "address-private.h"
 #include "address-set-private.h"
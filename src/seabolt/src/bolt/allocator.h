@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_ALLOCATOR_H
+#define SEABOLT_ALLOCATOR_H
+
+#include "bolt-public.h"
+
+/**
+ * The allocation function signature, to be provided along with \ref reallocate_func and \ref deallocate_func
+ * to route the memory allocated by the connector to a custom allocator.
+ *
+ * @param state the state object as provided to \ref BoltAllocator_set
+ * @param size the number of bytes to allocate
+ * @returns a pointer to the allocated memory, aligned for any type.
+ */
+typedef void* (* allocate_func)(void* state, size_t size);
+
+/**
+ * The reallocation function signature, see \ref allocate_func.
+ *
+ * @param state the state object as provided to \ref BoltAllocator_set
+ * @param ptr the memory to be resized, as returned by one of the custom functions
+ * @param old_size the size the memory was last allocated with
+ * @param new_size the number of bytes required
+ * @returns a pointer to the resized memory, holding the contents of the old memory up to the lesser of the sizes.
+ */
+typedef void* (* reallocate_func)(void* state, void* ptr, size_t old_size, size_t new_size);
+
+/**
+ * The deallocation function signature, see \ref allocate_func.
+ *
+ * @param state the state object as provided to \ref BoltAllocator_set
+ * @param ptr the memory to be freed, as returned by one of the custom functions
+ * @param size the size the memory was last allocated with
+ */
+typedef void (* deallocate_func)(void* state, void* ptr, size_t size);
+
+/**
+ * Routes all memory that the connector allocates through the passed functions instead of malloc, realloc and
+ * free, so that it can be served by other allocators or memory pools. The functions must be thread safe.
+ *
+ * Must be called before \ref Bolt_startup and before any other connector function is invoked, as memory
+ * allocated by one allocator cannot be freed by another. Memory allocated internally by third party libraries,
+ * like OpenSSL, is not affected. Passing NULL for all three functions restores malloc, realloc and free.
+ *
+ * @param allocate the function allocating memory.
+ * @param reallocate the function resizing memory.
+ * @param deallocate the function freeing memory.
+ * @param state an optional object that will be passed to the provided functions.
+ * @returns \ref BOLT_SUCCESS, \ref BOLT_ALLOCATOR_INCOMPLETE if only some of the functions are NULL, or
+ * \ref BOLT_ALLOCATOR_IN_USE if the connector has already allocated memory.
+ */
+SEABOLT_EXPORT int32_t
+BoltAllocator_set(allocate_func allocate, reallocate_func reallocate, deallocate_func deallocate, void* state);
+
+#endif //SEABOLT_ALLOCATOR_H
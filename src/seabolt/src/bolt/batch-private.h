@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_BATCH_PRIVATE_H
+#define SEABOLT_BATCH_PRIVATE_H
+
+#include "batch.h"
+#include "buffering.h"
+
+struct BoltBatchInFlight {
+    /// The PULL request of the batch
+    BoltRequest request;
+    int32_t rows;
+};
+
+struct BoltBatch {
+    BoltConnection* connection;
+    const BoltStatement* statement;
+
+    int32_t max_rows;
+    int32_t max_bytes;
+    int32_t max_in_flight;
+
+    /// The parameter map header and key, followed by the list header when a batch is sent
+    struct BoltBuffer* header;
+    int32_t key_size;
+    /// Writes the rows, after space reserved for the header so that the parameters are sent without copying
+    BoltWriter* writer;
+    int32_t reserved;
+    /// End of the last complete row
+    int32_t rows_end;
+    int32_t rows;
+
+    /// Ring of the batches awaiting their results, oldest first
+    struct BoltBatchInFlight* in_flight;
+    int32_t in_flight_first;
+    int32_t in_flight_count;
+
+    int64_t rows_completed;
+    /// The error of the first failed batch, if any
+    int32_t error;
+};
+
+#endif //SEABOLT_BATCH_PRIVATE_H
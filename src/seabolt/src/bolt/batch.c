@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_PROTOCOL
+
+#include "bolt-private.h"
+#include "batch-private.h"
+#include "connection-private.h"
+#include "mem.h"
+#include "packstream.h"
+#include "writer-private.h"
+
+// The list header is written in front of the rows when a batch is sent, and takes at most 5 bytes
+#define MAX_LIST_HEADER_SIZE 5
+
+static void _start_batch(BoltBatch* batch)
+{
+    BoltWriter_rewind(batch->writer, 0);
+    BoltBuffer_load_pointer(batch->writer->buffer, batch->reserved);
+    batch->rows_end = batch->reserved;
+    batch->rows = 0;
+}
+
+BoltBatch* BoltBatch_create(BoltConnection* connection, const BoltStatement* statement,
+        const char* parameter, int32_t parameter_size)
+{
+    BoltBatch* batch = BoltMem_allocate(sizeof(BoltBatch));
+    batch->connection = connection;
+    batch->statement = statement;
+    batch->max_rows = 1000;
+    batch->max_bytes = 1024*1024;
+    batch->max_in_flight = 2;
+
+    batch->header = BoltBuffer_create(parameter_size+16);
+    load_map_header(batch->header, 1);
+    load_string(batch->header, parameter, parameter_size);
+    batch->key_size = batch->header->extent;
+    batch->reserved = batch->key_size+MAX_LIST_HEADER_SIZE;
+    batch->writer = BoltWriter_create_with_check(connection->protocol->check_writable_struct);
+    _start_batch(batch);
+
+    batch->in_flight = BoltMem_allocate(batch->max_in_flight*sizeof(struct BoltBatchInFlight));
+    batch->in_flight_first = 0;
+    batch->in_flight_count = 0;
+    batch->rows_completed = 0;
+    batch->error = BOLT_SUCCESS;
+    return batch;
+}
+
+void BoltBatch_destroy(BoltBatch* batch)
+{
+    if (batch==NULL) return;
+
+    BoltBuffer_destroy(batch->header);
+    BoltWriter_destroy(batch->writer);
+    BoltMem_deallocate(batch->in_flight, batch->max_in_flight*sizeof(struct BoltBatchInFlight));
+    BoltMem_deallocate(batch, sizeof(BoltBatch));
+}
+
+int32_t BoltBatch_set_max_rows(BoltBatch* batch, int32_t max_rows)
+{
+    if (max_rows<0) return BOLT_PROTOCOL_VIOLATION;
+    batch->max_rows = max_rows;
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltBatch_set_max_bytes(BoltBatch* batch, int32_t max_bytes)
+{
+    if (max_bytes<0) return BOLT_PROTOCOL_VIOLATION;
+    batch->max_bytes = max_bytes;
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltBatch_set_max_in_flight(BoltBatch* batch, int32_t max_in_flight)
+{
+    if (max_in_flight<1 || batch->in_flight_count>0) return BOLT_PROTOCOL_VIOLATION;
+    batch->in_flight = BoltMem_reallocate(batch->in_flight, batch->max_in_flight*sizeof(struct BoltBatchInFlight),
+            max_in_flight*sizeof(struct BoltBatchInFlight));
+    batch->max_in_flight = max_in_flight;
+    batch->in_flight_first = 0;
+    return BOLT_SUCCESS;
+}
+
+// Waits for the result of the oldest batch in flight
+static int32_t _complete_oldest(BoltBatch* batch)
+{
+    struct BoltBatchInFlight* oldest = &batch->in_flight[batch->in_flight_first];
+    batch->in_flight_first = (batch->in_flight_first+1)%batch->max_in_flight;
+    batch->in_flight_count -= 1;
+    if (batch->error!=BOLT_SUCCESS) {
+        // the server ignores everything after a failure, and the connection may be unusable
+        return batch->error;
+    }
+
+    if (BoltConnection_fetch_summary(batch->connection, oldest->request)<0) {
+        batch->error = batch->connection->status->error;
+    }
+    else if (!BoltConnection_summary_success(batch->connection)) {
+        batch->error = BOLT_SERVER_FAILURE;
+    }
+    else {
+        batch->rows_completed += oldest->rows;
+    }
+    return batch->error;
+}
+
+BoltWriter* BoltBatch_begin_row(BoltBatch* batch)
+{
+    BoltWriter_rewind(batch->writer, batch->rows_end);
+    return batch->writer;
+}
+
+int32_t BoltBatch_end_row(BoltBatch* batch)
+{
+    if (batch->error!=BOLT_SUCCESS) return batch->error;
+    if (!BoltWriter_complete(batch->writer)) return BOLT_PROTOCOL_VIOLATION;
+
+    batch->rows_end = batch->writer->buffer->extent;
+    batch->rows += 1;
+    if ((batch->max_rows>0 && batch->rows>=batch->max_rows)
+            || (batch->max_bytes>0 && batch->rows_end-batch->reserved>=batch->max_bytes)) {
+        return BoltBatch_flush(batch);
+    }
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltBatch_flush(BoltBatch* batch)
+{
+    if (batch->error!=BOLT_SUCCESS) return batch->error;
+    if (batch->rows==0) return BOLT_SUCCESS;
+
+    if (batch->in_flight_count==batch->max_in_flight && _complete_oldest(batch)!=BOLT_SUCCESS) {
+        return batch->error;
+    }
+
+    // the parameter map is completed in the space reserved in front of the rows
+    batch->header->extent = batch->key_size;
+    load_list_header(batch->header, batch->rows);
+    int32_t start = batch->reserved-batch->header->extent;
+    char* parameters = batch->writer->buffer->data+start;
+    memcpy(parameters, batch->header->data, (size_t) batch->header->extent);
+
+    BoltConnection* connection = batch->connection;
+    int32_t status = BoltConnection_set_run_statement(connection, batch->statement, 0);
+    if (status==BOLT_SUCCESS) {
+        status = BoltConnection_set_run_encoded_parameters(connection, parameters, batch->rows_end-start);
+    }
+    if (status==BOLT_SUCCESS) {
+        status = BoltConnection_load_run_request(connection);
+    }
+    if (status==BOLT_SUCCESS) {
+        status = BoltConnection_load_pull_request(connection, -1);
+    }
+    if (status==BOLT_SUCCESS) {
+        status = BoltConnection_send(connection);
+    }
+    if (status!=BOLT_SUCCESS) {
+        batch->error = status<0 || status==BOLT_STATUS_SET ? connection->status->error : status;
+        return batch->error;
+    }
+
+    int32_t index = (batch->in_flight_first+batch->in_flight_count)%batch->max_in_flight;
+    batch->in_flight[index].request = BoltConnection_last_request(connection);
+    batch->in_flight[index].rows = batch->rows;
+    batch->in_flight_count += 1;
+    _start_batch(batch);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltBatch_finish(BoltBatch* batch)
+{
+    int32_t status = BoltBatch_flush(batch);
+    while (batch->in_flight_count>0) {
+        int32_t completed = _complete_oldest(batch);
+        if (status==BOLT_SUCCESS) {
+            status = completed;
+        }
+    }
+    return status;
+}
+
+int64_t BoltBatch_rows_completed(BoltBatch* batch)
+{
+    return batch->rows_completed;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_BATCH_H
+#define SEABOLT_BATCH_H
+
+#include "bolt-public.h"
+#include "connection.h"
+#include "statement.h"
+#include "writer.h"
+
+/**
+ * The type that loads rows in bulk, by running a statement such as
+ *
+ *     UNWIND $rows AS row CREATE (:Person {name: row.name})
+ *
+ * once per batch of rows. Rows are encoded one at a time straight into the list parameter, and a RUN and PULL
+ * are sent as soon as a batch holds the configured number of rows or bytes. Batches are pipelined: the next batch
+ * is encoded while earlier ones are still being processed by the server, and the application only waits when the
+ * configured number of batches is in flight.
+ *
+ * Each batch runs in its own auto-commit transaction, or in the explicit transaction currently open on the
+ * connection. The RUN bookmarks, transaction metadata and timeout set on the connection are used for every batch.
+ *
+ * An instance needs to be destroyed with \ref BoltBatch_destroy when it's no longer needed.
+ */
+typedef struct BoltBatch BoltBatch;
+
+/**
+ * Creates a new instance of \ref BoltBatch, which loads rows through an open and initialised connection.
+ *
+ * By default a batch is sent once it holds 1000 rows or 1 MiB of encoded rows, and up to 2 batches are kept in
+ * flight.
+ *
+ * @param connection the connection to run the statement on, which must outlive the batch.
+ * @param statement the statement to run for each batch, which must outlive the batch.
+ * @param parameter the name of the list parameter the statement expects the rows in.
+ * @param parameter_size the size of the parameter name.
+ * @returns the pointer to the newly allocated \ref BoltBatch instance.
+ */
+SEABOLT_EXPORT BoltBatch* BoltBatch_create(BoltConnection* connection, const BoltStatement* statement,
+        const char* parameter, int32_t parameter_size);
+
+/**
+ * Destroys the passed \ref BoltBatch instance. Rows that have not been sent are discarded, call
+ * \ref BoltBatch_finish first to send them.
+ *
+ * @param batch the instance to be destroyed.
+ */
+SEABOLT_EXPORT void BoltBatch_destroy(BoltBatch* batch);
+
+/**
+ * Sets the number of rows after which a batch is sent.
+ *
+ * @param batch the instance to modify.
+ * @param max_rows the maximum number of rows per batch, 0 for no limit.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltBatch_set_max_rows(BoltBatch* batch, int32_t max_rows);
+
+/**
+ * Sets the encoded size of the rows after which a batch is sent.
+ *
+ * @param batch the instance to modify.
+ * @param max_bytes the maximum number of bytes per batch, 0 for no limit.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltBatch_set_max_bytes(BoltBatch* batch, int32_t max_bytes);
+
+/**
+ * Sets the number of batches sent before waiting for the result of the oldest one. Can only be changed while no
+ * batches are in flight.
+ *
+ * @param batch the instance to modify.
+ * @param max_in_flight the maximum number of unacknowledged batches, at least 1.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltBatch_set_max_in_flight(BoltBatch* batch, int32_t max_in_flight);
+
+/**
+ * Starts a new row, discarding any incomplete row written before. The row is written as exactly one value,
+ * usually a map, e.g.
+ *
+ *     BoltWriter* row = BoltBatch_begin_row(batch);
+ *     BoltWriter_begin_map(row, 1);
+ *     BoltWriter_key(row, "name", 4);
+ *     BoltWriter_string(row, "Alice", 5);
+ *     BoltWriter_end(row);
+ *     BoltBatch_end_row(batch);
+ *
+ * @param batch the instance to add the row to.
+ * @returns the writer for the row, owned by the batch.
+ */
+SEABOLT_EXPORT BoltWriter* BoltBatch_begin_row(BoltBatch* batch);
+
+/**
+ * Adds the row written since \ref BoltBatch_begin_row to the current batch, and sends the batch if it is full.
+ *
+ * @param batch the instance to add the row to.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, \ref BOLT_PROTOCOL_VIOLATION if the row is not
+ *          one complete value, or the error of a failed batch.
+ */
+SEABOLT_EXPORT int32_t BoltBatch_end_row(BoltBatch* batch);
+
+/**
+ * Sends the current batch, if it holds any rows, without waiting for its result.
+ *
+ * @param batch the instance to flush.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or the error of a failed batch.
+ */
+SEABOLT_EXPORT int32_t BoltBatch_flush(BoltBatch* batch);
+
+/**
+ * Sends the current batch and waits for the results of all batches in flight.
+ *
+ * Once a batch fails, the failure is returned by all later calls and the server ignores the batches that followed
+ * it, until the connection is reset.
+ *
+ * @param batch the instance to finish.
+ * @returns \ref BOLT_SUCCESS if all batches succeeded, \ref BOLT_SERVER_FAILURE if the server failed a batch, or
+ *          another error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltBatch_finish(BoltBatch* batch);
+
+/**
+ * Returns the number of rows in batches the server has successfully processed.
+ *
+ * @param batch the instance to query.
+ * @returns the number of completed rows.
+ */
+SEABOLT_EXPORT int64_t BoltBatch_rows_completed(BoltBatch* batch);
+
+#endif //SEABOLT_BATCH_H
@@ -28,16 +28,21 @@ extern "C"
 
 #include "address.h"
 #include "address-resolver.h"
+#include "allocator.h"
 #include "auth.h"
+#include "batch.h"
 #include "config.h"
 #include "connector.h"
 #include "connection.h"
 #include "error.h"
 #include "lifecycle.h"
 #include "log.h"
+#include "metrics.h"
+#include "statement.h"
 #include "stats.h"
 #include "status.h"
 #include "values.h"
+#include "writer.h"
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_BUFFERS
+
+#include "bolt-private.h"
+#include "buffer-pool.h"
+#include "mem.h"
+#include "sync.h"
+
+/// Buffers smaller than 2^MIN_CLASS_SHIFT bytes are not pooled
+#define MIN_CLASS_SHIFT 12
+/// Buffers of 2^(MAX_CLASS_SHIFT+1) bytes or more are not pooled
+#define MAX_CLASS_SHIFT 20
+#define NUM_CLASSES (MAX_CLASS_SHIFT-MIN_CLASS_SHIFT+1)
+/// Released buffers are not shrunk below 2^SHRINK_MIN_SHIFT bytes, leaving buffers of ordinary messages intact
+#define SHRINK_MIN_SHIFT 16
+
+struct BoltBufferPool {
+    mutex_t mutex;
+
+    int32_t max_buffers;
+    int32_t num_buffers;
+    int64_t max_bytes;
+    /// The total size of the retained buffers
+    int64_t num_bytes;
+    /// Stacks of free buffers, class n holding those of 2^(MIN_CLASS_SHIFT+n) bytes up to twice that
+    BoltBuffer** buffers[NUM_CLASSES];
+    int32_t class_sizes[NUM_CLASSES];
+
+    int32_t max_rings;
+    int32_t num_rings;
+    BoltRing** rings;
+};
+
+struct BoltBufferPool* BoltBufferPool_create(int32_t max_buffers, int64_t max_bytes, int32_t max_rings)
+{
+    struct BoltBufferPool* pool = BoltMem_allocate(sizeof(struct BoltBufferPool));
+    BoltSync_mutex_create(&pool->mutex);
+    pool->max_buffers = max_buffers;
+    pool->num_buffers = 0;
+    pool->max_bytes = max_bytes;
+    pool->num_bytes = 0;
+    for (int i = 0; i<NUM_CLASSES; i++) {
+        // Each class may end up holding all the retained buffers
+        pool->buffers[i] = BoltMem_allocate(max_buffers*sizeof(BoltBuffer*));
+        pool->class_sizes[i] = 0;
+    }
+    pool->max_rings = max_rings;
+    pool->num_rings = 0;
+    pool->rings = BoltMem_allocate(max_rings*sizeof(BoltRing*));
+    return pool;
+}
+
+void BoltBufferPool_destroy(struct BoltBufferPool* pool)
+{
+    if (pool==NULL) return;
+
+    for (int i = 0; i<NUM_CLASSES; i++) {
+        for (int j = 0; j<pool->class_sizes[i]; j++) {
+            BoltBuffer_destroy(pool->buffers[i][j]);
+        }
+        BoltMem_deallocate(pool->buffers[i], pool->max_buffers*sizeof(BoltBuffer*));
+    }
+    for (int i = 0; i<pool->num_rings; i++) {
+        BoltRing_destroy(pool->rings[i]);
+    }
+    BoltMem_deallocate(pool->rings, pool->max_rings*sizeof(BoltRing*));
+    BoltSync_mutex_destroy(&pool->mutex);
+    BoltMem_deallocate(pool, sizeof(struct BoltBufferPool));
+}
+
+BoltBuffer* BoltBufferPool_acquire(struct BoltBufferPool* pool, int size)
+{
+    BoltBuffer* buffer = NULL;
+    if (pool!=NULL) {
+        // Start from the smallest class whose every buffer fits
+        int first = 0;
+        while (first<NUM_CLASSES && (1 << (MIN_CLASS_SHIFT+first))<size) {
+            first++;
+        }
+
+        BoltSync_mutex_lock(&pool->mutex);
+        for (int i = first; i<NUM_CLASSES && buffer==NULL; i++) {
+            if (pool->class_sizes[i]>0) {
+                pool->class_sizes[i] -= 1;
+                buffer = pool->buffers[i][pool->class_sizes[i]];
+                pool->num_buffers -= 1;
+                pool->num_bytes -= buffer->size;
+            }
+        }
+        BoltSync_mutex_unlock(&pool->mutex);
+    }
+    return buffer!=NULL ? buffer : BoltBuffer_create(size);
+}
+
+void BoltBufferPool_release(struct BoltBufferPool* pool, BoltBuffer* buffer)
+{
+    if (buffer==NULL) return;
+
+    if (pool!=NULL && buffer->size>=(1 << MIN_CLASS_SHIFT) && buffer->size<(1 << (MAX_CLASS_SHIFT+1))) {
+        // Capacity the buffer did not need since it was last shrunk is given back before it is filed
+        buffer->cursor = 0;
+        buffer->extent = 0;
+        BoltBuffer_shrink(buffer, 1 << SHRINK_MIN_SHIFT);
+        buffer->high_water = 0;
+
+        int index = 0;
+        while (buffer->size>=(1 << (MIN_CLASS_SHIFT+index+1))) {
+            index++;
+        }
+
+        BoltSync_mutex_lock(&pool->mutex);
+        int retained = pool->num_buffers<pool->max_buffers && pool->num_bytes+buffer->size<=pool->max_bytes;
+        if (retained) {
+            pool->buffers[index][pool->class_sizes[index]] = buffer;
+            pool->class_sizes[index] += 1;
+            pool->num_buffers += 1;
+            pool->num_bytes += buffer->size;
+        }
+        BoltSync_mutex_unlock(&pool->mutex);
+
+        if (retained) return;
+    }
+    BoltBuffer_destroy(buffer);
+}
+
+BoltRing* BoltBufferPool_acquire_ring(struct BoltBufferPool* pool, int64_t size)
+{
+    BoltRing* ring = NULL;
+    if (pool!=NULL) {
+        BoltSync_mutex_lock(&pool->mutex);
+        for (int i = pool->num_rings-1; i>=0; i--) {
+            if (pool->rings[i]->size>=size) {
+                ring = pool->rings[i];
+                pool->num_rings -= 1;
+                pool->rings[i] = pool->rings[pool->num_rings];
+                break;
+            }
+        }
+        BoltSync_mutex_unlock(&pool->mutex);
+    }
+    return ring!=NULL ? ring : BoltRing_create(size);
+}
+
+void BoltBufferPool_release_ring(struct BoltBufferPool* pool, BoltRing* ring)
+{
+    if (ring==NULL) return;
+
+    if (pool!=NULL) {
+        ring->head = 0;
+        ring->tail = 0;
+
+        BoltSync_mutex_lock(&pool->mutex);
+        int retained = pool->num_rings<pool->max_rings;
+        if (retained) {
+            pool->rings[pool->num_rings] = ring;
+            pool->num_rings += 1;
+        }
+        BoltSync_mutex_unlock(&pool->mutex);
+
+        if (retained) return;
+    }
+    BoltRing_destroy(ring);
+}
+
+int32_t BoltBufferPool_size(struct BoltBufferPool* pool)
+{
+    BoltSync_mutex_lock(&pool->mutex);
+    int32_t size = pool->num_buffers+pool->num_rings;
+    BoltSync_mutex_unlock(&pool->mutex);
+    return size;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_BUFFER_POOL_H
+#define SEABOLT_BUFFER_POOL_H
+
+#include "buffering.h"
+
+/**
+ * Keeps the buffers of closed connections for reuse by the next connection opened through the same connector, so
+ * reconnecting does not go back to the allocator and buffers that had to grow keep their capacity.
+ *
+ * Buffers are filed by size class, each class holding the buffers of at least 2^n bytes, and are handed out from
+ * the smallest class that fits the request. Released buffers are first shrunk to what they recently needed, see
+ * \ref BoltBuffer_shrink. Buffers outside the pooled size classes and any beyond the configured limits, on both
+ * their number and their total size, are destroyed on release. All functions are thread safe, and accept a NULL pool to fall back to plain
+ * creation and destruction.
+ */
+struct BoltBufferPool;
+
+/**
+ * Creates a buffer pool.
+ *
+ * @param max_buffers the maximum number of \ref BoltBuffer "BoltBuffers" to retain.
+ * @param max_bytes the maximum total size of the \ref BoltBuffer "BoltBuffers" to retain.
+ * @param max_rings the maximum number of \ref BoltRing "BoltRings" to retain.
+ * @return the pointer to the newly allocated \ref BoltBufferPool instance.
+ */
+struct BoltBufferPool* BoltBufferPool_create(int32_t max_buffers, int64_t max_bytes, int32_t max_rings);
+
+/**
+ * Destroys the pool along with all the buffers it retains.
+ *
+ * @param pool
+ */
+void BoltBufferPool_destroy(struct BoltBufferPool* pool);
+
+/**
+ * Takes an empty buffer of at least _size_ bytes from the pool, or creates one if none is available.
+ *
+ * @param pool
+ * @param size
+ * @return
+ */
+BoltBuffer* BoltBufferPool_acquire(struct BoltBufferPool* pool, int size);
+
+/**
+ * Returns a buffer to the pool, discarding its contents.
+ *
+ * @param pool
+ * @param buffer
+ */
+void BoltBufferPool_release(struct BoltBufferPool* pool, BoltBuffer* buffer);
+
+/**
+ * Takes an empty ring of at least _size_ bytes from the pool, or creates one if none is available.
+ *
+ * @param pool
+ * @param size
+ * @return
+ */
+BoltRing* BoltBufferPool_acquire_ring(struct BoltBufferPool* pool, int64_t size);
+
+/**
+ * Returns a ring to the pool, discarding its contents.
+ *
+ * @param pool
+ * @param ring
+ */
+void BoltBufferPool_release_ring(struct BoltBufferPool* pool, BoltRing* ring);
+
+/**
+ * Returns the number of buffers and rings currently retained by the pool.
+ *
+ * @param pool
+ * @return
+ */
+int32_t BoltBufferPool_size(struct BoltBufferPool* pool);
+
+#endif //SEABOLT_BUFFER_POOL_H
@@ -17,6 +17,7 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_BUFFERS
 
 #include <limits.h>
 #include <memory.h>
@@ -32,6 +33,7 @@ BoltBuffer* BoltBuffer_create(int size)
     buffer->data = BoltMem_allocate((size_t) (buffer->size));
     buffer->extent = 0;
     buffer->cursor = 0;
+    buffer->high_water = 0;
     return buffer;
 }
 
@@ -53,71 +55,116 @@ void BoltBuffer_compact(BoltBuffer* buffer)
     }
 }
 
+void BoltBuffer_shrink(BoltBuffer* buffer, int min_size)
+{
+    if (buffer->extent==0 && buffer->high_water<=buffer->size/4) {
+        int64_t new_size = 2*(int64_t) buffer->high_water;
+        if (new_size<min_size) {
+            new_size = min_size;
+        }
+        if (new_size<buffer->size) {
+            buffer->data = BoltMem_reallocate(buffer->data, (size_t) (buffer->size), (size_t) (new_size));
+            buffer->size = (int) new_size;
+            buffer->cursor = 0;
+        }
+    }
+    buffer->high_water = buffer->extent;
+}
+
 int BoltBuffer_loadable(BoltBuffer* buffer)
 {
-    int available = buffer->size-buffer->extent;
-    return available>INT_MAX ? INT_MAX : available;
+    return buffer->size-buffer->extent;
 }
 
 char* BoltBuffer_load_pointer(BoltBuffer* buffer, int size)
 {
+    if (size<0 || (int64_t) buffer->extent+size>INT_MAX) {
+        return NULL;
+    }
     int available = BoltBuffer_loadable(buffer);
     if (size>available) {
-        int new_size = buffer->size+(size-available);
+        // at least double, so that loading piece by piece does not reallocate on every load;
+        // the cap below never drops under extent+size, which was checked above
+        int64_t new_size = (int64_t) buffer->extent+size;
+        if (new_size<2*(int64_t) buffer->size) {
+            new_size = 2*(int64_t) buffer->size;
+        }
+        if (new_size>INT_MAX) {
+            new_size = INT_MAX;
+        }
         buffer->data = BoltMem_reallocate(buffer->data, (size_t) (buffer->size), (size_t) (new_size));
-        buffer->size = new_size;
+        buffer->size = (int) new_size;
     }
     int extent = buffer->extent;
     buffer->extent += size;
+    if (buffer->extent>buffer->high_water) {
+        buffer->high_water = buffer->extent;
+    }
     return &buffer->data[extent];
 }
 
-void BoltBuffer_load(BoltBuffer* buffer, const char* data, int size)
+int BoltBuffer_load(BoltBuffer* buffer, const char* data, int size)
 {
     char* target = BoltBuffer_load_pointer(buffer, size);
-    memcpy(target, data, size>=0 ? (size_t) (size) : 0);
+    if (target==NULL) return -1;
+    memcpy(target, data, (size_t) (size));
+    return size;
 }
 
-void BoltBuffer_load_i8(BoltBuffer* buffer, int8_t x)
+int BoltBuffer_load_i8(BoltBuffer* buffer, int8_t x)
 {
     char* target = BoltBuffer_load_pointer(buffer, sizeof(x));
+    if (target==NULL) return -1;
     target[0] = (char) (x);
+    return (int) (sizeof(x));
 }
 
-void BoltBuffer_load_u8(BoltBuffer* buffer, uint8_t x)
+int BoltBuffer_load_u8(BoltBuffer* buffer, uint8_t x)
 {
     char* target = BoltBuffer_load_pointer(buffer, sizeof(x));
+    if (target==NULL) return -1;
     target[0] = (char) (x);
+    return (int) (sizeof(x));
 }
 
-void BoltBuffer_load_u16be(BoltBuffer* buffer, uint16_t x)
+int BoltBuffer_load_u16be(BoltBuffer* buffer, uint16_t x)
 {
     char* target = BoltBuffer_load_pointer(buffer, sizeof(x));
+    if (target==NULL) return -1;
     memcpy_be(&target[0], &x, sizeof(x));
+    return (int) (sizeof(x));
 }
 
-void BoltBuffer_load_i16be(BoltBuffer* buffer, int16_t x)
+int BoltBuffer_load_i16be(BoltBuffer* buffer, int16_t x)
 {
     char* target = BoltBuffer_load_pointer(buffer, sizeof(x));
+    if (target==NULL) return -1;
     memcpy_be(&target[0], &x, sizeof(x));
+    return (int) (sizeof(x));
 }
 
-void BoltBuffer_load_i32be(BoltBuffer* buffer, int32_t x)
+int BoltBuffer_load_i32be(BoltBuffer* buffer, int32_t x)
 {
     char* target = BoltBuffer_load_pointer(buffer, sizeof(x));
+    if (target==NULL) return -1;
     memcpy_be(&target[0], &x, sizeof(x));
+    return (int) (sizeof(x));
 }
 
-void BoltBuffer_load_i64be(BoltBuffer* buffer, int64_t x)
+int BoltBuffer_load_i64be(BoltBuffer* buffer, int64_t x)
 {
     char* target = BoltBuffer_load_pointer(buffer, sizeof(x));
+    if (target==NULL) return -1;
     memcpy_be(&target[0], &x, sizeof(x));
+    return (int) (sizeof(x));
 }
 
-void BoltBuffer_load_f64be(BoltBuffer* buffer, double x)
+int BoltBuffer_load_f64be(BoltBuffer* buffer, double x)
 {
-    char* target = BoltBuffer_load_pointer(buffer, (int) ((sizeof(x))));
+    char* target = BoltBuffer_load_pointer(buffer, sizeof(x));
+    if (target==NULL) return -1;
     memcpy_be(&target[0], &x, sizeof(x));
+    return (int) (sizeof(x));
 }
 
 int BoltBuffer_unloadable(BoltBuffer* buffer)
@@ -217,3 +264,61 @@ int BoltBuffer_unload_f64be(BoltBuffer* buffer, double* x)
     buffer->cursor += sizeof(*x);
     return 0;
 }
+
+BoltRing* BoltRing_create(int64_t size)
+{
+    BoltRing* ring = BoltMem_allocate(sizeof(BoltRing));
+    ring->size = 1;
+    while (ring->size<size) {
+        ring->size *= 2;
+    }
+    ring->data = BoltMem_allocate((size_t) (ring->size));
+    ring->head = 0;
+    ring->tail = 0;
+    return ring;
+}
+
+void BoltRing_destroy(BoltRing* ring)
+{
+    BoltMem_deallocate(ring->data, (size_t) (ring->size));
+    BoltMem_deallocate(ring, sizeof(BoltRing));
+}
+
+int64_t BoltRing_unloadable(const BoltRing* ring)
+{
+    return ring->tail-ring->head;
+}
+
+char* BoltRing_load_pointer(BoltRing* ring, int64_t* size)
+{
+    int64_t start = ring->tail & (ring->size-1);
+    int64_t space = ring->size-BoltRing_unloadable(ring);
+    *size = space<ring->size-start ? space : ring->size-start;
+    return &ring->data[start];
+}
+
+void BoltRing_loaded(BoltRing* ring, int64_t size)
+{
+    ring->tail += size;
+}
+
+int64_t BoltRing_unload(BoltRing* ring, char* data, int64_t size)
+{
+    int64_t available = BoltRing_unloadable(ring);
+    if (size>available) {
+        size = available;
+    }
+    int64_t start = ring->head & (ring->size-1);
+    int64_t first = size<ring->size-start ? size : ring->size-start;
+    memcpy(data, &ring->data[start], (size_t) first);
+    if (first<size) {
+        memcpy(data+first, ring->data, (size_t) (size-first));
+    }
+    ring->head += size;
+    if (ring->head==ring->tail) {
+        // start over at the beginning, so that the next load gets the whole buffer as one piece
+        ring->head = 0;
+        ring->tail = 0;
+    }
+    return size;
+}
@@ -28,14 +28,34 @@
 
 /**
  * General purpose data buffer.
+ *
+ * The buffer grows geometrically when more space is needed, so loading data piece by piece costs amortised
+ * constant time. Individual buffers hold at most one message or request batch, so sizes stay within an int.
  */
 typedef struct BoltBuffer {
     int size;
     int extent;
     int cursor;
     char* data;
+    /// The largest extent since the buffer was last shrunk
+    int high_water;
 } BoltBuffer;
 
+/**
+ * Fixed size wrap-around buffer, used to stage data received from the network. Unlike \ref BoltBuffer it never
+ * needs to move unread data to make room, as loading continues at the start of the buffer once the end is
+ * reached. Positions count every byte ever loaded or unloaded and are 64-bit, so they do not overflow.
+ */
+typedef struct BoltRing {
+    /// Always a power of two
+    int64_t size;
+    /// Position of the next byte to unload
+    int64_t head;
+    /// Position of the next byte to load
+    int64_t tail;
+    char* data;
+} BoltRing;
+
 /**
  * Create a buffer.
  *
@@ -58,6 +78,16 @@ void BoltBuffer_destroy(BoltBuffer* buffer);
  */
 void BoltBuffer_compact(BoltBuffer* buffer);
 
+/**
+ * Release memory that the buffer did not need recently. An empty buffer whose high-water mark since the last call
+ * is below a quarter of its size is reallocated to twice that mark, but not below _min_size_. Meant to be called
+ * whenever the owner of the buffer becomes idle, so a single large message does not pin memory indefinitely.
+ *
+ * @param buffer
+ * @param min_size
+ */
+void BoltBuffer_shrink(BoltBuffer* buffer, int min_size);
+
 /**
  * Return the amount of loadable space in a buffer, in bytes.
  *
@@ -71,7 +101,7 @@ int BoltBuffer_loadable(BoltBuffer* buffer);
  *
  * @param buffer
  * @param size
- * @return
+ * @return pointer to the space, or NULL if the buffer cannot hold size more bytes (sizes are capped at INT_MAX)
  */
 char* BoltBuffer_load_pointer(BoltBuffer* buffer, int size);
 
@@ -81,64 +111,72 @@ char* BoltBuffer_load_pointer(BoltBuffer* buffer, int size);
  * @param buffer
  * @param data
  * @param size
+ * @return the number of bytes loaded, or -1 if the buffer cannot hold them
  */
-void BoltBuffer_load(BoltBuffer* buffer, const char* data, int size);
+int BoltBuffer_load(BoltBuffer* buffer, const char* data, int size);
 
 /**
  * Load an unsigned 8-bit integer into a buffer.
  *
  * @param buffer
  * @param x
+ * @return the number of bytes loaded, or -1 if the buffer cannot hold them
  */
-void BoltBuffer_load_u8(BoltBuffer* buffer, uint8_t x);
+int BoltBuffer_load_u8(BoltBuffer* buffer, uint8_t x);
 
 /**
  * Load an unsigned 16-bit integer (big-endian) into a buffer.
  *
  * @param buffer
  * @param x
+ * @return the number of bytes loaded, or -1 if the buffer cannot hold them
  */
-void BoltBuffer_load_u16be(BoltBuffer* buffer, uint16_t x);
+int BoltBuffer_load_u16be(BoltBuffer* buffer, uint16_t x);
 
 /**
  * Load a signed 8-bit integer into a buffer.
  *
  * @param buffer
  * @param x
+ * @return the number of bytes loaded, or -1 if the buffer cannot hold them
  */
-void BoltBuffer_load_i8(BoltBuffer* buffer, int8_t x);
+int BoltBuffer_load_i8(BoltBuffer* buffer, int8_t x);
 
 /**
  * Load a signed 16-bit integer (big-endian) into a buffer.
  *
  * @param buffer
  * @param x
+ * @return the number of bytes loaded, or -1 if the buffer cannot hold them
  */
-void BoltBuffer_load_i16be(BoltBuffer* buffer, int16_t x);
+int BoltBuffer_load_i16be(BoltBuffer* buffer, int16_t x);
 
 /**
  * Load a signed 32-bit integer (big-endian) into a buffer.
  *
  * @param buffer
  * @param x
+ * @return the number of bytes loaded, or -1 if the buffer cannot hold them
  */
-void BoltBuffer_load_i32be(BoltBuffer* buffer, int32_t x);
+int BoltBuffer_load_i32be(BoltBuffer* buffer, int32_t x);
 
 /**
  * Load a signed 64-bit integer (big-endian) into a buffer.
  *
  * @param buffer
  * @param x
+ * @return the number of bytes loaded, or -1 if the buffer cannot hold them
  */
-void BoltBuffer_load_i64be(BoltBuffer* buffer, int64_t x);
+int BoltBuffer_load_i64be(BoltBuffer* buffer, int64_t x);
 
 /**
  * Load a double precision floating point number (big-endian) into a buffer.
  *
  * @param buffer
  * @param x
+ * @return the number of bytes loaded, or -1 if the buffer cannot hold them
  */
-void BoltBuffer_load_f64be(BoltBuffer* buffer, double x);
+int BoltBuffer_load_f64be(BoltBuffer* buffer, double x);
 
 /**
  * Return the amount of unloadable data in a buffer, in bytes.
@@ -239,4 +277,55 @@ int BoltBuffer_unload_i64be(BoltBuffer* buffer, int64_t* x);
  */
 int BoltBuffer_unload_f64be(BoltBuffer* buffer, double* x);
 
+/**
+ * Create a ring buffer of at least _size_ bytes.
+ *
+ * @param size
+ * @return
+ */
+BoltRing* BoltRing_create(int64_t size);
+
+/**
+ * Destroy a ring buffer.
+ *
+ * @param ring
+ */
+void BoltRing_destroy(BoltRing* ring);
+
+/**
+ * Return the amount of data available for unloading from a ring buffer, in bytes.
+ *
+ * @param ring
+ * @return
+ */
+int64_t BoltRing_unloadable(const BoltRing* ring);
+
+/**
+ * Return a pointer to the free space that directly follows the loaded data, which is at most the space up to the
+ * end of the underlying memory. Data written there is only made available by \ref BoltRing_loaded.
+ *
+ * @param ring
+ * @param size set to the size of the free space
+ * @return
+ */
+char* BoltRing_load_pointer(BoltRing* ring, int64_t* size);
+
+/**
+ * Make _size_ bytes written to the space returned by \ref BoltRing_load_pointer available for unloading.
+ *
+ * @param ring
+ * @param size
+ */
+void BoltRing_loaded(BoltRing* ring, int64_t size);
+
+/**
+ * Unload up to _size_ bytes from a ring buffer.
+ *
+ * @param ring
+ * @param data
+ * @param size
+ * @return the number of bytes unloaded
+ */
+int64_t BoltRing_unload(BoltRing* ring, char* data, int64_t size);
+
 #endif // SEABOLT_BUFFERING
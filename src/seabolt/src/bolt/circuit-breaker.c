@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bolt-private.h"
+#include "circuit-breaker.h"
+
+void BoltCircuitBreaker_init(BoltCircuitBreaker* breaker)
+{
+    breaker->state = BOLT_CIRCUIT_CLOSED;
+    breaker->failures = 0;
+    breaker->opened_at = 0;
+}
+
+int BoltCircuitBreaker_is_available(const BoltCircuitBreaker* breaker, int32_t reset_time, int64_t now)
+{
+    switch (breaker->state) {
+    case BOLT_CIRCUIT_OPEN:
+        return now-breaker->opened_at>=reset_time;
+    case BOLT_CIRCUIT_HALF_OPEN:
+        // a probe is already in flight
+        return 0;
+    default:
+        return 1;
+    }
+}
+
+int BoltCircuitBreaker_permit(BoltCircuitBreaker* breaker, int32_t reset_time, int64_t now)
+{
+    if (!BoltCircuitBreaker_is_available(breaker, reset_time, now)) {
+        return BOLT_ROUTING_CIRCUIT_OPEN;
+    }
+
+    if (breaker->state==BOLT_CIRCUIT_OPEN) {
+        // this caller becomes the single probe
+        breaker->state = BOLT_CIRCUIT_HALF_OPEN;
+    }
+
+    return BOLT_SUCCESS;
+}
+
+void BoltCircuitBreaker_on_success(BoltCircuitBreaker* breaker)
+{
+    breaker->state = BOLT_CIRCUIT_CLOSED;
+    breaker->failures = 0;
+}
+
+void BoltCircuitBreaker_on_failure(BoltCircuitBreaker* breaker, int32_t threshold, int64_t now)
+{
+    breaker->failures++;
+    if (breaker->state==BOLT_CIRCUIT_HALF_OPEN || (threshold>0 && breaker->failures>=threshold)) {
+        breaker->state = BOLT_CIRCUIT_OPEN;
+        breaker->opened_at = now;
+    }
+}
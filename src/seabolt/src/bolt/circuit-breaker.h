@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_CIRCUIT_BREAKER_H
+#define SEABOLT_CIRCUIT_BREAKER_H
+
+#include "bolt-public.h"
+
+#define BOLT_CIRCUIT_CLOSED 0
+#define BOLT_CIRCUIT_OPEN 1
+#define BOLT_CIRCUIT_HALF_OPEN 2
+
+/**
+ * Tracks consecutive failures towards a single server.
+ *
+ * A breaker starts CLOSED and opens once _threshold_ consecutive failures have been recorded. While OPEN
+ * it rejects all attempts until _reset_time_ milliseconds have passed, after which it becomes HALF_OPEN
+ * and hands out a single probe permit. The outcome of the probe either closes or re-opens it.
+ *
+ * All functions take the current time explicitly, and are expected to be called with external locking.
+ */
+typedef struct BoltCircuitBreaker {
+    int state;
+    int failures;
+    int64_t opened_at;
+} BoltCircuitBreaker;
+
+#define SIZE_OF_CIRCUIT_BREAKER sizeof(struct BoltCircuitBreaker)
+
+void BoltCircuitBreaker_init(BoltCircuitBreaker* breaker);
+
+int BoltCircuitBreaker_is_available(const BoltCircuitBreaker* breaker, int32_t reset_time, int64_t now);
+
+int BoltCircuitBreaker_permit(BoltCircuitBreaker* breaker, int32_t reset_time, int64_t now);
+
+void BoltCircuitBreaker_on_success(BoltCircuitBreaker* breaker);
+
+void BoltCircuitBreaker_on_failure(BoltCircuitBreaker* breaker, int32_t threshold, int64_t now);
+
+#endif //SEABOLT_CIRCUIT_BREAKER_H
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_CONNECTIONS
+
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include "bolt-private.h"
+#include "communication-capture.h"
+#include "log-private.h"
+#include "mem.h"
+
+#if USE_WINSOCK
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#endif
+
+typedef struct CaptureCommunicationContext {
+    BoltCommunication* inner;
+    FILE* file;
+    /// Sent bytes are recorded as zeros while set
+    int redacting;
+} CaptureCommunicationContext;
+
+#define INNER(comm) (((CaptureCommunicationContext*) (comm)->context)->inner)
+
+void _write_frame(BoltCommunication* comm, char direction, const char* data, int size)
+{
+    CaptureCommunicationContext* context = comm->context;
+    if (size<=0 || context->file==NULL) {
+        return;
+    }
+    char header[5];
+    header[0] = direction;
+    header[1] = (char) ((size >> 24) & 0xFF);
+    header[2] = (char) ((size >> 16) & 0xFF);
+    header[3] = (char) ((size >> 8) & 0xFF);
+    header[4] = (char) (size & 0xFF);
+    int written = fwrite(header, 1, sizeof(header), context->file)==sizeof(header);
+    if (direction==BOLT_CAPTURE_CLIENT && context->redacting) {
+        static const char zeros[256] = {0};
+        for (int offset = 0; written && offset<size; offset += (int) sizeof(zeros)) {
+            size_t length = size-offset<(int) sizeof(zeros) ? (size_t) (size-offset) : sizeof(zeros);
+            written = fwrite(zeros, 1, length, context->file)==length;
+        }
+    }
+    else {
+        written = written && fwrite(data, 1, (size_t) size, context->file)==(size_t) size;
+    }
+    if (!written) {
+        BoltLog_warning(comm->log, "Unable to write wire capture, capture stopped");
+        fclose(context->file);
+        context->file = NULL;
+    }
+}
+
+int capture_last_error(BoltCommunication* comm)
+{
+    return INNER(comm)->last_error(INNER(comm));
+}
+
+int capture_transform_error(BoltCommunication* comm, int error_code)
+{
+    return INNER(comm)->transform_error(INNER(comm), error_code);
+}
+
+int capture_ignore_sigpipe(BoltCommunication* comm)
+{
+    return INNER(comm)->ignore_sigpipe(INNER(comm));
+}
+
+int capture_restore_sigpipe(BoltCommunication* comm)
+{
+    return INNER(comm)->restore_sigpipe(INNER(comm));
+}
+
+int capture_open(BoltCommunication* comm, const struct sockaddr_storage* address)
+{
+    return INNER(comm)->open(INNER(comm), address);
+}
+
+int capture_close(BoltCommunication* comm)
+{
+    CaptureCommunicationContext* context = comm->context;
+    if (context->file!=NULL) {
+        fflush(context->file);
+    }
+    return INNER(comm)->close(INNER(comm));
+}
+
+int capture_send(BoltCommunication* comm, char* buffer, int length, int* sent)
+{
+    int status = INNER(comm)->send(INNER(comm), buffer, length, sent);
+    if (status==BOLT_SUCCESS) {
+        _write_frame(comm, BOLT_CAPTURE_CLIENT, buffer, *sent);
+    }
+    return status;
+}
+
+int capture_recv(BoltCommunication* comm, char* buffer, int length, int* received)
+{
+    int status = INNER(comm)->recv(INNER(comm), buffer, length, received);
+    if (status==BOLT_SUCCESS) {
+        _write_frame(comm, BOLT_CAPTURE_SERVER, buffer, *received);
+    }
+    return status;
+}
+
+int capture_destroy(BoltCommunication* comm)
+{
+    CaptureCommunicationContext* context = comm->context;
+    if (context!=NULL) {
+        if (context->file!=NULL) {
+            fclose(context->file);
+        }
+        BoltCommunication_destroy(context->inner);
+        BoltMem_deallocate(context, sizeof(CaptureCommunicationContext));
+        comm->context = NULL;
+    }
+    return BOLT_SUCCESS;
+}
+
+BoltAddress* capture_local_endpoint(BoltCommunication* comm)
+{
+    return INNER(comm)->get_local_endpoint(INNER(comm));
+}
+
+BoltAddress* capture_remote_endpoint(BoltCommunication* comm)
+{
+    return INNER(comm)->get_remote_endpoint(INNER(comm));
+}
+
+// Creates or truncates the file at path, readable and writable by its owner only
+FILE* _create_capture_file(const char* path)
+{
+#if USE_WINSOCK
+    int fd = -1;
+    if (_sopen_s(&fd, path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _SH_DENYRW, _S_IREAD | _S_IWRITE)!=0) {
+        return NULL;
+    }
+    FILE* file = _fdopen(fd, "wb");
+    if (file==NULL) {
+        _close(fd);
+    }
+    return file;
+#else
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd<0) {
+        return NULL;
+    }
+    // an existing file keeps its permissions when truncated
+    FILE* file = fchmod(fd, S_IRUSR | S_IWUSR)==0 ? fdopen(fd, "wb") : NULL;
+    if (file==NULL) {
+        close(fd);
+    }
+    return file;
+#endif
+}
+
+BoltCommunication* BoltCommunication_create_capture(BoltCommunication* comm, const char* path)
+{
+    FILE* file = _create_capture_file(path);
+    if (file==NULL) {
+        BoltLog_warning(comm->log, "Unable to open wire capture file %s", path);
+        return comm;
+    }
+
+    BoltCommunication* capture = BoltMem_allocate(sizeof(BoltCommunication));
+    capture->open = &capture_open;
+    capture->close = &capture_close;
+    capture->send = &capture_send;
+    capture->recv = &capture_recv;
+    capture->destroy = &capture_destroy;
+
+    capture->get_local_endpoint = &capture_local_endpoint;
+    capture->get_remote_endpoint = &capture_remote_endpoint;
+
+    capture->ignore_sigpipe = &capture_ignore_sigpipe;
+    capture->restore_sigpipe = &capture_restore_sigpipe;
+
+    capture->last_error = &capture_last_error;
+    capture->transform_error = &capture_transform_error;
+
+    // Errors and options are shared with the wrapped instance
+    capture->status_owned = 0;
+    capture->status = comm->status;
+    capture->sock_opts_owned = 0;
+    capture->sock_opts = comm->sock_opts;
+    capture->log = comm->log;
+
+    CaptureCommunicationContext* context = BoltMem_allocate(sizeof(CaptureCommunicationContext));
+    context->inner = comm;
+    context->file = file;
+    context->redacting = 0;
+
+    capture->context = context;
+
+    return capture;
+}
+
+void BoltCapture_set_redacting(BoltCommunication* comm, int redacting)
+{
+    if (comm!=NULL && comm->send==&capture_send) {
+        ((CaptureCommunicationContext*) comm->context)->redacting = redacting;
+    }
+}
+
+int64_t BoltCapture_load(const char* path, char direction, char** stream)
+{
+    FILE* file = fopen(path, "rb");
+    if (file==NULL) {
+        return -1;
+    }
+
+    int64_t capacity = 4096;
+    int64_t size = 0;
+    char* data = BoltMem_allocate(capacity);
+    unsigned char header[5];
+    size_t header_size;
+    while ((header_size = fread(header, 1, sizeof(header), file))==sizeof(header)) {
+        int64_t length = ((int64_t) header[1] << 24) | (header[2] << 16) | (header[3] << 8) | header[4];
+        if (header[0]!=direction) {
+            if (fseek(file, (long) length, SEEK_CUR)!=0) {
+                break;
+            }
+            continue;
+        }
+        if (size+length>capacity) {
+            int64_t new_capacity = capacity;
+            while (size+length>new_capacity) {
+                new_capacity *= 2;
+            }
+            data = BoltMem_reallocate(data, capacity, new_capacity);
+            capacity = new_capacity;
+        }
+        if (fread(data+size, 1, (size_t) length, file)!=(size_t) length) {
+            header_size = 1;
+            break;
+        }
+        size += length;
+    }
+    fclose(file);
+
+    if (header_size!=0) {
+        BoltMem_deallocate(data, capacity);
+        return -1;
+    }
+
+    if (size==0) {
+        BoltMem_deallocate(data, capacity);
+        *stream = NULL;
+        return 0;
+    }
+    *stream = BoltMem_reallocate(data, capacity, size);
+    return size;
+}
+
+void BoltCapture_release(char* stream, int64_t size)
+{
+    BoltMem_deallocate(stream, size);
+}
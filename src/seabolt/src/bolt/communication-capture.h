@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_COMMUNICATION_CAPTURE_H
+#define SEABOLT_COMMUNICATION_CAPTURE_H
+
+#include "communication.h"
+
+/// Capture frame holding bytes sent by the client
+#define BOLT_CAPTURE_CLIENT 'C'
+/// Capture frame holding bytes received from the server
+#define BOLT_CAPTURE_SERVER 'S'
+
+/**
+ * Wraps _comm_ so that every byte sent and received through it is appended to the file at _path_.
+ *
+ * The file is a sequence of frames, each made of a direction byte (\ref BOLT_CAPTURE_CLIENT or
+ * \ref BOLT_CAPTURE_SERVER), a big-endian 32 bit length and the bytes themselves. Encrypted transports
+ * are captured after decryption, so the file is only readable and writable by its owner.
+ *
+ * @param comm the communication instance to wrap, owned by the returned instance.
+ * @param path the file to write the capture to, truncated if it exists.
+ * @return the capturing communication instance, or _comm_ itself if the file could not be opened.
+ */
+BoltCommunication* BoltCommunication_create_capture(BoltCommunication* comm, const char* path);
+
+/**
+ * Makes a capturing communication instance record sent bytes as zeros, keeping their framing, while
+ * _redacting_ is set. Used to keep credentials out of captures. Has no effect on other instances.
+ *
+ * @param comm the communication instance.
+ * @param redacting 1 to start redacting sent bytes, 0 to stop.
+ */
+void BoltCapture_set_redacting(BoltCommunication* comm, int redacting);
+
+/**
+ * Reads the bytes of a capture file that flowed in the given _direction_, concatenated in order.
+ *
+ * @param path the capture file to read.
+ * @param direction either \ref BOLT_CAPTURE_CLIENT or \ref BOLT_CAPTURE_SERVER.
+ * @param stream set to the loaded bytes, to be released with \ref BoltCapture_release.
+ * @return the number of bytes loaded, or -1 if the file could not be read or is malformed.
+ */
+int64_t BoltCapture_load(const char* path, char direction, char** stream);
+
+/**
+ * Releases the bytes loaded by \ref BoltCapture_load.
+ *
+ * @param stream the loaded bytes, may be NULL.
+ * @param size the number of bytes loaded.
+ */
+void BoltCapture_release(char* stream, int64_t size);
+
+#endif //SEABOLT_COMMUNICATION_CAPTURE_H
@@ -16,6 +16,9 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_CONNECTIONS
+
 #include "communication-mock.h"
 #include "bolt-private.h"
 #include "config-private.h"
@@ -116,6 +119,23 @@ int mock_socket_recv(BoltCommunication* comm, char* buffer, int length, int* rec
     return BOLT_SUCCESS;
 }
 
+int mock_replay_recv(BoltCommunication* comm, char* buffer, int length, int* received)
+{
+    MockCommunicationContext* context = comm->context;
+    int64_t available = context->replay_size-context->replay_cursor;
+    if (available==0) {
+        *received = 0;
+        return BOLT_END_OF_TRANSMISSION;
+    }
+
+    int size = available<length ? (int) available : length;
+    memcpy(buffer, context->replay+context->replay_cursor, (size_t) size);
+    context->replay_cursor += size;
+    *received = size;
+
+    return BOLT_SUCCESS;
+}
+
 int mock_socket_destroy(BoltCommunication* comm)
 {
     BoltLog_debug(comm->log, "socket_destroy");
@@ -181,8 +201,25 @@ BoltCommunication_create_mock(int32_t version, BoltSocketOptions* sock_opts, Bol
     context->remote_endpoint = NULL;
     context->protocol_version = version;
     context->protocol_version_sent = 0;
+    context->replay = NULL;
+    context->replay_size = 0;
+    context->replay_cursor = 0;
 
     comm->context = context;
 
     return comm;
 }
+
+BoltCommunication*
+BoltCommunication_create_replay(const char* stream, int64_t size, BoltSocketOptions* sock_opts, BoltLog* log)
+{
+    BoltCommunication* comm = BoltCommunication_create_mock(0, sock_opts, log);
+    comm->recv = &mock_replay_recv;
+
+    MockCommunicationContext* context = comm->context;
+    context->protocol_version_sent = 1;
+    context->replay = stream;
+    context->replay_size = size;
+
+    return comm;
+}
@@ -28,8 +28,26 @@ typedef struct MockCommunicationContext {
 
     int32_t protocol_version;
     int protocol_version_sent;
+
+    const char* replay;
+    int64_t replay_size;
+    int64_t replay_cursor;
 } MockCommunicationContext;
 
 BoltCommunication* BoltCommunication_create_mock(int32_t version, BoltSocketOptions* socket_options, BoltLog* log);
 
+/**
+ * Creates a mock communication instance that discards everything sent and serves _stream_ as the bytes
+ * received from the server, including the handshake response. Once the stream is exhausted receiving fails
+ * with \ref BOLT_END_OF_TRANSMISSION.
+ *
+ * @param stream the server byte stream, e.g. loaded with \ref BoltCapture_load; must outlive the instance.
+ * @param size the size of _stream_.
+ * @param socket_options the socket options, may be NULL.
+ * @param log the log to use, may be NULL.
+ * @return the replaying communication instance.
+ */
+BoltCommunication* BoltCommunication_create_replay(const char* stream, int64_t size, BoltSocketOptions* socket_options,
+        BoltLog* log);
+
 #endif //SEABOLT_COMMUNICATION_MOCK_H
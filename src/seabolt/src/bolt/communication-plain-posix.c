@@ -16,7 +16,11 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_CONNECTIONS
+
 #include "communication-plain.h"
+#include "mem.h"
 #include "status-private.h"
 
 #include <pthread.h>
@@ -88,7 +92,7 @@ int socket_ignore_sigpipe(void** replaced_action)
     }
 
     if (*replaced_action==NULL) {
-        *replaced_action = malloc(sizeof(sigset_t));
+        *replaced_action = BoltMem_allocate(sizeof(sigset_t));
     }
     memcpy(*replaced_action, &sig_restore, sizeof(sigset_t));
     return 0;
@@ -118,7 +122,7 @@ int socket_restore_sigpipe(void** action_to_restore)
 
         pthread_sigmask(SIG_SETMASK, (sigset_t*) *action_to_restore, NULL);
 
-        free(*action_to_restore);
+        BoltMem_deallocate(*action_to_restore, sizeof(sigset_t));
         *action_to_restore = NULL;
         return 0;
     }
@@ -16,6 +16,9 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_CONNECTIONS
+
 #include "communication-secure.h"
 
 int socket_last_error(BoltCommunication* comm)
@@ -16,6 +16,9 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_CONNECTIONS
+
 #include "communication-plain.h"
 #include "bolt-private.h"
 #include "config-private.h"
@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_TLS
+
 #include "bolt-private.h"
 #include "communication-secure.h"
 #include "config-private.h"
@@ -288,7 +290,7 @@ static struct CRYPTO_dynlock_value* secure_openssl_create_mutex(const char* file
     UNUSED(line);
 
     struct CRYPTO_dynlock_value* value;
-    value = (struct CRYPTO_dynlock_value*) malloc(sizeof(struct CRYPTO_dynlock_value));
+    value = (struct CRYPTO_dynlock_value*) BoltMem_allocate(sizeof(struct CRYPTO_dynlock_value));
     if (!value) return NULL;
     BoltSync_mutex_create(&value->mutex);
     return value;
@@ -313,7 +315,7 @@ static void secure_openssl_destroy_mutex(struct CRYPTO_dynlock_value* l, const c
     UNUSED(line);
 
     BoltSync_mutex_destroy(&l->mutex);
-    free(l);
+    BoltMem_deallocate(l, sizeof(struct CRYPTO_dynlock_value));
 }
 
 #endif
@@ -546,7 +548,8 @@ BoltCommunication* BoltCommunication_create_secure(BoltSecurityContext* sec_ctx,
 {
     BoltCommunication* plain_comm = BoltCommunication_create_plain(socket_options, log);
 
-    BoltCommunication* comm = BoltMem_allocate(sizeof(BoltCommunication));
+    // freed by BoltCommunication_destroy, which accounts it to the connections
+    BoltCommunication* comm = BoltMem_allocate_tagged(BOLT_MEMORY_CONNECTIONS, sizeof(BoltCommunication));
     comm->open = &secure_openssl_open;
     comm->close = &secure_openssl_close;
     comm->send = &secure_openssl_send;
@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_TLS
+
 #include "bolt-private.h"
 #include "communication-secure.h"
 #include "config-private.h"
@@ -544,6 +546,7 @@ int secure_schannel_verify_chain(BoltCommunication* comm)
 
     int result;
     int server_name_length = 0;
+    int64_t server_name_size = 0;
     wchar_t* server_name = NULL;
     PCCERT_CHAIN_CONTEXT chain_context = NULL;
 
@@ -566,7 +569,8 @@ int secure_schannel_verify_chain(BoltCommunication* comm)
 
     // Windows API requires the hostname given for hostname verification to be in UTF-8
     server_name_length = MultiByteToWideChar(CP_ACP, 0, ctx->hostname, -1, NULL, 0);
-    server_name = malloc(sizeof(wchar_t)*server_name_length);
+    server_name_size = sizeof(wchar_t)*server_name_length;
+    server_name = BoltMem_allocate(server_name_size);
     if (server_name==NULL) {
         result = BOLT_OUT_OF_MEMORY;
         goto cleanup;
@@ -708,7 +712,7 @@ int secure_schannel_verify_chain(BoltCommunication* comm)
     }
 
     if (server_name!=NULL) {
-        free(server_name);
+        BoltMem_deallocate(server_name, server_name_size);
     }
 
     return result;
@@ -1114,7 +1118,8 @@ BoltCommunication* BoltCommunication_create_secure(BoltSecurityContext* sec_ctx,
 {
     BoltCommunication* plain_comm = BoltCommunication_create_plain(socket_options, log);
 
-    BoltCommunication* comm = BoltMem_allocate(sizeof(BoltCommunication));
+    // freed by BoltCommunication_destroy, which accounts it to the connections
+    BoltCommunication* comm = BoltMem_allocate_tagged(BOLT_MEMORY_CONNECTIONS, sizeof(BoltCommunication));
     comm->open = &secure_schannel_open;
     comm->close = &secure_schannel_close;
     comm->send = &secure_schannel_send;
@@ -54,6 +54,14 @@ struct BoltConfig {
     int32_t max_connection_life_time;
     int32_t max_connection_acquisition_time;
     struct BoltSocketOptions* socket_options;
+    int32_t circuit_breaker_threshold;
+    int32_t circuit_breaker_reset_time;
+    char* wire_capture_directory;
+    int32_t lazy_decoding;
+    int32_t packed_lists;
+    int32_t packed_structures;
+    /// Buffers shared by the connections of a connector, created by the connector and never cloned
+    struct BoltBufferPool* buffer_pool;
 };
 
 BoltConfig* BoltConfig_clone(BoltConfig* config);
@@ -17,9 +17,12 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_POOLS
+
 #include "bolt-private.h"
 #include "config-private.h"
 #include "address-resolver-private.h"
+#include "buffer-pool.h"
 #include "log-private.h"
 #include "mem.h"
 
@@ -154,6 +157,13 @@ BoltConfig* BoltConfig_create()
     config->max_connection_life_time = 0;
     config->max_connection_acquisition_time = 0;
     config->socket_options = NULL;
+    config->circuit_breaker_threshold = 5;
+    config->circuit_breaker_reset_time = 30000;
+    config->wire_capture_directory = NULL;
+    config->lazy_decoding = 0;
+    config->packed_lists = 0;
+    config->packed_structures = 0;
+    config->buffer_pool = NULL;
     return config;
 }
 
@@ -172,6 +182,12 @@ BoltConfig* BoltConfig_clone(BoltConfig* config)
         BoltConfig_set_max_connection_life_time(clone, config->max_connection_life_time);
         BoltConfig_set_max_connection_acquisition_time(clone, config->max_connection_acquisition_time);
         BoltConfig_set_socket_options(clone, config->socket_options);
+        BoltConfig_set_circuit_breaker_threshold(clone, config->circuit_breaker_threshold);
+        BoltConfig_set_circuit_breaker_reset_time(clone, config->circuit_breaker_reset_time);
+        BoltConfig_set_wire_capture_directory(clone, config->wire_capture_directory);
+        BoltConfig_set_lazy_decoding(clone, config->lazy_decoding);
+        BoltConfig_set_packed_lists(clone, config->packed_lists);
+        BoltConfig_set_packed_structures(clone, config->packed_structures);
     }
     return clone;
 }
@@ -196,6 +212,12 @@ void BoltConfig_destroy(BoltConfig* config)
     if (config->socket_options!=NULL) {
         BoltSocketOptions_destroy(config->socket_options);
     }
+    if (config->wire_capture_directory!=NULL) {
+        BoltMem_deallocate(config->wire_capture_directory, SIZE_OF_C_STRING(config->wire_capture_directory));
+    }
+    if (config->buffer_pool!=NULL) {
+        BoltBufferPool_destroy(config->buffer_pool);
+    }
     BoltMem_deallocate(config, sizeof(BoltConfig));
 }
 
@@ -251,6 +273,10 @@ BoltValue* BoltConfig_get_routing_context(BoltConfig* config)
 int32_t BoltConfig_set_routing_context(BoltConfig* config, BoltValue* routing_context)
 {
     config->routing_context = BoltValue_duplicate(routing_context);
+    if (config->routing_context!=NULL) {
+        // Copied into every routing table request, and into the config clones
+        BoltValue_share(config->routing_context);
+    }
     return BOLT_SUCCESS;
 }
 
@@ -319,3 +345,76 @@ int32_t BoltConfig_set_socket_options(BoltConfig* config, BoltSocketOptions* soc
     config->socket_options = BoltSocketOptions_clone(socket_options);
     return BOLT_SUCCESS;
 }
+
+int32_t BoltConfig_get_circuit_breaker_threshold(BoltConfig* config)
+{
+    return config->circuit_breaker_threshold;
+}
+
+int32_t BoltConfig_set_circuit_breaker_threshold(BoltConfig* config, int32_t circuit_breaker_threshold)
+{
+    config->circuit_breaker_threshold = circuit_breaker_threshold;
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltConfig_get_circuit_breaker_reset_time(BoltConfig* config)
+{
+    return config->circuit_breaker_reset_time;
+}
+
+int32_t BoltConfig_set_circuit_breaker_reset_time(BoltConfig* config, int32_t circuit_breaker_reset_time)
+{
+    config->circuit_breaker_reset_time = circuit_breaker_reset_time;
+    return BOLT_SUCCESS;
+}
+
+const char* BoltConfig_get_wire_capture_directory(BoltConfig* config)
+{
+    return config->wire_capture_directory;
+}
+
+int32_t BoltConfig_set_wire_capture_directory(BoltConfig* config, const char* wire_capture_directory)
+{
+    if (config->wire_capture_directory!=NULL) {
+        BoltMem_deallocate(config->wire_capture_directory, SIZE_OF_C_STRING(config->wire_capture_directory));
+        config->wire_capture_directory = NULL;
+    }
+    if (wire_capture_directory!=NULL) {
+        config->wire_capture_directory = BoltMem_duplicate(wire_capture_directory,
+                SIZE_OF_C_STRING(wire_capture_directory));
+    }
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltConfig_get_lazy_decoding(BoltConfig* config)
+{
+    return config->lazy_decoding;
+}
+
+int32_t BoltConfig_set_lazy_decoding(BoltConfig* config, int32_t lazy_decoding)
+{
+    config->lazy_decoding = lazy_decoding;
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltConfig_get_packed_lists(BoltConfig* config)
+{
+    return config->packed_lists;
+}
+
+int32_t BoltConfig_set_packed_lists(BoltConfig* config, int32_t packed_lists)
+{
+    config->packed_lists = packed_lists;
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltConfig_get_packed_structures(BoltConfig* config)
+{
+    return config->packed_structures;
+}
+
+int32_t BoltConfig_set_packed_structures(BoltConfig* config, int32_t packed_structures)
+{
+    config->packed_structures = packed_structures;
+    return BOLT_SUCCESS;
+}
@@ -403,4 +403,138 @@ SEABOLT_EXPORT BoltSocketOptions* BoltConfig_get_socket_options(BoltConfig* conf
  */
 SEABOLT_EXPORT int32_t BoltConfig_set_socket_options(BoltConfig* config, BoltSocketOptions* socket_options);
 
+/**
+ * Gets the configured circuit breaker failure threshold.
+ *
+ * @param config the config instance to query.
+ * @return the configured circuit breaker failure threshold.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_get_circuit_breaker_threshold(BoltConfig* config);
+
+/**
+ * Sets the configured circuit breaker failure threshold.
+ *
+ * When routing, a server is taken out of selection after this many consecutive connection or protocol
+ * failures towards it. Set to 0 to disable circuit breaking.
+ *
+ * @param config the config instance to modify.
+ * @param circuit_breaker_threshold the circuit breaker failure threshold to set.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_set_circuit_breaker_threshold(BoltConfig* config, int32_t circuit_breaker_threshold);
+
+/**
+ * Gets the configured circuit breaker reset time.
+ *
+ * @param config the config instance to query.
+ * @return the configured circuit breaker reset time.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_get_circuit_breaker_reset_time(BoltConfig* config);
+
+/**
+ * Sets the configured circuit breaker reset time.
+ *
+ * This is the time in milliseconds an open circuit breaker waits before letting a single probe
+ * acquisition through to the server.
+ *
+ * @param config the config instance to modify.
+ * @param circuit_breaker_reset_time the circuit breaker reset time to set.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_set_circuit_breaker_reset_time(BoltConfig* config, int32_t circuit_breaker_reset_time);
+
+/**
+ * Gets the configured wire capture directory.
+ *
+ * @param config the config instance to query.
+ * @return the configured wire capture directory, or NULL if capturing is disabled.
+ */
+SEABOLT_EXPORT const char* BoltConfig_get_wire_capture_directory(BoltConfig* config);
+
+/**
+ * Sets the configured wire capture directory.
+ *
+ * When set, the bytes exchanged by each connection are recorded to a file named after the process id, the time
+ * the connection was opened and the connection id in this directory, for offline replay. Set to NULL (the
+ * default) to disable capturing.
+ *
+ * Files are only accessible to their owner, as they hold everything exchanged with the server in plain text,
+ * including query parameters and results. The initialisation message carrying the credentials is recorded as
+ * zeros.
+ *
+ * @param config the config instance to modify.
+ * @param wire_capture_directory the wire capture directory to set.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_set_wire_capture_directory(BoltConfig* config, const char* wire_capture_directory);
+
+/**
+ * Gets whether graph structures are decoded lazily.
+ *
+ * @param config the config instance to query.
+ * @return 1 if graph structures are decoded lazily, 0 otherwise.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_get_lazy_decoding(BoltConfig* config);
+
+/**
+ * Sets whether graph structures are decoded lazily.
+ *
+ * When enabled, received nodes, relationships and paths only keep their encoded fields, which are decoded as
+ * they are first accessed through \ref BoltStructure_value. Fields are decoded in order, so reading a node's id
+ * does not decode its labels or properties. This makes results holding graph structures with many properties
+ * cheaper to receive when only some of their fields are read. Disabled (0) by default.
+ *
+ * @param config the config instance to modify.
+ * @param lazy_decoding 1 to decode graph structures lazily, 0 to decode them as they are received.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_set_lazy_decoding(BoltConfig* config, int32_t lazy_decoding);
+
+/**
+ * Gets whether long lists of scalars are decoded as packed lists.
+ *
+ * @param config the config instance to query.
+ * @return 1 if long lists of scalars are decoded as packed lists, 0 otherwise.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_get_packed_lists(BoltConfig* config);
+
+/**
+ * Sets whether long lists of scalars are decoded as packed lists.
+ *
+ * When enabled, received lists of 16 or more integers, floats or booleans store their elements in a single dense
+ * array, read through \ref BoltList_integers, \ref BoltList_floats and \ref BoltList_booleans, instead of one
+ * \ref BoltValue per element. Callers enabling this should check \ref BoltList_packed_type before reading such
+ * lists, because \ref BoltList_value unpacks a packed list in place, which invalidates the arrays handed out for
+ * it. Disabled (0) by default.
+ *
+ * @param config the config instance to modify.
+ * @param packed_lists 1 to decode long lists of scalars as packed lists, 0 to decode them as ordinary lists.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_set_packed_lists(BoltConfig* config, int32_t packed_lists);
+
+/**
+ * Gets whether temporal and spatial structures are decoded as packed structures.
+ *
+ * @param config the config instance to query.
+ * @return 1 if temporal and spatial structures are decoded as packed structures, 0 otherwise.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_get_packed_structures(BoltConfig* config);
+
+/**
+ * Sets whether temporal and spatial structures are decoded as packed structures.
+ *
+ * When enabled, received points, dates, times, date times with an offset and durations keep their fields as plain
+ * integers and floats, read through \ref BoltStructure_integer and \ref BoltStructure_float, instead of one
+ * \ref BoltValue per field. Callers enabling this should read such structures through those functions only,
+ * because \ref BoltStructure_value unpacks a packed structure in place, which allocates its fields and modifies a
+ * value that other threads may be reading. Disabled (0) by default.
+ *
+ * @param config the config instance to modify.
+ * @param packed_structures 1 to decode temporal and spatial structures as packed structures, 0 to decode them as
+ * ordinary structures.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltConfig_set_packed_structures(BoltConfig* config, int32_t packed_structures);
+
 #endif //SEABOLT_CONFIG_H
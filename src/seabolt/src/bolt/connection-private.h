@@ -21,6 +21,7 @@
 
 #include "communication.h"
 #include "connection.h"
+#include "metrics-private.h"
 #include "status-private.h"
 #include "bolt.h"
 
@@ -31,20 +32,8 @@
 
 typedef void (* error_action_func)(struct BoltConnection*, void*);
 
-typedef struct BoltConnectionMetrics BoltConnectionMetrics;
-
 typedef struct BoltSecurityContext BoltSecurityContext;
 
-/**
- * Record of connection usage statistics.
- */
-struct BoltConnectionMetrics {
-    struct timespec time_opened;
-    struct timespec time_closed;
-    unsigned long long bytes_sent;
-    unsigned long long bytes_received;
-};
-
 struct BoltConnection {
     /// The agent currently responsible for using this connection
     const void* agent;
@@ -63,11 +52,25 @@ struct BoltConnection {
 
     /// The communication object
     BoltCommunication* comm;
+    /// Directory to record the exchanged bytes to, if any
+    const char* capture_directory;
+    /// Pool to take the buffers from on open and to return them to on close, if any
+    struct BoltBufferPool* buffer_pool;
+    /// Whether graph structures are decoded lazily, see \ref BoltConfig_set_lazy_decoding
+    int lazy_decoding;
+    /// Whether long lists of scalars are decoded packed, see \ref BoltConfig_set_packed_lists
+    int packed_lists;
+    /// Whether temporal and spatial structures are decoded packed, see \ref BoltConfig_set_packed_structures
+    int packed_structures;
 
     /// The protocol version used for this connection
     int32_t protocol_version;
     /// State required by the protocol
     struct BoltProtocol* protocol;
+    /// Protocol state kept from before the connection was last closed, reused on reopen if the version matches
+    struct BoltProtocol* idle_protocol;
+    /// The protocol version of the idle protocol state
+    int32_t idle_protocol_version;
 
     // These buffers contain data exactly as it is transmitted or
     // received. Therefore for Bolt v1, chunk headers are included
@@ -76,10 +79,12 @@ struct BoltConnection {
     /// Transmit buffer
     struct BoltBuffer* tx_buffer;
     /// Receive buffer
-    struct BoltBuffer* rx_buffer;
+    struct BoltRing* rx_ring;
 
     /// Connection metrics
     BoltConnectionMetrics* metrics;
+    /// Messages loaded into tx_buffer, counted as sent once the buffer is
+    int64_t messages_loaded;
     /// Current status of the connection
     BoltStatus* status;
 
@@ -128,6 +133,17 @@ void BoltConnection_destroy(BoltConnection* connection);
 int32_t BoltConnection_open(BoltConnection* connection, BoltTransport transport,
         BoltAddress* address, BoltTrust* trust, BoltLog* log, BoltSocketOptions* sock_opts);
 
+/**
+ * Frames the full chunks of the partially encoded message in _msg_buffer_ and sends them straight away, along
+ * with any requests queued before it. Used as a \ref PackStreamSink so that encoding very large requests needs
+ * at most about one chunk of buffer space.
+ *
+ * @param connection the connection, passed as void* to match \ref flush_func.
+ * @param msg_buffer the buffer holding the partially encoded message.
+ * @return \ref BOLT_SUCCESS on success, \ref BOLT_STATUS_SET if sending failed.
+ */
+int BoltConnection_send_chunks(void* connection, struct BoltBuffer* msg_buffer);
+
 /**
  * Closes the connection.
  *
@@ -161,4 +177,12 @@ BoltConnection_init(BoltConnection* connection, const char* user_agent, const Bo
  */
 int32_t BoltConnection_receive(BoltConnection* connection, char* buffer, int buffer_size);
 
+/**
+ * Shrinks the buffers of an idle connection that have not needed their current size since the last call, see
+ * \ref BoltBuffer_shrink.
+ *
+ * @param connection
+ */
+void BoltConnection_shrink_buffers(BoltConnection* connection);
+
 #endif //SEABOLT_CONNECTION_PRIVATE_H
@@ -17,8 +17,11 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_CONNECTIONS
+
 #include "bolt-private.h"
 #include "address-private.h"
+#include "buffer-pool.h"
 #include "config-private.h"
 #include "connection-private.h"
 #include "log-private.h"
@@ -29,6 +32,7 @@
 #include "v2.h"
 #include "v3.h"
 #include "atomic.h"
+#include "communication-capture.h"
 #include "communication-plain.h"
 #include "communication-secure.h"
 
@@ -37,6 +41,13 @@
 #define ERROR_CTX_SIZE 1024
 
 #define MAX_ID_LEN 32
+#define MAX_CAPTURE_PATH_LEN 4096
+
+#if USE_WINSOCK
+#define PROCESS_ID() ((long) GetCurrentProcessId())
+#else
+#define PROCESS_ID() ((long) getpid())
+#endif
 
 #define TRY(code, error_ctx_fmt, file, line) { \
     int status_try = (code); \
@@ -125,6 +136,25 @@ void _set_status_from_comm(BoltConnection* connection, BoltConnectionState state
     _set_status_with_ctx(connection, state, connection->comm->status->error, connection->comm->status->error_ctx);
 }
 
+void _destroy_protocol(struct BoltProtocol* protocol, int32_t protocol_version)
+{
+    if (protocol==NULL) return;
+
+    switch (protocol_version) {
+    case 1:
+        BoltProtocolV1_destroy_protocol(protocol);
+        break;
+    case 2:
+        BoltProtocolV2_destroy_protocol(protocol);
+        break;
+    case 3:
+        BoltProtocolV3_destroy_protocol(protocol);
+        break;
+    default:
+        break;
+    }
+}
+
 void _close(BoltConnection* connection)
 {
     BoltLog_info(connection->log, "[%s]: Closing connection", BoltConnection_id(connection));
@@ -134,17 +164,21 @@ void _close(BoltConnection* connection)
 
         switch (connection->protocol_version) {
         case 1:
-            BoltProtocolV1_destroy_protocol(connection->protocol);
+            BoltProtocolV1_recycle_protocol(connection->protocol);
             break;
         case 2:
-            BoltProtocolV2_destroy_protocol(connection->protocol);
+            BoltProtocolV2_recycle_protocol(connection->protocol);
             break;
         case 3:
-            BoltProtocolV3_destroy_protocol(connection->protocol);
+            BoltProtocolV3_recycle_protocol(connection->protocol);
             break;
         default:
             break;
         }
+        // Kept around so that reopening does not need to rebuild it
+        _destroy_protocol(connection->idle_protocol, connection->idle_protocol_version);
+        connection->idle_protocol = connection->protocol;
+        connection->idle_protocol_version = connection->protocol_version;
         connection->protocol = NULL;
         connection->protocol_version = 0;
     }
@@ -159,6 +193,40 @@ void _close(BoltConnection* connection)
     _set_status(connection, BOLT_CONNECTION_STATE_DISCONNECTED, BOLT_SUCCESS);
 }
 
+void _add_time_blocked(volatile int64_t* time_blocked, struct timespec* started)
+{
+    struct timespec now;
+    struct timespec diff;
+    BoltTime_get_time(&now);
+    BoltTime_diff_time(&diff, &now, started);
+    BoltAtomic_add(time_blocked, (int64_t) diff.tv_sec*NANOS_PER_SEC+diff.tv_nsec);
+}
+
+int _send(BoltConnection* connection, char* buffer, int size)
+{
+    struct timespec started;
+    BoltTime_get_time(&started);
+    int status = BoltCommunication_send(connection->comm, buffer, size, BoltConnection_id(connection));
+    _add_time_blocked(&connection->metrics->time_blocked_send, &started);
+    if (status==BOLT_SUCCESS) {
+        BoltAtomic_add(&connection->metrics->bytes_sent, size);
+    }
+    return status;
+}
+
+int _receive(BoltConnection* connection, char* buffer, int min_size, int max_size, int* received)
+{
+    struct timespec started;
+    BoltTime_get_time(&started);
+    int status = BoltCommunication_receive(connection->comm, buffer, min_size, max_size, received,
+            BoltConnection_id(connection));
+    _add_time_blocked(&connection->metrics->time_blocked_receive, &started);
+    if (status==BOLT_SUCCESS) {
+        BoltAtomic_add(&connection->metrics->bytes_received, *received);
+    }
+    return status;
+}
+
 int handshake_b(BoltConnection* connection, int32_t _1, int32_t _2, int32_t _3, int32_t _4)
 {
     BoltLog_info(connection->log, "[%s]: Performing handshake", BoltConnection_id(connection));
@@ -168,13 +236,13 @@ int handshake_b(BoltConnection* connection, int32_t _1, int32_t _2, int32_t _3,
     memcpy_be(&handshake[0x08], &_2, 4);
     memcpy_be(&handshake[0x0C], &_3, 4);
     memcpy_be(&handshake[0x10], &_4, 4);
-    int status = BoltCommunication_send(connection->comm, handshake, 20, BoltConnection_id(connection));
+    int status = _send(connection, handshake, 20);
     if (status!=BOLT_SUCCESS) {
         _set_status_from_comm(connection, BOLT_CONNECTION_STATE_DEFUNCT);
         return BOLT_STATUS_SET;
     }
     int received = 0;
-    status = BoltCommunication_receive(connection->comm, handshake, 4, 4, &received, BoltConnection_id(connection));
+    status = _receive(connection, handshake, 4, 4, &received);
     if (status!=BOLT_SUCCESS) {
         _set_status_from_comm(connection, BOLT_CONNECTION_STATE_DEFUNCT);
         return BOLT_STATUS_SET;
@@ -182,15 +250,35 @@ int handshake_b(BoltConnection* connection, int32_t _1, int32_t _2, int32_t _3,
     memcpy_be(&connection->protocol_version, &handshake[0], 4);
     BoltLog_info(connection->log, "[%s]: <SET protocol_version=%d>", BoltConnection_id(connection),
             connection->protocol_version);
+    if (connection->idle_protocol!=NULL && connection->idle_protocol_version==connection->protocol_version) {
+        connection->protocol = connection->idle_protocol;
+        connection->idle_protocol = NULL;
+        switch (connection->protocol_version) {
+        case 1:
+            BoltProtocolV1_reuse_protocol(connection->protocol);
+            break;
+        case 2:
+            BoltProtocolV2_reuse_protocol(connection->protocol);
+            break;
+        case 3:
+            BoltProtocolV3_reuse_protocol(connection->protocol);
+            break;
+        default:
+            break;
+        }
+        return BOLT_SUCCESS;
+    }
+    _destroy_protocol(connection->idle_protocol, connection->idle_protocol_version);
+    connection->idle_protocol = NULL;
     switch (connection->protocol_version) {
     case 1:
-        connection->protocol = BoltProtocolV1_create_protocol();
+        connection->protocol = BoltProtocolV1_create_protocol(connection->buffer_pool);
         return BOLT_SUCCESS;
     case 2:
-        connection->protocol = BoltProtocolV2_create_protocol();
+        connection->protocol = BoltProtocolV2_create_protocol(connection->buffer_pool);
         return BOLT_SUCCESS;
     case 3:
-        connection->protocol = BoltProtocolV3_create_protocol();
+        connection->protocol = BoltProtocolV3_create_protocol(connection->buffer_pool);
         return BOLT_SUCCESS;
     default:
         _close(connection);
@@ -205,18 +293,24 @@ BoltConnection* BoltConnection_create()
     memset(connection, 0, size);
     connection->access_mode = BOLT_ACCESS_MODE_WRITE;
     connection->status = BoltStatus_create_with_ctx(ERROR_CTX_SIZE);
-    connection->metrics = BoltMem_allocate(sizeof(BoltConnectionMetrics));
-    memset(connection->metrics, 0, sizeof(BoltConnectionMetrics));
+    connection->metrics = BoltConnectionMetrics_create();
     return connection;
 }
 
 void BoltConnection_destroy(BoltConnection* connection)
 {
+    _destroy_protocol(connection->idle_protocol, connection->idle_protocol_version);
+    if (connection->address!=NULL) {
+        BoltAddress_destroy((struct BoltAddress*) connection->address);
+    }
+    if (connection->id!=NULL) {
+        BoltMem_deallocate(connection->id, MAX_ID_LEN);
+    }
     if (connection->status!=NULL) {
         BoltStatus_destroy(connection->status);
     }
     if (connection->metrics!=NULL) {
-        BoltMem_deallocate(connection->metrics, sizeof(BoltConnectionMetrics));
+        BoltConnectionMetrics_destroy(connection->metrics);
     }
     BoltMem_deallocate(connection, sizeof(BoltConnection));
 }
@@ -228,12 +322,21 @@ BoltConnection_open(BoltConnection* connection, BoltTransport transport, struct
     if (connection->status->state!=BOLT_CONNECTION_STATE_DISCONNECTED) {
         BoltConnection_close(connection);
     }
-    // Id buffer composed of local&remote Endpoints
-    connection->id = BoltMem_allocate(MAX_ID_LEN);
+    // Id buffer composed of local&remote Endpoints, kept across reopen
+    if (connection->id==NULL) {
+        connection->id = BoltMem_allocate(MAX_ID_LEN);
+    }
     snprintf(connection->id, MAX_ID_LEN, "conn-%" PRId64, BoltAtomic_increment(&id_seq));
     connection->log = log;
-    // Store connection info
-    connection->address = BoltAddress_create(address->host, address->port);
+    // Store connection info, unless reopening to the same address
+    if (connection->address!=NULL && (strcmp(connection->address->host, address->host)!=0
+            || strcmp(connection->address->port, address->port)!=0)) {
+        BoltAddress_destroy((struct BoltAddress*) connection->address);
+        connection->address = NULL;
+    }
+    if (connection->address==NULL) {
+        connection->address = BoltAddress_create(address->host, address->port);
+    }
 
     switch (transport) {
     case BOLT_TRANSPORT_PLAINTEXT:
@@ -248,11 +351,19 @@ BoltConnection_open(BoltConnection* connection, BoltTransport transport, struct
         break;
     }
 
+    if (connection->capture_directory!=NULL) {
+        char path[MAX_CAPTURE_PATH_LEN];
+        // connection ids restart with every process, so the process and time tell captures of different runs apart
+        snprintf(path, MAX_CAPTURE_PATH_LEN, "%s/%ld-%" PRId64 "-%s.bolt", connection->capture_directory,
+                PROCESS_ID(), BoltTime_get_time_ms(), connection->id);
+        connection->comm = BoltCommunication_create_capture(connection->comm, path);
+    }
+
     int status = BoltCommunication_open(connection->comm, address, connection->id);
     if (status==BOLT_SUCCESS) {
         BoltTime_get_time(&connection->metrics->time_opened);
-        connection->tx_buffer = BoltBuffer_create(INITIAL_TX_BUFFER_SIZE);
-        connection->rx_buffer = BoltBuffer_create(INITIAL_RX_BUFFER_SIZE);
+        connection->tx_buffer = BoltBufferPool_acquire(connection->buffer_pool, INITIAL_TX_BUFFER_SIZE);
+        connection->rx_ring = BoltBufferPool_acquire_ring(connection->buffer_pool, INITIAL_RX_BUFFER_SIZE);
 
         TRY(handshake_b(connection, 3, 2, 1, 0), "BoltConnection_open(%s:%d), handshake_b error code: %d", __FILE__,
                 __LINE__);
@@ -272,70 +383,97 @@ void BoltConnection_close(BoltConnection* connection)
     if (connection->status->state!=BOLT_CONNECTION_STATE_DISCONNECTED) {
         _close(connection);
     }
-    if (connection->rx_buffer!=NULL) {
-        BoltBuffer_destroy(connection->rx_buffer);
-        connection->rx_buffer = NULL;
+    if (connection->rx_ring!=NULL) {
+        BoltBufferPool_release_ring(connection->buffer_pool, connection->rx_ring);
+        connection->rx_ring = NULL;
     }
     if (connection->tx_buffer!=NULL) {
-        BoltBuffer_destroy(connection->tx_buffer);
+        BoltBufferPool_release(connection->buffer_pool, connection->tx_buffer);
         connection->tx_buffer = NULL;
+        connection->messages_loaded = 0;
     }
-    if (connection->address!=NULL) {
-        BoltAddress_destroy((struct BoltAddress*) connection->address);
-        connection->address = NULL;
-    }
-    if (connection->id!=NULL) {
-        BoltMem_deallocate(connection->id, MAX_ID_LEN);
-        connection->id = NULL;
-    }
+    // The id, address and protocol state are kept for reuse until the connection is reopened or destroyed
 }
 
 int32_t BoltConnection_send(BoltConnection* connection)
 {
     int size = BoltBuffer_unloadable(connection->tx_buffer);
-    int status = BoltCommunication_send(connection->comm, BoltBuffer_unload_pointer(connection->tx_buffer, size), size,
-            BoltConnection_id(connection));
+    int status = _send(connection, BoltBuffer_unload_pointer(connection->tx_buffer, size), size);
     if (status!=BOLT_SUCCESS) {
         _set_status_from_comm(connection, BOLT_CONNECTION_STATE_DEFUNCT);
         status = BOLT_STATUS_SET;
     }
+    else {
+        BoltAtomic_add(&connection->metrics->messages_sent, connection->messages_loaded);
+    }
+    connection->messages_loaded = 0;
     BoltBuffer_compact(connection->tx_buffer);
     return status;
 }
 
+int BoltConnection_send_chunks(void* connection, struct BoltBuffer* msg_buffer)
+{
+    BoltConnection* conn = (BoltConnection*) connection;
+    int status = push_chunks_to_transmission(msg_buffer, conn->tx_buffer);
+    if (status!=BOLT_SUCCESS) {
+        return status;
+    }
+    return BoltConnection_send(conn);
+}
+
 int BoltConnection_receive(BoltConnection* connection, char* buffer, int size)
 {
     if (size==0) return 0;
-    int available = BoltBuffer_unloadable(connection->rx_buffer);
-    if (size>available) {
-        int delta = size-available;
-        while (delta>0) {
-            int max_size = BoltBuffer_loadable(connection->rx_buffer);
-            if (max_size==0) {
-                BoltBuffer_compact(connection->rx_buffer);
-                max_size = BoltBuffer_loadable(connection->rx_buffer);
-            }
-            max_size = delta>max_size ? delta : max_size;
-            int received = 0;
-            int status = BoltCommunication_receive(connection->comm,
-                    BoltBuffer_load_pointer(connection->rx_buffer, max_size), delta, max_size,
-                    &received, BoltConnection_id(connection));
-            if (status!=BOLT_SUCCESS) {
-                _set_status_from_comm(connection, BOLT_CONNECTION_STATE_DEFUNCT);
-                return BOLT_STATUS_SET;
-            }
-            // adjust the buffer extent based on the actual amount of data received
-            connection->rx_buffer->extent = connection->rx_buffer->extent-max_size+received;
-            delta -= received;
+    struct BoltRing* ring = connection->rx_ring;
+    int64_t copied = BoltRing_unload(ring, buffer, size);
+    while (copied<size) {
+        // the ring is empty here, so it is either refilled as a whole or bypassed
+        int64_t missing = size-copied;
+        int64_t max_size = missing;
+        char* target = buffer+copied;
+        int direct = missing>=ring->size;
+        if (!direct) {
+            target = BoltRing_load_pointer(ring, &max_size);
+        }
+        int received = 0;
+        int status = _receive(connection, target, (int) (missing<max_size ? missing : max_size), (int) max_size,
+                &received);
+        if (status!=BOLT_SUCCESS) {
+            _set_status_from_comm(connection, BOLT_CONNECTION_STATE_DEFUNCT);
+            return BOLT_STATUS_SET;
+        }
+        if (direct) {
+            copied += received;
+        }
+        else {
+            BoltRing_loaded(ring, received);
+            copied += BoltRing_unload(ring, buffer+copied, missing);
         }
     }
-    BoltBuffer_unload(connection->rx_buffer, buffer, size);
     return BOLT_SUCCESS;
 }
 
+void BoltConnection_shrink_buffers(BoltConnection* connection)
+{
+    if (connection->tx_buffer!=NULL) {
+        BoltBuffer_shrink(connection->tx_buffer, INITIAL_TX_BUFFER_SIZE);
+    }
+    if (connection->protocol!=NULL) {
+        connection->protocol->shrink_buffers(connection);
+    }
+}
+
 int BoltConnection_fetch(BoltConnection* connection, BoltRequest request)
 {
     const int fetched = connection->protocol->fetch(connection, request);
+    if (fetched>FETCH_RECORD) {
+        // A message that failed to decode is left partly unread, so the stream can no longer be followed
+        if (fetched!=BOLT_STATUS_SET) {
+            _set_status_with_ctx(connection, BOLT_CONNECTION_STATE_DEFUNCT, fetched,
+                    "BoltConnection_fetch(%s:%d), unable to decode message", __FILE__, __LINE__);
+        }
+        return FETCH_ERROR;
+    }
     if (fetched==FETCH_SUMMARY) {
         if (connection->protocol->is_success_summary(connection)) {
             _set_status(connection, BOLT_CONNECTION_STATE_READY, BOLT_SUCCESS);
@@ -402,7 +540,10 @@ BoltConnection_init(BoltConnection* connection, const char* user_agent, const st
     case 1:
     case 2:
     case 3: {
+        // keep the credentials in INIT or HELLO out of wire captures
+        BoltCapture_set_redacting(connection->comm, 1);
         int code = connection->protocol->init(connection, user_agent, auth_token);
+        BoltCapture_set_redacting(connection->comm, 0);
         switch (code) {
         case BOLT_V1_SUCCESS:
             _set_status(connection, BOLT_CONNECTION_STATE_READY, BOLT_SUCCESS);
@@ -502,6 +643,27 @@ BoltConnection_set_run_cypher_parameter(BoltConnection* connection, int32_t inde
     return connection->protocol->set_run_cypher_parameter(connection, index, name, name_size);
 }
 
+BoltWriter* BoltConnection_run_parameter_writer(BoltConnection* connection)
+{
+    return connection->protocol->run_parameter_writer(connection);
+}
+
+int32_t BoltConnection_set_run_statement(BoltConnection* connection, const BoltStatement* statement,
+        const int32_t n_parameter)
+{
+    TRY(connection->protocol->set_run_statement(connection, statement, n_parameter),
+            "BoltConnection_set_run_statement(%s:%d), error code: %d", __FILE__, __LINE__);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltConnection_set_run_encoded_parameters(BoltConnection* connection, const char* data,
+        const int32_t size)
+{
+    TRY(connection->protocol->set_run_encoded_parameters(connection, data, size),
+            "BoltConnection_set_run_encoded_parameters(%s:%d), error code: %d", __FILE__, __LINE__);
+    return BOLT_SUCCESS;
+}
+
 int32_t BoltConnection_set_run_bookmarks(BoltConnection* connection, struct BoltValue* bookmark_list)
 {
     TRY(connection->protocol->set_run_bookmark(connection, bookmark_list),
@@ -609,3 +771,8 @@ BoltStatus* BoltConnection_status(BoltConnection* connection)
 {
     return connection->status;
 }
+
+const BoltConnectionMetrics* BoltConnection_metrics(BoltConnection* connection)
+{
+    return connection->metrics;
+}
@@ -27,7 +27,10 @@
 #include "bolt-public.h"
 #include "address.h"
 #include "config.h"
+#include "metrics.h"
+#include "statement.h"
 #include "status.h"
+#include "writer.h"
 
 typedef uint64_t BoltRequest;
 
@@ -235,6 +238,56 @@ SEABOLT_EXPORT BoltValue*
 BoltConnection_set_run_cypher_parameter(BoltConnection* connection, int32_t index, const char* name,
         const uint64_t name_size);
 
+/**
+ * Returns a writer that encodes the parameters of the buffered RUN message directly, which is cheaper than
+ * populating the \ref BoltValue parameters for parameter-heavy queries. The parameters must be written as a
+ * single map, e.g.
+ *
+ *     BoltWriter* writer = BoltConnection_run_parameter_writer(connection);
+ *     BoltWriter_begin_map(writer, 1);
+ *     BoltWriter_key(writer, "x", 1);
+ *     BoltWriter_integer(writer, 42);
+ *     BoltWriter_end(writer);
+ *
+ * Any parameters set through \ref BoltConnection_set_run_cypher_parameter are discarded. The written parameters
+ * are used by every RUN loaded until the next call to \ref BoltConnection_set_run_cypher or
+ * \ref BoltConnection_clear_run.
+ *
+ * @param connection the instance on which to update buffered RUN message.
+ * @return the writer, owned by the connection.
+ */
+SEABOLT_EXPORT BoltWriter* BoltConnection_run_parameter_writer(BoltConnection* connection);
+
+/**
+ * Sets the registered statement and the number of parameters on the buffered RUN message. The statement is sent
+ * in its pre-encoded form, so frequently run queries are not re-encoded on every RUN. Parameters are set as for
+ * \ref BoltConnection_set_run_cypher.
+ *
+ * The statement is referenced, not copied, and must stay valid until the RUN message is loaded.
+ *
+ * @param connection the instance on which to update buffered RUN message.
+ * @param statement the statement created with \ref BoltStatement_create.
+ * @param n_parameter number of parameters.
+ * @return \ref BOLT_SUCCESS on success, an error code otherwise.
+ */
+SEABOLT_EXPORT int32_t
+BoltConnection_set_run_statement(BoltConnection* connection, const BoltStatement* statement,
+        const int32_t n_parameter);
+
+/**
+ * Sets already PackStream encoded parameters on the buffered RUN message, e.g. the contents of a \ref BoltWriter
+ * kept by the application for parameters that are sent repeatedly. Any other parameters are discarded.
+ *
+ * The data is referenced, not copied, and must stay valid until the RUN message is loaded.
+ *
+ * @param connection the instance on which to update buffered RUN message.
+ * @param data the encoded parameter map.
+ * @param size the size of the encoded parameter map.
+ * @return \ref BOLT_SUCCESS on success, \ref BOLT_PROTOCOL_VIOLATION if _data_ is not a map.
+ */
+SEABOLT_EXPORT int32_t
+BoltConnection_set_run_encoded_parameters(BoltConnection* connection, const char* data, const int32_t size);
+
 /**
  * Loads the buffered RUN message into the request queue.
  *
@@ -406,4 +459,12 @@ SEABOLT_EXPORT BoltValue* BoltConnection_metadata(BoltConnection* connection);
  */
 SEABOLT_EXPORT BoltStatus* BoltConnection_status(BoltConnection* connection);
 
+/**
+ * Returns the I/O statistics of the connection.
+ *
+ * @param connection the instance to query.
+ * @return a \ref BoltConnectionMetrics instance owned by the connection.
+ */
+SEABOLT_EXPORT const BoltConnectionMetrics* BoltConnection_metrics(BoltConnection* connection);
+
 #endif // SEABOLT_CONNECTION
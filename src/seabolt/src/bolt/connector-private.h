@@ -20,6 +20,7 @@
 #define SEABOLT_CONNECTOR_PRIVATE_H
 
 #include "connector.h"
+#include "sync.h"
 
 struct BoltConnector {
     const struct BoltAddress* address;
@@ -27,6 +28,11 @@ struct BoltConnector {
     const struct BoltConfig* config;
 
     void* pool_state;
+
+    mutex_t metrics_mutex;
+    /// Metrics text that did not fit the buffer of the last \ref BoltConnector_write_metrics call, for the next call
+    char* metrics_text;
+    int32_t metrics_length;
 };
 
 #endif //SEABOLT_CONNECTOR_PRIVATE_H
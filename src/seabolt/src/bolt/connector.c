@@ -17,9 +17,12 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_POOLS
+
 #include "bolt-private.h"
 
 #include "address-private.h"
+#include "buffer-pool.h"
 #include "config-private.h"
 #include "connector-private.h"
 #include "log-private.h"
@@ -28,8 +31,11 @@
 #include "mem.h"
 #include "routing-pool.h"
 #include "status-private.h"
+#include "string-builder.h"
 #include "connection-private.h"
 
+#define POOLED_BUFFER_BYTES 65536
+
 BoltConfig* BoltConnector_apply_defaults(BoltConfig* config)
 {
     if (config->trust==NULL) {
@@ -38,6 +44,12 @@ BoltConfig* BoltConnector_apply_defaults(BoltConfig* config)
     if (config->socket_options==NULL) {
         config->socket_options = BoltSocketOptions_create();
     }
+    if (config->buffer_pool==NULL) {
+        // Room for the three buffers and the ring of every connection a full pool may hold, buffers averaging no
+        // more than POOLED_BUFFER_BYTES each so a few connections that received huge results cannot pin memory
+        config->buffer_pool = BoltBufferPool_create(3*config->max_pool_size,
+                3*(int64_t) config->max_pool_size*POOLED_BUFFER_BYTES, config->max_pool_size);
+    }
     return config;
 }
 
@@ -46,8 +58,16 @@ BoltConnector_create(BoltAddress* address, BoltValue* auth_token, struct BoltCon
 {
     BoltConnector* connector = (BoltConnector*) BoltMem_allocate(sizeof(BoltConnector));
     connector->address = BoltAddress_create(address->host, address->port);
-    connector->auth_token = BoltValue_duplicate(auth_token);
+    BoltValue* auth_token_copy = BoltValue_duplicate(auth_token);
+    if (auth_token_copy!=NULL) {
+        // Copied into the INIT or HELLO message of every connection
+        BoltValue_share(auth_token_copy);
+    }
+    connector->auth_token = auth_token_copy;
     connector->config = BoltConnector_apply_defaults(BoltConfig_clone(config));
+    connector->metrics_text = NULL;
+    connector->metrics_length = 0;
+    BoltSync_mutex_create(&connector->metrics_mutex);
 
     BoltLog_info(connector->config->log, "[connector]: Version %s [%s]", SEABOLT_VERSION,
             SEABOLT_VERSION_HASH);
@@ -84,6 +104,10 @@ void BoltConnector_destroy(BoltConnector* connector)
         break;
     }
 
+    if (connector->metrics_text!=NULL) {
+        BoltMem_deallocate(connector->metrics_text, connector->metrics_length+1);
+    }
+    BoltSync_mutex_destroy(&connector->metrics_mutex);
     BoltConfig_destroy((struct BoltConfig*) connector->config);
     BoltAddress_destroy((BoltAddress*) connector->address);
     BoltValue_destroy((BoltValue*) connector->auth_token);
@@ -139,3 +163,112 @@ void BoltConnector_release(BoltConnector* connector, BoltConnection* connection)
         break;
     }
 }
+
+int32_t BoltConnector_connection_metrics(BoltConnector* connector, BoltConnectionMetrics* metrics)
+{
+    switch (connector->config->scheme) {
+    case BOLT_SCHEME_DIRECT:
+        BoltDirectPool_connection_metrics((struct BoltDirectPool*) connector->pool_state, metrics);
+        break;
+    case BOLT_SCHEME_NEO4J:
+        BoltRoutingPool_connection_metrics((struct BoltRoutingPool*) connector->pool_state, metrics);
+        break;
+    case BOLT_SCHEME_DIRECT_UNPOOLED:
+        BoltNoPool_connection_metrics((struct BoltNoPool*) connector->pool_state, metrics);
+        break;
+    default:
+        return BOLT_UNSUPPORTED;
+    }
+
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltConnector_pool_metrics(BoltConnector* connector, BoltPoolMetrics* metrics)
+{
+    switch (connector->config->scheme) {
+    case BOLT_SCHEME_DIRECT:
+        BoltDirectPool_pool_metrics((struct BoltDirectPool*) connector->pool_state, metrics);
+        break;
+    case BOLT_SCHEME_NEO4J:
+        BoltRoutingPool_pool_metrics((struct BoltRoutingPool*) connector->pool_state, metrics);
+        break;
+    case BOLT_SCHEME_DIRECT_UNPOOLED:
+        BoltNoPool_pool_metrics((struct BoltNoPool*) connector->pool_state, metrics);
+        break;
+    default:
+        return BOLT_UNSUPPORTED;
+    }
+
+    return BOLT_SUCCESS;
+}
+
+// Renders the metrics text into a copy owned by the connector, returning its length or -1 if the connector's
+// scheme is not supported
+int32_t _render_metrics(BoltConnector* connector)
+{
+    struct BoltServerMetrics* servers = NULL;
+    int32_t count = 0;
+    struct BoltRoutingMetrics routing;
+    int routed = 0;
+
+    switch (connector->config->scheme) {
+    case BOLT_SCHEME_DIRECT:
+        count = 1;
+        servers = BoltMem_allocate(SIZE_OF_SERVER_METRICS);
+        BoltDirectPool_server_metrics((struct BoltDirectPool*) connector->pool_state, servers);
+        break;
+    case BOLT_SCHEME_NEO4J:
+        count = BoltRoutingPool_server_metrics((struct BoltRoutingPool*) connector->pool_state, &servers);
+        BoltRoutingPool_routing_metrics((struct BoltRoutingPool*) connector->pool_state, &routing);
+        routed = 1;
+        break;
+    case BOLT_SCHEME_DIRECT_UNPOOLED:
+        count = 1;
+        servers = BoltMem_allocate(SIZE_OF_SERVER_METRICS);
+        BoltNoPool_server_metrics((struct BoltNoPool*) connector->pool_state, servers);
+        break;
+    default:
+        return -1;
+    }
+
+    struct StringBuilder* builder = StringBuilder_create();
+    BoltMetrics_write_text(builder, servers, count, routed ? &routing : NULL);
+    connector->metrics_length = StringBuilder_get_length(builder);
+    connector->metrics_text = BoltMem_duplicate(StringBuilder_get_string(builder), connector->metrics_length+1);
+    StringBuilder_destroy(builder);
+
+    for (int32_t i = 0; i<count; i++) {
+        BoltServerMetrics_cleanup(&servers[i]);
+    }
+    if (servers!=NULL) {
+        BoltMem_deallocate(servers, count*SIZE_OF_SERVER_METRICS);
+    }
+    return connector->metrics_length;
+}
+
+int32_t BoltConnector_write_metrics(BoltConnector* connector, char* dest, int32_t length)
+{
+    BoltSync_mutex_lock(&connector->metrics_mutex);
+    // the exported counters include the memory the rendering itself allocates, so freshly rendered text that does
+    // not fit is kept for the next call rather than rendered again with a different length, but only for that call
+    int kept = connector->metrics_text!=NULL;
+    int32_t text_length = kept ? connector->metrics_length : _render_metrics(connector);
+    if (text_length<0) {
+        BoltSync_mutex_unlock(&connector->metrics_mutex);
+        return -1;
+    }
+
+    if (dest!=NULL && length>0) {
+        int32_t copy_length = text_length<length ? text_length : length-1;
+        memcpy(dest, connector->metrics_text, (size_t) copy_length);
+        dest[copy_length] = 0;
+    }
+    if (kept || (dest!=NULL && text_length<length)) {
+        BoltMem_deallocate(connector->metrics_text, connector->metrics_length+1);
+        connector->metrics_text = NULL;
+        connector->metrics_length = 0;
+    }
+    BoltSync_mutex_unlock(&connector->metrics_mutex);
+
+    return text_length;
+}
@@ -94,4 +94,49 @@ SEABOLT_EXPORT BoltConnection* BoltConnector_acquire(BoltConnector* connector, B
  */
 SEABOLT_EXPORT void BoltConnector_release(BoltConnector* connector, BoltConnection* connection);
 
+/**
+ * Adds up the I/O statistics of all connections owned by the connector's pool(s) into the provided
+ * \ref BoltConnectionMetrics instance, which should be created with \ref BoltConnectionMetrics_create.
+ *
+ * Counters of connections in a routing cluster member pool that has since been cleaned up are retained.
+ *
+ * @param connector the instance to query.
+ * @param metrics the instance to accumulate the statistics into.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltConnector_connection_metrics(BoltConnector* connector, BoltConnectionMetrics* metrics);
+
+/**
+ * Adds up the statistics of the connector's pool(s) into the provided \ref BoltPoolMetrics instance, which
+ * should be created with \ref BoltPoolMetrics_create.
+ *
+ * For connectors with a \ref BOLT_SCHEME_NEO4J scheme, statistics of all cluster member pools are merged,
+ * including pools that have since been cleaned up.
+ *
+ * @param connector the instance to query.
+ * @param metrics the instance to accumulate the statistics into.
+ * @returns \ref BOLT_SUCCESS when the operation is successful, or another positive error code identifying the reason.
+ */
+SEABOLT_EXPORT int32_t BoltConnector_pool_metrics(BoltConnector* connector, BoltPoolMetrics* metrics);
+
+/**
+ * Renders driver statistics in the OpenMetrics text exposition format into the provided buffer.
+ *
+ * Exported families cover memory usage, pool occupancy and activity, acquisition times, connection I/O
+ * and, for connectors with a \ref BOLT_SCHEME_NEO4J scheme, routing table refreshes and circuit breaker
+ * states. Pool and connection statistics are labelled with the host and port of the server they belong to.
+ *
+ * The output is always NUL terminated. When the text does not fit, which includes calls with a NULL _dest_ to
+ * query its length, the truncated text is written and the full text is kept for the next call only, so that a
+ * buffer sized to the returned length receives exactly that text rather than a fresh snapshot of a possibly
+ * different length. Any later call renders a fresh snapshot.
+ *
+ * @param connector the instance to query.
+ * @param dest the destination buffer, or NULL to only query the length.
+ * @param length the size of the destination buffer.
+ * @returns the length of the full text excluding the terminating NUL, the output is truncated when this is not
+ * less than _length_, or -1 if the connector's scheme is not supported.
+ */
+SEABOLT_EXPORT int32_t BoltConnector_write_metrics(BoltConnector* connector, char* dest, int32_t length);
+
 #endif //SEABOLT_ALL_CONNECTOR_H
@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_POOLS
+
 #include "bolt-private.h"
 #include "address-private.h"
 #include "atomic.h"
@@ -47,6 +49,7 @@ void close_pool_entry(struct BoltDirectPool* pool, int index)
         }
 
         BoltConnection_close(connection);
+        pool->metrics->connections_closed += 1;
     }
 }
 
@@ -72,6 +75,7 @@ int find_unused_connection(struct BoltDirectPool* pool)
                                 BoltConnection_id(connection));
 
                         close_pool_entry(pool, i);
+                        pool->metrics->lifetime_expiries += 1;
                     }
                 }
             }
@@ -141,9 +145,19 @@ int open_init(struct BoltDirectPool* pool, int index)
         return BOLT_ADDRESS_NOT_RESOLVED;  // Could not resolve address
     }
     struct BoltConnection* connection = pool->connections[index];
+    if (connection->status->state!=BOLT_CONNECTION_STATE_DISCONNECTED) {
+        // BoltConnection_open will close it first
+        pool->metrics->connections_closed += 1;
+    }
+    connection->capture_directory = pool->config->wire_capture_directory;
+    connection->lazy_decoding = pool->config->lazy_decoding;
+    connection->packed_lists = pool->config->packed_lists;
+    connection->packed_structures = pool->config->packed_structures;
+    connection->buffer_pool = pool->config->buffer_pool;
     switch (BoltConnection_open(connection, pool->config->transport, pool->address, pool->config->trust,
             pool->config->log, pool->config->socket_options)) {
     case 0:
+        pool->metrics->connections_opened += 1;
         return init(pool, index);
     default:
         return BOLT_CONNECTION_HAS_MORE_INFO;  // Could not open socket
@@ -156,6 +170,7 @@ int reset_or_open_init(struct BoltDirectPool* pool, int index)
     case 0:
         return BOLT_SUCCESS;
     default:
+        pool->metrics->reset_failures += 1;
         return open_init(pool, index);
     }
 }
@@ -166,6 +181,7 @@ void reset_or_close(struct BoltDirectPool* pool, int index)
     case 0:
         break;
     default:
+        pool->metrics->reset_failures += 1;
         close_pool_entry(pool, index);
     }
 }
@@ -185,6 +201,7 @@ struct BoltDirectPool* BoltDirectPool_create(const struct BoltAddress* address,
     pool->auth_token = auth_token;
     pool->max_size = config->max_pool_size;
     pool->in_use_count = 0;
+    pool->metrics = BoltPoolMetrics_create();
     pool->connections = (struct BoltConnection**) BoltMem_allocate(config->max_pool_size*sizeof(BoltConnection*));
     for (int i = 0; i<config->max_pool_size; i++) {
         pool->connections[i] = BoltConnection_create();
@@ -212,6 +229,7 @@ void BoltDirectPool_destroy(struct BoltDirectPool* pool)
         BoltConnection_destroy(pool->connections[index]);
     }
     BoltMem_deallocate(pool->connections, pool->max_size*sizeof(BoltConnection*));
+    BoltPoolMetrics_destroy(pool->metrics);
     if (pool->sec_context!=NULL) {
         BoltSecurityContext_destroy(pool->sec_context);
     }
@@ -226,12 +244,16 @@ BoltConnection* BoltDirectPool_acquire(struct BoltDirectPool* pool, BoltStatus*
 {
     int index = 0;
     int pool_error;
+    int found_full = 0;
     BoltConnection* connection = NULL;
+    struct timespec started;
+    BoltTime_get_time(&started);
 
     BoltLog_info(pool->config->log, "[%s]: Acquiring connection from the pool towards %s:%s", pool->id,
             pool->address->host, pool->address->port);
 
     BoltSync_mutex_lock(&pool->mutex);
+    pool->metrics->acquisitions += 1;
 
     while (1) {
         index = find_unused_connection(pool);
@@ -288,6 +310,12 @@ BoltConnection* BoltDirectPool_acquire(struct BoltDirectPool* pool, BoltStatus*
             break;
         }
 
+        // Counted once per acquisition, however many times it has to wait for a released connection
+        if (status->error==BOLT_POOL_FULL && !found_full) {
+            pool->metrics->pool_full_events += 1;
+            found_full = 1;
+        }
+
         // Retry acquire operation until we get a live connection or timeout
         if (status->error==BOLT_POOL_FULL && pool->config->max_connection_acquisition_time>0) {
             BoltLog_info(pool->config->log,
@@ -302,6 +330,7 @@ BoltConnection* BoltDirectPool_acquire(struct BoltDirectPool* pool, BoltStatus*
             status->state = BOLT_CONNECTION_STATE_DISCONNECTED;
             status->error = BOLT_POOL_ACQUISITION_TIMED_OUT;
             status->error_ctx = NULL;
+            pool->metrics->acquisition_timeouts += 1;
         }
 
         break;
@@ -311,6 +340,12 @@ BoltConnection* BoltDirectPool_acquire(struct BoltDirectPool* pool, BoltStatus*
         BoltAtomic_increment(&pool->in_use_count);
     }
 
+    struct timespec now;
+    struct timespec elapsed;
+    BoltTime_get_time(&now);
+    BoltTime_diff_time(&elapsed, &now, &started);
+    BoltHistogram_record(&pool->metrics->acquisition_time, (int64_t) elapsed.tv_sec*1000000+elapsed.tv_nsec/1000);
+
     BoltSync_mutex_unlock(&pool->mutex);
 
     return connection;
@@ -329,6 +364,7 @@ int BoltDirectPool_release(struct BoltDirectPool* pool, struct BoltConnection* c
         connection->protocol->clear_begin_tx(connection);
 
         reset_or_close(pool, index);
+        BoltConnection_shrink_buffers(connection);
 
         BoltSync_cond_signal(&pool->released_cond);
     }
@@ -342,3 +378,27 @@ int BoltDirectPool_connections_in_use(struct BoltDirectPool* pool)
     return (int) BoltAtomic_add(&pool->in_use_count, 0);
 }
 
+void BoltDirectPool_connection_metrics(struct BoltDirectPool* pool, BoltConnectionMetrics* metrics)
+{
+    BoltSync_mutex_lock(&pool->mutex);
+    for (int i = 0; i<pool->max_size; i++) {
+        BoltConnectionMetrics_add(metrics, pool->connections[i]->metrics);
+    }
+    BoltSync_mutex_unlock(&pool->mutex);
+}
+
+void BoltDirectPool_pool_metrics(struct BoltDirectPool* pool, BoltPoolMetrics* metrics)
+{
+    BoltSync_mutex_lock(&pool->mutex);
+    BoltPoolMetrics_add(metrics, pool->metrics);
+    BoltSync_mutex_unlock(&pool->mutex);
+}
+
+void BoltDirectPool_server_metrics(struct BoltDirectPool* pool, struct BoltServerMetrics* metrics)
+{
+    BoltServerMetrics_init(metrics, pool->address->host, pool->address->port);
+    metrics->pool_size = pool->max_size;
+    metrics->connections_in_use = BoltDirectPool_connections_in_use(pool);
+    BoltDirectPool_connection_metrics(pool, &metrics->connection_metrics);
+    BoltDirectPool_pool_metrics(pool, &metrics->pool_metrics);
+}
@@ -28,6 +28,8 @@
 #include "connector.h"
 #include "sync.h"
 
+struct BoltServerMetrics;
+
 typedef struct BoltDirectPool {
     mutex_t mutex;
     cond_t released_cond;
@@ -39,6 +41,7 @@ typedef struct BoltDirectPool {
     int max_size;
     volatile int64_t in_use_count;
     BoltConnection** connections;
+    BoltPoolMetrics* metrics;
 } BoltDirectPool;
 
 #define SIZE_OF_DIRECT_POOL sizeof(struct BoltDirectPool)
@@ -56,4 +59,10 @@ int BoltDirectPool_release(struct BoltDirectPool* pool, struct BoltConnection* c
 
 int BoltDirectPool_connections_in_use(struct BoltDirectPool* pool);
 
+void BoltDirectPool_connection_metrics(struct BoltDirectPool* pool, BoltConnectionMetrics* metrics);
+
+void BoltDirectPool_pool_metrics(struct BoltDirectPool* pool, BoltPoolMetrics* metrics);
+
+void BoltDirectPool_server_metrics(struct BoltDirectPool* pool, struct BoltServerMetrics* metrics);
+
 #endif //SEABOLT_POOLING_H
@@ -84,6 +84,12 @@ const char* BoltError_get_string(int32_t code)
         return "routing table refresh failed";
     case BOLT_ROUTING_UNEXPECTED_DISCOVERY_RESPONSE:
         return "invalid discovery response";
+    case BOLT_ROUTING_CIRCUIT_OPEN:
+        return "circuit breaker towards the selected server is open";
+    case BOLT_ALLOCATOR_IN_USE:
+        return "allocator can not be replaced once memory has been allocated";
+    case BOLT_ALLOCATOR_INCOMPLETE:
+        return "allocator must provide all of its functions";
     case BOLT_CONNECTION_HAS_MORE_INFO:
         return "error set in connection";
     case BOLT_STATUS_SET:
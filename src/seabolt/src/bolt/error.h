@@ -83,6 +83,12 @@
 #define BOLT_ROUTING_UNABLE_TO_REFRESH_ROUTING_TABLE   0x803
 /// Invalid discovery response
 #define BOLT_ROUTING_UNEXPECTED_DISCOVERY_RESPONSE   0x804
+/// Circuit breaker towards the selected server is open
+#define BOLT_ROUTING_CIRCUIT_OPEN   0x805
+/// Custom allocator set after memory was allocated
+#define BOLT_ALLOCATOR_IN_USE   0x900
+/// Custom allocator provided without all of its functions
+#define BOLT_ALLOCATOR_INCOMPLETE   0x901
 /// Error set in connection
 #define BOLT_CONNECTION_HAS_MORE_INFO   0xFFE
 /// Error set in connection
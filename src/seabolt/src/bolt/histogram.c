@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bolt-private.h"
+#include "histogram.h"
+
+void BoltHistogram_init(BoltHistogram* histogram)
+{
+    memset(histogram, 0, sizeof(BoltHistogram));
+}
+
+int BoltHistogram_bucket_index(int64_t value)
+{
+    if (value<2*BOLT_HISTOGRAM_SUB_BUCKET_COUNT) {
+        return value<0 ? 0 : (int) value;
+    }
+
+    if (value>=((int64_t) 1 << BOLT_HISTOGRAM_MAX_BITS)) {
+        return BOLT_HISTOGRAM_BUCKET_COUNT-1;
+    }
+
+    int msb = 0;
+    while ((value >> (msb+1))!=0) {
+        msb++;
+    }
+
+    // keep the top SUB_BUCKET_BITS+1 bits of the value, the leading one selects the upper half of a range
+    int shift = msb-BOLT_HISTOGRAM_SUB_BUCKET_BITS;
+    return shift*BOLT_HISTOGRAM_SUB_BUCKET_COUNT+(int) (value >> shift);
+}
+
+int64_t BoltHistogram_bucket_upper_bound(int index)
+{
+    if (index<2*BOLT_HISTOGRAM_SUB_BUCKET_COUNT) {
+        return index;
+    }
+
+    int shift = index/BOLT_HISTOGRAM_SUB_BUCKET_COUNT-1;
+    int64_t mantissa = index%BOLT_HISTOGRAM_SUB_BUCKET_COUNT+BOLT_HISTOGRAM_SUB_BUCKET_COUNT;
+    return ((mantissa+1) << shift)-1;
+}
+
+void BoltHistogram_record(BoltHistogram* histogram, int64_t value)
+{
+    if (value<0) {
+        value = 0;
+    }
+
+    histogram->buckets[BoltHistogram_bucket_index(value)] += 1;
+    if (histogram->count==0 || value<histogram->min) {
+        histogram->min = value;
+    }
+    if (value>histogram->max) {
+        histogram->max = value;
+    }
+    histogram->count += 1;
+    histogram->sum += value;
+}
+
+void BoltHistogram_add(BoltHistogram* total, const BoltHistogram* histogram)
+{
+    if (histogram->count==0) {
+        return;
+    }
+
+    for (int i = 0; i<BOLT_HISTOGRAM_BUCKET_COUNT; i++) {
+        total->buckets[i] += histogram->buckets[i];
+    }
+    if (total->count==0 || histogram->min<total->min) {
+        total->min = histogram->min;
+    }
+    if (histogram->max>total->max) {
+        total->max = histogram->max;
+    }
+    total->count += histogram->count;
+    total->sum += histogram->sum;
+}
+
+int64_t BoltHistogram_value_at_percentile(const BoltHistogram* histogram, double percentile)
+{
+    if (histogram->count==0) {
+        return 0;
+    }
+
+    if (percentile>100.0) {
+        percentile = 100.0;
+    }
+
+    int64_t target = (int64_t) (percentile/100.0*(double) histogram->count+0.5);
+    if (target<1) {
+        target = 1;
+    }
+
+    int64_t seen = 0;
+    for (int i = 0; i<BOLT_HISTOGRAM_BUCKET_COUNT; i++) {
+        seen += histogram->buckets[i];
+        if (seen>=target) {
+            int64_t value = BoltHistogram_bucket_upper_bound(i);
+            return value>histogram->max ? histogram->max : value;
+        }
+    }
+
+    return histogram->max;
+}
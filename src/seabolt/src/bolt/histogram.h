@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_HISTOGRAM_H
+#define SEABOLT_HISTOGRAM_H
+
+#include "bolt-public.h"
+
+/**
+ * Number of bits of a recorded value that are kept exactly within each power of two range.
+ *
+ * With 5 bits every recorded value is represented by a bucket whose width is at most 1/32 (~3%) of the value.
+ */
+#define BOLT_HISTOGRAM_SUB_BUCKET_BITS 5
+#define BOLT_HISTOGRAM_SUB_BUCKET_COUNT (1 << BOLT_HISTOGRAM_SUB_BUCKET_BITS)
+/// Values at or above 2^BOLT_HISTOGRAM_MAX_BITS are recorded into the last bucket
+#define BOLT_HISTOGRAM_MAX_BITS 32
+#define BOLT_HISTOGRAM_BUCKET_COUNT \
+    ((BOLT_HISTOGRAM_MAX_BITS-BOLT_HISTOGRAM_SUB_BUCKET_BITS+1)*BOLT_HISTOGRAM_SUB_BUCKET_COUNT)
+
+/**
+ * A log-linear (HDR style) histogram of non-negative integer values with a fixed memory footprint.
+ *
+ * Not thread safe, callers are expected to provide their own locking.
+ */
+typedef struct BoltHistogram {
+    int64_t count;
+    int64_t sum;
+    int64_t min;
+    int64_t max;
+    int64_t buckets[BOLT_HISTOGRAM_BUCKET_COUNT];
+} BoltHistogram;
+
+void BoltHistogram_init(BoltHistogram* histogram);
+
+void BoltHistogram_record(BoltHistogram* histogram, int64_t value);
+
+void BoltHistogram_add(BoltHistogram* total, const BoltHistogram* histogram);
+
+int64_t BoltHistogram_value_at_percentile(const BoltHistogram* histogram, double percentile);
+
+int BoltHistogram_bucket_index(int64_t value);
+
+int64_t BoltHistogram_bucket_upper_bound(int index);
+
+#endif //SEABOLT_HISTOGRAM_H
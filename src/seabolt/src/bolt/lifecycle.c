@@ -21,6 +21,8 @@
 #include "lifecycle.h"
 #include "communication.h"
 #include "communication-secure.h"
+#include "slab.h"
+#include "log-async.h"
 
 void Bolt_startup()
 {
@@ -28,6 +30,8 @@ void Bolt_startup()
     WSADATA data;
     WSAStartup(MAKEWORD(2, 2), &data);
 #endif
+    BoltSlab_startup();
+    BoltAsyncLog_startup();
     BoltCommunication_startup();
     BoltSecurityContext_startup();
 }
@@ -40,5 +44,7 @@ void Bolt_shutdown()
 
     BoltSecurityContext_shutdown();
     BoltCommunication_shutdown();
+    BoltAsyncLog_shutdown();
+    BoltSlab_shutdown();
 }
 
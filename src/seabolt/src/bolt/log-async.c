@@ -0,0 +1,752 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_LOGGING
+
+#include "bolt-private.h"
+#include "atomic.h"
+#include "log-async.h"
+#include "log-private.h"
+#include "mem.h"
+#include "string-builder.h"
+
+#define BOLT_LOG_PADDING (-1)
+
+#define ALIGN_RECORD(size) (((size)+7) & ~((int64_t) 7))
+
+#define MAX_SPEC_LENGTH 32
+
+#define NO_PRECISION (-1)
+#define STAR_PRECISION (-2)
+
+enum BoltLogModifier {
+    MODIFIER_NONE,
+    MODIFIER_HH,
+    MODIFIER_H,
+    MODIFIER_L,
+    MODIFIER_LL,
+    MODIFIER_Z,
+    MODIFIER_J,
+    MODIFIER_T,
+    MODIFIER_UNSUPPORTED
+};
+
+/**
+ * Single conversion specification within a format string.
+ */
+struct BoltLogSpec {
+    const char* start;
+    int length;
+    char conversion;
+    enum BoltLogModifier modifier;
+    int star_count;
+    /// Explicit precision, \ref NO_PRECISION or \ref STAR_PRECISION when taken from the last star argument
+    int precision;
+};
+
+union BoltLogArgument {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const void* p;
+    int64_t string_offset;
+};
+
+/// Rings of one thread, keyed by the id of the log they belong to
+struct BoltLogThreadRing {
+    int64_t log_id;
+    struct BoltLogRing* ring;
+};
+
+struct BoltLogThread {
+    int32_t count;
+    int32_t capacity;
+    struct BoltLogThreadRing* rings;
+};
+
+struct BoltLogRecord {
+    int32_t size;
+    int16_t level;
+    int16_t argument_count;
+    const char* format;
+};
+
+#define SIZE_OF_RECORD_HEADER ALIGN_RECORD((int64_t) sizeof(struct BoltLogRecord))
+
+static volatile int64_t async_log_seq = 0;
+
+static BOLT_THREAD_LOCAL int64_t cached_log_id = 0;
+static BOLT_THREAD_LOCAL struct BoltLogRing* cached_ring = NULL;
+static BOLT_THREAD_LOCAL struct BoltLogThread* thread_rings = NULL;
+
+/// Live asynchronous logs, so that exiting threads only touch rings that still exist
+static struct {
+    int started;
+    mutex_t mutex;
+    thread_key_t key;
+    struct BoltAsyncLog* logs;
+} live = {0, NULL, NULL, NULL};
+
+// Locates the next conversion specification, returning NULL when there are no more
+const char* _next_spec(const char* format, struct BoltLogSpec* spec)
+{
+    const char* cursor = strchr(format, '%');
+    if (cursor==NULL) {
+        return NULL;
+    }
+
+    spec->start = cursor++;
+    spec->star_count = 0;
+    spec->precision = NO_PRECISION;
+    spec->modifier = MODIFIER_NONE;
+    while (*cursor!=0 && strchr("-+ #0", *cursor)!=NULL) {
+        cursor++;
+    }
+    for (int part = 0; part<2; part++) {
+        if (part==1) {
+            if (*cursor!='.') {
+                break;
+            }
+            cursor++;
+            spec->precision = 0;
+        }
+        if (*cursor=='*') {
+            spec->star_count++;
+            spec->precision = part==1 ? STAR_PRECISION : spec->precision;
+            cursor++;
+        }
+        while (*cursor>='0' && *cursor<='9') {
+            spec->precision = part==1 ? spec->precision*10+(*cursor-'0') : spec->precision;
+            cursor++;
+        }
+    }
+    switch (*cursor) {
+    case 'h':
+        spec->modifier = cursor[1]=='h' ? MODIFIER_HH : MODIFIER_H;
+        cursor += cursor[1]=='h' ? 2 : 1;
+        break;
+    case 'l':
+        spec->modifier = cursor[1]=='l' ? MODIFIER_LL : MODIFIER_L;
+        cursor += cursor[1]=='l' ? 2 : 1;
+        break;
+    case 'z':
+        spec->modifier = MODIFIER_Z;
+        cursor++;
+        break;
+    case 'j':
+        spec->modifier = MODIFIER_J;
+        cursor++;
+        break;
+    case 't':
+        spec->modifier = MODIFIER_T;
+        cursor++;
+        break;
+    case 'L':
+        spec->modifier = MODIFIER_UNSUPPORTED;
+        cursor++;
+        break;
+    default:
+        break;
+    }
+    spec->conversion = *cursor;
+    spec->length = (int) (cursor-spec->start)+(*cursor!=0 ? 1 : 0);
+    return spec->start;
+}
+
+int64_t _capture_signed(enum BoltLogModifier modifier, va_list* args)
+{
+    switch (modifier) {
+    case MODIFIER_L:
+        return va_arg(*args, long);
+    case MODIFIER_LL:
+        return va_arg(*args, long long);
+    case MODIFIER_Z:
+        return (int64_t) va_arg(*args, size_t);
+    case MODIFIER_J:
+        return va_arg(*args, intmax_t);
+    case MODIFIER_T:
+        return va_arg(*args, ptrdiff_t);
+    default:
+        return va_arg(*args, int);
+    }
+}
+
+uint64_t _capture_unsigned(enum BoltLogModifier modifier, va_list* args)
+{
+    switch (modifier) {
+    case MODIFIER_L:
+        return va_arg(*args, unsigned long);
+    case MODIFIER_LL:
+        return va_arg(*args, unsigned long long);
+    case MODIFIER_Z:
+        return va_arg(*args, size_t);
+    case MODIFIER_J:
+        return va_arg(*args, uintmax_t);
+    case MODIFIER_T:
+        return (uint64_t) va_arg(*args, ptrdiff_t);
+    default:
+        return va_arg(*args, unsigned int);
+    }
+}
+
+// Number of bytes of string printed by spec, never reading past the precision as the string does not have
+// to be terminated within it
+int64_t _string_length(const struct BoltLogSpec* spec, const union BoltLogArgument* stars, const char* string)
+{
+    int64_t precision = spec->precision==STAR_PRECISION ? stars[spec->star_count-1].i : spec->precision;
+    if (precision<0) {
+        return (int64_t) strlen(string);
+    }
+    const char* end = (const char*) memchr(string, 0, (size_t) precision);
+    return end!=NULL ? end-string : precision;
+}
+
+// Captures the arguments referenced by format, returning the number of captured arguments or -1 if the
+// call can not be deferred
+int _capture(const char* format, va_list* args, union BoltLogArgument* arguments, int64_t* strings_size)
+{
+    int count = 0;
+    struct BoltLogSpec spec;
+    *strings_size = 0;
+    while (_next_spec(format, &spec)!=NULL) {
+        format = spec.start+spec.length;
+        if (spec.conversion=='%') {
+            continue;
+        }
+        if (spec.modifier==MODIFIER_UNSUPPORTED || count+spec.star_count+1>BOLT_LOG_MAX_ARGUMENTS) {
+            return -1;
+        }
+        for (int i = 0; i<spec.star_count; i++) {
+            arguments[count++].i = va_arg(*args, int);
+        }
+        switch (spec.conversion) {
+        case 'd':
+        case 'i':
+            arguments[count++].i = _capture_signed(spec.modifier, args);
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            arguments[count++].u = _capture_unsigned(spec.modifier, args);
+            break;
+        case 'c':
+            if (spec.modifier!=MODIFIER_NONE) {
+                return -1;
+            }
+            arguments[count++].i = va_arg(*args, int);
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            arguments[count++].d = va_arg(*args, double);
+            break;
+        case 'p':
+            arguments[count++].p = va_arg(*args, void*);
+            break;
+        case 's': {
+            if (spec.modifier!=MODIFIER_NONE) {
+                return -1;
+            }
+            const char* string = va_arg(*args, const char*);
+            arguments[count].p = string;
+            *strings_size += string!=NULL ? _string_length(&spec, &arguments[count-spec.star_count], string)+1 : 0;
+            count++;
+            break;
+        }
+        default:
+            return -1;
+        }
+    }
+    return count;
+}
+
+#define APPEND_ARGUMENT(builder, spec_format, stars, arguments, value) \
+    do { \
+        if ((stars)==2) { \
+            StringBuilder_append_f(builder, spec_format, (int) (arguments)[0].i, (int) (arguments)[1].i, value); \
+        } \
+        else if ((stars)==1) { \
+            StringBuilder_append_f(builder, spec_format, (int) (arguments)[0].i, value); \
+        } \
+        else { \
+            StringBuilder_append_f(builder, spec_format, value); \
+        } \
+    } while (0)
+
+void _render(struct StringBuilder* builder, const struct BoltLogRecord* record)
+{
+    const union BoltLogArgument* arguments = (const union BoltLogArgument*) ((const char*) record
+            +SIZE_OF_RECORD_HEADER);
+    const char* format = record->format;
+    char spec_format[MAX_SPEC_LENGTH];
+    struct BoltLogSpec spec;
+    int index = 0;
+    while (_next_spec(format, &spec)!=NULL) {
+        StringBuilder_append_n(builder, format, (int) (spec.start-format));
+        format = spec.start+spec.length;
+        if (spec.conversion=='%') {
+            StringBuilder_append(builder, "%");
+            continue;
+        }
+        if (spec.length>=MAX_SPEC_LENGTH) {
+            StringBuilder_append(builder, "?");
+            index += spec.star_count+1;
+            continue;
+        }
+        memcpy(spec_format, spec.start, (size_t) spec.length);
+        spec_format[spec.length] = 0;
+
+        const union BoltLogArgument* stars = &arguments[index];
+        const union BoltLogArgument* value = &arguments[index+spec.star_count];
+        index += spec.star_count+1;
+        switch (spec.conversion) {
+        case 'd':
+        case 'i':
+            switch (spec.modifier) {
+            case MODIFIER_L:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (long) value->i);
+                break;
+            case MODIFIER_LL:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (long long) value->i);
+                break;
+            case MODIFIER_Z:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (size_t) value->i);
+                break;
+            case MODIFIER_J:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (intmax_t) value->i);
+                break;
+            case MODIFIER_T:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (ptrdiff_t) value->i);
+                break;
+            default:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (int) value->i);
+                break;
+            }
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            switch (spec.modifier) {
+            case MODIFIER_L:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (unsigned long) value->u);
+                break;
+            case MODIFIER_LL:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (unsigned long long) value->u);
+                break;
+            case MODIFIER_Z:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (size_t) value->u);
+                break;
+            case MODIFIER_J:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (uintmax_t) value->u);
+                break;
+            case MODIFIER_T:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (ptrdiff_t) value->u);
+                break;
+            default:
+                APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (unsigned int) value->u);
+                break;
+            }
+            break;
+        case 'c':
+            APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, (int) value->i);
+            break;
+        case 'p':
+            APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, value->p);
+            break;
+        case 's': {
+            const char* string = value->string_offset<0 ? NULL : (const char*) record+value->string_offset;
+            APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, string);
+            break;
+        }
+        default:
+            APPEND_ARGUMENT(builder, spec_format, spec.star_count, stars, value->d);
+            break;
+        }
+    }
+    StringBuilder_append(builder, format);
+}
+
+void _thread_exit(void* value)
+{
+    struct BoltLogThread* thread = (struct BoltLogThread*) value;
+    BoltSync_mutex_lock(&live.mutex);
+    for (struct BoltAsyncLog* async = live.logs; async!=NULL; async = async->next) {
+        for (int32_t i = 0; i<thread->count; i++) {
+            if (thread->rings[i].log_id==async->id) {
+                BoltAtomic_increment(&thread->rings[i].ring->exited);
+            }
+        }
+    }
+    BoltSync_mutex_unlock(&live.mutex);
+
+    BoltMem_deallocate(thread->rings, thread->capacity*sizeof(struct BoltLogThreadRing));
+    BoltMem_deallocate(thread, sizeof(struct BoltLogThread));
+    thread_rings = NULL;
+    cached_log_id = 0;
+    cached_ring = NULL;
+}
+
+void BoltAsyncLog_startup()
+{
+    if (live.started) {
+        return;
+    }
+    BoltSync_mutex_create(&live.mutex);
+    BoltThread_key_create(&live.key, _thread_exit);
+    live.started = 1;
+}
+
+void BoltAsyncLog_shutdown()
+{
+    if (!live.started) {
+        return;
+    }
+    if (thread_rings!=NULL) {
+        BoltThread_key_set(&live.key, NULL);
+        _thread_exit(thread_rings);
+    }
+    BoltThread_key_delete(&live.key);
+    BoltSync_mutex_destroy(&live.mutex);
+    live.started = 0;
+}
+
+// Drops the entries of logs that have been destroyed since, so a thread's table stays bounded
+void _prune_thread_rings(struct BoltLogThread* thread)
+{
+    if (!live.started) {
+        return;
+    }
+    int32_t kept = 0;
+    BoltSync_mutex_lock(&live.mutex);
+    for (int32_t i = 0; i<thread->count; i++) {
+        for (struct BoltAsyncLog* async = live.logs; async!=NULL; async = async->next) {
+            if (thread->rings[i].log_id==async->id) {
+                thread->rings[kept++] = thread->rings[i];
+                break;
+            }
+        }
+    }
+    BoltSync_mutex_unlock(&live.mutex);
+    thread->count = kept;
+}
+
+struct BoltLogRing* _create_ring(struct BoltAsyncLog* async)
+{
+    unsigned long thread_id = BoltThread_id();
+    struct BoltLogRing* ring = NULL;
+    BoltSync_mutex_lock(&async->mutex);
+    for (int32_t i = 0; i<async->ring_count; i++) {
+        // without thread exit tracking, rings of exited threads are taken over by new threads that happen to get
+        // the same id
+        if (async->rings[i]->thread_id==thread_id && BoltAtomic_add(&async->rings[i]->exited, 0)==0) {
+            ring = async->rings[i];
+            break;
+        }
+    }
+    if (ring==NULL) {
+        ring = (struct BoltLogRing*) BoltMem_allocate(sizeof(struct BoltLogRing));
+        ring->thread_id = thread_id;
+        ring->capacity = async->ring_capacity;
+        ring->buffer = (char*) BoltMem_allocate((size_t) ring->capacity);
+        ring->head = 0;
+        ring->tail = 0;
+        ring->dropped = 0;
+        ring->exited = 0;
+        async->rings = (struct BoltLogRing**) BoltMem_reallocate(async->rings,
+                async->ring_count*sizeof(struct BoltLogRing*), (async->ring_count+1)*sizeof(struct BoltLogRing*));
+        async->rings[async->ring_count++] = ring;
+    }
+    BoltSync_mutex_unlock(&async->mutex);
+    return ring;
+}
+
+struct BoltLogRing* _find_ring(struct BoltAsyncLog* async)
+{
+    if (cached_log_id==async->id) {
+        return cached_ring;
+    }
+
+    struct BoltLogThread* thread = thread_rings;
+    if (thread==NULL) {
+        thread = (struct BoltLogThread*) BoltMem_allocate(sizeof(struct BoltLogThread));
+        thread->count = 0;
+        thread->capacity = 0;
+        thread->rings = NULL;
+        thread_rings = thread;
+        if (live.started) {
+            BoltThread_key_set(&live.key, thread);
+        }
+    }
+
+    struct BoltLogRing* ring = NULL;
+    for (int32_t i = 0; i<thread->count; i++) {
+        if (thread->rings[i].log_id==async->id) {
+            ring = thread->rings[i].ring;
+            break;
+        }
+    }
+    if (ring==NULL) {
+        ring = _create_ring(async);
+        _prune_thread_rings(thread);
+        if (thread->count==thread->capacity) {
+            int32_t capacity = thread->capacity==0 ? 4 : thread->capacity*2;
+            thread->rings = (struct BoltLogThreadRing*) BoltMem_reallocate(thread->rings,
+                    thread->capacity*sizeof(struct BoltLogThreadRing), capacity*sizeof(struct BoltLogThreadRing));
+            thread->capacity = capacity;
+        }
+        thread->rings[thread->count].log_id = async->id;
+        thread->rings[thread->count].ring = ring;
+        thread->count++;
+    }
+
+    cached_log_id = async->id;
+    cached_ring = ring;
+    return ring;
+}
+
+int BoltAsyncLog_enqueue(struct BoltAsyncLog* async, int level, const char* format, va_list args)
+{
+    union BoltLogArgument arguments[BOLT_LOG_MAX_ARGUMENTS];
+    int64_t strings_size = 0;
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int count = _capture(format, &args_copy, arguments, &strings_size);
+    va_end(args_copy);
+    if (count<0) {
+        return 0;
+    }
+
+    int64_t arguments_offset = SIZE_OF_RECORD_HEADER;
+    int64_t strings_offset = arguments_offset+count*(int64_t) sizeof(union BoltLogArgument);
+    int64_t size = ALIGN_RECORD(strings_offset+strings_size);
+    struct BoltLogRing* ring = _find_ring(async);
+    if (size>ring->capacity/2) {
+        return 0;
+    }
+
+    int64_t head = ring->head;
+    int64_t free_space = ring->capacity-(head-BoltAtomic_add(&ring->tail, 0));
+    int64_t offset = head%ring->capacity;
+    int64_t padding = ring->capacity-offset<size ? ring->capacity-offset : 0;
+    if (free_space<padding+size) {
+        BoltAtomic_increment(&ring->dropped);
+        return 1;
+    }
+    if (padding>0) {
+        struct BoltLogRecord* pad = (struct BoltLogRecord*) (ring->buffer+offset);
+        pad->size = (int32_t) padding;
+        pad->level = BOLT_LOG_PADDING;
+        offset = 0;
+    }
+
+    struct BoltLogRecord* record = (struct BoltLogRecord*) (ring->buffer+offset);
+    record->size = (int32_t) size;
+    record->level = (int16_t) level;
+    record->argument_count = (int16_t) count;
+    record->format = format;
+
+    // copy strings next to the arguments, as the originals may be gone by the time the record is rendered
+    union BoltLogArgument* stored = (union BoltLogArgument*) ((char*) record+arguments_offset);
+    int64_t string_offset = strings_offset;
+    struct BoltLogSpec spec;
+    int index = 0;
+    while (_next_spec(format, &spec)!=NULL) {
+        format = spec.start+spec.length;
+        if (spec.conversion=='%') {
+            continue;
+        }
+        for (int i = 0; i<spec.star_count; i++, index++) {
+            stored[index] = arguments[index];
+        }
+        if (spec.conversion=='s') {
+            const char* string = (const char*) arguments[index].p;
+            if (string==NULL) {
+                stored[index].string_offset = -1;
+            }
+            else {
+                int64_t length = _string_length(&spec, &arguments[index-spec.star_count], string);
+                memcpy((char*) record+string_offset, string, (size_t) length);
+                ((char*) record)[string_offset+length] = 0;
+                stored[index].string_offset = string_offset;
+                string_offset += length+1;
+            }
+        }
+        else {
+            stored[index] = arguments[index];
+        }
+        index++;
+    }
+
+    // publish the record to the drain
+    BoltAtomic_add(&ring->head, padding+size);
+    return 1;
+}
+
+void _deliver(const struct BoltLog* log, int level, const char* message)
+{
+    log_func func = NULL;
+    switch (level) {
+    case BOLT_LOG_ERROR:
+        func = log->error_logger;
+        break;
+    case BOLT_LOG_WARNING:
+        func = log->warning_logger;
+        break;
+    case BOLT_LOG_INFO:
+        func = log->info_logger;
+        break;
+    case BOLT_LOG_DEBUG:
+        func = log->debug_logger;
+        break;
+    default:
+        break;
+    }
+    if (func!=NULL) {
+        func(log->state, message);
+    }
+}
+
+void _drain_ring(struct BoltAsyncLog* async, struct BoltLogRing* ring)
+{
+    int64_t tail = ring->tail;
+    int64_t head = BoltAtomic_add(&ring->head, 0);
+    while (tail<head) {
+        const struct BoltLogRecord* record = (const struct BoltLogRecord*) (ring->buffer+tail%ring->capacity);
+        if (record->level!=BOLT_LOG_PADDING) {
+            struct StringBuilder* builder = StringBuilder_create();
+            _render(builder, record);
+            _deliver(async->log, record->level, StringBuilder_get_string(builder));
+            StringBuilder_destroy(builder);
+        }
+        tail += record->size;
+    }
+    BoltAtomic_add(&ring->tail, tail-ring->tail);
+
+    int64_t dropped = BoltAtomic_add(&ring->dropped, 0);
+    if (dropped>0) {
+        BoltAtomic_add(&ring->dropped, -dropped);
+        struct StringBuilder* builder = StringBuilder_create();
+        StringBuilder_append_f(builder, "[log]: %" PRId64 " log messages dropped on thread %lu, log buffer full",
+                dropped, ring->thread_id);
+        _deliver(async->log, BOLT_LOG_WARNING, StringBuilder_get_string(builder));
+        StringBuilder_destroy(builder);
+    }
+}
+
+void _destroy_ring(struct BoltLogRing* ring)
+{
+    BoltMem_deallocate(ring->buffer, (size_t) ring->capacity);
+    BoltMem_deallocate(ring, sizeof(struct BoltLogRing));
+}
+
+void BoltAsyncLog_drain(struct BoltAsyncLog* async)
+{
+    BoltSync_mutex_lock(&async->mutex);
+    int32_t kept = 0;
+    for (int32_t i = 0; i<async->ring_count; i++) {
+        struct BoltLogRing* ring = async->rings[i];
+        // an exited thread writes no more records, so it is safe to free its ring once drained
+        const int exited = BoltAtomic_add(&ring->exited, 0)!=0;
+        _drain_ring(async, ring);
+        if (exited) {
+            _destroy_ring(ring);
+        }
+        else {
+            async->rings[kept++] = ring;
+        }
+    }
+    if (kept<async->ring_count) {
+        async->rings = (struct BoltLogRing**) BoltMem_adjust(async->rings,
+                async->ring_count*sizeof(struct BoltLogRing*), kept*sizeof(struct BoltLogRing*));
+        async->ring_count = kept;
+    }
+    BoltSync_mutex_unlock(&async->mutex);
+}
+
+void _drain_loop(void* arg)
+{
+    struct BoltAsyncLog* async = (struct BoltAsyncLog*) arg;
+    BoltSync_mutex_lock(&async->mutex);
+    while (!async->stopping) {
+        BoltSync_cond_timedwait(&async->cond, &async->mutex, async->flush_interval);
+        BoltAsyncLog_drain(async);
+    }
+    BoltSync_mutex_unlock(&async->mutex);
+}
+
+struct BoltAsyncLog* BoltAsyncLog_create(const struct BoltLog* log, int32_t buffer_size, int32_t flush_interval)
+{
+    struct BoltAsyncLog* async = (struct BoltAsyncLog*) BoltMem_allocate(sizeof(struct BoltAsyncLog));
+    async->id = BoltAtomic_increment(&async_log_seq);
+    async->log = log;
+    async->ring_capacity = ALIGN_RECORD(buffer_size);
+    async->flush_interval = flush_interval>0 ? flush_interval : 1;
+    async->stopping = 0;
+    async->ring_count = 0;
+    async->rings = NULL;
+    async->next = NULL;
+    BoltSync_mutex_create(&async->mutex);
+    BoltSync_cond_create(&async->cond);
+    BoltThread_create(&async->thread, _drain_loop, async);
+    if (live.started) {
+        BoltSync_mutex_lock(&live.mutex);
+        async->next = live.logs;
+        live.logs = async;
+        BoltSync_mutex_unlock(&live.mutex);
+    }
+    return async;
+}
+
+void BoltAsyncLog_destroy(struct BoltAsyncLog* async)
+{
+    if (live.started) {
+        BoltSync_mutex_lock(&live.mutex);
+        for (struct BoltAsyncLog** cursor = &live.logs; *cursor!=NULL; cursor = &(*cursor)->next) {
+            if (*cursor==async) {
+                *cursor = async->next;
+                break;
+            }
+        }
+        BoltSync_mutex_unlock(&live.mutex);
+    }
+
+    BoltSync_mutex_lock(&async->mutex);
+    async->stopping = 1;
+    BoltSync_cond_signal(&async->cond);
+    BoltSync_mutex_unlock(&async->mutex);
+    if (async->thread!=NULL) {
+        BoltThread_join(&async->thread);
+    }
+
+    BoltAsyncLog_drain(async);
+    for (int32_t i = 0; i<async->ring_count; i++) {
+        _destroy_ring(async->rings[i]);
+    }
+    BoltMem_deallocate(async->rings, async->ring_count*sizeof(struct BoltLogRing*));
+    BoltSync_cond_destroy(&async->cond);
+    BoltSync_mutex_destroy(&async->mutex);
+    BoltMem_deallocate(async, sizeof(struct BoltAsyncLog));
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_LOG_ASYNC_H
+#define SEABOLT_LOG_ASYNC_H
+
+#include "log.h"
+#include "sync.h"
+
+#include <stdarg.h>
+
+#define BOLT_LOG_ERROR 0
+#define BOLT_LOG_WARNING 1
+#define BOLT_LOG_INFO 2
+#define BOLT_LOG_DEBUG 3
+
+/// Maximum number of arguments (including `*` widths and precisions) a deferred log call can carry
+#define BOLT_LOG_MAX_ARGUMENTS 16
+
+/**
+ * Single producer, single consumer byte ring holding the binary log records of one thread.
+ */
+struct BoltLogRing {
+    unsigned long thread_id;
+    char* buffer;
+    int64_t capacity;
+    /// Total number of bytes written, only advanced by the owning thread
+    volatile int64_t head;
+    /// Total number of bytes consumed, only advanced by the drain
+    volatile int64_t tail;
+    /// Records discarded because the ring was full
+    volatile int64_t dropped;
+    /// Set once the owning thread exited, the drain frees the ring after delivering what is left
+    volatile int64_t exited;
+};
+
+/**
+ * Deferred logging state attached to a \ref BoltLog.
+ *
+ * Log calls capture their format string and raw arguments into a per-thread \ref BoltLogRing without
+ * formatting. A background thread periodically formats the records and invokes the logging functions.
+ *
+ * Each thread keeps its own table of rings keyed by log, so only the first call of a thread on a log
+ * synchronises with the drain.
+ */
+struct BoltAsyncLog {
+    int64_t id;
+    const struct BoltLog* log;
+    int64_t ring_capacity;
+    int flush_interval;
+
+    mutex_t mutex;
+    cond_t cond;
+    thread_t thread;
+    volatile int stopping;
+
+    int32_t ring_count;
+    struct BoltLogRing** rings;
+
+    /// Next live asynchronous log, see \ref BoltAsyncLog_startup
+    struct BoltAsyncLog* next;
+};
+
+/**
+ * Sets up the tracking of thread exits, after which the rings of exited threads are reclaimed by the drain.
+ * Without it rings are only released when their log is destroyed.
+ */
+void BoltAsyncLog_startup();
+
+/**
+ * Stops the tracking of thread exits, releasing the ring table of the calling thread. Called from Bolt_shutdown.
+ */
+void BoltAsyncLog_shutdown();
+
+struct BoltAsyncLog* BoltAsyncLog_create(const struct BoltLog* log, int32_t buffer_size, int32_t flush_interval);
+
+void BoltAsyncLog_destroy(struct BoltAsyncLog* async);
+
+/**
+ * Captures a log call into the calling thread's ring.
+ *
+ * @returns 1 if the call was captured or dropped because the ring was full, 0 if the call can not be deferred
+ * (unsupported conversion, too many arguments or a record too large for the ring) and should be logged
+ * synchronously instead.
+ */
+int BoltAsyncLog_enqueue(struct BoltAsyncLog* async, int level, const char* format, va_list args);
+
+/**
+ * Formats and delivers all captured records.
+ */
+void BoltAsyncLog_drain(struct BoltAsyncLog* async);
+
+#endif //SEABOLT_LOG_ASYNC_H
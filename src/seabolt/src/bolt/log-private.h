@@ -34,6 +34,10 @@ struct BoltLog {
     log_func warning_logger;
     log_func info_logger;
     log_func debug_logger;
+
+    int32_t async_buffer_size;
+    int32_t async_flush_interval;
+    struct BoltAsyncLog* async;
 };
 
 BoltLog* BoltLog_clone(BoltLog *log);
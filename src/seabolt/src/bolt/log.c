@@ -17,8 +17,10 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_LOGGING
 
 #include "bolt-private.h"
+#include "log-async.h"
 #include "log-private.h"
 #include "mem.h"
 #include "string-builder.h"
@@ -36,6 +38,9 @@ struct BoltLog* BoltLog_create(void* state)
     log->info_enabled = 0;
     log->warning_enabled = 0;
     log->error_enabled = 0;
+    log->async_buffer_size = 0;
+    log->async_flush_interval = 0;
+    log->async = NULL;
     return log;
 }
 
@@ -54,11 +59,15 @@ BoltLog* BoltLog_clone(BoltLog* log)
     clone->warning_enabled = log->warning_enabled;
     clone->error_logger = log->error_logger;
     clone->error_enabled = log->error_enabled;
+    BoltLog_set_async(clone, log->async_buffer_size, log->async_flush_interval);
     return clone;
 }
 
 void BoltLog_destroy(struct BoltLog* log)
 {
+    if (log->async!=NULL) {
+        BoltAsyncLog_destroy(log->async);
+    }
     BoltMem_deallocate(log, sizeof(struct BoltLog));
 }
 
@@ -86,6 +95,26 @@ void BoltLog_set_debug_func(BoltLog* log, log_func func)
     log->debug_logger = func;
 }
 
+void BoltLog_set_async(BoltLog* log, int32_t buffer_size, int32_t flush_interval)
+{
+    if (log->async!=NULL) {
+        BoltAsyncLog_destroy(log->async);
+        log->async = NULL;
+    }
+    log->async_buffer_size = buffer_size;
+    log->async_flush_interval = flush_interval;
+    if (buffer_size>0) {
+        log->async = BoltAsyncLog_create(log, buffer_size, flush_interval);
+    }
+}
+
+void BoltLog_flush(BoltLog* log)
+{
+    if (log->async!=NULL) {
+        BoltAsyncLog_drain(log->async);
+    }
+}
+
 void _perform_log_call(log_func func, void* state, const char* format, va_list args)
 {
     uint64_t size = 512*sizeof(char);
@@ -113,7 +142,9 @@ void BoltLog_error(const struct BoltLog* log, const char* format, ...)
     if (log!=NULL && log->error_enabled) {
         va_list args;
         va_start(args, format);
-        _perform_log_call(log->error_logger, log->state, format, args);
+        if (log->async==NULL || !BoltAsyncLog_enqueue(log->async, BOLT_LOG_ERROR, format, args)) {
+            _perform_log_call(log->error_logger, log->state, format, args);
+        }
         va_end(args);
     }
 }
@@ -123,7 +154,9 @@ void BoltLog_warning(const struct BoltLog* log, const char* format, ...)
     if (log!=NULL && log->warning_enabled) {
         va_list args;
         va_start(args, format);
-        _perform_log_call(log->warning_logger, log->state, format, args);
+        if (log->async==NULL || !BoltAsyncLog_enqueue(log->async, BOLT_LOG_WARNING, format, args)) {
+            _perform_log_call(log->warning_logger, log->state, format, args);
+        }
         va_end(args);
     }
 }
@@ -133,9 +166,10 @@ void BoltLog_info(const struct BoltLog* log, const char* format, ...)
     if (log!=NULL && log->info_enabled) {
         va_list args;
         va_start(args, format);
-        _perform_log_call(log->info_logger, log->state, format, args);
+        if (log->async==NULL || !BoltAsyncLog_enqueue(log->async, BOLT_LOG_INFO, format, args)) {
+            _perform_log_call(log->info_logger, log->state, format, args);
+        }
         va_end(args);
-
     }
 }
 
@@ -144,7 +178,9 @@ void BoltLog_debug(const struct BoltLog* log, const char* format, ...)
     if (log!=NULL && log->debug_enabled) {
         va_list args;
         va_start(args, format);
-        _perform_log_call(log->debug_logger, log->state, format, args);
+        if (log->async==NULL || !BoltAsyncLog_enqueue(log->async, BOLT_LOG_DEBUG, format, args)) {
+            _perform_log_call(log->debug_logger, log->state, format, args);
+        }
         va_end(args);
     }
 }
@@ -89,4 +89,30 @@ SEABOLT_EXPORT void BoltLog_set_info_func(BoltLog* log, log_func func);
  */
 SEABOLT_EXPORT void BoltLog_set_debug_func(BoltLog* log, log_func func);
 
+/**
+ * Enables or disables deferred (asynchronous) logging.
+ *
+ * When enabled, log calls only capture their format string and arguments as a compact binary record into a
+ * buffer owned by the calling thread, and a background thread formats the records and invokes the logging
+ * functions every _flush_interval_ milliseconds. Logging functions are therefore called from the background
+ * thread and messages are delivered with a delay. Ordering is preserved among messages logged from the same
+ * thread only. Records that do not fit into a full buffer are dropped, and the number of dropped records is
+ * reported through the WARNING level logging function.
+ *
+ * Logs passed to \ref BoltConfig_set_log are cloned together with this setting, so each connector runs its own
+ * background thread.
+ *
+ * @param log the instance to be modified.
+ * @param buffer_size the size of the per-thread buffer in bytes, 0 disables deferred logging.
+ * @param flush_interval the interval in milliseconds the background thread delivers buffered records.
+ */
+SEABOLT_EXPORT void BoltLog_set_async(BoltLog* log, int32_t buffer_size, int32_t flush_interval);
+
+/**
+ * Delivers all records buffered by deferred logging to the logging functions, on the calling thread.
+ *
+ * @param log the instance to be flushed.
+ */
+SEABOLT_EXPORT void BoltLog_flush(BoltLog* log);
+
 #endif // SEABOLT_LOG
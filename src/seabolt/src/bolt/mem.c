@@ -19,7 +19,9 @@
 
 #include "bolt-private.h"
 
+#include "allocator.h"
 #include "mem.h"
+#include "stats.h"
 #include "atomic.h"
 
 void* BoltMem_reverse_copy(void* dest, const void* src, int64_t n)
@@ -32,44 +34,106 @@ void* BoltMem_reverse_copy(void* dest, const void* src, int64_t n)
     return dest;
 }
 
-static int64_t __allocation = 0;
-static int64_t __peak_allocation = 0;
-static int64_t __allocation_events = 0;
+static void* _default_allocate(void* state, size_t size)
+{
+    UNUSED(state);
+    return malloc(size);
+}
 
-void* BoltMem_allocate(int64_t new_size)
+static void* _default_reallocate(void* state, void* ptr, size_t old_size, size_t new_size)
 {
-    void* p = malloc(new_size);
-    int64_t new_allocation = BoltAtomic_add(&__allocation, new_size);
-    int64_t peak_allocation = BoltAtomic_add(&__peak_allocation, 0);
-    if (new_allocation>peak_allocation) BoltAtomic_add(&__peak_allocation, new_allocation-peak_allocation);
-    BoltAtomic_increment(&__allocation_events);
-    return p;
+    UNUSED(state);
+    UNUSED(old_size);
+    return realloc(ptr, new_size);
 }
 
-void* BoltMem_reallocate(void* ptr, int64_t old_size, int64_t new_size)
+static void _default_deallocate(void* state, void* ptr, size_t size)
+{
+    UNUSED(state);
+    UNUSED(size);
+    free(ptr);
+}
+
+static allocate_func __allocate = &_default_allocate;
+static reallocate_func __reallocate = &_default_reallocate;
+static deallocate_func __deallocate = &_default_deallocate;
+static void* __allocator_state = NULL;
+
+struct BoltMemCounters {
+    int64_t allocation;
+    int64_t peak_allocation;
+    int64_t allocation_events;
+};
+
+static struct BoltMemCounters __total = {0, 0, 0};
+static struct BoltMemCounters __tagged[BOLT_MEMORY_TAGS];
+
+int32_t BoltAllocator_set(allocate_func allocate, reallocate_func reallocate, deallocate_func deallocate, void* state)
 {
-    void* p = realloc(ptr, new_size);
+    const int provided = (allocate!=NULL)+(reallocate!=NULL)+(deallocate!=NULL);
+    if (provided!=0 && provided!=3) {
+        return BOLT_ALLOCATOR_INCOMPLETE;
+    }
+    if (__total.allocation_events!=0) {
+        return BOLT_ALLOCATOR_IN_USE;
+    }
+    if (provided==0) {
+        // Restores malloc, realloc and free
+        __allocate = &_default_allocate;
+        __reallocate = &_default_reallocate;
+        __deallocate = &_default_deallocate;
+        __allocator_state = NULL;
+        return BOLT_SUCCESS;
+    }
+    __allocate = allocate;
+    __reallocate = reallocate;
+    __deallocate = deallocate;
+    __allocator_state = state;
+    return BOLT_SUCCESS;
+}
 
-    int64_t new_allocation = BoltAtomic_add(&__allocation, -old_size+new_size);
-    int64_t peak_allocation = BoltAtomic_add(&__peak_allocation, 0);
-    if (__allocation>__peak_allocation) BoltAtomic_add(&__peak_allocation, new_allocation-peak_allocation);
-    BoltAtomic_increment(&__allocation_events);
+static void _count(struct BoltMemCounters* counters, int64_t delta)
+{
+    int64_t new_allocation = BoltAtomic_add(&counters->allocation, delta);
+    int64_t peak_allocation = BoltAtomic_add(&counters->peak_allocation, 0);
+    if (new_allocation>peak_allocation) BoltAtomic_add(&counters->peak_allocation, new_allocation-peak_allocation);
+    BoltAtomic_increment(&counters->allocation_events);
+}
+
+void BoltMem_record_tagged(BoltMemoryTag tag, int64_t old_size, int64_t new_size)
+{
+    _count(&__total, new_size-old_size);
+    _count(&__tagged[tag], new_size-old_size);
+}
+
+void* BoltMem_allocate_tagged(BoltMemoryTag tag, int64_t new_size)
+{
+    void* p = __allocate(__allocator_state, (size_t) new_size);
+    BoltMem_record_tagged(tag, 0, new_size);
     return p;
 }
 
-void* BoltMem_deallocate(void* ptr, int64_t old_size)
+void* BoltMem_reallocate_tagged(BoltMemoryTag tag, void* ptr, int64_t old_size, int64_t new_size)
+{
+    // Custom allocators are only handed memory they allocated themselves
+    void* p = ptr==NULL ? __allocate(__allocator_state, (size_t) new_size)
+                        : __reallocate(__allocator_state, ptr, (size_t) old_size, (size_t) new_size);
+    BoltMem_record_tagged(tag, old_size, new_size);
+    return p;
+}
+
+void* BoltMem_deallocate_tagged(BoltMemoryTag tag, void* ptr, int64_t old_size)
 {
     if (ptr==NULL) {
         return NULL;
     }
 
-    free(ptr);
-    BoltAtomic_add(&__allocation, -old_size);
-    BoltAtomic_increment(&__allocation_events);
+    __deallocate(__allocator_state, ptr, (size_t) old_size);
+    BoltMem_record_tagged(tag, old_size, 0);
     return NULL;
 }
 
-void* BoltMem_adjust(void* ptr, int64_t old_size, int64_t new_size)
+void* BoltMem_adjust_tagged(BoltMemoryTag tag, void* ptr, int64_t old_size, int64_t new_size)
 {
     if (new_size==old_size) {
         // In this case, the physical data storage requirement
@@ -86,44 +150,99 @@ void* BoltMem_adjust(void* ptr, int64_t old_size, int64_t new_size)
         // In this case we need to allocate new storage space
         // where previously none was allocated. This means
         // that a full allocation is required.
-        return BoltMem_allocate(new_size);
+        return BoltMem_allocate_tagged(tag, new_size);
     }
     if (new_size==0) {
         // In this case, we are moving from previously having
         // data to no longer requiring any storage space. This
         // means that we can free up the previously-allocated
         // space.
-        return BoltMem_deallocate(ptr, old_size);
+        return BoltMem_deallocate_tagged(tag, ptr, old_size);
     }
     // Finally, this case deals with previous allocation
     // and a new allocation requirement, but of different
     // sizes. Here, we `realloc`, which should be more
     // efficient than a naïve deallocation followed by a
     // brand new allocation.
-    return BoltMem_reallocate(ptr, old_size, new_size);
+    return BoltMem_reallocate_tagged(tag, ptr, old_size, new_size);
 }
 
-void* BoltMem_duplicate(const void* ptr, int64_t ptr_size)
+void* BoltMem_duplicate_tagged(BoltMemoryTag tag, const void* ptr, int64_t ptr_size)
 {
     if (ptr==NULL) {
         return NULL;
     }
-    void* p = BoltMem_allocate(ptr_size);
+    void* p = BoltMem_allocate_tagged(tag, ptr_size);
     memcpy(p, ptr, ptr_size);
     return p;
 }
 
+void* BoltMem_allocate(int64_t new_size)
+{
+    return BoltMem_allocate_tagged(BOLT_MEMORY_OTHER, new_size);
+}
+
+void* BoltMem_reallocate(void* ptr, int64_t old_size, int64_t new_size)
+{
+    return BoltMem_reallocate_tagged(BOLT_MEMORY_OTHER, ptr, old_size, new_size);
+}
+
+void* BoltMem_deallocate(void* ptr, int64_t old_size)
+{
+    return BoltMem_deallocate_tagged(BOLT_MEMORY_OTHER, ptr, old_size);
+}
+
+void* BoltMem_adjust(void* ptr, int64_t old_size, int64_t new_size)
+{
+    return BoltMem_adjust_tagged(BOLT_MEMORY_OTHER, ptr, old_size, new_size);
+}
+
+void* BoltMem_duplicate(const void* ptr, int64_t ptr_size)
+{
+    return BoltMem_duplicate_tagged(BOLT_MEMORY_OTHER, ptr, ptr_size);
+}
+
+void* BoltMem_allocate_untracked(int64_t size)
+{
+    return __allocate(__allocator_state, (size_t) size);
+}
+
+void BoltMem_deallocate_untracked(void* ptr, int64_t old_size)
+{
+    __deallocate(__allocator_state, ptr, (size_t) old_size);
+}
+
+void BoltMem_record(int64_t old_size, int64_t new_size)
+{
+    BoltMem_record_tagged(BOLT_MEMORY_OTHER, old_size, new_size);
+}
+
 int64_t BoltMem_current_allocation()
 {
-    return __allocation;
+    return __total.allocation;
 }
 
 int64_t BoltMem_peak_allocation()
 {
-    return __peak_allocation;
+    return __total.peak_allocation;
 }
 
 int64_t BoltMem_allocation_events()
 {
-    return __allocation_events;
+    return __total.allocation_events;
+}
+
+int64_t BoltMem_current_allocation_tagged(BoltMemoryTag tag)
+{
+    return __tagged[tag].allocation;
+}
+
+int64_t BoltMem_peak_allocation_tagged(BoltMemoryTag tag)
+{
+    return __tagged[tag].peak_allocation;
+}
+
+int64_t BoltMem_allocation_events_tagged(BoltMemoryTag tag)
+{
+    return __tagged[tag].allocation_events;
 }
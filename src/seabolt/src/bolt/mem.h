@@ -24,6 +24,7 @@
 #include <stdio.h>
 
 #include "bolt-public.h"
+#include "stats.h"
 
 
 void* BoltMem_reverse_copy(void * dest, const void * src, int64_t n);
@@ -83,6 +84,62 @@ void* BoltMem_adjust(void* ptr, int64_t old_size, int64_t new_size);
 */
 void* BoltMem_duplicate(const void *ptr, int64_t ptr_size);
 
+/**
+ * Allocates memory through the configured allocator without recording it in the allocation statistics, for
+ * caches that record the blocks they hand out themselves. Such memory is freed with
+ * \ref BoltMem_deallocate_untracked.
+ *
+ * @param size
+ * @return
+ */
+void* BoltMem_allocate_untracked(int64_t size);
+
+/**
+ * Frees memory through the configured allocator without recording it in the allocation statistics.
+ *
+ * @param ptr
+ * @param old_size
+ */
+void BoltMem_deallocate_untracked(void* ptr, int64_t old_size);
+
+/**
+ * Records an allocation of _new_size_ bytes in place of _old_size_ bytes that was served without going through
+ * \ref BoltMem_allocate, such as from the slab caches, in the allocation statistics.
+ *
+ * @param old_size
+ * @param new_size
+ */
+void BoltMem_record(int64_t old_size, int64_t new_size);
+
+/**
+ * Tagged variants of the functions above, accounting the memory to the \ref BoltMemoryTag "subsystem" _tag_ as
+ * well as to the totals. Memory must be reallocated and deallocated with the tag it was allocated with.
+ */
+void* BoltMem_allocate_tagged(BoltMemoryTag tag, int64_t new_size);
+
+void* BoltMem_reallocate_tagged(BoltMemoryTag tag, void* ptr, int64_t old_size, int64_t new_size);
+
+void* BoltMem_deallocate_tagged(BoltMemoryTag tag, void* ptr, int64_t old_size);
+
+void* BoltMem_adjust_tagged(BoltMemoryTag tag, void* ptr, int64_t old_size, int64_t new_size);
+
+void* BoltMem_duplicate_tagged(BoltMemoryTag tag, const void* ptr, int64_t ptr_size);
+
+void BoltMem_record_tagged(BoltMemoryTag tag, int64_t old_size, int64_t new_size);
+
+/*
+ * Source files define BOLT_MEM_TAG to their subsystem's tag before any include, which makes every allocation
+ * they make through the functions above accounted to that subsystem.
+ */
+#ifdef BOLT_MEM_TAG
+#define BoltMem_allocate(new_size) BoltMem_allocate_tagged(BOLT_MEM_TAG, new_size)
+#define BoltMem_reallocate(ptr, old_size, new_size) BoltMem_reallocate_tagged(BOLT_MEM_TAG, ptr, old_size, new_size)
+#define BoltMem_deallocate(ptr, old_size) BoltMem_deallocate_tagged(BOLT_MEM_TAG, ptr, old_size)
+#define BoltMem_adjust(ptr, old_size, new_size) BoltMem_adjust_tagged(BOLT_MEM_TAG, ptr, old_size, new_size)
+#define BoltMem_duplicate(ptr, ptr_size) BoltMem_duplicate_tagged(BOLT_MEM_TAG, ptr, ptr_size)
+#define BoltMem_record(old_size, new_size) BoltMem_record_tagged(BOLT_MEM_TAG, old_size, new_size)
+#endif
+
 /**
  * Retrieve the amount of memory currently allocated.
  *
@@ -103,4 +160,13 @@ int64_t BoltMem_peak_allocation();
  */
 int64_t BoltMem_allocation_events();
 
+/**
+ * Per subsystem variants of the statistics above.
+ */
+int64_t BoltMem_current_allocation_tagged(BoltMemoryTag tag);
+
+int64_t BoltMem_peak_allocation_tagged(BoltMemoryTag tag);
+
+int64_t BoltMem_allocation_events_tagged(BoltMemoryTag tag);
+
 #endif // SEABOLT_MEM
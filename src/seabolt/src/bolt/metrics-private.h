@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_METRICS_PRIVATE_H
+#define SEABOLT_METRICS_PRIVATE_H
+
+#include "metrics.h"
+#include "histogram.h"
+
+#include <time.h>
+
+/**
+ * Record of connection usage statistics.
+ *
+ * Counters are updated through \ref BoltAtomic_add, as they are read by metrics exports on other threads.
+ */
+struct BoltConnectionMetrics {
+    struct timespec time_opened;
+    struct timespec time_closed;
+    volatile int64_t bytes_sent;
+    volatile int64_t bytes_received;
+    volatile int64_t messages_sent;
+    volatile int64_t messages_received;
+    volatile int64_t records_received;
+    /// Time spent blocked in send calls, in nanoseconds
+    volatile int64_t time_blocked_send;
+    /// Time spent blocked in receive calls, in nanoseconds
+    volatile int64_t time_blocked_receive;
+};
+
+void BoltConnectionMetrics_add(BoltConnectionMetrics* total, const BoltConnectionMetrics* metrics);
+
+/**
+ * Record of connection pool usage statistics.
+ */
+struct BoltPoolMetrics {
+    int64_t acquisitions;
+    int64_t acquisition_timeouts;
+    int64_t pool_full_events;
+    int64_t connections_opened;
+    int64_t connections_closed;
+    int64_t lifetime_expiries;
+    int64_t reset_failures;
+    /// Acquisition times in microseconds
+    BoltHistogram acquisition_time;
+};
+
+void BoltPoolMetrics_add(BoltPoolMetrics* total, const BoltPoolMetrics* metrics);
+
+/**
+ * Point in time statistics of a single server, as collected by the pools for exporting.
+ */
+typedef struct BoltServerMetrics {
+    struct BoltAddress* address;
+    int64_t connections_in_use;
+    int64_t pool_size;
+    /// One of BOLT_CIRCUIT_*, only applicable to routing pools
+    int32_t circuit_state;
+    BoltConnectionMetrics connection_metrics;
+    BoltPoolMetrics pool_metrics;
+} BoltServerMetrics;
+
+#define SIZE_OF_SERVER_METRICS sizeof(struct BoltServerMetrics)
+
+void BoltServerMetrics_init(BoltServerMetrics* metrics, const char* host, const char* port);
+
+void BoltServerMetrics_cleanup(BoltServerMetrics* metrics);
+
+/**
+ * Routing statistics, as collected by the routing pool for exporting.
+ */
+typedef struct BoltRoutingMetrics {
+    int64_t refreshes;
+    int64_t refresh_failures;
+} BoltRoutingMetrics;
+
+struct StringBuilder;
+
+void BoltMetrics_write_text(struct StringBuilder* builder, const BoltServerMetrics* servers, int32_t count,
+        const BoltRoutingMetrics* routing);
+
+#endif //SEABOLT_METRICS_PRIVATE_H
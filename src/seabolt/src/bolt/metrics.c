@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_CONNECTIONS
+
+#include "bolt-private.h"
+#include "address-private.h"
+#include "atomic.h"
+#include "circuit-breaker.h"
+#include "metrics-private.h"
+#include "mem.h"
+#include "stats.h"
+#include "string-builder.h"
+
+#define NANOS_PER_SECOND 1000000000.0
+#define MICROS_PER_SECOND 1000000.0
+
+/// Upper bounds (in seconds) of the exported acquisition time histogram buckets
+static const double acquisition_time_buckets[] = {0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0,
+                                                  10.0, 60.0};
+
+#define ACQUISITION_TIME_BUCKET_COUNT (sizeof(acquisition_time_buckets)/sizeof(double))
+
+BoltConnectionMetrics* BoltConnectionMetrics_create()
+{
+    BoltConnectionMetrics* metrics = BoltMem_allocate(sizeof(BoltConnectionMetrics));
+    memset(metrics, 0, sizeof(BoltConnectionMetrics));
+    return metrics;
+}
+
+void BoltConnectionMetrics_destroy(BoltConnectionMetrics* metrics)
+{
+    BoltMem_deallocate(metrics, sizeof(BoltConnectionMetrics));
+}
+
+// Reads a counter that may be updated concurrently
+int64_t _read_counter(const volatile int64_t* counter)
+{
+    return BoltAtomic_add((volatile int64_t*) counter, 0);
+}
+
+void BoltConnectionMetrics_add(BoltConnectionMetrics* total, const BoltConnectionMetrics* metrics)
+{
+    BoltAtomic_add(&total->bytes_sent, _read_counter(&metrics->bytes_sent));
+    BoltAtomic_add(&total->bytes_received, _read_counter(&metrics->bytes_received));
+    BoltAtomic_add(&total->messages_sent, _read_counter(&metrics->messages_sent));
+    BoltAtomic_add(&total->messages_received, _read_counter(&metrics->messages_received));
+    BoltAtomic_add(&total->records_received, _read_counter(&metrics->records_received));
+    BoltAtomic_add(&total->time_blocked_send, _read_counter(&metrics->time_blocked_send));
+    BoltAtomic_add(&total->time_blocked_receive, _read_counter(&metrics->time_blocked_receive));
+}
+
+uint64_t BoltConnectionMetrics_get_bytes_sent(const BoltConnectionMetrics* metrics)
+{
+    return (uint64_t) _read_counter(&metrics->bytes_sent);
+}
+
+uint64_t BoltConnectionMetrics_get_bytes_received(const BoltConnectionMetrics* metrics)
+{
+    return (uint64_t) _read_counter(&metrics->bytes_received);
+}
+
+uint64_t BoltConnectionMetrics_get_messages_sent(const BoltConnectionMetrics* metrics)
+{
+    return (uint64_t) _read_counter(&metrics->messages_sent);
+}
+
+uint64_t BoltConnectionMetrics_get_messages_received(const BoltConnectionMetrics* metrics)
+{
+    return (uint64_t) _read_counter(&metrics->messages_received);
+}
+
+uint64_t BoltConnectionMetrics_get_records_received(const BoltConnectionMetrics* metrics)
+{
+    return (uint64_t) _read_counter(&metrics->records_received);
+}
+
+uint64_t BoltConnectionMetrics_get_time_blocked_send(const BoltConnectionMetrics* metrics)
+{
+    return (uint64_t) _read_counter(&metrics->time_blocked_send);
+}
+
+uint64_t BoltConnectionMetrics_get_time_blocked_receive(const BoltConnectionMetrics* metrics)
+{
+    return (uint64_t) _read_counter(&metrics->time_blocked_receive);
+}
+
+BoltPoolMetrics* BoltPoolMetrics_create()
+{
+    BoltPoolMetrics* metrics = BoltMem_allocate(sizeof(BoltPoolMetrics));
+    memset(metrics, 0, sizeof(BoltPoolMetrics));
+    BoltHistogram_init(&metrics->acquisition_time);
+    return metrics;
+}
+
+void BoltPoolMetrics_destroy(BoltPoolMetrics* metrics)
+{
+    BoltMem_deallocate(metrics, sizeof(BoltPoolMetrics));
+}
+
+void BoltPoolMetrics_add(BoltPoolMetrics* total, const BoltPoolMetrics* metrics)
+{
+    total->acquisitions += metrics->acquisitions;
+    total->acquisition_timeouts += metrics->acquisition_timeouts;
+    total->pool_full_events += metrics->pool_full_events;
+    total->connections_opened += metrics->connections_opened;
+    total->connections_closed += metrics->connections_closed;
+    total->lifetime_expiries += metrics->lifetime_expiries;
+    total->reset_failures += metrics->reset_failures;
+    BoltHistogram_add(&total->acquisition_time, &metrics->acquisition_time);
+}
+
+int64_t BoltPoolMetrics_get_acquisitions(const BoltPoolMetrics* metrics)
+{
+    return metrics->acquisitions;
+}
+
+int64_t BoltPoolMetrics_get_acquisition_timeouts(const BoltPoolMetrics* metrics)
+{
+    return metrics->acquisition_timeouts;
+}
+
+int64_t BoltPoolMetrics_get_pool_full_events(const BoltPoolMetrics* metrics)
+{
+    return metrics->pool_full_events;
+}
+
+int64_t BoltPoolMetrics_get_connections_opened(const BoltPoolMetrics* metrics)
+{
+    return metrics->connections_opened;
+}
+
+int64_t BoltPoolMetrics_get_connections_closed(const BoltPoolMetrics* metrics)
+{
+    return metrics->connections_closed;
+}
+
+int64_t BoltPoolMetrics_get_lifetime_expiries(const BoltPoolMetrics* metrics)
+{
+    return metrics->lifetime_expiries;
+}
+
+int64_t BoltPoolMetrics_get_reset_failures(const BoltPoolMetrics* metrics)
+{
+    return metrics->reset_failures;
+}
+
+int64_t BoltPoolMetrics_get_acquisition_time_percentile(const BoltPoolMetrics* metrics, double percentile)
+{
+    return BoltHistogram_value_at_percentile(&metrics->acquisition_time, percentile);
+}
+
+int64_t BoltPoolMetrics_get_acquisition_time_max(const BoltPoolMetrics* metrics)
+{
+    return metrics->acquisition_time.max;
+}
+
+int64_t BoltPoolMetrics_get_acquisition_time_sum(const BoltPoolMetrics* metrics)
+{
+    return metrics->acquisition_time.sum;
+}
+
+void BoltServerMetrics_init(BoltServerMetrics* metrics, const char* host, const char* port)
+{
+    memset(metrics, 0, SIZE_OF_SERVER_METRICS);
+    metrics->address = BoltAddress_create(host, port);
+    metrics->circuit_state = BOLT_CIRCUIT_CLOSED;
+    BoltHistogram_init(&metrics->pool_metrics.acquisition_time);
+}
+
+void BoltServerMetrics_cleanup(BoltServerMetrics* metrics)
+{
+    BoltAddress_destroy(metrics->address);
+    metrics->address = NULL;
+}
+
+void _write_family(struct StringBuilder* builder, const char* name, const char* type, const char* help)
+{
+    StringBuilder_append_f(builder, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+void _write_server_labels(struct StringBuilder* builder, const BoltServerMetrics* server)
+{
+    StringBuilder_append_f(builder, "host=\"%s\",port=\"%s\"", server->address->host, server->address->port);
+}
+
+#define WRITE_SERVER_FAMILY(builder, servers, count, name, type, help, suffix, format, expr) \
+    do { \
+        _write_family(builder, name, type, help); \
+        for (int32_t i = 0; i<(count); i++) { \
+            const BoltServerMetrics* server = &(servers)[i]; \
+            StringBuilder_append(builder, name suffix "{"); \
+            _write_server_labels(builder, server); \
+            StringBuilder_append_f(builder, "} " format "\n", expr); \
+        } \
+    } while (0)
+
+void _write_acquisition_time(struct StringBuilder* builder, const BoltServerMetrics* servers, int32_t count)
+{
+    const char* name = "seabolt_pool_acquisition_seconds";
+    _write_family(builder, name, "histogram", "Time spent acquiring a connection from the pool.");
+    for (int32_t i = 0; i<count; i++) {
+        const BoltHistogram* histogram = &servers[i].pool_metrics.acquisition_time;
+
+        // translate the log-linear buckets into cumulative counts, attributing each to the exported bucket
+        // its upper bound falls into
+        int64_t cumulative[ACQUISITION_TIME_BUCKET_COUNT];
+        memset(cumulative, 0, sizeof(cumulative));
+        for (int index = 0; index<BOLT_HISTOGRAM_BUCKET_COUNT; index++) {
+            if (histogram->buckets[index]==0) {
+                continue;
+            }
+            double upper_bound = (double) BoltHistogram_bucket_upper_bound(index)/MICROS_PER_SECOND;
+            for (size_t j = 0; j<ACQUISITION_TIME_BUCKET_COUNT; j++) {
+                if (upper_bound<=acquisition_time_buckets[j]) {
+                    cumulative[j] += histogram->buckets[index];
+                }
+            }
+        }
+
+        for (size_t j = 0; j<ACQUISITION_TIME_BUCKET_COUNT; j++) {
+            StringBuilder_append_f(builder, "%s_bucket{", name);
+            _write_server_labels(builder, &servers[i]);
+            StringBuilder_append_f(builder, ",le=\"%g\"} %" PRId64 "\n", acquisition_time_buckets[j], cumulative[j]);
+        }
+        StringBuilder_append_f(builder, "%s_bucket{", name);
+        _write_server_labels(builder, &servers[i]);
+        StringBuilder_append_f(builder, ",le=\"+Inf\"} %" PRId64 "\n", histogram->count);
+        StringBuilder_append_f(builder, "%s_count{", name);
+        _write_server_labels(builder, &servers[i]);
+        StringBuilder_append_f(builder, "} %" PRId64 "\n", histogram->count);
+        StringBuilder_append_f(builder, "%s_sum{", name);
+        _write_server_labels(builder, &servers[i]);
+        StringBuilder_append_f(builder, "} %.6f\n", (double) histogram->sum/MICROS_PER_SECOND);
+    }
+}
+
+void BoltMetrics_write_text(struct StringBuilder* builder, const BoltServerMetrics* servers, int32_t count,
+        const BoltRoutingMetrics* routing)
+{
+    _write_family(builder, "seabolt_memory_allocated_bytes", "gauge", "Memory currently allocated by the driver.");
+    StringBuilder_append_f(builder, "seabolt_memory_allocated_bytes %" PRIu64 "\n",
+            BoltStat_memory_allocation_current());
+    _write_family(builder, "seabolt_memory_allocated_peak_bytes", "gauge",
+            "Peak memory allocated by the driver.");
+    StringBuilder_append_f(builder, "seabolt_memory_allocated_peak_bytes %" PRIu64 "\n",
+            BoltStat_memory_allocation_peak());
+    _write_family(builder, "seabolt_memory_allocation_events", "counter",
+            "Number of allocation, reallocation and release events.");
+    StringBuilder_append_f(builder, "seabolt_memory_allocation_events_total %" PRId64 "\n",
+            BoltStat_memory_allocation_events());
+    _write_family(builder, "seabolt_memory_subsystem_allocated_bytes", "gauge",
+            "Memory currently allocated by each subsystem of the driver.");
+    for (BoltMemoryTag tag = 0; tag<BOLT_MEMORY_TAGS; tag++) {
+        StringBuilder_append_f(builder, "seabolt_memory_subsystem_allocated_bytes{subsystem=\"%s\"} %" PRIu64 "\n",
+                BoltStat_memory_tag_name(tag), BoltStat_memory_tag_allocation_current(tag));
+    }
+    _write_family(builder, "seabolt_memory_subsystem_allocated_peak_bytes", "gauge",
+            "Peak memory allocated by each subsystem of the driver.");
+    for (BoltMemoryTag tag = 0; tag<BOLT_MEMORY_TAGS; tag++) {
+        StringBuilder_append_f(builder,
+                "seabolt_memory_subsystem_allocated_peak_bytes{subsystem=\"%s\"} %" PRIu64 "\n",
+                BoltStat_memory_tag_name(tag), BoltStat_memory_tag_allocation_peak(tag));
+    }
+    _write_family(builder, "seabolt_memory_subsystem_allocation_events", "counter",
+            "Number of allocation, reallocation and release events of each subsystem.");
+    for (BoltMemoryTag tag = 0; tag<BOLT_MEMORY_TAGS; tag++) {
+        StringBuilder_append_f(builder,
+                "seabolt_memory_subsystem_allocation_events_total{subsystem=\"%s\"} %" PRId64 "\n",
+                BoltStat_memory_tag_name(tag), BoltStat_memory_tag_allocation_events(tag));
+    }
+
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_pool_size", "gauge",
+            "Maximum number of connections in the pool.", "", "%" PRId64, server->pool_size);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_pool_connections_in_use", "gauge",
+            "Number of connections currently handed out.", "", "%" PRId64, server->connections_in_use);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_pool_acquisitions", "counter",
+            "Number of connection acquisition attempts.", "_total", "%" PRId64,
+            server->pool_metrics.acquisitions);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_pool_acquisition_timeouts", "counter",
+            "Number of acquisitions that timed out waiting for a connection.", "_total", "%" PRId64,
+            server->pool_metrics.acquisition_timeouts);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_pool_full_events", "counter",
+            "Number of times an acquisition found the pool full.", "_total", "%" PRId64,
+            server->pool_metrics.pool_full_events);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_pool_connections_opened", "counter",
+            "Number of connections opened.", "_total", "%" PRId64, server->pool_metrics.connections_opened);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_pool_connections_closed", "counter",
+            "Number of connections closed.", "_total", "%" PRId64, server->pool_metrics.connections_closed);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_pool_lifetime_expiries", "counter",
+            "Number of connections closed on reaching their maximum lifetime.", "_total", "%" PRId64,
+            server->pool_metrics.lifetime_expiries);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_pool_reset_failures", "counter",
+            "Number of failed RESET attempts.", "_total", "%" PRId64, server->pool_metrics.reset_failures);
+    _write_acquisition_time(builder, servers, count);
+
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_connection_sent_bytes", "counter",
+            "Number of bytes sent.", "_total", "%" PRIu64, (uint64_t) server->connection_metrics.bytes_sent);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_connection_received_bytes", "counter",
+            "Number of bytes received.", "_total", "%" PRIu64, (uint64_t) server->connection_metrics.bytes_received);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_connection_sent_messages", "counter",
+            "Number of request messages sent.", "_total", "%" PRIu64,
+            (uint64_t) server->connection_metrics.messages_sent);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_connection_received_messages", "counter",
+            "Number of response messages received.", "_total", "%" PRIu64,
+            (uint64_t) server->connection_metrics.messages_received);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_connection_received_records", "counter",
+            "Number of records received.", "_total", "%" PRIu64,
+            (uint64_t) server->connection_metrics.records_received);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_connection_send_blocked_seconds", "counter",
+            "Time spent blocked while sending.", "_total", "%.9f",
+            (double) server->connection_metrics.time_blocked_send/NANOS_PER_SECOND);
+    WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_connection_receive_blocked_seconds", "counter",
+            "Time spent blocked while receiving.", "_total", "%.9f",
+            (double) server->connection_metrics.time_blocked_receive/NANOS_PER_SECOND);
+
+    if (routing!=NULL) {
+        WRITE_SERVER_FAMILY(builder, servers, count, "seabolt_routing_circuit_state", "gauge",
+                "Circuit breaker state, 0 for closed, 1 for open and 2 for half-open.", "", "%d",
+                server->circuit_state);
+        _write_family(builder, "seabolt_routing_table_refreshes", "counter", "Number of routing table refreshes.");
+        StringBuilder_append_f(builder, "seabolt_routing_table_refreshes_total %" PRId64 "\n", routing->refreshes);
+        _write_family(builder, "seabolt_routing_table_refresh_failures", "counter",
+                "Number of failed routing table refreshes.");
+        StringBuilder_append_f(builder, "seabolt_routing_table_refresh_failures_total %" PRId64 "\n",
+                routing->refresh_failures);
+    }
+
+    StringBuilder_append(builder, "# EOF\n");
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_METRICS_H
+#define SEABOLT_METRICS_H
+
+#include "bolt-public.h"
+
+/**
+ * The type that holds I/O statistics of a connection, or of a set of connections.
+ *
+ * Counters accumulate over the lifetime of the owning \ref BoltConnection instance, including re-opens
+ * carried out by connection pools.
+ */
+typedef struct BoltConnectionMetrics BoltConnectionMetrics;
+
+/**
+ * Creates a new instance of \ref BoltConnectionMetrics with all counters set to zero.
+ *
+ * @return the pointer to the newly allocated \ref BoltConnectionMetrics instance.
+ */
+SEABOLT_EXPORT BoltConnectionMetrics* BoltConnectionMetrics_create();
+
+/**
+ * Destroys the passed \ref BoltConnectionMetrics instance.
+ *
+ * @param metrics the instance to be destroyed.
+ */
+SEABOLT_EXPORT void BoltConnectionMetrics_destroy(BoltConnectionMetrics* metrics);
+
+/**
+ * Returns the number of bytes sent.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of bytes sent.
+ */
+SEABOLT_EXPORT uint64_t BoltConnectionMetrics_get_bytes_sent(const BoltConnectionMetrics* metrics);
+
+/**
+ * Returns the number of bytes received.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of bytes received.
+ */
+SEABOLT_EXPORT uint64_t BoltConnectionMetrics_get_bytes_received(const BoltConnectionMetrics* metrics);
+
+/**
+ * Returns the number of request messages sent.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of request messages sent.
+ */
+SEABOLT_EXPORT uint64_t BoltConnectionMetrics_get_messages_sent(const BoltConnectionMetrics* metrics);
+
+/**
+ * Returns the number of response messages received, including records.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of response messages received.
+ */
+SEABOLT_EXPORT uint64_t BoltConnectionMetrics_get_messages_received(const BoltConnectionMetrics* metrics);
+
+/**
+ * Returns the number of records received.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of records received.
+ */
+SEABOLT_EXPORT uint64_t BoltConnectionMetrics_get_records_received(const BoltConnectionMetrics* metrics);
+
+/**
+ * Returns the cumulative time spent blocked while sending data, in nanoseconds.
+ *
+ * @param metrics the instance to query.
+ * @returns the time blocked on send in nanoseconds.
+ */
+SEABOLT_EXPORT uint64_t BoltConnectionMetrics_get_time_blocked_send(const BoltConnectionMetrics* metrics);
+
+/**
+ * Returns the cumulative time spent blocked while receiving data, in nanoseconds.
+ *
+ * @param metrics the instance to query.
+ * @returns the time blocked on receive in nanoseconds.
+ */
+SEABOLT_EXPORT uint64_t BoltConnectionMetrics_get_time_blocked_receive(const BoltConnectionMetrics* metrics);
+
+/**
+ * The type that holds statistics of a connection pool, or of a set of connection pools.
+ */
+typedef struct BoltPoolMetrics BoltPoolMetrics;
+
+/**
+ * Creates a new instance of \ref BoltPoolMetrics with all counters set to zero.
+ *
+ * @return the pointer to the newly allocated \ref BoltPoolMetrics instance.
+ */
+SEABOLT_EXPORT BoltPoolMetrics* BoltPoolMetrics_create();
+
+/**
+ * Destroys the passed \ref BoltPoolMetrics instance.
+ *
+ * @param metrics the instance to be destroyed.
+ */
+SEABOLT_EXPORT void BoltPoolMetrics_destroy(BoltPoolMetrics* metrics);
+
+/**
+ * Returns the number of connection acquisition attempts.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of connection acquisition attempts.
+ */
+SEABOLT_EXPORT int64_t BoltPoolMetrics_get_acquisitions(const BoltPoolMetrics* metrics);
+
+/**
+ * Returns the number of acquisitions that timed out waiting for a connection to be released.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of acquisitions that timed out waiting for a connection to be released.
+ */
+SEABOLT_EXPORT int64_t BoltPoolMetrics_get_acquisition_timeouts(const BoltPoolMetrics* metrics);
+
+/**
+ * Returns the number of acquisitions that found the pool full, however many times they waited for a connection.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of acquisitions that found the pool full.
+ */
+SEABOLT_EXPORT int64_t BoltPoolMetrics_get_pool_full_events(const BoltPoolMetrics* metrics);
+
+/**
+ * Returns the number of connections opened.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of connections opened.
+ */
+SEABOLT_EXPORT int64_t BoltPoolMetrics_get_connections_opened(const BoltPoolMetrics* metrics);
+
+/**
+ * Returns the number of connections closed.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of connections closed.
+ */
+SEABOLT_EXPORT int64_t BoltPoolMetrics_get_connections_closed(const BoltPoolMetrics* metrics);
+
+/**
+ * Returns the number of connections closed because of reaching their maximum lifetime.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of connections closed because of reaching their maximum lifetime.
+ */
+SEABOLT_EXPORT int64_t BoltPoolMetrics_get_lifetime_expiries(const BoltPoolMetrics* metrics);
+
+/**
+ * Returns the number of failed RESET attempts.
+ *
+ * @param metrics the instance to query.
+ * @returns the number of failed RESET attempts.
+ */
+SEABOLT_EXPORT int64_t BoltPoolMetrics_get_reset_failures(const BoltPoolMetrics* metrics);
+
+/**
+ * Returns the acquisition time below which the given percentage of acquisitions completed, in microseconds.
+ *
+ * Acquisition time covers waiting for the pool as well as opening or resetting the handed out connection.
+ * The returned value is accurate to within ~3%.
+ *
+ * @param metrics the instance to query.
+ * @param percentile the percentile to query, between 0 and 100.
+ * @returns the acquisition time at the percentile in microseconds, or 0 if nothing is recorded.
+ */
+SEABOLT_EXPORT int64_t BoltPoolMetrics_get_acquisition_time_percentile(const BoltPoolMetrics* metrics, double percentile);
+
+/**
+ * Returns the maximum acquisition time, in microseconds.
+ *
+ * @param metrics the instance to query.
+ * @returns the maximum acquisition time in microseconds.
+ */
+SEABOLT_EXPORT int64_t BoltPoolMetrics_get_acquisition_time_max(const BoltPoolMetrics* metrics);
+
+/**
+ * Returns the total of all acquisition times, in microseconds.
+ *
+ * @param metrics the instance to query.
+ * @returns the total acquisition time in microseconds.
+ */
+SEABOLT_EXPORT int64_t BoltPoolMetrics_get_acquisition_time_sum(const BoltPoolMetrics* metrics);
+
+#endif //SEABOLT_METRICS_H
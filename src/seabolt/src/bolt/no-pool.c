@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_POOLS
+
 #include "bolt-private.h"
 #include "address-private.h"
 #include "atomic.h"
@@ -58,6 +60,8 @@ struct BoltNoPool* BoltNoPool_create(const struct BoltAddress* address, const st
     pool->auth_token = auth_token;
     pool->size = 0;
     pool->connections = NULL;
+    pool->metrics = BoltConnectionMetrics_create();
+    pool->pool_metrics = BoltPoolMetrics_create();
     return pool;
 }
 
@@ -72,6 +76,8 @@ void BoltNoPool_destroy(struct BoltNoPool* pool)
         BoltConnection_destroy(connection);
     }
     BoltMem_deallocate((void*) pool->connections, pool->size*sizeof(BoltConnection*));
+    BoltConnectionMetrics_destroy(pool->metrics);
+    BoltPoolMetrics_destroy(pool->pool_metrics);
     BoltAddress_destroy(pool->address);
     BoltMem_deallocate(pool->id, MAX_ID_LEN);
     BoltSync_mutex_destroy(&pool->mutex);
@@ -82,6 +88,8 @@ BoltConnection* BoltNoPool_acquire(struct BoltNoPool* pool, BoltStatus* status)
 {
     int pool_error = BOLT_SUCCESS;
     BoltConnection*connection = NULL;
+    struct timespec started;
+    BoltTime_get_time(&started);
 
     BoltLog_info(pool->config->log, "[%s]: Acquiring connection towards %s:%s", pool->id,
             pool->address->host, pool->address->port);
@@ -96,9 +104,17 @@ BoltConnection* BoltNoPool_acquire(struct BoltNoPool* pool, BoltStatus* status)
     }
 
     if (pool_error==BOLT_SUCCESS) {
+        connection->capture_directory = pool->config->wire_capture_directory;
+        connection->lazy_decoding = pool->config->lazy_decoding;
+        connection->packed_lists = pool->config->packed_lists;
+        connection->packed_structures = pool->config->packed_structures;
+        connection->buffer_pool = pool->config->buffer_pool;
         switch (BoltConnection_open(connection, pool->config->transport, pool->address, pool->config->trust,
                 pool->config->log, pool->config->socket_options)) {
         case 0:
+            BoltSync_mutex_lock(&pool->mutex);
+            pool->pool_metrics->connections_opened += 1;
+            BoltSync_mutex_unlock(&pool->mutex);
             break;
         default:
             pool_error = BOLT_CONNECTION_HAS_MORE_INFO;  // Could not open socket
@@ -145,6 +161,16 @@ BoltConnection* BoltNoPool_acquire(struct BoltNoPool* pool, BoltStatus* status)
         break;
     }
 
+    struct timespec now;
+    struct timespec elapsed;
+    BoltTime_get_time(&now);
+    BoltTime_diff_time(&elapsed, &now, &started);
+    BoltSync_mutex_lock(&pool->mutex);
+    pool->pool_metrics->acquisitions += 1;
+    BoltHistogram_record(&pool->pool_metrics->acquisition_time,
+            (int64_t) elapsed.tv_sec*1000000+elapsed.tv_nsec/1000);
+    BoltSync_mutex_unlock(&pool->mutex);
+
     return connection;
 }
 
@@ -164,6 +190,8 @@ int BoltNoPool_release(struct BoltNoPool* pool, struct BoltConnection* connectio
                 (pool->size-1)*sizeof(BoltConnection*));
         pool->size = pool->size-1;
     }
+    BoltConnectionMetrics_add(pool->metrics, connection->metrics);
+    pool->pool_metrics->connections_closed += 1;
     BoltSync_mutex_unlock(&pool->mutex);
 
     BoltConnection_close(connection);
@@ -172,3 +200,31 @@ int BoltNoPool_release(struct BoltNoPool* pool, struct BoltConnection* connectio
     return index;
 }
 
+void BoltNoPool_connection_metrics(struct BoltNoPool* pool, BoltConnectionMetrics* metrics)
+{
+    BoltSync_mutex_lock(&pool->mutex);
+    BoltConnectionMetrics_add(metrics, pool->metrics);
+    for (int i = 0; i<pool->size; i++) {
+        BoltConnectionMetrics_add(metrics, ((BoltConnection*) pool->connections[i])->metrics);
+    }
+    BoltSync_mutex_unlock(&pool->mutex);
+}
+
+void BoltNoPool_pool_metrics(struct BoltNoPool* pool, BoltPoolMetrics* metrics)
+{
+    BoltSync_mutex_lock(&pool->mutex);
+    BoltPoolMetrics_add(metrics, pool->pool_metrics);
+    BoltSync_mutex_unlock(&pool->mutex);
+}
+
+void BoltNoPool_server_metrics(struct BoltNoPool* pool, struct BoltServerMetrics* metrics)
+{
+    BoltServerMetrics_init(metrics, pool->address->host, pool->address->port);
+    BoltSync_mutex_lock(&pool->mutex);
+    // there is no upper bound on a no-pool, every acquired connection is in use
+    metrics->pool_size = pool->size;
+    metrics->connections_in_use = pool->size;
+    BoltSync_mutex_unlock(&pool->mutex);
+    BoltNoPool_connection_metrics(pool, &metrics->connection_metrics);
+    BoltNoPool_pool_metrics(pool, &metrics->pool_metrics);
+}
@@ -28,6 +28,8 @@
 #include "connector.h"
 #include "sync.h"
 
+struct BoltServerMetrics;
+
 /**
  * Pooling contract for a no-pooling connection acquisition
  */
@@ -39,6 +41,9 @@ struct BoltNoPool {
     const struct BoltConfig* config;
     volatile int size;
     volatile BoltConnection** connections;
+    /// Accumulated metrics of the connections already released
+    BoltConnectionMetrics* metrics;
+    BoltPoolMetrics* pool_metrics;
 };
 
 #define SIZE_OF_NO_POOL sizeof(struct BoltNoPool)
@@ -54,4 +59,10 @@ BoltConnection* BoltNoPool_acquire(struct BoltNoPool* pool, BoltStatus* status);
 
 int BoltNoPool_release(struct BoltNoPool* pool, struct BoltConnection* connection);
 
+void BoltNoPool_connection_metrics(struct BoltNoPool* pool, BoltConnectionMetrics* metrics);
+
+void BoltNoPool_pool_metrics(struct BoltNoPool* pool, BoltPoolMetrics* metrics);
+
+void BoltNoPool_server_metrics(struct BoltNoPool* pool, struct BoltServerMetrics* metrics);
+
 #endif //SEABOLT_POOLING_H
@@ -17,98 +17,107 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_PROTOCOL
+
 #include "bolt-private.h"
 #include "log-private.h"
+#include "mem.h"
 #include "packstream.h"
 #include "values-private.h"
 
 #define TRY(code) { int status_try = (code); if (status_try != BOLT_SUCCESS) { return status_try; } }
+#define LOAD(call) { if ((call)<0) { return BOLT_OUT_OF_MEMORY; } }
 
 int load_null(struct BoltBuffer* buffer)
 {
-    BoltBuffer_load_u8(buffer, 0xC0);
+    LOAD(BoltBuffer_load_u8(buffer, 0xC0));
     return BOLT_SUCCESS;
 }
 
 int load_boolean(struct BoltBuffer* buffer, int value)
 {
-    BoltBuffer_load_u8(buffer, (value==0) ? (uint8_t) (0xC2) : (uint8_t) (0xC3));
+    LOAD(BoltBuffer_load_u8(buffer, (value==0) ? (uint8_t) (0xC2) : (uint8_t) (0xC3)));
     return BOLT_SUCCESS;
 }
 
 int load_integer(struct BoltBuffer* buffer, int64_t value)
 {
     if (value>=-0x10 && value<0x80) {
-        BoltBuffer_load_i8(buffer, (int8_t) (value));
+        LOAD(BoltBuffer_load_i8(buffer, (int8_t) (value)));
     }
     else if (value>=INT8_MIN && value<=INT8_MAX) {
-        BoltBuffer_load_u8(buffer, 0xC8);
-        BoltBuffer_load_i8(buffer, (int8_t) (value));
+        LOAD(BoltBuffer_load_u8(buffer, 0xC8));
+        LOAD(BoltBuffer_load_i8(buffer, (int8_t) (value)));
     }
     else if (value>=INT16_MIN && value<=INT16_MAX) {
-        BoltBuffer_load_u8(buffer, 0xC9);
-        BoltBuffer_load_i16be(buffer, (int16_t) (value));
+        LOAD(BoltBuffer_load_u8(buffer, 0xC9));
+        LOAD(BoltBuffer_load_i16be(buffer, (int16_t) (value)));
     }
     else if (value>=INT32_MIN && value<=INT32_MAX) {
-        BoltBuffer_load_u8(buffer, 0xCA);
-        BoltBuffer_load_i32be(buffer, (int32_t) (value));
+        LOAD(BoltBuffer_load_u8(buffer, 0xCA));
+        LOAD(BoltBuffer_load_i32be(buffer, (int32_t) (value)));
     }
     else {
-        BoltBuffer_load_u8(buffer, 0xCB);
-        BoltBuffer_load_i64be(buffer, value);
+        LOAD(BoltBuffer_load_u8(buffer, 0xCB));
+        LOAD(BoltBuffer_load_i64be(buffer, value));
     }
     return BOLT_SUCCESS;
 }
 
 int load_float(struct BoltBuffer* buffer, double value)
 {
-    BoltBuffer_load_u8(buffer, 0xC1);
-    BoltBuffer_load_f64be(buffer, value);
+    LOAD(BoltBuffer_load_u8(buffer, 0xC1));
+    LOAD(BoltBuffer_load_f64be(buffer, value));
     return BOLT_SUCCESS;
 }
 
-int load_bytes(struct BoltBuffer* buffer, const char* string, int32_t size)
+int load_bytes_header(struct BoltBuffer* buffer, int32_t size)
 {
     if (size<0) {
         return BOLT_PROTOCOL_VIOLATION;
     }
     if (size<0x100) {
-        BoltBuffer_load_u8(buffer, 0xCC);
-        BoltBuffer_load_u8(buffer, (uint8_t) (size));
-        BoltBuffer_load(buffer, string, size);
+        LOAD(BoltBuffer_load_u8(buffer, 0xCC));
+        LOAD(BoltBuffer_load_u8(buffer, (uint8_t) (size)));
     }
     else if (size<0x10000) {
-        BoltBuffer_load_u8(buffer, 0xCD);
-        BoltBuffer_load_u16be(buffer, (uint16_t) (size));
-        BoltBuffer_load(buffer, string, size);
+        LOAD(BoltBuffer_load_u8(buffer, 0xCD));
+        LOAD(BoltBuffer_load_u16be(buffer, (uint16_t) (size)));
     }
     else {
-        BoltBuffer_load_u8(buffer, 0xCE);
-        BoltBuffer_load_i32be(buffer, size);
-        BoltBuffer_load(buffer, string, size);
+        LOAD(BoltBuffer_load_u8(buffer, 0xCE));
+        LOAD(BoltBuffer_load_i32be(buffer, size));
     }
     return BOLT_SUCCESS;
 }
 
+int load_bytes(struct BoltBuffer* buffer, const char* string, int32_t size)
+{
+    int status = load_bytes_header(buffer, size);
+    if (status!=BOLT_SUCCESS) return status;
+    LOAD(BoltBuffer_load(buffer, string, size));
+    return BOLT_SUCCESS;
+}
+
 int load_string_header(struct BoltBuffer* buffer, int32_t size)
 {
     if (size<0) {
         return BOLT_PROTOCOL_VIOLATION;
     }
     if (size<0x10) {
-        BoltBuffer_load_u8(buffer, (uint8_t) (0x80+size));
+        LOAD(BoltBuffer_load_u8(buffer, (uint8_t) (0x80+size)));
     }
     else if (size<0x100) {
-        BoltBuffer_load_u8(buffer, 0xD0);
-        BoltBuffer_load_u8(buffer, (uint8_t) (size));
+        LOAD(BoltBuffer_load_u8(buffer, 0xD0));
+        LOAD(BoltBuffer_load_u8(buffer, (uint8_t) (size)));
     }
     else if (size<0x10000) {
-        BoltBuffer_load_u8(buffer, 0xD1);
-        BoltBuffer_load_u16be(buffer, (uint16_t) (size));
+        LOAD(BoltBuffer_load_u8(buffer, 0xD1));
+        LOAD(BoltBuffer_load_u16be(buffer, (uint16_t) (size)));
     }
     else {
-        BoltBuffer_load_u8(buffer, 0xD2);
-        BoltBuffer_load_i32be(buffer, size);
+        LOAD(BoltBuffer_load_u8(buffer, 0xD2));
+        LOAD(BoltBuffer_load_i32be(buffer, size));
     }
     return BOLT_SUCCESS;
 }
@@ -117,7 +126,7 @@ int load_string(struct BoltBuffer* buffer, const char* string, int32_t size)
 {
     int status = load_string_header(buffer, size);
     if (status!=BOLT_SUCCESS) return status;
-    BoltBuffer_load(buffer, string, size);
+    LOAD(BoltBuffer_load(buffer, string, size));
     return BOLT_SUCCESS;
 }
 
@@ -127,19 +136,19 @@ int load_list_header(struct BoltBuffer* buffer, int32_t size)
         return BOLT_PROTOCOL_VIOLATION;
     }
     if (size<0x10) {
-        BoltBuffer_load_u8(buffer, (uint8_t) (0x90+size));
+        LOAD(BoltBuffer_load_u8(buffer, (uint8_t) (0x90+size)));
     }
     else if (size<0x100) {
-        BoltBuffer_load_u8(buffer, 0xD4);
-        BoltBuffer_load_u8(buffer, (uint8_t) (size));
+        LOAD(BoltBuffer_load_u8(buffer, 0xD4));
+        LOAD(BoltBuffer_load_u8(buffer, (uint8_t) (size)));
     }
     else if (size<0x10000) {
-        BoltBuffer_load_u8(buffer, 0xD5);
-        BoltBuffer_load_u16be(buffer, (uint16_t) (size));
+        LOAD(BoltBuffer_load_u8(buffer, 0xD5));
+        LOAD(BoltBuffer_load_u16be(buffer, (uint16_t) (size)));
     }
     else {
-        BoltBuffer_load_u8(buffer, 0xD6);
-        BoltBuffer_load_i32be(buffer, size);
+        LOAD(BoltBuffer_load_u8(buffer, 0xD6));
+        LOAD(BoltBuffer_load_i32be(buffer, size));
     }
     return BOLT_SUCCESS;
 }
@@ -150,19 +159,19 @@ int load_map_header(struct BoltBuffer* buffer, int32_t size)
         return BOLT_PROTOCOL_VIOLATION;
     }
     if (size<0x10) {
-        BoltBuffer_load_u8(buffer, (uint8_t) (0xA0+size));
+        LOAD(BoltBuffer_load_u8(buffer, (uint8_t) (0xA0+size)));
     }
     else if (size<0x100) {
-        BoltBuffer_load_u8(buffer, 0xD8);
-        BoltBuffer_load_u8(buffer, (uint8_t) (size));
+        LOAD(BoltBuffer_load_u8(buffer, 0xD8));
+        LOAD(BoltBuffer_load_u8(buffer, (uint8_t) (size)));
     }
     else if (size<0x10000) {
-        BoltBuffer_load_u8(buffer, 0xD9);
-        BoltBuffer_load_u16be(buffer, (uint16_t) (size));
+        LOAD(BoltBuffer_load_u8(buffer, 0xD9));
+        LOAD(BoltBuffer_load_u16be(buffer, (uint16_t) (size)));
     }
     else {
-        BoltBuffer_load_u8(buffer, 0xDA);
-        BoltBuffer_load_i32be(buffer, size);
+        LOAD(BoltBuffer_load_u8(buffer, 0xDA));
+        LOAD(BoltBuffer_load_i32be(buffer, size));
     }
     return BOLT_SUCCESS;
 }
@@ -172,29 +181,85 @@ int load_structure_header(struct BoltBuffer* buffer, int16_t code, int8_t size)
     if (code<0 || size<0 || size>=0x10) {
         return BOLT_PROTOCOL_VIOLATION;
     }
-    BoltBuffer_load_u8(buffer, (uint8_t) (0xB0+size));
-    BoltBuffer_load_i8(buffer, (int8_t) (code));
+    LOAD(BoltBuffer_load_u8(buffer, (uint8_t) (0xB0+size)));
+    LOAD(BoltBuffer_load_i8(buffer, (int8_t) (code)));
     return BOLT_SUCCESS;
 }
 
-int load(check_struct_signature_func check_struct_type, struct BoltBuffer* buffer, struct BoltValue* value,
-        const struct BoltLog* log)
+static int _flush(const struct PackStreamSink* sink, struct BoltBuffer* buffer)
+{
+    if (sink!=NULL && BoltBuffer_unloadable(buffer)>=sink->threshold) {
+        return sink->flush(sink->context, buffer);
+    }
+    return BOLT_SUCCESS;
+}
+
+int load_payload(struct BoltBuffer* buffer, const char* data, int32_t size, const struct PackStreamSink* sink)
+{
+    if (sink==NULL) {
+        LOAD(BoltBuffer_load(buffer, data, size));
+        return BOLT_SUCCESS;
+    }
+    // copy large payloads in pieces so that no more than a threshold worth of them is ever buffered
+    for (int32_t offset = 0; offset<size;) {
+        int32_t piece = size-offset<sink->threshold ? size-offset : sink->threshold;
+        LOAD(BoltBuffer_load(buffer, data+offset, piece));
+        offset += piece;
+        TRY(_flush(sink, buffer));
+    }
+    return BOLT_SUCCESS;
+}
+
+static int _load(check_struct_signature_func check_struct_type, struct BoltBuffer* buffer, struct BoltValue* value,
+        const struct PackStreamSink* sink, const struct BoltLog* log)
 {
     switch (BoltValue_type(value)) {
     case BOLT_NULL:
         return load_null(buffer);
     case BOLT_LIST: {
         TRY(load_list_header(buffer, value->size));
+        // Packed lists are encoded straight from their arrays, without being unpacked
+        switch (BoltList_packed_type(value)) {
+        case BOLT_INTEGER:
+            for (int32_t i = 0; i<value->size; i++) {
+                TRY(load_integer(buffer, BoltList_integers(value)[i]));
+                TRY(_flush(sink, buffer));
+            }
+            return 0;
+        case BOLT_FLOAT:
+            for (int32_t i = 0; i<value->size; i++) {
+                TRY(load_float(buffer, BoltList_floats(value)[i]));
+                TRY(_flush(sink, buffer));
+            }
+            return 0;
+        case BOLT_BOOLEAN:
+            for (int32_t i = 0; i<value->size; i++) {
+                TRY(load_boolean(buffer, BoltList_booleans(value)[i]));
+                TRY(_flush(sink, buffer));
+            }
+            return 0;
+        default:
+            break;
+        }
         for (int32_t i = 0; i<value->size; i++) {
-            TRY(load(check_struct_type, buffer, BoltList_value(value, i), log));
+            TRY(_load(check_struct_type, buffer, BoltList_value(value, i), sink, log));
+            TRY(_flush(sink, buffer));
         }
         return 0;
     }
     case BOLT_BOOLEAN:
         return load_boolean(buffer, BoltBoolean_get(value));
     case BOLT_BYTES:
+        if (sink!=NULL && value->size>sink->threshold) {
+            TRY(load_bytes_header(buffer, value->size));
+            return load_payload(buffer, BoltBytes_get_all(value), value->size, sink);
+        }
         return load_bytes(buffer, BoltBytes_get_all(value), value->size);
     case BOLT_STRING:
+        if (sink!=NULL && value->size>sink->threshold) {
+            TRY(load_string_header(buffer, value->size));
+            return load_payload(buffer, BoltString_get(value), value->size, sink);
+        }
         return load_string(buffer, BoltString_get(value), value->size);
     case BOLT_DICTIONARY: {
         TRY(load_map_header(buffer, value->size));
@@ -202,7 +267,8 @@ int load(check_struct_signature_func check_struct_type, struct BoltBuffer* buffe
             const char* key = BoltDictionary_get_key(value, i);
             if (key!=NULL) {
                 TRY(load_string(buffer, key, BoltDictionary_get_key_size(value, i)));
-                TRY(load(check_struct_type, buffer, BoltDictionary_value(value, i), log));
+                TRY(_load(check_struct_type, buffer, BoltDictionary_value(value, i), sink, log));
+                TRY(_flush(sink, buffer));
             }
         }
         return BOLT_SUCCESS;
@@ -214,8 +280,21 @@ int load(check_struct_signature_func check_struct_type, struct BoltBuffer* buffe
     case BOLT_STRUCTURE: {
         if (check_struct_type(BoltStructure_code(value))) {
             TRY(load_structure_header(buffer, BoltStructure_code(value), (int8_t) value->size));
+            // Packed structures are encoded straight from their fields, without being unpacked
+            if (BoltStructure_is_packed(value)) {
+                for (int32_t i = 0; i<value->size; i++) {
+                    if ((value->type & BOLT_PACKED_FLOAT_FLAG(i))!=0) {
+                        TRY(load_float(buffer, BoltStructure_float(value, i)));
+                    }
+                    else {
+                        TRY(load_integer(buffer, BoltStructure_integer(value, i)));
+                    }
+                }
+                return BOLT_SUCCESS;
+            }
             for (int32_t i = 0; i<value->size; i++) {
-                TRY(load(check_struct_type, buffer, BoltStructure_value(value, i), log));
+                TRY(_load(check_struct_type, buffer, BoltStructure_value(value, i), sink, log));
+                TRY(_flush(sink, buffer));
             }
             return BOLT_SUCCESS;
         }
@@ -226,6 +305,18 @@ int load(check_struct_signature_func check_struct_type, struct BoltBuffer* buffe
     }
 }
 
+int load(check_struct_signature_func check_struct_type, struct BoltBuffer* buffer, struct BoltValue* value,
+        const struct BoltLog* log)
+{
+    return _load(check_struct_type, buffer, value, NULL, log);
+}
+
+int load_streaming(check_struct_signature_func check_struct_type, struct BoltBuffer* buffer, struct BoltValue* value,
+        const struct PackStreamSink* sink, const struct BoltLog* log)
+{
+    return _load(check_struct_type, buffer, value, sink, log);
+}
+
 enum PackStreamType marker_type(uint8_t marker)
 {
     if (marker<0x80 || (marker>=0xC8 && marker<=0xCB) || marker>=0xF0) {
@@ -260,6 +351,21 @@ enum PackStreamType marker_type(uint8_t marker)
     }
 }
 
+/// The type a list is packed as when its elements are of the given type, BOLT_NULL if they cannot be packed
+static enum BoltType _packed_type(enum PackStreamType type)
+{
+    switch (type) {
+    case PACKSTREAM_BOOLEAN:
+        return BOLT_BOOLEAN;
+    case PACKSTREAM_INTEGER:
+        return BOLT_INTEGER;
+    case PACKSTREAM_FLOAT:
+        return BOLT_FLOAT;
+    default:
+        return BOLT_NULL;
+    }
+}
+
 int unload_null(struct BoltBuffer* recv_buffer, struct BoltValue* value)
 {
     uint8_t marker;
@@ -273,15 +379,15 @@ int unload_null(struct BoltBuffer* recv_buffer, struct BoltValue* value)
     return BOLT_SUCCESS;
 }
 
-int unload_boolean(struct BoltBuffer* recv_buffer, struct BoltValue* value)
+static int _unload_boolean(struct BoltBuffer* recv_buffer, char* x)
 {
     uint8_t marker;
     BoltBuffer_unload_u8(recv_buffer, &marker);
     if (marker==0xC3) {
-        BoltValue_format_as_Boolean(value, 1);
+        *x = 1;
     }
     else if (marker==0xC2) {
-        BoltValue_format_as_Boolean(value, 0);
+        *x = 0;
     }
     else {
         return BOLT_PROTOCOL_UNEXPECTED_MARKER;
@@ -289,35 +395,33 @@ int unload_boolean(struct BoltBuffer* recv_buffer, struct BoltValue* value)
     return BOLT_SUCCESS;
 }
 
-int unload_integer(struct BoltBuffer* recv_buffer, struct BoltValue* value)
+static int _unload_integer(struct BoltBuffer* recv_buffer, int64_t* x)
 {
     uint8_t marker;
     BoltBuffer_unload_u8(recv_buffer, &marker);
     if (marker<0x80) {
-        BoltValue_format_as_Integer(value, marker);
+        *x = marker;
     }
     else if (marker>=0xF0) {
-        BoltValue_format_as_Integer(value, marker-0x100);
+        *x = marker-0x100;
     }
     else if (marker==0xC8) {
-        int8_t x;
-        BoltBuffer_unload_i8(recv_buffer, &x);
-        BoltValue_format_as_Integer(value, x);
+        int8_t x8;
+        BoltBuffer_unload_i8(recv_buffer, &x8);
+        *x = x8;
     }
     else if (marker==0xC9) {
-        int16_t x;
-        BoltBuffer_unload_i16be(recv_buffer, &x);
-        BoltValue_format_as_Integer(value, x);
+        int16_t x16;
+        BoltBuffer_unload_i16be(recv_buffer, &x16);
+        *x = x16;
     }
     else if (marker==0xCA) {
-        int32_t x;
-        BoltBuffer_unload_i32be(recv_buffer, &x);
-        BoltValue_format_as_Integer(value, x);
+        int32_t x32;
+        BoltBuffer_unload_i32be(recv_buffer, &x32);
+        *x = x32;
     }
     else if (marker==0xCB) {
-        int64_t x;
-        BoltBuffer_unload_i64be(recv_buffer, &x);
-        BoltValue_format_as_Integer(value, x);
+        BoltBuffer_unload_i64be(recv_buffer, x);
     }
     else {
         return BOLT_PROTOCOL_UNEXPECTED_MARKER;  // BOLT_ERROR_WRONG_TYPE
@@ -325,14 +429,12 @@ int unload_integer(struct BoltBuffer* recv_buffer, struct BoltValue* value)
     return BOLT_SUCCESS;
 }
 
-int unload_float(struct BoltBuffer* recv_buffer, struct BoltValue* value)
+static int _unload_float(struct BoltBuffer* recv_buffer, double* x)
 {
     uint8_t marker;
     BoltBuffer_unload_u8(recv_buffer, &marker);
     if (marker==0xC1) {
-        double x;
-        BoltBuffer_unload_f64be(recv_buffer, &x);
-        BoltValue_format_as_Float(value, x);
+        BoltBuffer_unload_f64be(recv_buffer, x);
     }
     else {
         return BOLT_PROTOCOL_UNEXPECTED_MARKER;  // BOLT_ERROR_WRONG_TYPE
@@ -340,6 +442,30 @@ int unload_float(struct BoltBuffer* recv_buffer, struct BoltValue* value)
     return BOLT_SUCCESS;
 }
 
+int unload_boolean(struct BoltBuffer* recv_buffer, struct BoltValue* value)
+{
+    char x;
+    TRY(_unload_boolean(recv_buffer, &x));
+    BoltValue_format_as_Boolean(value, x);
+    return BOLT_SUCCESS;
+}
+
+int unload_integer(struct BoltBuffer* recv_buffer, struct BoltValue* value)
+{
+    int64_t x;
+    TRY(_unload_integer(recv_buffer, &x));
+    BoltValue_format_as_Integer(value, x);
+    return BOLT_SUCCESS;
+}
+
+int unload_float(struct BoltBuffer* recv_buffer, struct BoltValue* value)
+{
+    double x;
+    TRY(_unload_float(recv_buffer, &x));
+    BoltValue_format_as_Float(value, x);
+    return BOLT_SUCCESS;
+}
+
 int unload_string(struct BoltBuffer* recv_buffer, struct BoltValue* value, const struct BoltLog* log)
 {
     uint8_t marker;
@@ -405,7 +531,214 @@ int unload_bytes(struct BoltBuffer* recv_buffer, struct BoltValue* value, const
     return BOLT_PROTOCOL_UNEXPECTED_MARKER;
 }
 
-int unload_list(check_struct_signature_func check_struct_type, struct BoltBuffer* recv_buffer, struct BoltValue* value,
+static int _header_size(uint8_t marker)
+{
+    switch (marker) {
+    case 0xC8:
+    case 0xCC:
+    case 0xD0:
+    case 0xD4:
+    case 0xD8:
+        return 2;
+    case 0xC9:
+    case 0xCD:
+    case 0xD1:
+    case 0xD5:
+    case 0xD9:
+        return 3;
+    case 0xCA:
+    case 0xCE:
+    case 0xD2:
+    case 0xD6:
+    case 0xDA:
+        return 5;
+    case 0xC1:
+    case 0xCB:
+        return 9;
+    default:
+        // structure markers carry their signature in the following byte
+        return (marker>=0xB0 && marker<=0xBF) ? 2 : 1;
+    }
+}
+
+static uint64_t _header_uint(const uint8_t* header, int header_size)
+{
+    uint64_t x = 0;
+    for (int i = 1; i<header_size; i++) {
+        x = (x << 8) | header[i];
+    }
+    return x;
+}
+
+static int32_t _header_length(const uint8_t* header, int header_size)
+{
+    if (header_size==1) {
+        return header[0] & 0x0F;
+    }
+    uint64_t x = _header_uint(header, header_size);
+    return header_size==5 ? (int32_t) (uint32_t) x : (int32_t) x;
+}
+
+/**
+ * Works out from the complete _header_ of an encoded value how many nested values and payload bytes follow it,
+ * checking the value the same way decoding it would.
+ */
+static int _encoded_extent(check_struct_signature_func check_struct_type, const uint8_t* header, int header_size,
+        int64_t* values, int32_t* payload)
+{
+    const uint8_t marker = header[0];
+    int32_t size;
+    *values = 0;
+    *payload = 0;
+    switch (marker_type(marker)) {
+    case PACKSTREAM_NULL:
+    case PACKSTREAM_BOOLEAN:
+    case PACKSTREAM_INTEGER:
+    case PACKSTREAM_FLOAT:
+        return BOLT_SUCCESS;
+    case PACKSTREAM_STRING:
+    case PACKSTREAM_BYTES:
+        size = _header_length(header, header_size);
+        if (size<0) {
+            return BOLT_PROTOCOL_VIOLATION;
+        }
+        *payload = size;
+        return BOLT_SUCCESS;
+    case PACKSTREAM_LIST:
+    case PACKSTREAM_MAP:
+        size = _header_length(header, header_size);
+        if (size<0) {
+            return BOLT_PROTOCOL_VIOLATION;
+        }
+        *values = marker_type(marker)==PACKSTREAM_MAP ? 2*(int64_t) size : size;
+        return BOLT_SUCCESS;
+    case PACKSTREAM_STRUCTURE:
+        if (marker<0xB0 || marker>0xBF || !check_struct_type((int8_t) header[1])) {
+            return BOLT_PROTOCOL_UNEXPECTED_MARKER;
+        }
+        *values = marker & 0x0F;
+        return BOLT_SUCCESS;
+    default:
+        return BOLT_PROTOCOL_UNEXPECTED_MARKER;
+    }
+}
+
+/**
+ * Moves past _values_ complete encoded values in _buffer_ without decoding them.
+ */
+static int _skip(check_struct_signature_func check_struct_type, struct BoltBuffer* buffer, int64_t values)
+{
+    uint8_t header[9];
+    while (values>0) {
+        if (BoltBuffer_peek_u8(buffer, &header[0])!=0) {
+            return BOLT_PROTOCOL_VIOLATION;
+        }
+        int header_size = _header_size(header[0]);
+        if (BoltBuffer_unload(buffer, (char*) header, header_size)<0) {
+            return BOLT_PROTOCOL_VIOLATION;
+        }
+        int64_t nested;
+        int32_t payload;
+        TRY(_encoded_extent(check_struct_type, header, header_size, &nested, &payload));
+        if (payload>0 && BoltBuffer_unload_pointer(buffer, payload)==NULL) {
+            return BOLT_PROTOCOL_VIOLATION;
+        }
+        values += nested-1;
+    }
+    return BOLT_SUCCESS;
+}
+
+int check_encoded(check_struct_signature_func check_struct_type, const char* data, int32_t size)
+{
+    struct BoltBuffer encoded;
+    encoded.data = (char*) data;
+    encoded.size = size;
+    encoded.extent = size;
+    encoded.cursor = 0;
+    encoded.high_water = size;
+    TRY(_skip(check_struct_type, &encoded, 1));
+    return BoltBuffer_unloadable(&encoded)==0 ? BOLT_SUCCESS : BOLT_PROTOCOL_VIOLATION;
+}
+
+struct BoltLazyFields {
+    check_struct_signature_func check_struct_type;
+    check_struct_signature_func check_lazy_struct;
+    check_struct_signature_func check_packed_struct;
+    int pack_lists;
+    /// The number of fields of the structure
+    int32_t count;
+    /// The number of fields decoded so far
+    int32_t decoded;
+    /// Offset of the next field to decode in the encoded fields
+    int32_t offset;
+    /// Size of the encoded fields, which directly follow this header
+    int32_t size;
+};
+
+#define LAZY_FIELDS_BYTES(lazy) ((char*) (lazy)+sizeof(struct BoltLazyFields))
+
+struct BoltLazyFields* BoltLazyFields_create(check_struct_signature_func check_struct_type,
+        check_struct_signature_func check_lazy_struct, check_struct_signature_func check_packed_struct, int pack_lists,
+        int32_t count, const char* bytes, int32_t size)
+{
+    struct BoltLazyFields* lazy = BoltMem_allocate_tagged(BOLT_MEMORY_VALUES, sizeof(struct BoltLazyFields)+size);
+    lazy->check_struct_type = check_struct_type;
+    lazy->check_lazy_struct = check_lazy_struct;
+    lazy->check_packed_struct = check_packed_struct;
+    lazy->pack_lists = pack_lists;
+    lazy->count = count;
+    lazy->decoded = 0;
+    lazy->offset = 0;
+    lazy->size = size;
+    memcpy(LAZY_FIELDS_BYTES(lazy), bytes, (size_t) size);
+    return lazy;
+}
+
+struct BoltLazyFields* BoltLazyFields_duplicate(const struct BoltLazyFields* lazy)
+{
+    return BoltMem_duplicate_tagged(BOLT_MEMORY_VALUES, lazy, sizeof(struct BoltLazyFields)+lazy->size);
+}
+
+void BoltLazyFields_destroy(struct BoltLazyFields* lazy)
+{
+    BoltMem_deallocate_tagged(BOLT_MEMORY_VALUES, lazy, sizeof(struct BoltLazyFields)+lazy->size);
+}
+
+int32_t BoltLazyFields_decoded(const struct BoltLazyFields* lazy)
+{
+    return lazy->decoded;
+}
+
+int32_t BoltLazyFields_decode(struct BoltLazyFields* lazy, struct BoltValue* fields, int32_t count)
+{
+    if (count>lazy->count) {
+        count = lazy->count;
+    }
+    struct BoltBuffer encoded;
+    encoded.data = LAZY_FIELDS_BYTES(lazy);
+    encoded.size = lazy->size;
+    encoded.extent = lazy->size;
+    encoded.cursor = lazy->offset;
+    encoded.high_water = lazy->size;
+    while (lazy->decoded<count) {
+        if (unload_lazy(lazy->check_struct_type, lazy->check_lazy_struct, lazy->check_packed_struct, lazy->pack_lists,
+                &encoded,
+                &fields[lazy->decoded], NULL)!=BOLT_SUCCESS) {
+            // The fields were checked when the structure was received, so this is not expected; the remaining
+            // fields are left null rather than being attempted again
+            BoltValue_format_as_Null(&fields[lazy->decoded]);
+            lazy->decoded = lazy->count;
+            break;
+        }
+        lazy->decoded += 1;
+    }
+    lazy->offset = BoltBuffer_unloadable(&encoded)==0 ? lazy->size : encoded.cursor;
+    return lazy->decoded;
+}
+
+int unload_list(check_struct_signature_func check_struct_type, check_struct_signature_func check_lazy_struct,
+        check_struct_signature_func check_packed_struct, int pack_lists, struct BoltBuffer* recv_buffer,
+        struct BoltValue* value,
         const struct BoltLog* log)
 {
     uint8_t marker;
@@ -435,14 +768,45 @@ int unload_list(check_struct_signature_func check_struct_type, struct BoltBuffer
     if (size<0) {
         return BOLT_PROTOCOL_VIOLATION;
     }
-    BoltValue_format_as_List(value, size);
-    for (int i = 0; i<size; i++) {
-        TRY(unload(check_struct_type, recv_buffer, BoltList_value(value, i), log));
+    // If asked for, long lists are packed if their first element is a scalar, and unpacked again should a later one
+    // not match
+    enum BoltType packed = BOLT_NULL;
+    if (pack_lists && size>=PACKED_LIST_MIN_SIZE && BoltBuffer_peek_u8(recv_buffer, &marker)==0) {
+        packed = _packed_type(marker_type(marker));
+    }
+    int32_t i = 0;
+    if (packed!=BOLT_NULL) {
+        BoltValue_format_as_packed_List(value, packed, size);
+        for (; i<size; i++) {
+            if (BoltBuffer_peek_u8(recv_buffer, &marker)!=0 || _packed_type(marker_type(marker))!=packed) {
+                break;
+            }
+            switch (packed) {
+            case BOLT_INTEGER:
+                TRY(_unload_integer(recv_buffer, &BoltList_integers(value)[i]));
+                break;
+            case BOLT_FLOAT:
+                TRY(_unload_float(recv_buffer, &BoltList_floats(value)[i]));
+                break;
+            default:
+                TRY(_unload_boolean(recv_buffer, &BoltList_booleans(value)[i]));
+                break;
+            }
+        }
+    }
+    else {
+        BoltValue_format_as_List(value, size);
+    }
+    for (; i<size; i++) {
+        TRY(unload_lazy(check_struct_type, check_lazy_struct, check_packed_struct, pack_lists, recv_buffer,
+                BoltList_value(value, i), log));
     }
     return BOLT_SUCCESS;
 }
 
-int unload_map(check_struct_signature_func check_struct_type, struct BoltBuffer* recv_buffer, struct BoltValue* value,
+int unload_map(check_struct_signature_func check_struct_type, check_struct_signature_func check_lazy_struct,
+        check_struct_signature_func check_packed_struct, int pack_lists, struct BoltBuffer* recv_buffer,
+        struct BoltValue* value,
         const struct BoltLog* log)
 {
     uint8_t marker;
@@ -474,14 +838,17 @@ int unload_map(check_struct_signature_func check_struct_type, struct BoltBuffer*
     }
     BoltValue_format_as_Dictionary(value, size);
     for (int i = 0; i<size; i++) {
-        TRY(unload(check_struct_type, recv_buffer, BoltDictionary_key(value, i), log));
-        TRY(unload(check_struct_type, recv_buffer, BoltDictionary_value(value, i), log));
+        TRY(unload_lazy(check_struct_type, check_lazy_struct, check_packed_struct, pack_lists, recv_buffer,
+                BoltDictionary_key(value, i), log));
+        TRY(unload_lazy(check_struct_type, check_lazy_struct, check_packed_struct, pack_lists, recv_buffer,
+                BoltDictionary_value(value, i), log));
     }
     return BOLT_SUCCESS;
 }
 
-int
-unload_structure(check_struct_signature_func check_struct_type, struct BoltBuffer* recv_buffer, struct BoltValue* value,
+int unload_structure(check_struct_signature_func check_struct_type, check_struct_signature_func check_lazy_struct,
+        check_struct_signature_func check_packed_struct, int pack_lists, struct BoltBuffer* recv_buffer,
+        struct BoltValue* value,
         const struct BoltLog* log)
 {
     uint8_t marker;
@@ -492,9 +859,43 @@ unload_structure(check_struct_signature_func check_struct_type, struct BoltBuffe
         size = marker & 0x0F;
         BoltBuffer_unload_i8(recv_buffer, &code);
         if (check_struct_type(code)) {
+            if (size>0 && check_lazy_struct!=NULL && check_lazy_struct(code)) {
+                // Only the encoded fields are kept, to be decoded when first accessed
+                BoltValue_format_as_Structure(value, code, size);
+                const char* fields = recv_buffer->data+recv_buffer->cursor;
+                int available = BoltBuffer_unloadable(recv_buffer);
+                TRY(_skip(check_struct_type, recv_buffer, size));
+                BoltStructure_set_lazy(value, BoltLazyFields_create(check_struct_type, check_lazy_struct,
+                        check_packed_struct, pack_lists, size, fields, available-BoltBuffer_unloadable(recv_buffer)));
+                return BOLT_SUCCESS;
+            }
+            if (size<=BOLT_PACKED_STRUCTURE_MAX_SIZE && check_packed_struct!=NULL && check_packed_struct(code)) {
+                // Integer and float fields are stored straight into the structure, any other field unpacks it
+                BoltValue_format_as_packed_Structure(value, code, size);
+                for (int i = 0; i<size; i++) {
+                    enum PackStreamType type = BoltBuffer_peek_u8(recv_buffer, &marker)==0 ? marker_type(marker)
+                                                                                             : PACKSTREAM_RESERVED;
+                    if (BoltStructure_is_packed(value) && type==PACKSTREAM_INTEGER) {
+                        int64_t x;
+                        TRY(_unload_integer(recv_buffer, &x));
+                        BoltStructure_set_integer(value, i, x);
+                    }
+                    else if (BoltStructure_is_packed(value) && type==PACKSTREAM_FLOAT) {
+                        double x;
+                        TRY(_unload_float(recv_buffer, &x));
+                        BoltStructure_set_float(value, i, x);
+                    }
+                    else {
+                        TRY(unload_lazy(check_struct_type, check_lazy_struct, check_packed_struct, pack_lists,
+                                recv_buffer, BoltStructure_value(value, i), log));
+                    }
+                }
+                return BOLT_SUCCESS;
+            }
             BoltValue_format_as_Structure(value, code, size);
             for (int i = 0; i<size; i++) {
-                unload(check_struct_type, recv_buffer, BoltStructure_value(value, i), log);
+                unload_lazy(check_struct_type, check_lazy_struct, check_packed_struct, pack_lists, recv_buffer,
+                        BoltStructure_value(value, i), log);
             }
             return BOLT_SUCCESS;
         }
@@ -504,6 +905,13 @@ unload_structure(check_struct_signature_func check_struct_type, struct BoltBuffe
 
 int unload(check_struct_signature_func check_struct_type, struct BoltBuffer* buffer, struct BoltValue* value,
         const struct BoltLog* log)
+{
+    return unload_lazy(check_struct_type, NULL, NULL, 0, buffer, value, log);
+}
+
+int unload_lazy(check_struct_signature_func check_struct_type, check_struct_signature_func check_lazy_struct,
+        check_struct_signature_func check_packed_struct, int pack_lists, struct BoltBuffer* buffer,
+        struct BoltValue* value, const struct BoltLog* log)
 {
     uint8_t marker;
     BoltBuffer_peek_u8(buffer, &marker);
@@ -521,13 +929,448 @@ int unload(check_struct_signature_func check_struct_type, struct BoltBuffer* buf
     case PACKSTREAM_BYTES:
         return unload_bytes(buffer, value, log);
     case PACKSTREAM_LIST:
-        return unload_list(check_struct_type, buffer, value, log);
+        return unload_list(check_struct_type, check_lazy_struct, check_packed_struct, pack_lists, buffer, value, log);
     case PACKSTREAM_MAP:
-        return unload_map(check_struct_type, buffer, value, log);
+        return unload_map(check_struct_type, check_lazy_struct, check_packed_struct, pack_lists, buffer, value, log);
     case PACKSTREAM_STRUCTURE:
-        return unload_structure(check_struct_type, buffer, value, log);
+        return unload_structure(check_struct_type, check_lazy_struct, check_packed_struct, pack_lists, buffer, value,
+                log);
+    default:
+        BoltLog_error(log, "Unknown marker: %d", marker);
+        return BOLT_PROTOCOL_UNEXPECTED_MARKER;
+    }
+}
+
+#define INITIAL_DECODER_STACK_SIZE 8
+
+struct PackStreamFrame {
+    /// The container being populated
+    struct BoltValue* value;
+    /// The type of the container
+    enum PackStreamType type;
+    /// The index of the next child value (keys and values count separately for maps)
+    int32_t index;
+    /// The total number of child values
+    int32_t count;
+    /// Set for long lists until their first element decides whether they are packed
+    int pending;
+};
+
+struct PackStreamDecoder {
+    check_struct_signature_func check_struct_type;
+
+    struct BoltValue* root;
+    int message;
+    int16_t message_code;
+    int done;
+
+    struct PackStreamFrame* stack;
+    int32_t depth;
+    int32_t capacity;
+
+    /// Marker and size (or value) bytes of the value currently being decoded
+    uint8_t header[9];
+    int header_size;
+    int header_needed;
+
+    /// Destination of a string or bytes payload that is still being received
+    char* payload;
+    int32_t payload_size;
+    int32_t payload_offset;
+
+    /// Holds scalar elements of packed lists and fields of packed structures while they are decoded
+    struct BoltValue element;
+
+    /// Identifies the structures whose fields are decoded packed, if any
+    check_struct_signature_func check_packed_struct;
+    /// Whether long lists of scalars are decoded packed
+    int pack_lists;
+
+    /// Identifies the structures whose fields are captured to be decoded lazily, if any
+    check_struct_signature_func check_lazy_struct;
+    /// The structure whose encoded fields are being captured, if any
+    struct BoltValue* capture;
+    /// The number of encoded values of the structure still to capture
+    int64_t capture_values;
+    /// The number of payload bytes of the current string or bytes value still to capture
+    int32_t capture_payload;
+    /// The captured bytes
+    struct BoltBuffer* capture_buffer;
+};
+
+struct PackStreamDecoder* PackStreamDecoder_create(check_struct_signature_func check_struct_type)
+{
+    struct PackStreamDecoder* decoder = BoltMem_allocate(sizeof(struct PackStreamDecoder));
+    memset(decoder, 0, sizeof(struct PackStreamDecoder));
+    decoder->check_struct_type = check_struct_type;
+    decoder->capacity = INITIAL_DECODER_STACK_SIZE;
+    decoder->stack = BoltMem_allocate(decoder->capacity*sizeof(struct PackStreamFrame));
+    return decoder;
+}
+
+void PackStreamDecoder_destroy(struct PackStreamDecoder* decoder)
+{
+    if (decoder==NULL) return;
+
+    if (decoder->capture_buffer!=NULL) {
+        BoltBuffer_destroy(decoder->capture_buffer);
+    }
+    BoltMem_deallocate(decoder->stack, decoder->capacity*sizeof(struct PackStreamFrame));
+    BoltMem_deallocate(decoder, sizeof(struct PackStreamDecoder));
+}
+
+void PackStreamDecoder_reset(struct PackStreamDecoder* decoder, struct BoltValue* value)
+{
+    decoder->root = value;
+    decoder->message = 0;
+    decoder->message_code = -1;
+    decoder->done = 0;
+    decoder->depth = 0;
+    decoder->header_size = 0;
+    decoder->header_needed = 0;
+    decoder->payload = NULL;
+    decoder->payload_size = 0;
+    decoder->payload_offset = 0;
+    decoder->capture = NULL;
+    decoder->capture_values = 0;
+    decoder->capture_payload = 0;
+}
+
+void PackStreamDecoder_set_lazy(struct PackStreamDecoder* decoder, check_struct_signature_func check_lazy_struct)
+{
+    decoder->check_lazy_struct = check_lazy_struct;
+}
+
+void PackStreamDecoder_set_packed(struct PackStreamDecoder* decoder, check_struct_signature_func check_packed_struct)
+{
+    decoder->check_packed_struct = check_packed_struct;
+}
+
+void PackStreamDecoder_set_pack_lists(struct PackStreamDecoder* decoder, int pack_lists)
+{
+    decoder->pack_lists = pack_lists;
+}
+
+void PackStreamDecoder_reset_message(struct PackStreamDecoder* decoder, struct BoltValue* fields)
+{
+    PackStreamDecoder_reset(decoder, fields);
+    decoder->message = 1;
+}
+
+int PackStreamDecoder_done(struct PackStreamDecoder* decoder)
+{
+    return decoder->done;
+}
+
+int16_t PackStreamDecoder_message_code(struct PackStreamDecoder* decoder)
+{
+    return decoder->message_code;
+}
+
+static struct BoltValue* _next_target(struct PackStreamDecoder* decoder, enum PackStreamType type)
+{
+    if (decoder->depth==0) {
+        return decoder->root;
+    }
+    struct PackStreamFrame* frame = &decoder->stack[decoder->depth-1];
+    switch (frame->type) {
+    case PACKSTREAM_MAP:
+        return frame->index%2==0 ? BoltDictionary_key(frame->value, frame->index/2)
+                                 : BoltDictionary_value(frame->value, frame->index/2);
+    case PACKSTREAM_STRUCTURE:
+        if (BoltStructure_is_packed(frame->value) && (type==PACKSTREAM_INTEGER || type==PACKSTREAM_FLOAT)) {
+            return &decoder->element;
+        }
+        // Any other field unpacks the structure
+        return BoltStructure_value(frame->value, frame->index);
+    default:
+        if (frame->pending) {
+            enum BoltType packed = _packed_type(type);
+            if (packed!=BOLT_NULL) {
+                BoltValue_format_as_packed_List(frame->value, packed, frame->count);
+            }
+            else {
+                BoltValue_format_as_List(frame->value, frame->count);
+            }
+            frame->pending = 0;
+        }
+        if (BoltList_packed_type(frame->value)!=BOLT_NULL
+                && BoltList_packed_type(frame->value)==_packed_type(type)) {
+            return &decoder->element;
+        }
+        // Any other element unpacks the list
+        return BoltList_value(frame->value, frame->index);
+    }
+}
+
+static void _value_complete(struct PackStreamDecoder* decoder)
+{
+    while (decoder->depth>0) {
+        struct PackStreamFrame* frame = &decoder->stack[decoder->depth-1];
+        frame->index += 1;
+        if (frame->index<frame->count) {
+            return;
+        }
+        decoder->depth -= 1;
+    }
+    decoder->done = 1;
+}
+
+static void _scalar_complete(struct PackStreamDecoder* decoder, struct BoltValue* value)
+{
+    if (value==&decoder->element) {
+        struct PackStreamFrame* frame = &decoder->stack[decoder->depth-1];
+        if (frame->type!=PACKSTREAM_STRUCTURE) {
+            BoltList_set_packed(frame->value, frame->index, value);
+        }
+        else if (BoltValue_type(value)==BOLT_FLOAT) {
+            BoltStructure_set_float(frame->value, frame->index, BoltFloat_get(value));
+        }
+        else {
+            BoltStructure_set_integer(frame->value, frame->index, BoltInteger_get(value));
+        }
+    }
+    _value_complete(decoder);
+}
+
+static void _push(struct PackStreamDecoder* decoder, struct BoltValue* value, enum PackStreamType type, int32_t count)
+{
+    if (count==0) {
+        _value_complete(decoder);
+        return;
+    }
+    if (decoder->depth==decoder->capacity) {
+        int32_t capacity = decoder->capacity*2;
+        decoder->stack = BoltMem_reallocate(decoder->stack, decoder->capacity*sizeof(struct PackStreamFrame),
+                capacity*sizeof(struct PackStreamFrame));
+        decoder->capacity = capacity;
+    }
+    struct PackStreamFrame* frame = &decoder->stack[decoder->depth];
+    frame->value = value;
+    frame->type = type;
+    frame->index = 0;
+    frame->count = count;
+    frame->pending = 0;
+    decoder->depth += 1;
+}
+
+static void _start_capture(struct PackStreamDecoder* decoder, struct BoltValue* value)
+{
+    if (decoder->capture_buffer==NULL) {
+        decoder->capture_buffer = BoltBuffer_create(1024);
+    }
+    decoder->capture_buffer->cursor = 0;
+    decoder->capture_buffer->extent = 0;
+    decoder->capture = value;
+    decoder->capture_values = value->size;
+    decoder->capture_payload = 0;
+}
+
+static void _capture_complete(struct PackStreamDecoder* decoder)
+{
+    struct BoltValue* value = decoder->capture;
+    BoltStructure_set_lazy(value, BoltLazyFields_create(decoder->check_struct_type, decoder->check_lazy_struct,
+            decoder->check_packed_struct, decoder->pack_lists, value->size, decoder->capture_buffer->data,
+            decoder->capture_buffer->extent));
+    decoder->capture = NULL;
+    _value_complete(decoder);
+}
+
+static int _capture_header(struct PackStreamDecoder* decoder)
+{
+    int64_t values;
+    int32_t payload;
+    TRY(_encoded_extent(decoder->check_struct_type, decoder->header, decoder->header_size, &values, &payload));
+    LOAD(BoltBuffer_load(decoder->capture_buffer, (const char*) decoder->header, decoder->header_size));
+    decoder->capture_values += values-1;
+    decoder->capture_payload = payload;
+    if (decoder->capture_values==0 && decoder->capture_payload==0) {
+        _capture_complete(decoder);
+    }
+    return BOLT_SUCCESS;
+}
+
+static int _decode_header(struct PackStreamDecoder* decoder, const struct BoltLog* log)
+{
+    const uint8_t* header = decoder->header;
+    const int header_size = decoder->header_size;
+    const uint8_t marker = header[0];
+    enum PackStreamType type = marker_type(marker);
+    struct BoltValue* value = _next_target(decoder, type);
+
+    if (decoder->message && decoder->depth==0) {
+        // The message structure itself is unpacked into a list of fields
+        if (marker<0xB0 || marker>0xBF) {
+            return BOLT_PROTOCOL_VIOLATION;
+        }
+        decoder->message_code = header[1];
+        BoltValue_format_as_List(value, marker & 0x0F);
+        _push(decoder, value, PACKSTREAM_LIST, marker & 0x0F);
+        return BOLT_SUCCESS;
+    }
+
+    int32_t size;
+    switch (type) {
+    case PACKSTREAM_NULL:
+        BoltValue_format_as_Null(value);
+        _value_complete(decoder);
+        return BOLT_SUCCESS;
+    case PACKSTREAM_BOOLEAN:
+        BoltValue_format_as_Boolean(value, marker==0xC3);
+        _scalar_complete(decoder, value);
+        return BOLT_SUCCESS;
+    case PACKSTREAM_INTEGER:
+        if (header_size==1) {
+            BoltValue_format_as_Integer(value, marker<0x80 ? marker : marker-0x100);
+        }
+        else {
+            uint64_t x = _header_uint(header, header_size);
+            int shift = 64-8*(header_size-1);
+            // sign-extend the big-endian value to 64 bits
+            BoltValue_format_as_Integer(value, shift==0 ? (int64_t) x : ((int64_t) (x << shift)) >> shift);
+        }
+        _scalar_complete(decoder, value);
+        return BOLT_SUCCESS;
+    case PACKSTREAM_FLOAT: {
+        uint64_t x = _header_uint(header, header_size);
+        double d;
+        memcpy(&d, &x, sizeof(d));
+        BoltValue_format_as_Float(value, d);
+        _scalar_complete(decoder, value);
+        return BOLT_SUCCESS;
+    }
+    case PACKSTREAM_STRING:
+    case PACKSTREAM_BYTES:
+        size = _header_length(header, header_size);
+        if (size<0) {
+            return BOLT_PROTOCOL_VIOLATION;
+        }
+        if (type==PACKSTREAM_STRING) {
+            BoltValue_format_as_String(value, NULL, size);
+            decoder->payload = BoltString_get(value);
+        }
+        else {
+            BoltValue_format_as_Bytes(value, NULL, size);
+            decoder->payload = BoltBytes_get_all(value);
+        }
+        decoder->payload_size = size;
+        decoder->payload_offset = 0;
+        if (size==0) {
+            decoder->payload = NULL;
+            _value_complete(decoder);
+        }
+        return BOLT_SUCCESS;
+    case PACKSTREAM_LIST:
+        size = _header_length(header, header_size);
+        if (size<0) {
+            return BOLT_PROTOCOL_VIOLATION;
+        }
+        if (decoder->pack_lists && size>=PACKED_LIST_MIN_SIZE) {
+            // Formatted once the first element shows whether the list can be packed
+            _push(decoder, value, PACKSTREAM_LIST, size);
+            decoder->stack[decoder->depth-1].pending = 1;
+            return BOLT_SUCCESS;
+        }
+        BoltValue_format_as_List(value, size);
+        _push(decoder, value, PACKSTREAM_LIST, size);
+        return BOLT_SUCCESS;
+    case PACKSTREAM_MAP:
+        size = _header_length(header, header_size);
+        if (size<0 || size>INT32_MAX/2) {
+            return BOLT_PROTOCOL_VIOLATION;
+        }
+        BoltValue_format_as_Dictionary(value, size);
+        _push(decoder, value, PACKSTREAM_MAP, 2*size);
+        return BOLT_SUCCESS;
+    case PACKSTREAM_STRUCTURE: {
+        if (marker<0xB0 || marker>0xBF) {
+            return BOLT_PROTOCOL_UNEXPECTED_MARKER;
+        }
+        int8_t code = (int8_t) header[1];
+        if (!decoder->check_struct_type(code)) {
+            return BOLT_PROTOCOL_UNEXPECTED_MARKER;
+        }
+        size = marker & 0x0F;
+        if (size<=BOLT_PACKED_STRUCTURE_MAX_SIZE && decoder->check_packed_struct!=NULL
+                && decoder->check_packed_struct(code)) {
+            BoltValue_format_as_packed_Structure(value, code, size);
+            _push(decoder, value, PACKSTREAM_STRUCTURE, size);
+            return BOLT_SUCCESS;
+        }
+        BoltValue_format_as_Structure(value, code, size);
+        if (size>0 && decoder->check_lazy_struct!=NULL && decoder->check_lazy_struct(code)) {
+            // Only the encoded fields are kept, to be decoded when first accessed
+            _start_capture(decoder, value);
+            return BOLT_SUCCESS;
+        }
+        _push(decoder, value, PACKSTREAM_STRUCTURE, size);
+        return BOLT_SUCCESS;
+    }
     default:
         BoltLog_error(log, "Unknown marker: %d", marker);
         return BOLT_PROTOCOL_UNEXPECTED_MARKER;
     }
 }
+
+int PackStreamDecoder_feed(struct PackStreamDecoder* decoder, struct BoltBuffer* buffer, const struct BoltLog* log)
+{
+    while (!decoder->done) {
+        int available = BoltBuffer_unloadable(buffer);
+
+        if (decoder->payload!=NULL) {
+            int32_t remaining = decoder->payload_size-decoder->payload_offset;
+            int32_t n = available<remaining ? available : remaining;
+            if (n==0) {
+                return BOLT_SUCCESS;
+            }
+            BoltBuffer_unload(buffer, decoder->payload+decoder->payload_offset, n);
+            decoder->payload_offset += n;
+            if (decoder->payload_offset<decoder->payload_size) {
+                return BOLT_SUCCESS;
+            }
+            decoder->payload = NULL;
+            _value_complete(decoder);
+            continue;
+        }
+
+        if (decoder->capture_payload>0) {
+            int32_t n = available<decoder->capture_payload ? available : decoder->capture_payload;
+            if (n==0) {
+                return BOLT_SUCCESS;
+            }
+            char* target = BoltBuffer_load_pointer(decoder->capture_buffer, n);
+            if (target==NULL) {
+                return BOLT_OUT_OF_MEMORY;
+            }
+            BoltBuffer_unload(buffer, target, n);
+            decoder->capture_payload -= n;
+            if (decoder->capture_payload==0 && decoder->capture_values==0) {
+                _capture_complete(decoder);
+            }
+            continue;
+        }
+
+        if (available==0) {
+            return BOLT_SUCCESS;
+        }
+        if (decoder->header_size==0) {
+            BoltBuffer_unload_u8(buffer, &decoder->header[0]);
+            decoder->header_size = 1;
+            decoder->header_needed = _header_size(decoder->header[0]);
+            available -= 1;
+        }
+        int n = decoder->header_needed-decoder->header_size;
+        if (n>available) {
+            n = available;
+        }
+        BoltBuffer_unload(buffer, (char*) (decoder->header+decoder->header_size), n);
+        decoder->header_size += n;
+        if (decoder->header_size<decoder->header_needed) {
+            return BOLT_SUCCESS;
+        }
+        TRY(decoder->capture!=NULL ? _capture_header(decoder) : _decode_header(decoder, log));
+        decoder->header_size = 0;
+        decoder->header_needed = 0;
+    }
+    return BOLT_SUCCESS;
+}
@@ -40,14 +40,163 @@ enum PackStreamType {
 
 typedef int (* check_struct_signature_func)(int16_t);
 
+typedef int (* flush_func)(void* context, struct BoltBuffer* buffer);
+
+/**
+ * Destination for the encoded bytes of a value that is too large to be buffered in full. Whenever
+ * _threshold_ bytes are waiting in the buffer, _flush_ is called to consume (some of) them.
+ */
+struct PackStreamSink {
+    flush_func flush;
+    void* context;
+    int32_t threshold;
+};
+
 enum PackStreamType marker_type(uint8_t marker);
 
+int load_null(struct BoltBuffer* buffer);
+
+int load_boolean(struct BoltBuffer* buffer, int value);
+
+int load_integer(struct BoltBuffer* buffer, int64_t value);
+
+int load_float(struct BoltBuffer* buffer, double value);
+
+int load_bytes_header(struct BoltBuffer* buffer, int32_t size);
+
+int load_bytes(struct BoltBuffer* buffer, const char* string, int32_t size);
+
+int load_string_header(struct BoltBuffer* buffer, int32_t size);
+
+int load_string(struct BoltBuffer* buffer, const char* string, int32_t size);
+
+int load_list_header(struct BoltBuffer* buffer, int32_t size);
+
+int load_map_header(struct BoltBuffer* buffer, int32_t size);
+
 int load_structure_header(struct BoltBuffer* buffer, int16_t code, int8_t size);
 
 int load(check_struct_signature_func check_struct_type, struct BoltBuffer* buffer, struct BoltValue* value,
         const struct BoltLog* log);
 
+/**
+ * Copies _size_ bytes of _data_ into _buffer_, handing them over to _sink_ at most a threshold worth at a time.
+ * A NULL _sink_ copies all of _data_ at once.
+ */
+int load_payload(struct BoltBuffer* buffer, const char* data, int32_t size, const struct PackStreamSink* sink);
+
+/**
+ * Same as \ref load, but hands encoded data over to _sink_ while encoding, so that buffer usage stays
+ * bounded regardless of the size of _value_. A NULL _sink_ is equivalent to calling \ref load.
+ */
+int load_streaming(check_struct_signature_func check_struct_type, struct BoltBuffer* buffer, struct BoltValue* value,
+        const struct PackStreamSink* sink, const struct BoltLog* log);
+
 int unload(check_struct_signature_func check_struct_type, struct BoltBuffer* buffer, struct BoltValue* value,
         const struct BoltLog* log);
 
+/**
+ * Same as \ref unload, but structures accepted by _check_lazy_struct_ only keep a copy of their encoded fields,
+ * which are decoded when first accessed through \ref BoltStructure_value, and structures accepted by
+ * _check_packed_struct_ are decoded as packed structures, see \ref BoltValue_format_as_packed_Structure. Long
+ * lists of scalars are decoded as packed lists if _pack_lists_ is set, see \ref BoltValue_format_as_packed_List.
+ * NULL predicates and a zero _pack_lists_ are equivalent to calling \ref unload.
+ */
+int unload_lazy(check_struct_signature_func check_struct_type, check_struct_signature_func check_lazy_struct,
+        check_struct_signature_func check_packed_struct, int pack_lists, struct BoltBuffer* buffer,
+        struct BoltValue* value, const struct BoltLog* log);
+
+/**
+ * Checks that _data_ holds exactly one complete encoded value, whose structures are all accepted by
+ * _check_struct_type_, without decoding it.
+ *
+ * @returns BOLT_SUCCESS, BOLT_PROTOCOL_UNEXPECTED_MARKER for an unknown marker or structure, or
+ * BOLT_PROTOCOL_VIOLATION if the value is incomplete or followed by other data.
+ */
+int check_encoded(check_struct_signature_func check_struct_type, const char* data, int32_t size);
+
+/**
+ * The encoded fields of a lazily decoded structure, along with the progress of decoding them.
+ */
+struct BoltLazyFields;
+
+struct BoltLazyFields* BoltLazyFields_create(check_struct_signature_func check_struct_type,
+        check_struct_signature_func check_lazy_struct, check_struct_signature_func check_packed_struct, int pack_lists,
+        int32_t count, const char* bytes, int32_t size);
+
+struct BoltLazyFields* BoltLazyFields_duplicate(const struct BoltLazyFields* lazy);
+
+void BoltLazyFields_destroy(struct BoltLazyFields* lazy);
+
+/**
+ * @returns the number of leading fields decoded so far.
+ */
+int32_t BoltLazyFields_decoded(const struct BoltLazyFields* lazy);
+
+/**
+ * Decodes the fields into _fields_ until the first _count_ of them are decoded.
+ *
+ * @returns the number of leading fields decoded so far.
+ */
+int32_t BoltLazyFields_decode(struct BoltLazyFields* lazy, struct BoltValue* fields, int32_t count);
+
+/**
+ * Resumable PackStream decoder.
+ *
+ * Unlike \ref unload, which requires the whole value to be present in the buffer and recurses on the C stack,
+ * the decoder keeps an explicit stack of partially populated containers and can be fed a value in arbitrary
+ * slices as they arrive from the network. String and byte payloads are copied straight into the target
+ * \ref BoltValue, so the caller only needs to buffer the slice currently being fed.
+ */
+struct PackStreamDecoder;
+
+struct PackStreamDecoder* PackStreamDecoder_create(check_struct_signature_func check_struct_type);
+
+void PackStreamDecoder_destroy(struct PackStreamDecoder* decoder);
+
+/**
+ * Prepares the decoder to decode a single value into _value_.
+ */
+void PackStreamDecoder_reset(struct PackStreamDecoder* decoder, struct BoltValue* value);
+
+/**
+ * Prepares the decoder to decode a Bolt message. The message signature is made available through
+ * \ref PackStreamDecoder_message_code and its fields are decoded into _fields_, which is formatted as a list.
+ */
+void PackStreamDecoder_reset_message(struct PackStreamDecoder* decoder, struct BoltValue* fields);
+
+/**
+ * Makes the decoder decode the structures accepted by _check_lazy_struct_ lazily, see \ref unload_lazy. Their
+ * encoded fields are still checked as they are received. A NULL _check_lazy_struct_ decodes all values eagerly.
+ */
+void PackStreamDecoder_set_lazy(struct PackStreamDecoder* decoder, check_struct_signature_func check_lazy_struct);
+
+/**
+ * Makes the decoder decode the structures accepted by _check_packed_struct_ as packed structures, see
+ * \ref BoltValue_format_as_packed_Structure. A NULL _check_packed_struct_ decodes all structures as ordinary ones.
+ */
+void PackStreamDecoder_set_packed(struct PackStreamDecoder* decoder, check_struct_signature_func check_packed_struct);
+
+/**
+ * Makes the decoder decode long lists of scalars as packed lists if _pack_lists_ is set, see
+ * \ref BoltValue_format_as_packed_List. Lists are decoded as ordinary ones by default.
+ */
+void PackStreamDecoder_set_pack_lists(struct PackStreamDecoder* decoder, int pack_lists);
+
+/**
+ * Consumes as much of the unloadable data in _buffer_ as possible. Data following a completely decoded value is
+ * left in the buffer.
+ *
+ * @returns BOLT_SUCCESS, or an error code if the data is not valid PackStream.
+ */
+int PackStreamDecoder_feed(struct PackStreamDecoder* decoder, struct BoltBuffer* buffer,
+        const struct BoltLog* log);
+
+/**
+ * @returns 1 once the value (or message) has been completely decoded, 0 otherwise.
+ */
+int PackStreamDecoder_done(struct PackStreamDecoder* decoder);
+
+int16_t PackStreamDecoder_message_code(struct PackStreamDecoder* decoder);
+
 #endif //SEABOLT_ALL_PACKSTREAM_H
@@ -17,12 +17,16 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_PROTOCOL
+
+#include <limits.h>
+
 #include "bolt-private.h"
 #include "mem.h"
 #include "protocol.h"
+#include "statement-private.h"
 #include "values-private.h"
-
-#define BOLT_MAX_CHUNK_SIZE 65535
+#include "writer-private.h"
 
 #define TRY(code) { int status_try = (code); if (status_try != BOLT_SUCCESS) { return status_try; } }
 
@@ -33,11 +37,14 @@ struct BoltMessage* BoltMessage_create(int8_t code, int32_t n_fields)
     message->code = code;
     message->fields = BoltValue_create();
     BoltValue_format_as_List(message->fields, n_fields);
+    message->encoded_fields = BoltMem_allocate(n_fields*sizeof(struct BoltEncodedField));
+    memset(message->encoded_fields, 0, n_fields*sizeof(struct BoltEncodedField));
     return message;
 }
 
 void BoltMessage_destroy(struct BoltMessage* message)
 {
+    BoltMem_deallocate(message->encoded_fields, message->fields->size*sizeof(struct BoltEncodedField));
     BoltValue_destroy(message->fields);
     BoltMem_deallocate(message, sizeof(struct BoltMessage));
 }
@@ -51,23 +58,107 @@ struct BoltValue* BoltMessage_param(struct BoltMessage* message, int32_t index)
     return BoltList_value(message->fields, index);
 }
 
+void BoltMessage_set_encoded_param(struct BoltMessage* message, int32_t index, const char* data, int32_t size)
+{
+    if (index<message->fields->size) {
+        message->encoded_fields[index].data = data;
+        message->encoded_fields[index].size = data!=NULL ? size : 0;
+    }
+}
+
+struct BoltValue* BoltMessage_decode_fields(struct BoltMessage* message, check_struct_signature_func check_struct_type,
+        const struct BoltLog* log)
+{
+    struct BoltValue* fields = NULL;
+    for (int32_t i = 0; i<message->fields->size; i++) {
+        const struct BoltEncodedField* encoded = &message->encoded_fields[i];
+        if (encoded->data==NULL) {
+            continue;
+        }
+        if (fields==NULL) {
+            fields = BoltValue_duplicate(message->fields);
+        }
+        struct BoltBuffer* buffer = BoltBuffer_create(encoded->size);
+        BoltBuffer_load(buffer, encoded->data, encoded->size);
+        if (unload(check_struct_type, buffer, BoltList_value(fields, i), log)!=BOLT_SUCCESS) {
+            BoltValue_format_as_Null(BoltList_value(fields, i));
+        }
+        BoltBuffer_destroy(buffer);
+    }
+    return fields;
+}
+
 int write_message(struct BoltMessage* message, check_struct_signature_func check_writable_struct,
-        struct BoltBuffer* buffer, const struct BoltLog* log)
+        struct BoltBuffer* buffer, const struct PackStreamSink* sink, const struct BoltLog* log)
 {
     if (check_writable_struct(message->code)) {
         TRY(load_structure_header(buffer, message->code, (int8_t) (message->fields->size)));
         for (int32_t i = 0; i<message->fields->size; i++) {
-            TRY(load(check_writable_struct, buffer, BoltList_value(message->fields, i), log));
+            const struct BoltEncodedField* encoded = &message->encoded_fields[i];
+            if (encoded->data!=NULL) {
+                TRY(load_payload(buffer, encoded->data, encoded->size, sink));
+                continue;
+            }
+            TRY(load_streaming(check_writable_struct, buffer, BoltList_value(message->fields, i), sink, log));
         }
         return BOLT_SUCCESS;
     }
     return BOLT_PROTOCOL_UNSUPPORTED_TYPE;
 }
 
-void push_to_transmission(struct BoltBuffer* msg_buffer, struct BoltBuffer* tx_buffer)
+void BoltRunEncoding_clear(struct BoltRunEncoding* encoding)
+{
+    encoding->statement = NULL;
+    encoding->parameters_written = 0;
+    encoding->parameters = NULL;
+    encoding->parameters_size = 0;
+}
+
+int BoltRunEncoding_set_parameters(struct BoltRunEncoding* encoding, check_struct_signature_func check_writable_struct,
+        const char* data, int32_t size)
+{
+    if (data==NULL || size<=0 || marker_type((uint8_t) data[0])!=PACKSTREAM_MAP) {
+        return BOLT_PROTOCOL_VIOLATION;
+    }
+    // Written by any writer, so only structures the protocol can send are let through
+    TRY(check_encoded(check_writable_struct, data, size));
+    encoding->parameters_written = 0;
+    encoding->parameters = data;
+    encoding->parameters_size = size;
+    return BOLT_SUCCESS;
+}
+
+int BoltRunEncoding_apply(const struct BoltRunEncoding* encoding, struct BoltMessage* run)
+{
+    if (encoding->statement!=NULL) {
+        BoltMessage_set_encoded_param(run, 0, encoding->statement->encoded, encoding->statement->encoded_size);
+    }
+    else {
+        BoltMessage_set_encoded_param(run, 0, NULL, 0);
+    }
+
+    if (encoding->parameters_written) {
+        const struct BoltWriter* writer = encoding->writer;
+        if (!BoltWriter_complete(writer) || marker_type((uint8_t) BoltWriter_data(writer)[0])!=PACKSTREAM_MAP) {
+            return BOLT_PROTOCOL_VIOLATION;
+        }
+        BoltMessage_set_encoded_param(run, 1, BoltWriter_data(writer), BoltWriter_size(writer));
+    }
+    else {
+        BoltMessage_set_encoded_param(run, 1, encoding->parameters, encoding->parameters_size);
+    }
+    return BOLT_SUCCESS;
+}
+
+int push_to_transmission(struct BoltBuffer* msg_buffer, struct BoltBuffer* tx_buffer)
 {
     // loop through data, generate several chunks if it's larger than max chunk size
     int total_size = BoltBuffer_unloadable(msg_buffer);
+    // every chunk has a 2 byte header, and the message ends with an empty chunk
+    int64_t chunks = ((int64_t) total_size+BOLT_MAX_CHUNK_SIZE-1)/BOLT_MAX_CHUNK_SIZE;
+    if ((int64_t) tx_buffer->extent+total_size+2*chunks+2>INT_MAX) {
+        return BOLT_OUT_OF_MEMORY;
+    }
     int total_remaining = total_size;
     char header[2];
     while (total_remaining>0) {
@@ -83,5 +174,23 @@ void push_to_transmission(struct BoltBuffer* msg_buffer, struct BoltBuffer* tx_b
     header[1] = (char) (0);
     BoltBuffer_load(tx_buffer, &header[0], sizeof(header));
     BoltBuffer_compact(msg_buffer);
+    return BOLT_SUCCESS;
+}
+
+int push_chunks_to_transmission(struct BoltBuffer* msg_buffer, struct BoltBuffer* tx_buffer)
+{
+    int64_t chunks = BoltBuffer_unloadable(msg_buffer)/BOLT_MAX_CHUNK_SIZE;
+    if ((int64_t) tx_buffer->extent+chunks*(BOLT_MAX_CHUNK_SIZE+2)>INT_MAX) {
+        return BOLT_OUT_OF_MEMORY;
+    }
+    char header[2];
+    header[0] = (char) (BOLT_MAX_CHUNK_SIZE >> 8);
+    header[1] = (char) (BOLT_MAX_CHUNK_SIZE);
+    while (BoltBuffer_unloadable(msg_buffer)>=BOLT_MAX_CHUNK_SIZE) {
+        BoltBuffer_load(tx_buffer, &header[0], sizeof(header));
+        BoltBuffer_load(tx_buffer, BoltBuffer_unload_pointer(msg_buffer, BOLT_MAX_CHUNK_SIZE), BOLT_MAX_CHUNK_SIZE);
+    }
+    BoltBuffer_compact(msg_buffer);
+    return BOLT_SUCCESS;
 }
 
@@ -27,10 +27,16 @@
 #define FETCH_SUMMARY 0
 #define FETCH_RECORD 1
 
+#define BOLT_MAX_CHUNK_SIZE 65535
+
 struct BoltProtocol;
 
 struct BoltConnection;
 
+struct BoltWriter;
+
+struct BoltStatement;
+
 typedef int (* bool_func)(struct BoltConnection*);
 
 typedef struct BoltValue* (* bolt_value_func)(struct BoltConnection*);
@@ -83,6 +89,14 @@ typedef BoltRequest (* last_request_func)(struct BoltConnection*);
 
 typedef int (* fetch_func)(struct BoltConnection*, BoltRequest);
 
+typedef struct BoltWriter* (* writer_func)(struct BoltConnection*);
+
+typedef int (* set_run_statement_func)(struct BoltConnection*, const struct BoltStatement*, int32_t);
+
+typedef int (* set_run_encoded_parameters_func)(struct BoltConnection*, const char*, int32_t);
+
+typedef void (* shrink_buffers_func)(struct BoltConnection*);
+
 struct BoltProtocol {
     void* proto_state;
 
@@ -91,6 +105,10 @@ struct BoltProtocol {
 
     check_struct_signature_func check_readable_struct;
     check_struct_signature_func check_writable_struct;
+    /// Identifies the structures that are decoded lazily if the connection asks for it
+    check_struct_signature_func check_lazy_struct;
+    /// Identifies the structures that are decoded packed, if any
+    check_struct_signature_func check_packed_struct;
 
     init_func init;
     goodbye_func goodbye;
@@ -111,6 +129,10 @@ struct BoltProtocol {
     set_run_tx_metadata_func set_run_tx_metadata;
     set_run_cypher_func set_run_cypher;
     set_run_cypher_parameter_func set_run_cypher_parameter;
+    writer_func run_parameter_writer;
+    set_run_statement_func set_run_statement;
+    set_run_encoded_parameters_func set_run_encoded_parameters;
+    shrink_buffers_func shrink_buffers;
     load_run_func load_run;
 
     load_discard_func load_discard;
@@ -137,9 +159,16 @@ struct BoltProtocol {
     fetch_func fetch;
 };
 
+struct BoltEncodedField {
+    const char* data;
+    int32_t size;
+};
+
 struct BoltMessage {
     int8_t code;
     struct BoltValue* fields;
+    /// Already encoded PackStream data that is sent instead of the corresponding field, if data is not NULL
+    struct BoltEncodedField* encoded_fields;
 };
 
 struct BoltMessage* BoltMessage_create(int8_t code, int32_t n_fields);
@@ -148,10 +177,79 @@ void BoltMessage_destroy(struct BoltMessage* message);
 
 struct BoltValue* BoltMessage_param(struct BoltMessage* message, int32_t index);
 
+/**
+ * Makes \ref write_message copy _size_ bytes of already PackStream encoded _data_ in place of the field at _index_.
+ * The data is referenced, not copied, so it has to stay valid until the message is written. Passing NULL _data_
+ * reverts to encoding the field value.
+ */
+void BoltMessage_set_encoded_param(struct BoltMessage* message, int32_t index, const char* data, int32_t size);
+
+/**
+ * Decodes the fields set through \ref BoltMessage_set_encoded_param, for logging what is actually sent.
+ *
+ * @returns a copy of the message fields with the encoded ones decoded, to be destroyed by the caller, or NULL if
+ * no field is encoded.
+ */
+struct BoltValue* BoltMessage_decode_fields(struct BoltMessage* message, check_struct_signature_func check_struct_type,
+        const struct BoltLog* log);
+
+/**
+ * Encodes _message_ into _buffer_. If _sink_ is not NULL, it is handed the partially encoded message whenever a
+ * full chunk is available (see \ref load_streaming).
+ */
 int
 write_message(struct BoltMessage* message, check_struct_signature_func check_writable, struct BoltBuffer* buffer,
-        const struct BoltLog* log);
+        const struct PackStreamSink* sink, const struct BoltLog* log);
 
-void push_to_transmission(struct BoltBuffer* msg_buffer, struct BoltBuffer* tx_buffer);
+/**
+ * Already encoded parts of a RUN message, which take precedence over the statement and parameter field values.
+ */
+struct BoltRunEncoding {
+    /// The registered statement to send, if not NULL
+    const struct BoltStatement* statement;
+    /// Writer for the parameters, owned by the protocol state
+    struct BoltWriter* writer;
+    /// Whether the parameters are taken from the writer
+    int parameters_written;
+    /// Caller supplied encoded parameters to send, if not NULL
+    const char* parameters;
+    int32_t parameters_size;
+};
+
+/**
+ * Reverts to sending the statement and parameter field values.
+ */
+void BoltRunEncoding_clear(struct BoltRunEncoding* encoding);
+
+/**
+ * Sends the PackStream encoded map in _data_ as the parameters of the next RUN, in place of the parameter dictionary.
+ *
+ * @returns BOLT_SUCCESS, BOLT_PROTOCOL_VIOLATION if _data_ is not one complete map, or
+ * BOLT_PROTOCOL_UNEXPECTED_MARKER if it holds a structure not accepted by _check_writable_struct_.
+ */
+int BoltRunEncoding_set_parameters(struct BoltRunEncoding* encoding, check_struct_signature_func check_writable_struct,
+        const char* data, int32_t size);
+
+/**
+ * Applies _encoding_ to the statement (0) and parameter (1) fields of the _run_ message.
+ *
+ * @returns BOLT_SUCCESS, or BOLT_PROTOCOL_VIOLATION if the written parameters are not one complete map.
+ */
+int BoltRunEncoding_apply(const struct BoltRunEncoding* encoding, struct BoltMessage* run);
+
+/**
+ * Moves all of _msg_buffer_ into _tx_buffer_ as chunks, followed by the end of message marker.
+ *
+ * @returns BOLT_SUCCESS, or BOLT_OUT_OF_MEMORY (moving nothing) if _tx_buffer_ cannot hold the chunks.
+ */
+int push_to_transmission(struct BoltBuffer* msg_buffer, struct BoltBuffer* tx_buffer);
+
+/**
+ * Moves only the full-sized chunks of a partially encoded message into _tx_buffer_, leaving the remainder in
+ * _msg_buffer_.
+ *
+ * @returns BOLT_SUCCESS, or BOLT_OUT_OF_MEMORY (moving nothing) if _tx_buffer_ cannot hold the chunks.
+ */
+int push_chunks_to_transmission(struct BoltBuffer* msg_buffer, struct BoltBuffer* tx_buffer);
 
 #endif //SEABOLT_ALL_PROTOCOL_H
@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_ROUTING
+
 #include "bolt-private.h"
 #include "address-private.h"
 #include "address-resolver-private.h"
@@ -28,6 +30,7 @@
 #include "mem.h"
 #include "routing-pool.h"
 #include "routing-table.h"
+#include "time.h"
 #include "values-private.h"
 
 int
@@ -76,6 +79,11 @@ int BoltRoutingPool_update_routing_table_from(struct BoltRoutingPool* pool, stru
 
     // Open a new connection
     if (status==BOLT_SUCCESS) {
+        connection->capture_directory = pool->config->wire_capture_directory;
+        connection->lazy_decoding = pool->config->lazy_decoding;
+        connection->packed_lists = pool->config->packed_lists;
+        connection->packed_structures = pool->config->packed_structures;
+        connection->buffer_pool = pool->config->buffer_pool;
         status = BoltConnection_open(connection, pool->config->transport, server, pool->config->trust,
                 pool->config->log, pool->config->socket_options);
     }
@@ -191,6 +199,35 @@ int BoltRoutingPool_update_routing_table(struct BoltRoutingPool* pool)
     return result;
 }
 
+// Should be called with breakers_mutex held
+BoltCircuitBreaker* BoltRoutingPool_find_breaker(struct BoltRoutingPool* pool, const struct BoltAddress* server,
+        int create_breaker)
+{
+    int index = BoltAddressSet_index_of(pool->breaker_servers, server);
+    if (index<0 && create_breaker) {
+        index = BoltAddressSet_add(pool->breaker_servers, server);
+        pool->breakers = BoltMem_reallocate(pool->breakers, (pool->breaker_servers->size-1)*SIZE_OF_CIRCUIT_BREAKER,
+                pool->breaker_servers->size*SIZE_OF_CIRCUIT_BREAKER);
+        BoltCircuitBreaker_init(&pool->breakers[index]);
+        BoltAtomic_increment(&pool->breaker_count);
+    }
+    return index<0 ? NULL : &pool->breakers[index];
+}
+
+// Should be called with breakers_mutex held
+void BoltRoutingPool_remove_breaker(struct BoltRoutingPool* pool, const struct BoltAddress* server)
+{
+    int old_size = pool->breaker_servers->size;
+    int index = BoltAddressSet_remove(pool->breaker_servers, server);
+    if (index<0) {
+        return;
+    }
+    memmove(&pool->breakers[index], &pool->breakers[index+1], (old_size-index-1)*SIZE_OF_CIRCUIT_BREAKER);
+    pool->breakers = BoltMem_adjust(pool->breakers, old_size*SIZE_OF_CIRCUIT_BREAKER,
+            (old_size-1)*SIZE_OF_CIRCUIT_BREAKER);
+    BoltAtomic_decrement(&pool->breaker_count);
+}
+
 void BoltRoutingPool_cleanup(struct BoltRoutingPool* pool)
 {
     BoltLog_debug(pool->config->log, "[routing]: starting pool cleanup");
@@ -235,6 +272,8 @@ void BoltRoutingPool_cleanup(struct BoltRoutingPool* pool)
                 BoltDirectPool* old_pool = (BoltDirectPool*) old_server_pools[i];
                 BoltLog_debug(pool->config->log, "[routing]: cleaning up pool towards %s:%s", old_pool->address->host,
                         old_pool->address->port);
+                BoltDirectPool_connection_metrics(old_pool, pool->metrics);
+                BoltDirectPool_pool_metrics(old_pool, pool->pool_metrics);
                 BoltDirectPool_destroy(old_pool);
             }
         }
@@ -244,6 +283,17 @@ void BoltRoutingPool_cleanup(struct BoltRoutingPool* pool)
     }
 
     BoltMem_deallocate(cleanup_marker, old_size*sizeof(int));
+
+    // breakers of servers that left the routing table would otherwise be kept forever
+    BoltSync_mutex_lock(&pool->breakers_mutex);
+    for (int i = pool->breaker_servers->size-1; i>=0; i--) {
+        const BoltAddress* server = (const BoltAddress*) pool->breaker_servers->elements[i];
+        if (BoltAddressSet_index_of(active_servers, server)<0) {
+            BoltRoutingPool_remove_breaker(pool, server);
+        }
+    }
+    BoltSync_mutex_unlock(&pool->breakers_mutex);
+
     BoltAddressSet_destroy(active_servers);
     BoltLog_debug(pool->config->log, "[routing]: clean up complete (%d direct pools removed)", cleanup_count);
 }
@@ -266,6 +316,7 @@ int BoltRoutingPool_ensure_routing_table(struct BoltRoutingPool* pool, BoltAcces
                 BoltLog_debug(pool->config->log, "[routing]: routing table is expired, starting refresh");
 
                 status = BoltRoutingPool_update_routing_table(pool);
+                BoltAtomic_increment(&pool->refreshes);
                 if (status==BOLT_SUCCESS) {
                     BoltLog_debug(pool->config->log,
                             "[routing]: routing table is updated, calling cleanup on server pools");
@@ -275,6 +326,7 @@ int BoltRoutingPool_ensure_routing_table(struct BoltRoutingPool* pool, BoltAcces
                     BoltLog_debug(pool->config->log, "[routing]: server pools cleanup completed");
                 }
                 else {
+                    BoltAtomic_increment(&pool->refresh_failures);
                     BoltLog_debug(pool->config->log, "[routing]: routing table update failed with code %d", status);
                 }
             }
@@ -291,6 +343,108 @@ int BoltRoutingPool_ensure_routing_table(struct BoltRoutingPool* pool, BoltAcces
     return status;
 }
 
+int BoltRoutingPool_is_breaker_failure(int code)
+{
+    switch (code) {
+    case BOLT_INTERRUPTED:
+    case BOLT_CONNECTION_RESET:
+    case BOLT_NO_VALID_ADDRESS:
+    case BOLT_TIMED_OUT:
+    case BOLT_CONNECTION_REFUSED:
+    case BOLT_NETWORK_UNREACHABLE:
+    case BOLT_TLS_ERROR:
+    case BOLT_END_OF_TRANSMISSION:
+    case BOLT_ADDRESS_NOT_RESOLVED:
+    case BOLT_PROTOCOL_VIOLATION:
+    case BOLT_PROTOCOL_UNSUPPORTED_TYPE:
+    case BOLT_PROTOCOL_NOT_IMPLEMENTED_TYPE:
+    case BOLT_PROTOCOL_UNEXPECTED_MARKER:
+    case BOLT_PROTOCOL_UNSUPPORTED:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+int BoltRoutingPool_is_server_available(struct BoltRoutingPool* pool, const struct BoltAddress* server)
+{
+    if (pool->config->circuit_breaker_threshold<=0 || BoltAtomic_add(&pool->breaker_count, 0)==0) {
+        return 1;
+    }
+
+    BoltSync_mutex_lock(&pool->breakers_mutex);
+    BoltCircuitBreaker* breaker = BoltRoutingPool_find_breaker(pool, server, 0);
+    int available = breaker==NULL
+            || BoltCircuitBreaker_is_available(breaker, pool->config->circuit_breaker_reset_time,
+                    BoltTime_get_time_ms());
+    BoltSync_mutex_unlock(&pool->breakers_mutex);
+
+    return available;
+}
+
+int BoltRoutingPool_permit_server(struct BoltRoutingPool* pool, const struct BoltAddress* server)
+{
+    if (pool->config->circuit_breaker_threshold<=0 || BoltAtomic_add(&pool->breaker_count, 0)==0) {
+        return BOLT_SUCCESS;
+    }
+
+    int status = BOLT_SUCCESS;
+    BoltSync_mutex_lock(&pool->breakers_mutex);
+    BoltCircuitBreaker* breaker = BoltRoutingPool_find_breaker(pool, server, 0);
+    if (breaker!=NULL) {
+        int previous_state = breaker->state;
+        status = BoltCircuitBreaker_permit(breaker, pool->config->circuit_breaker_reset_time,
+                BoltTime_get_time_ms());
+        if (previous_state==BOLT_CIRCUIT_OPEN && breaker->state==BOLT_CIRCUIT_HALF_OPEN) {
+            BoltLog_info(pool->config->log, "[routing]: circuit towards %s:%s is half-open, probing", server->host,
+                    server->port);
+        }
+    }
+    BoltSync_mutex_unlock(&pool->breakers_mutex);
+
+    return status;
+}
+
+void BoltRoutingPool_record_server_success(struct BoltRoutingPool* pool, const struct BoltAddress* server)
+{
+    // called on every acquisition, so the lock is only taken while some server has failures on record
+    if (pool->config->circuit_breaker_threshold<=0 || BoltAtomic_add(&pool->breaker_count, 0)==0) {
+        return;
+    }
+
+    BoltSync_mutex_lock(&pool->breakers_mutex);
+    BoltCircuitBreaker* breaker = BoltRoutingPool_find_breaker(pool, server, 0);
+    if (breaker!=NULL) {
+        if (breaker->state!=BOLT_CIRCUIT_CLOSED) {
+            BoltLog_info(pool->config->log, "[routing]: circuit towards %s:%s is closed", server->host,
+                    server->port);
+        }
+        // a closed breaker without failures is no different from none
+        BoltRoutingPool_remove_breaker(pool, server);
+    }
+    BoltSync_mutex_unlock(&pool->breakers_mutex);
+}
+
+// Returns whether the failure opened the server's circuit
+int BoltRoutingPool_record_server_failure(struct BoltRoutingPool* pool, const struct BoltAddress* server)
+{
+    if (pool->config->circuit_breaker_threshold<=0) {
+        return 0;
+    }
+
+    BoltSync_mutex_lock(&pool->breakers_mutex);
+    BoltCircuitBreaker* breaker = BoltRoutingPool_find_breaker(pool, server, 1);
+    int previous_state = breaker->state;
+    BoltCircuitBreaker_on_failure(breaker, pool->config->circuit_breaker_threshold, BoltTime_get_time_ms());
+    int opened = previous_state!=BOLT_CIRCUIT_OPEN && breaker->state==BOLT_CIRCUIT_OPEN;
+    if (opened) {
+        BoltLog_warning(pool->config->log, "[routing]: circuit towards %s:%s is open after %d consecutive failures",
+                server->host, server->port, breaker->failures);
+    }
+    BoltSync_mutex_unlock(&pool->breakers_mutex);
+    return opened;
+}
+
 struct BoltAddress* BoltRoutingPool_select_least_connected(struct BoltRoutingPool* pool,
         volatile BoltAddressSet* servers, volatile int64_t offset)
 {
@@ -309,19 +463,22 @@ struct BoltAddress* BoltRoutingPool_select_least_connected(struct BoltRoutingPoo
         // Pick the current server
         BoltAddress* server = (BoltAddress*) servers->elements[index];
 
-        // Retrieve related direct pool if only it exists
-        int pool_index = BoltRoutingPool_ensure_server(pool, server, 0);
-        int server_active_connections = 0;
-        if (pool_index>=0) {
-            BoltDirectPool* server_pool = (BoltDirectPool*) pool->server_pools[pool_index];
+        // Skip servers whose circuit breaker is open
+        if (BoltRoutingPool_is_server_available(pool, server)) {
+            // Retrieve related direct pool if only it exists
+            int pool_index = BoltRoutingPool_ensure_server(pool, server, 0);
+            int server_active_connections = 0;
+            if (pool_index>=0) {
+                BoltDirectPool* server_pool = (BoltDirectPool*) pool->server_pools[pool_index];
 
-            // Compare in use connections to what we currently have and update if this is less
-            server_active_connections = BoltDirectPool_connections_in_use(server_pool);
-        }
+                // Compare in use connections to what we currently have and update if this is less
+                server_active_connections = BoltDirectPool_connections_in_use(server_pool);
+            }
 
-        if (server_active_connections<least_connected) {
-            least_connected_server = server;
-            least_connected = server_active_connections;
+            if (server_active_connections<least_connected) {
+                least_connected_server = server;
+                least_connected = server_active_connections;
+            }
         }
 
         // Stop if we had cycled through all servers
@@ -379,6 +536,12 @@ void BoltRoutingPool_forget_writer(struct BoltRoutingPool* pool, const struct Bo
 void BoltRoutingPool_handle_connection_error_by_code(struct BoltRoutingPool* pool, const struct BoltAddress* server,
         int code)
 {
+    // the server is still forgotten below, the breaker only keeps it from being selected again once a refreshed
+    // routing table brings it back
+    if (BoltRoutingPool_is_breaker_failure(code)) {
+        BoltRoutingPool_record_server_failure(pool, server);
+    }
+
     switch (code) {
     case BOLT_ROUTING_UNABLE_TO_RETRIEVE_ROUTING_TABLE:
     case BOLT_ROUTING_NO_SERVERS_TO_SELECT:
@@ -405,6 +568,19 @@ void BoltRoutingPool_handle_connection_error_by_code(struct BoltRoutingPool* poo
     }
 }
 
+void BoltRoutingPool_expire_routing_table(struct BoltRoutingPool* pool)
+{
+    // Lock
+    BoltSync_rwlock_wrlock(&pool->rwlock);
+    BoltLog_debug(pool->config->log, "[routing]: expire_routing_table: write lock acquired.");
+
+    pool->routing_table->expires = 0;
+
+    // Unlock
+    BoltSync_rwlock_wrunlock(&pool->rwlock);
+    BoltLog_debug(pool->config->log, "[routing]: expire_routing_table: write lock released.");
+}
+
 void BoltRoutingPool_handle_connection_error_by_failure(struct BoltRoutingPool* pool, const struct BoltAddress* server,
         const struct BoltValue* failure)
 {
@@ -467,6 +643,16 @@ BoltRoutingPool_create(const struct BoltAddress* address, const struct BoltValue
     pool->servers = BoltAddressSet_create();
     pool->server_pools = NULL;
 
+    pool->breaker_servers = BoltAddressSet_create();
+    pool->breakers = NULL;
+    pool->breaker_count = 0;
+    BoltSync_mutex_create(&pool->breakers_mutex);
+
+    pool->metrics = BoltConnectionMetrics_create();
+    pool->pool_metrics = BoltPoolMetrics_create();
+    pool->refreshes = 0;
+    pool->refresh_failures = 0;
+
     pool->routing_table = RoutingTable_create();
     pool->readers_offset = 0;
     pool->writers_offset = 0;
@@ -484,6 +670,13 @@ void BoltRoutingPool_destroy(struct BoltRoutingPool* pool)
     BoltMem_deallocate((void*) pool->server_pools, pool->servers->size*SIZE_OF_DIRECT_POOL_PTR);
     BoltAddressSet_destroy((BoltAddressSet*) pool->servers);
 
+    BoltMem_deallocate(pool->breakers, pool->breaker_servers->size*SIZE_OF_CIRCUIT_BREAKER);
+    BoltAddressSet_destroy(pool->breaker_servers);
+    BoltSync_mutex_destroy(&pool->breakers_mutex);
+
+    BoltConnectionMetrics_destroy(pool->metrics);
+    BoltPoolMetrics_destroy(pool->pool_metrics);
+
     RoutingTable_destroy(pool->routing_table);
 
     BoltSync_rwlock_destroy(&pool->rwlock);
@@ -499,11 +692,15 @@ BoltConnection* BoltRoutingPool_acquire(struct BoltRoutingPool* pool, BoltAccess
 
     int result = BoltRoutingPool_ensure_routing_table(pool, mode);
     if (result==BOLT_SUCCESS) {
+        volatile BoltAddressSet* candidates = mode==BOLT_ACCESS_MODE_READ
+                                              ? pool->routing_table->readers
+                                              : pool->routing_table->writers;
         server = mode==BOLT_ACCESS_MODE_READ
                  ? BoltRoutingPool_select_least_connected_reader(pool)
                  : BoltRoutingPool_select_least_connected_writer(pool);
         if (server==NULL) {
-            result = BOLT_ROUTING_NO_SERVERS_TO_SELECT;
+            // distinguish an empty role from one where every server has its circuit open
+            result = candidates->size>0 ? BOLT_ROUTING_CIRCUIT_OPEN : BOLT_ROUTING_NO_SERVERS_TO_SELECT;
         }
         else {
             // protect against modification of the returned address instance by other threads that may free it
@@ -511,6 +708,11 @@ BoltConnection* BoltRoutingPool_acquire(struct BoltRoutingPool* pool, BoltAccess
         }
     }
 
+    // Fail fast if the server's circuit breaker is open or its single probe is already taken
+    if (result==BOLT_SUCCESS) {
+        result = BoltRoutingPool_permit_server(pool, server);
+    }
+
     int server_pool_index = -1;
     if (result==BOLT_SUCCESS) {
         server_pool_index = BoltRoutingPool_ensure_server(pool, server, 1);
@@ -527,15 +729,25 @@ BoltConnection* BoltRoutingPool_acquire(struct BoltRoutingPool* pool, BoltAccess
             connection->on_error_cb_state = pool;
             connection->on_error_cb = BoltRoutingPool_connection_error_handler;
         }
+        else {
+            result = status->error;
+        }
     }
 
-    if (server!=NULL) {
-        BoltAddress_destroy(server);
+    BoltSync_rwlock_rdunlock(&pool->rwlock);
+
+    if (server==NULL && result==BOLT_ROUTING_CIRCUIT_OPEN) {
+        // the cluster may have moved the role to other servers since, so the next acquisition asks again
+        BoltRoutingPool_expire_routing_table(pool);
     }
 
-    BoltSync_rwlock_rdunlock(&pool->rwlock);
+    if (server!=NULL && result!=BOLT_ROUTING_CIRCUIT_OPEN && !BoltRoutingPool_is_breaker_failure(result)) {
+        // the server was reachable, which also completes any probe that was in flight
+        BoltRoutingPool_record_server_success(pool, server);
+    }
 
     if (result==BOLT_SUCCESS) {
+        BoltAddress_destroy(server);
         return connection;
     }
 
@@ -543,10 +755,13 @@ BoltConnection* BoltRoutingPool_acquire(struct BoltRoutingPool* pool, BoltAccess
     // table refresh fails.
     if (server!=NULL) {
         BoltRoutingPool_handle_connection_error_by_code(pool, server, result);
+        BoltAddress_destroy(server);
     }
 
-    status->error = result;
-    status->error_ctx = NULL;
+    if (status->error!=result) {
+        status->error = result;
+        status->error_ctx = NULL;
+    }
 
     return NULL;
 }
@@ -572,3 +787,46 @@ int BoltRoutingPool_release(struct BoltRoutingPool* pool, struct BoltConnection*
 
     return result;
 }
+
+void BoltRoutingPool_connection_metrics(struct BoltRoutingPool* pool, BoltConnectionMetrics* metrics)
+{
+    BoltSync_rwlock_rdlock(&pool->rwlock);
+    BoltConnectionMetrics_add(metrics, pool->metrics);
+    for (int i = 0; i<pool->servers->size; i++) {
+        BoltDirectPool_connection_metrics((BoltDirectPool*) pool->server_pools[i], metrics);
+    }
+    BoltSync_rwlock_rdunlock(&pool->rwlock);
+}
+
+void BoltRoutingPool_pool_metrics(struct BoltRoutingPool* pool, BoltPoolMetrics* metrics)
+{
+    BoltSync_rwlock_rdlock(&pool->rwlock);
+    BoltPoolMetrics_add(metrics, pool->pool_metrics);
+    for (int i = 0; i<pool->servers->size; i++) {
+        BoltDirectPool_pool_metrics((BoltDirectPool*) pool->server_pools[i], metrics);
+    }
+    BoltSync_rwlock_rdunlock(&pool->rwlock);
+}
+
+int32_t BoltRoutingPool_server_metrics(struct BoltRoutingPool* pool, struct BoltServerMetrics** metrics)
+{
+    BoltSync_rwlock_rdlock(&pool->rwlock);
+    int32_t count = pool->servers->size;
+    *metrics = count>0 ? BoltMem_allocate(count*SIZE_OF_SERVER_METRICS) : NULL;
+    for (int i = 0; i<count; i++) {
+        BoltDirectPool_server_metrics((BoltDirectPool*) pool->server_pools[i], &(*metrics)[i]);
+
+        BoltSync_mutex_lock(&pool->breakers_mutex);
+        BoltCircuitBreaker* breaker = BoltRoutingPool_find_breaker(pool, (BoltAddress*) pool->servers->elements[i], 0);
+        (*metrics)[i].circuit_state = breaker==NULL ? BOLT_CIRCUIT_CLOSED : breaker->state;
+        BoltSync_mutex_unlock(&pool->breakers_mutex);
+    }
+    BoltSync_rwlock_rdunlock(&pool->rwlock);
+    return count;
+}
+
+void BoltRoutingPool_routing_metrics(struct BoltRoutingPool* pool, struct BoltRoutingMetrics* metrics)
+{
+    metrics->refreshes = BoltAtomic_add(&pool->refreshes, 0);
+    metrics->refresh_failures = BoltAtomic_add(&pool->refresh_failures, 0);
+}
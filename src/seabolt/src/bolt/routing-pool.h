@@ -23,8 +23,12 @@
 #include "address.h"
 #include "values.h"
 #include "atomic.h"
+#include "circuit-breaker.h"
 #include "routing-table.h"
 
+struct BoltServerMetrics;
+struct BoltRoutingMetrics;
+
 struct BoltRoutingPool {
     const struct BoltAddress* address;
     const struct BoltConfig* config;
@@ -37,6 +41,19 @@ struct BoltRoutingPool {
     volatile BoltAddressSet* servers;
     volatile BoltDirectPool** server_pools;
 
+    /// Breakers of servers that failed since their last success, healthy servers have none
+    volatile BoltAddressSet* breaker_servers;
+    BoltCircuitBreaker* breakers;
+    mutex_t breakers_mutex;
+    /// Number of breakers, read without breakers_mutex to skip it while all servers are healthy
+    volatile int64_t breaker_count;
+
+    /// Accumulated metrics of the server pools already cleaned up
+    BoltConnectionMetrics* metrics;
+    BoltPoolMetrics* pool_metrics;
+    volatile int64_t refreshes;
+    volatile int64_t refresh_failures;
+
     rwlock_t rwlock;
 };
 
@@ -53,4 +70,21 @@ BoltConnection* BoltRoutingPool_acquire(struct BoltRoutingPool* pool, BoltAccess
 
 int BoltRoutingPool_release(struct BoltRoutingPool* pool, struct BoltConnection* connection);
 
+void BoltRoutingPool_connection_metrics(struct BoltRoutingPool* pool, BoltConnectionMetrics* metrics);
+
+void BoltRoutingPool_pool_metrics(struct BoltRoutingPool* pool, BoltPoolMetrics* metrics);
+
+int32_t BoltRoutingPool_server_metrics(struct BoltRoutingPool* pool, struct BoltServerMetrics** metrics);
+
+void BoltRoutingPool_routing_metrics(struct BoltRoutingPool* pool, struct BoltRoutingMetrics* metrics);
+
+int BoltRoutingPool_is_server_available(struct BoltRoutingPool* pool, const struct BoltAddress* server);
+
+void BoltRoutingPool_record_server_success(struct BoltRoutingPool* pool, const struct BoltAddress* server);
+
+void BoltRoutingPool_handle_connection_error_by_code(struct BoltRoutingPool* pool, const struct BoltAddress* server,
+        int code);
+
+void BoltRoutingPool_cleanup(struct BoltRoutingPool* pool);
+
 #endif //SEABOLT_ALL_DISCOVERY_H
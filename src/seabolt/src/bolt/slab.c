@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_VALUES
+
+#include "bolt-private.h"
+#include "mem.h"
+#include "slab.h"
+#include "sync.h"
+
+/// Blocks held by each thread-local magazine
+#define MAGAZINE_SIZE 32
+/// Size of the chunks that the depot carves blocks out of
+#define CHUNK_SIZE (64*1024)
+
+#define CLASS_OF(size) (((size)-1)/BOLT_SLAB_GRANULE)
+#define CLASS_SIZE(index) (((index)+1)*BOLT_SLAB_GRANULE)
+
+struct BoltSlabMagazine {
+    int32_t count;
+    void* blocks[MAGAZINE_SIZE];
+};
+
+/// Free blocks of the depot are linked through their first bytes
+struct BoltSlabBlock {
+    struct BoltSlabBlock* next;
+};
+
+struct BoltSlabDepot {
+    mutex_t mutex;
+    int started;
+    struct BoltSlabBlock* free[BOLT_SLAB_CLASSES];
+    /// Chunks are linked through their first granule, which is never handed out
+    struct BoltSlabBlock* chunks;
+    /// Number of blocks carved out of the chunks
+    int64_t carved;
+    /// Set for the threads whose magazines hold blocks, to flush them on exit
+    thread_key_t key;
+};
+
+static struct BoltSlabDepot depot = {NULL, 0, {NULL}, NULL, 0, NULL};
+
+static BOLT_THREAD_LOCAL struct BoltSlabMagazine magazines[BOLT_SLAB_CLASSES];
+
+static BOLT_THREAD_LOCAL int registered = 0;
+
+// Moves all the blocks of the magazines of an exiting thread to the depot
+static void _flush(void* value)
+{
+    struct BoltSlabMagazine* thread_magazines = (struct BoltSlabMagazine*) value;
+    BoltSync_mutex_lock(&depot.mutex);
+    for (int index = 0; index<BOLT_SLAB_CLASSES; index++) {
+        struct BoltSlabMagazine* magazine = &thread_magazines[index];
+        while (magazine->count>0) {
+            struct BoltSlabBlock* block = (struct BoltSlabBlock*) magazine->blocks[--magazine->count];
+            block->next = depot.free[index];
+            depot.free[index] = block;
+        }
+    }
+    BoltSync_mutex_unlock(&depot.mutex);
+    registered = 0;
+}
+
+// Arranges for the magazines of the calling thread to be flushed when it exits, before they first take a block
+static void _register()
+{
+    if (!registered) {
+        BoltThread_key_set(&depot.key, magazines);
+        registered = 1;
+    }
+}
+
+void BoltSlab_startup()
+{
+    if (depot.started) {
+        return;
+    }
+    BoltSync_mutex_create(&depot.mutex);
+    BoltThread_key_create(&depot.key, &_flush);
+    depot.started = 1;
+}
+
+// Returns whether the block was carved out of one of the chunks
+static int _is_carved(const void* ptr)
+{
+    for (struct BoltSlabBlock* chunk = depot.chunks; chunk!=NULL; chunk = chunk->next) {
+        if ((const char*) ptr>=(const char*) chunk && (const char*) ptr<(const char*) chunk+CHUNK_SIZE) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Frees the chunks once all their blocks are back in the depot, along with the blocks that came from BoltMem
+static void _release_chunks()
+{
+    int64_t carved_free = 0;
+    for (int index = 0; index<BOLT_SLAB_CLASSES; index++) {
+        for (struct BoltSlabBlock* block = depot.free[index]; block!=NULL; block = block->next) {
+            carved_free += _is_carved(block);
+        }
+    }
+    if (carved_free!=depot.carved) {
+        // blocks still in use keep their chunks, which are then kept for the lifetime of the process
+        return;
+    }
+
+    for (int index = 0; index<BOLT_SLAB_CLASSES; index++) {
+        struct BoltSlabBlock* block = depot.free[index];
+        while (block!=NULL) {
+            struct BoltSlabBlock* next = block->next;
+            if (!_is_carved(block)) {
+                BoltMem_deallocate_untracked(block, CLASS_SIZE(index));
+            }
+            block = next;
+        }
+        depot.free[index] = NULL;
+    }
+    while (depot.chunks!=NULL) {
+        struct BoltSlabBlock* chunk = depot.chunks;
+        depot.chunks = chunk->next;
+        BoltMem_deallocate_untracked(chunk, CHUNK_SIZE);
+    }
+    depot.carved = 0;
+}
+
+void BoltSlab_shutdown()
+{
+    if (!depot.started) {
+        return;
+    }
+    if (registered) {
+        BoltThread_key_set(&depot.key, NULL);
+        _flush(magazines);
+    }
+    _release_chunks();
+    BoltThread_key_delete(&depot.key);
+    BoltSync_mutex_destroy(&depot.mutex);
+    depot.started = 0;
+}
+
+// Carves a new chunk into free blocks of the given class, with the depot locked
+void _carve(int index)
+{
+    char* chunk = (char*) BoltMem_allocate_untracked(CHUNK_SIZE);
+    if (chunk==NULL) {
+        return;
+    }
+    ((struct BoltSlabBlock*) chunk)->next = depot.chunks;
+    depot.chunks = (struct BoltSlabBlock*) chunk;
+
+    const int64_t size = CLASS_SIZE(index);
+    for (int64_t offset = BOLT_SLAB_GRANULE; offset+size<=CHUNK_SIZE; offset += size) {
+        struct BoltSlabBlock* block = (struct BoltSlabBlock*) (chunk+offset);
+        block->next = depot.free[index];
+        depot.free[index] = block;
+        depot.carved++;
+    }
+}
+
+// Fills half of an empty magazine from the depot
+void _refill(int index, struct BoltSlabMagazine* magazine)
+{
+    BoltSync_mutex_lock(&depot.mutex);
+    if (depot.free[index]==NULL) {
+        _carve(index);
+    }
+    while (magazine->count<MAGAZINE_SIZE/2 && depot.free[index]!=NULL) {
+        struct BoltSlabBlock* block = depot.free[index];
+        depot.free[index] = block->next;
+        magazine->blocks[magazine->count++] = block;
+    }
+    BoltSync_mutex_unlock(&depot.mutex);
+}
+
+// Moves half of a full magazine to the depot
+void _spill(int index, struct BoltSlabMagazine* magazine)
+{
+    BoltSync_mutex_lock(&depot.mutex);
+    while (magazine->count>MAGAZINE_SIZE/2) {
+        struct BoltSlabBlock* block = (struct BoltSlabBlock*) magazine->blocks[--magazine->count];
+        block->next = depot.free[index];
+        depot.free[index] = block;
+    }
+    BoltSync_mutex_unlock(&depot.mutex);
+}
+
+void* BoltSlab_allocate(int64_t size)
+{
+    if (size<=0 || size>BOLT_SLAB_MAX_SIZE) {
+        return BoltMem_allocate(size);
+    }
+    const int index = (int) CLASS_OF(size);
+    if (!depot.started) {
+        return BoltMem_allocate(CLASS_SIZE(index));
+    }
+
+    struct BoltSlabMagazine* magazine = &magazines[index];
+    if (magazine->count==0) {
+        _register();
+        _refill(index, magazine);
+        if (magazine->count==0) {
+            return BoltMem_allocate(CLASS_SIZE(index));
+        }
+    }
+    BoltMem_record(0, CLASS_SIZE(index));
+    return magazine->blocks[--magazine->count];
+}
+
+void* BoltSlab_deallocate(void* ptr, int64_t old_size)
+{
+    if (ptr==NULL) {
+        return NULL;
+    }
+    if (old_size<=0 || old_size>BOLT_SLAB_MAX_SIZE) {
+        return BoltMem_deallocate(ptr, old_size);
+    }
+    const int index = (int) CLASS_OF(old_size);
+    if (!depot.started) {
+        if (_is_carved(ptr)) {
+            // freed after shutdown, the block stays unused in its chunk
+            BoltMem_record(CLASS_SIZE(index), 0);
+            return NULL;
+        }
+        return BoltMem_deallocate(ptr, CLASS_SIZE(index));
+    }
+
+    // Blocks that came from BoltMem before startup are of the class size too, so they can join the others
+    struct BoltSlabMagazine* magazine = &magazines[index];
+    if (magazine->count==0) {
+        _register();
+    }
+    else if (magazine->count==MAGAZINE_SIZE) {
+        _spill(index, magazine);
+    }
+    magazine->blocks[magazine->count++] = ptr;
+    BoltMem_record(CLASS_SIZE(index), 0);
+    return NULL;
+}
+
+void* BoltSlab_adjust(void* ptr, int64_t old_size, int64_t new_size)
+{
+    if (old_size>BOLT_SLAB_MAX_SIZE && new_size>BOLT_SLAB_MAX_SIZE) {
+        return BoltMem_adjust(ptr, old_size, new_size);
+    }
+    if (old_size>0 && new_size>0 && old_size<=BOLT_SLAB_MAX_SIZE && new_size<=BOLT_SLAB_MAX_SIZE
+            && CLASS_OF(old_size)==CLASS_OF(new_size)) {
+        return ptr;
+    }
+    if (old_size<=0) {
+        return new_size>0 ? BoltSlab_allocate(new_size) : ptr;
+    }
+    void* new_ptr = NULL;
+    if (new_size>0) {
+        new_ptr = BoltSlab_allocate(new_size);
+        memcpy(new_ptr, ptr, (size_t) (old_size<new_size ? old_size : new_size));
+    }
+    BoltSlab_deallocate(ptr, old_size);
+    return new_ptr;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_SLAB_H
+#define SEABOLT_SLAB_H
+
+#include "bolt-public.h"
+
+/// Blocks are handed out in multiples of this many bytes, the size of a BoltValue
+#define BOLT_SLAB_GRANULE 32
+/// Number of size classes, so that BoltValue arrays of up to this many entries come from the caches
+#define BOLT_SLAB_CLASSES 16
+/// Larger allocations go straight to BoltMem
+#define BOLT_SLAB_MAX_SIZE (BOLT_SLAB_GRANULE*BOLT_SLAB_CLASSES)
+
+/**
+ * Size-classed caches for the small blocks that BoltValues are made of, so that building and decoding nested
+ * values does not go to the general purpose allocator for every value.
+ *
+ * Requests of up to \ref BOLT_SLAB_MAX_SIZE bytes are rounded up to a multiple of \ref BOLT_SLAB_GRANULE and
+ * served from a thread-local magazine of free blocks of that class. Magazines are refilled from, and spill over
+ * to, a depot shared by all threads, which carves new blocks out of large chunks when it runs dry. Chunks are kept
+ * until shutdown, and come from the configured allocator like all other memory. Blocks may be freed by any thread,
+ * and those left in the magazines of a thread that exits are returned to the depot.
+ *
+ * Until \ref BoltSlab_startup has been called, and for larger requests, the functions fall back to the
+ * corresponding BoltMem functions. Blocks are accounted for in the BoltMem statistics by their class size.
+ */
+
+/**
+ * Sets up the shared depot, called from Bolt_startup.
+ */
+void BoltSlab_startup();
+
+/**
+ * Returns the blocks of the calling thread to the depot and releases its lock, called from Bolt_shutdown. The chunks
+ * are freed if all their blocks are back in the depot, and are kept otherwise, so that blocks still in use remain
+ * valid and can be freed after this call.
+ */
+void BoltSlab_shutdown();
+
+/**
+ * Allocates a block of at least _size_ bytes.
+ *
+ * @param size
+ * @return
+ */
+void* BoltSlab_allocate(int64_t size);
+
+/**
+ * Frees a block allocated with \ref BoltSlab_allocate or \ref BoltSlab_adjust.
+ *
+ * @param ptr
+ * @param old_size the size the block was requested with.
+ * @return NULL
+ */
+void* BoltSlab_deallocate(void* ptr, int64_t old_size);
+
+/**
+ * Adjusts the size of a block the way \ref BoltMem_adjust does, keeping the block as long as the size class
+ * does not change.
+ *
+ * @param ptr
+ * @param old_size
+ * @param new_size
+ * @return
+ */
+void* BoltSlab_adjust(void* ptr, int64_t old_size, int64_t new_size);
+
+#endif //SEABOLT_SLAB_H
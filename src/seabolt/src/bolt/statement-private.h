@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_STATEMENT_PRIVATE_H
+#define SEABOLT_STATEMENT_PRIVATE_H
+
+#include "statement.h"
+
+struct BoltStatement {
+    /// The PackStream string holding the cypher text
+    char* encoded;
+    int32_t encoded_size;
+    /// Offset of the cypher text within the encoded string
+    int32_t header_size;
+};
+
+#endif //SEABOLT_STATEMENT_PRIVATE_H
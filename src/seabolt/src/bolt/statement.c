@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_PROTOCOL
+
+#include "bolt-private.h"
+#include "buffering.h"
+#include "mem.h"
+#include "packstream.h"
+#include "statement-private.h"
+
+BoltStatement* BoltStatement_create(const char* cypher, uint64_t cypher_size)
+{
+    if (cypher_size>INT32_MAX-5) {
+        return NULL;
+    }
+
+    struct BoltBuffer* buffer = BoltBuffer_create((int) cypher_size+5);
+    load_string_header(buffer, (int32_t) cypher_size);
+    int32_t header_size = buffer->extent;
+    BoltBuffer_load(buffer, cypher, (int) cypher_size);
+
+    BoltStatement* statement = BoltMem_allocate(sizeof(BoltStatement));
+    statement->encoded_size = buffer->extent;
+    statement->header_size = header_size;
+    statement->encoded = BoltMem_duplicate(buffer->data, buffer->extent);
+    BoltBuffer_destroy(buffer);
+    return statement;
+}
+
+void BoltStatement_destroy(BoltStatement* statement)
+{
+    if (statement==NULL) return;
+
+    BoltMem_deallocate(statement->encoded, statement->encoded_size);
+    BoltMem_deallocate(statement, sizeof(BoltStatement));
+}
+
+const char* BoltStatement_cypher(const BoltStatement* statement)
+{
+    return statement->encoded+statement->header_size;
+}
+
+int32_t BoltStatement_cypher_size(const BoltStatement* statement)
+{
+    return statement->encoded_size-statement->header_size;
+}
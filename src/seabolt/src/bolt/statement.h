@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file
+ */
+
+#ifndef SEABOLT_STATEMENT_H
+#define SEABOLT_STATEMENT_H
+
+#include "bolt-public.h"
+
+/**
+ * The type that holds a Cypher statement together with its PackStream encoding, so that a statement which is
+ * run over and over again is encoded only once. A statement is immutable and can be shared between connections
+ * and threads.
+ */
+typedef struct BoltStatement BoltStatement;
+
+/**
+ * Creates a new instance of \ref BoltStatement.
+ *
+ * @param cypher the cypher text.
+ * @param cypher_size the size of the cypher text.
+ * @returns the pointer to the newly allocated \ref BoltStatement instance, or NULL if the cypher text is too long.
+ */
+SEABOLT_EXPORT BoltStatement* BoltStatement_create(const char* cypher, uint64_t cypher_size);
+
+/**
+ * Destroys the passed \ref BoltStatement instance.
+ *
+ * @param statement the instance to be destroyed.
+ */
+SEABOLT_EXPORT void BoltStatement_destroy(BoltStatement* statement);
+
+/**
+ * Returns the cypher text of the statement.
+ *
+ * @param statement the statement instance.
+ * @returns the cypher text, which is not null terminated.
+ */
+SEABOLT_EXPORT const char* BoltStatement_cypher(const BoltStatement* statement);
+
+/**
+ * Returns the size of the cypher text of the statement.
+ *
+ * @param statement the statement instance.
+ * @returns the size of the cypher text.
+ */
+SEABOLT_EXPORT int32_t BoltStatement_cypher_size(const BoltStatement* statement);
+
+#endif //SEABOLT_STATEMENT_H
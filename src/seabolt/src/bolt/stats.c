@@ -20,6 +20,7 @@
 #include "bolt-private.h"
 #include "stats.h"
 #include "mem.h"
+#include "string-builder.h"
 
 uint64_t BoltStat_memory_allocation_current()
 {
@@ -36,3 +37,64 @@ int64_t BoltStat_memory_allocation_events()
     return BoltMem_allocation_events();
 }
 
+
+static const char* memory_tag_names[BOLT_MEMORY_TAGS] = {
+        "other", "buffers", "values", "protocol", "connections", "pools", "routing", "tls", "logging"
+};
+
+static int _is_valid_tag(BoltMemoryTag tag)
+{
+    return tag>=0 && tag<BOLT_MEMORY_TAGS;
+}
+
+const char* BoltStat_memory_tag_name(BoltMemoryTag tag)
+{
+    return _is_valid_tag(tag) ? memory_tag_names[tag] : NULL;
+}
+
+uint64_t BoltStat_memory_tag_allocation_current(BoltMemoryTag tag)
+{
+    return _is_valid_tag(tag) ? (uint64_t) BoltMem_current_allocation_tagged(tag) : 0;
+}
+
+uint64_t BoltStat_memory_tag_allocation_peak(BoltMemoryTag tag)
+{
+    return _is_valid_tag(tag) ? (uint64_t) BoltMem_peak_allocation_tagged(tag) : 0;
+}
+
+int64_t BoltStat_memory_tag_allocation_events(BoltMemoryTag tag)
+{
+    return _is_valid_tag(tag) ? BoltMem_allocation_events_tagged(tag) : 0;
+}
+
+int32_t BoltStat_write_memory_profile(char* dest, int32_t length)
+{
+    // The counters are read before the text is built, so the memory of the builder does not show in the profile
+    int64_t current[BOLT_MEMORY_TAGS+1], peak[BOLT_MEMORY_TAGS+1], events[BOLT_MEMORY_TAGS+1];
+    for (BoltMemoryTag tag = 0; tag<BOLT_MEMORY_TAGS; tag++) {
+        current[tag] = BoltMem_current_allocation_tagged(tag);
+        peak[tag] = BoltMem_peak_allocation_tagged(tag);
+        events[tag] = BoltMem_allocation_events_tagged(tag);
+    }
+    current[BOLT_MEMORY_TAGS] = BoltMem_current_allocation();
+    peak[BOLT_MEMORY_TAGS] = BoltMem_peak_allocation();
+    events[BOLT_MEMORY_TAGS] = BoltMem_allocation_events();
+
+    struct StringBuilder* builder = StringBuilder_create();
+    StringBuilder_append_f(builder, "%-12s %16s %16s %16s\n", "subsystem", "current", "peak", "events");
+    for (int row = 0; row<=BOLT_MEMORY_TAGS; row++) {
+        StringBuilder_append_f(builder, "%-12s %16" PRId64 " %16" PRId64 " %16" PRId64 "\n",
+                row<BOLT_MEMORY_TAGS ? memory_tag_names[row] : "total", current[row], peak[row], events[row]);
+    }
+
+    int32_t text_length = StringBuilder_get_length(builder);
+    int32_t copy_length = text_length<length ? text_length : length;
+    if (dest!=NULL && copy_length>0) {
+        memcpy(dest, StringBuilder_get_string(builder), (size_t) copy_length);
+        if (copy_length<length) {
+            dest[copy_length] = 0;
+        }
+    }
+    StringBuilder_destroy(builder);
+    return text_length;
+}
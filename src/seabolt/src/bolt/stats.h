@@ -43,4 +43,71 @@ SEABOLT_EXPORT uint64_t BoltStat_memory_allocation_peak();
  */
 SEABOLT_EXPORT int64_t BoltStat_memory_allocation_events();
 
+/**
+ * The subsystem that the connector accounts an allocation to, see \ref BoltStat_memory_tag_allocation_current.
+ */
+typedef int32_t BoltMemoryTag;
+/// Memory not attributed to any of the other subsystems
+#define BOLT_MEMORY_OTHER           0
+/// Transmit and receive buffers, including pooled ones
+#define BOLT_MEMORY_BUFFERS         1
+/// Values, including the slab caches serving them
+#define BOLT_MEMORY_VALUES          2
+/// Protocol state, request messages and decoder state
+#define BOLT_MEMORY_PROTOCOL        3
+/// Connections, their communication objects, status and metrics
+#define BOLT_MEMORY_CONNECTIONS     4
+/// Connectors, their configuration and connection pools
+#define BOLT_MEMORY_POOLS           5
+/// Routing tables, addresses and address resolution
+#define BOLT_MEMORY_ROUTING         6
+/// TLS contexts and secure communication state
+#define BOLT_MEMORY_TLS             7
+/// Loggers and log message formatting
+#define BOLT_MEMORY_LOGGING         8
+/// The number of memory tags
+#define BOLT_MEMORY_TAGS            9
+
+/**
+ * Returns the name of the passed memory tag, as used in \ref BoltStat_write_memory_profile.
+ *
+ * @param tag the memory tag.
+ * @returns the name, or NULL if _tag_ is not a valid memory tag.
+ */
+SEABOLT_EXPORT const char* BoltStat_memory_tag_name(BoltMemoryTag tag);
+
+/**
+ * Returns the current allocated memory by the passed subsystem.
+ *
+ * @param tag the memory tag.
+ * @returns the current allocated memory, or 0 if _tag_ is not a valid memory tag.
+ */
+SEABOLT_EXPORT uint64_t BoltStat_memory_tag_allocation_current(BoltMemoryTag tag);
+
+/**
+ * Returns the peak allocated memory by the passed subsystem.
+ *
+ * @param tag the memory tag.
+ * @returns the peak allocated memory, or 0 if _tag_ is not a valid memory tag.
+ */
+SEABOLT_EXPORT uint64_t BoltStat_memory_tag_allocation_peak(BoltMemoryTag tag);
+
+/**
+ * Returns the number of allocation events (malloc, realloc, free) by the passed subsystem.
+ *
+ * @param tag the memory tag.
+ * @returns the number of allocation events, or 0 if _tag_ is not a valid memory tag.
+ */
+SEABOLT_EXPORT int64_t BoltStat_memory_tag_allocation_events(BoltMemoryTag tag);
+
+/**
+ * Renders the memory profile into the provided buffer as a table with a row per subsystem and a row for the
+ * totals, listing the current and peak allocated memory and the number of allocation events.
+ *
+ * @param dest the destination buffer.
+ * @param length the size of the destination buffer.
+ * @returns the length of the full text, which may be larger than _length_ in which case the output is truncated.
+ */
+SEABOLT_EXPORT int32_t BoltStat_write_memory_profile(char* dest, int32_t length);
+
 #endif //SEABOLT_STATS_H
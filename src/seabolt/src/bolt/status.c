@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_CONNECTIONS
+
 #include "bolt-private.h"
 #include "status-private.h"
 #include "mem.h"
@@ -17,13 +17,16 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_LOGGING
+
 #include "bolt-private.h"
+#include "mem.h"
 #include "string-builder.h"
 
 struct StringBuilder* StringBuilder_create()
 {
-    struct StringBuilder* builder = (struct StringBuilder*) malloc(sizeof(struct StringBuilder));
-    builder->buffer = (char*) malloc(256*sizeof(char));
+    struct StringBuilder* builder = (struct StringBuilder*) BoltMem_allocate(sizeof(struct StringBuilder));
+    builder->buffer = (char*) BoltMem_allocate(256*sizeof(char));
     builder->buffer[0] = 0;
     builder->buffer_pos = 0;
     builder->buffer_size = 256;
@@ -32,8 +35,8 @@ struct StringBuilder* StringBuilder_create()
 
 void StringBuilder_destroy(struct StringBuilder* builder)
 {
-    free(builder->buffer);
-    free(builder);
+    BoltMem_deallocate(builder->buffer, builder->buffer_size);
+    BoltMem_deallocate(builder, sizeof(struct StringBuilder));
 }
 
 void StringBuilder_ensure_buffer(struct StringBuilder* builder, int size_to_add)
@@ -43,7 +46,7 @@ void StringBuilder_ensure_buffer(struct StringBuilder* builder, int size_to_add)
     }
 
     int new_size = builder->buffer_pos+size_to_add;
-    builder->buffer = (char*) realloc(builder->buffer, new_size);
+    builder->buffer = (char*) BoltMem_reallocate(builder->buffer, builder->buffer_size, new_size);
     builder->buffer_size = new_size;
 }
 
@@ -72,7 +75,7 @@ void StringBuilder_append_f(struct StringBuilder* builder, const char* format, .
 
     int written;
     int size = 10240*sizeof(char);
-    char* message_fmt = (char*) malloc(size);
+    char* message_fmt = (char*) BoltMem_allocate(size);
     message_fmt[0] = 0;
     while (1) {
         va_list args;
@@ -89,13 +92,13 @@ void StringBuilder_append_f(struct StringBuilder* builder, const char* format, .
             written = size*10;
         }
 
-        message_fmt = (char*) realloc(message_fmt, written+1);
+        message_fmt = (char*) BoltMem_reallocate(message_fmt, size, written+1);
         size = written+1;
     }
 
     StringBuilder_append_n(builder, message_fmt, written);
 
-    free(message_fmt);
+    BoltMem_deallocate(message_fmt, size);
 }
 
 char* StringBuilder_get_string(struct StringBuilder* builder)
@@ -187,3 +187,67 @@ unsigned long BoltThread_id()
 {
     return (unsigned long) pthread_self();
 }
+
+struct BoltThread {
+    pthread_t handle;
+    thread_func func;
+    void* arg;
+};
+
+void* _thread_main(void* arg)
+{
+    struct BoltThread* thread = (struct BoltThread*) arg;
+    thread->func(thread->arg);
+    return NULL;
+}
+
+int BoltThread_create(thread_t* thread, thread_func func, void* arg)
+{
+    struct BoltThread* state = (struct BoltThread*) BoltMem_allocate(sizeof(struct BoltThread));
+    state->func = func;
+    state->arg = arg;
+    if (pthread_create(&state->handle, NULL, _thread_main, state)!=0) {
+        BoltMem_deallocate(state, sizeof(struct BoltThread));
+        *thread = NULL;
+        return 0;
+    }
+    *thread = state;
+    return 1;
+}
+
+int BoltThread_join(thread_t* thread)
+{
+    struct BoltThread* state = (struct BoltThread*) *thread;
+    int status = pthread_join(state->handle, NULL)==0;
+    BoltMem_deallocate(state, sizeof(struct BoltThread));
+    *thread = NULL;
+    return status;
+}
+
+void BoltThread_sleep(int64_t microseconds)
+{
+    struct timespec duration;
+    duration.tv_sec = microseconds/1000000;
+    duration.tv_nsec = (long) (microseconds%1000000)*1000;
+    while (nanosleep(&duration, &duration)!=0) {
+    }
+}
+
+int BoltThread_key_create(thread_key_t* key, thread_exit_func on_exit)
+{
+    *key = BoltMem_allocate(sizeof(pthread_key_t));
+    return pthread_key_create(*key, on_exit);
+}
+
+int BoltThread_key_set(thread_key_t* key, void* value)
+{
+    return pthread_setspecific(*(pthread_key_t*) *key, value);
+}
+
+int BoltThread_key_delete(thread_key_t* key)
+{
+    int status = pthread_key_delete(*(pthread_key_t*) *key);
+    BoltMem_deallocate(*key, sizeof(pthread_key_t));
+    *key = NULL;
+    return status;
+}
@@ -179,4 +179,110 @@ int BoltSync_cond_timedwait(cond_t* cond, mutex_t* mutex, int timeout_ms)
 unsigned long BoltThread_id()
 {
     return (unsigned long) GetCurrentThreadId();
-}
\ No newline at end of file
+}
+
+struct BoltThread {
+    HANDLE handle;
+    thread_func func;
+    void* arg;
+};
+
+DWORD WINAPI _thread_main(LPVOID arg)
+{
+    struct BoltThread* thread = (struct BoltThread*) arg;
+    thread->func(thread->arg);
+    return 0;
+}
+
+int BoltThread_create(thread_t* thread, thread_func func, void* arg)
+{
+    struct BoltThread* state = (struct BoltThread*) BoltMem_allocate(sizeof(struct BoltThread));
+    state->func = func;
+    state->arg = arg;
+    state->handle = CreateThread(NULL, 0, _thread_main, state, 0, NULL);
+    if (state->handle==NULL) {
+        BoltMem_deallocate(state, sizeof(struct BoltThread));
+        *thread = NULL;
+        return 0;
+    }
+    *thread = state;
+    return 1;
+}
+
+int BoltThread_join(thread_t* thread)
+{
+    struct BoltThread* state = (struct BoltThread*) *thread;
+    int status = WaitForSingleObject(state->handle, INFINITE)==WAIT_OBJECT_0;
+    CloseHandle(state->handle);
+    BoltMem_deallocate(state, sizeof(struct BoltThread));
+    *thread = NULL;
+    return status;
+}
+void BoltThread_sleep(int64_t microseconds)
+{
+    Sleep((DWORD) ((microseconds+999)/1000));
+}
+
+struct BoltThreadKey {
+    DWORD index;
+    thread_exit_func on_exit;
+};
+
+/// Fiber local storage callbacks only receive the stored value, so the value travels with its key
+struct BoltThreadValue {
+    struct BoltThreadKey* key;
+    void* value;
+};
+
+VOID WINAPI _thread_exit(PVOID data)
+{
+    struct BoltThreadValue* value = (struct BoltThreadValue*) data;
+    if (value==NULL) {
+        return;
+    }
+    if (value->value!=NULL && value->key->on_exit!=NULL) {
+        value->key->on_exit(value->value);
+    }
+    BoltMem_deallocate(value, sizeof(struct BoltThreadValue));
+}
+
+int BoltThread_key_create(thread_key_t* key, thread_exit_func on_exit)
+{
+    struct BoltThreadKey* state = (struct BoltThreadKey*) BoltMem_allocate(sizeof(struct BoltThreadKey));
+    state->on_exit = on_exit;
+    state->index = FlsAlloc(_thread_exit);
+    if (state->index==FLS_OUT_OF_INDEXES) {
+        BoltMem_deallocate(state, sizeof(struct BoltThreadKey));
+        *key = NULL;
+        return -1;
+    }
+    *key = state;
+    return 0;
+}
+
+int BoltThread_key_set(thread_key_t* key, void* value)
+{
+    struct BoltThreadKey* state = (struct BoltThreadKey*) *key;
+    struct BoltThreadValue* current = (struct BoltThreadValue*) FlsGetValue(state->index);
+    if (current==NULL) {
+        current = (struct BoltThreadValue*) BoltMem_allocate(sizeof(struct BoltThreadValue));
+        current->key = state;
+        if (!FlsSetValue(state->index, current)) {
+            BoltMem_deallocate(current, sizeof(struct BoltThreadValue));
+            return -1;
+        }
+    }
+    current->value = value;
+    return 0;
+}
+
+int BoltThread_key_delete(thread_key_t* key)
+{
+    struct BoltThreadKey* state = (struct BoltThreadKey*) *key;
+    // FlsFree hands every value still set to the callback, which then only releases the holders
+    state->on_exit = NULL;
+    int status = FlsFree(state->index) ? 0 : -1;
+    BoltMem_deallocate(state, sizeof(struct BoltThreadKey));
+    *key = NULL;
+    return status;
+}
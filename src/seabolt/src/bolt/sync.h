@@ -27,6 +27,20 @@ typedef void* rwlock_t;
 
 typedef void* cond_t;
 
+typedef void* thread_t;
+
+typedef void (* thread_func)(void* arg);
+
+typedef void* thread_key_t;
+
+typedef void (* thread_exit_func)(void* value);
+
+#if defined(_MSC_VER)
+#define BOLT_THREAD_LOCAL __declspec(thread)
+#else
+#define BOLT_THREAD_LOCAL _Thread_local
+#endif
+
 int BoltSync_mutex_create(mutex_t* mutex);
 
 int BoltSync_mutex_destroy(mutex_t* mutex);
@@ -71,4 +85,27 @@ int BoltSync_cond_timedwait(cond_t* cond, mutex_t* mutex, int timeout_ms);
 
 unsigned long BoltThread_id();
 
+int BoltThread_create(thread_t* thread, thread_func func, void* arg);
+
+int BoltThread_join(thread_t* thread);
+
+void BoltThread_sleep(int64_t microseconds);
+
+/**
+ * Creates a key that associates a value with each thread, calling _on_exit_ with the value of every
+ * thread that exits with a value set.
+ */
+int BoltThread_key_create(thread_key_t* key, thread_exit_func on_exit);
+
+/**
+ * Sets the value of the calling thread for _key_, NULL clears it.
+ */
+int BoltThread_key_set(thread_key_t* key, void* value);
+
+/**
+ * Deletes a key created with \ref BoltThread_key_create. Its exit function is no longer called, so the values
+ * still set are left to their owners.
+ */
+int BoltThread_key_delete(thread_key_t* key);
+
 #endif //SEABOLT_SYNC_H
@@ -17,13 +17,19 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_PROTOCOL
+
 #include "bolt-private.h"
+#include "atomic.h"
+#include "buffer-pool.h"
 #include "connection-private.h"
 #include "log-private.h"
 #include "mem.h"
 #include "protocol.h"
+#include "statement-private.h"
 #include "v1.h"
 #include "values-private.h"
+#include "writer-private.h"
 
 #define BOOKMARKS_KEY "bookmarks"
 #define BOOKMARKS_KEY_SIZE 9
@@ -60,6 +66,8 @@ int BoltProtocolV1_compile_INIT(struct BoltMessage* message, const char* user_ag
     BoltValue_copy(auth_token_field, auth_token);
 
     if (mask_secure_fields) {
+        // The copy shares its entries with the auth token, which must not be changed along with it
+        BoltValue_unshare(auth_token_field);
         struct BoltValue* secure_value = BoltDictionary_value_by_key(auth_token_field, "credentials", 11);
         if (secure_value!=NULL) {
             BoltValue_format_as_String(secure_value, "********", 8);
@@ -94,6 +102,19 @@ int BoltProtocolV1_check_readable_struct_signature(int16_t signature)
     return 0;
 }
 
+int BoltProtocolV1_check_lazy_struct_signature(int16_t signature)
+{
+    switch (signature) {
+    case BOLT_V1_NODE:
+    case BOLT_V1_RELATIONSHIP:
+    case BOLT_V1_UNBOUND_RELATIONSHIP:
+    case BOLT_V1_PATH:
+        return 1;
+    }
+
+    return 0;
+}
+
 int BoltProtocolV1_check_writable_struct_signature(int16_t signature)
 {
     switch (signature) {
@@ -178,19 +199,29 @@ void clear_failure_data(struct BoltProtocolV1State* state)
 
 int BoltProtocolV1_load_message(struct BoltConnection* connection, struct BoltMessage* message, int quiet)
 {
-    if (!quiet) {
+    if (!quiet && connection->log!=NULL && connection->log->debug_enabled) {
         struct BoltProtocolV1State* state = BoltProtocolV1_state(connection);
+        struct BoltValue* decoded = BoltMessage_decode_fields(message, connection->protocol->check_writable_struct,
+                connection->log);
         BoltLog_message(connection->log, BoltConnection_id(connection), "C", state->next_request_id, message->code,
-                message->fields, connection->protocol->structure_name, connection->protocol->message_name);
+                decoded!=NULL ? decoded : message->fields, connection->protocol->structure_name,
+                connection->protocol->message_name);
+        BoltValue_destroy(decoded);
     }
 
     struct BoltProtocolV1State* state = BoltProtocolV1_state(connection);
     int prev_cursor = state->tx_buffer->cursor;
     int prev_extent = state->tx_buffer->extent;
-    int status = write_message(message, connection->protocol->check_writable_struct, state->tx_buffer, connection->log);
+    // Large messages are sent chunk by chunk while being encoded rather than buffered whole
+    struct PackStreamSink sink = {&BoltConnection_send_chunks, connection, BOLT_MAX_CHUNK_SIZE};
+    int status = write_message(message, connection->protocol->check_writable_struct, state->tx_buffer, &sink,
+            connection->log);
+    if (status==BOLT_SUCCESS) {
+        status = push_to_transmission(state->tx_buffer, connection->tx_buffer);
+    }
     if (status==BOLT_SUCCESS) {
-        push_to_transmission(state->tx_buffer, connection->tx_buffer);
         state->next_request_id += 1;
+        connection->messages_loaded += 1;
     }
     else {
         // Reset buffer to its previous state
@@ -253,6 +284,7 @@ int BoltProtocolV1_clear_load_run_request(struct BoltConnection* connection)
     struct BoltProtocolV1State* state = BoltProtocolV1_state(connection);
     BoltValue_format_as_String(BoltMessage_param(state->run_request, 0), "", 0);
     BoltValue_format_as_Dictionary(BoltMessage_param(state->run_request, 1), 0);
+    BoltRunEncoding_clear(&state->run_encoding);
     return BOLT_SUCCESS;
 }
 
@@ -265,6 +297,7 @@ int BoltProtocolV1_set_run_cypher(struct BoltConnection* connection, const char*
         struct BoltValue* params = BoltMessage_param(state->run_request, 1);
         BoltValue_format_as_String(statement, cypher, (int32_t) (cypher_size));
         BoltValue_format_as_Dictionary(params, n_parameter);
+        BoltRunEncoding_clear(&state->run_encoding);
         return BOLT_SUCCESS;
     }
 
@@ -280,9 +313,51 @@ struct BoltValue* BoltProtocolV1_set_run_cypher_parameter(struct BoltConnection*
     return BoltDictionary_value(params, index);
 }
 
+struct BoltWriter* BoltProtocolV1_run_parameter_writer(struct BoltConnection* connection)
+{
+    struct BoltProtocolV1State* state = BoltProtocolV1_state(connection);
+    BoltValue_format_as_Dictionary(BoltMessage_param(state->run_request, 1), 0);
+    BoltWriter_reset(state->run_encoding.writer);
+    // v2 extends the set of writable structures
+    state->run_encoding.writer->check_struct_type = connection->protocol->check_writable_struct;
+    state->run_encoding.parameters_written = 1;
+    state->run_encoding.parameters = NULL;
+    return state->run_encoding.writer;
+}
+
+int BoltProtocolV1_set_run_statement(struct BoltConnection* connection, const struct BoltStatement* statement,
+        int32_t n_parameter)
+{
+    struct BoltProtocolV1State* state = BoltProtocolV1_state(connection);
+    struct BoltValue* cypher = BoltMessage_param(state->run_request, 0);
+    // the encoded statement is sent instead, and decoded from it should the message be logged
+    BoltValue_format_as_String(cypher, "", 0);
+    BoltValue_format_as_Dictionary(BoltMessage_param(state->run_request, 1), n_parameter);
+    BoltRunEncoding_clear(&state->run_encoding);
+    state->run_encoding.statement = statement;
+    return BOLT_SUCCESS;
+}
+
+void BoltProtocolV1_shrink_buffers(struct BoltConnection* connection)
+{
+    struct BoltProtocolV1State* state = BoltProtocolV1_state(connection);
+    BoltBuffer_shrink(state->tx_buffer, INITIAL_TX_BUFFER_SIZE);
+    BoltBuffer_shrink(state->rx_buffer, INITIAL_RX_BUFFER_SIZE);
+}
+
+int BoltProtocolV1_set_run_encoded_parameters(struct BoltConnection* connection, const char* data, int32_t size)
+{
+    struct BoltProtocolV1State* state = BoltProtocolV1_state(connection);
+    TRY(BoltRunEncoding_set_parameters(&state->run_encoding, connection->protocol->check_writable_struct, data,
+            size));
+    BoltValue_format_as_Dictionary(BoltMessage_param(state->run_request, 1), 0);
+    return BOLT_SUCCESS;
+}
+
 int BoltProtocolV1_load_run_request(struct BoltConnection* connection)
 {
     struct BoltProtocolV1State* state = BoltProtocolV1_state(connection);
+    TRY(BoltRunEncoding_apply(&state->run_encoding, state->run_request));
     TRY(BoltProtocolV1_load_message(connection, state->run_request, 0));
     return BOLT_SUCCESS;
 }
@@ -450,12 +525,13 @@ int16_t BoltProtocolV1_last_data_type(struct BoltConnection* connection)
     return state->data_type;
 }
 
-struct BoltProtocolV1State* BoltProtocolV1_create_state()
+struct BoltProtocolV1State* BoltProtocolV1_create_state(struct BoltBufferPool* buffer_pool)
 {
     struct BoltProtocolV1State* state = BoltMem_allocate(sizeof(struct BoltProtocolV1State));
 
-    state->tx_buffer = BoltBuffer_create(INITIAL_TX_BUFFER_SIZE);
-    state->rx_buffer = BoltBuffer_create(INITIAL_RX_BUFFER_SIZE);
+    state->buffer_pool = buffer_pool;
+    state->tx_buffer = BoltBufferPool_acquire(buffer_pool, INITIAL_TX_BUFFER_SIZE);
+    state->rx_buffer = BoltBufferPool_acquire(buffer_pool, INITIAL_RX_BUFFER_SIZE);
 
     state->server = BoltMem_allocate(MAX_SERVER_SIZE);
     memset(state->server, 0, MAX_SERVER_SIZE);
@@ -471,6 +547,8 @@ struct BoltProtocolV1State* BoltProtocolV1_create_state()
     state->record_counter = 0;
 
     state->run_request = create_run_message("", 0, 0);
+    state->run_encoding.writer = BoltWriter_create_with_check(&BoltProtocolV1_check_writable_struct_signature);
+    BoltRunEncoding_clear(&state->run_encoding);
     state->begin_request = create_run_message("BEGIN", 5, 0);
     state->commit_request = create_run_message("COMMIT", 6, 0);
     state->rollback_request = create_run_message("ROLLBACK", 8, 0);
@@ -490,10 +568,11 @@ void BoltProtocolV1_destroy_state(struct BoltProtocolV1State* state)
 {
     if (state==NULL) return;
 
-    BoltBuffer_destroy(state->tx_buffer);
-    BoltBuffer_destroy(state->rx_buffer);
+    BoltBufferPool_release(state->buffer_pool, state->tx_buffer);
+    BoltBufferPool_release(state->buffer_pool, state->rx_buffer);
 
     BoltMessage_destroy(state->run_request);
+    BoltWriter_destroy(state->run_encoding.writer);
     BoltMessage_destroy(state->begin_request);
     BoltMessage_destroy(state->commit_request);
     BoltMessage_destroy(state->rollback_request);
@@ -537,8 +616,10 @@ int BoltProtocolV1_unload(struct BoltConnection* connection)
             size = marker & 0x0F;
     BoltValue_format_as_List(state->data, size);
     for (int i = 0; i<size; i++) {
-        TRY(unload(connection->protocol->check_readable_struct, state->rx_buffer, BoltList_value(state->data, i),
-                connection->log));
+        TRY(unload_lazy(connection->protocol->check_readable_struct,
+                connection->lazy_decoding ? connection->protocol->check_lazy_struct : NULL,
+                connection->packed_structures ? connection->protocol->check_packed_struct : NULL,
+                connection->packed_lists, state->rx_buffer, BoltList_value(state->data, i), connection->log));
     }
     if (code==BOLT_V1_RECORD) {
         if (state->record_counter<MAX_LOGGED_RECORDS) {
@@ -696,8 +777,11 @@ int BoltProtocolV1_fetch(struct BoltConnection* connection, BoltRequest request_
         uint16_t chunk_size = char_to_uint16be(header);
         BoltBuffer_compact(state->rx_buffer);
         while (chunk_size!=0) {
-            status = BoltConnection_receive(connection, BoltBuffer_load_pointer(state->rx_buffer, chunk_size),
-                    chunk_size);
+            char* target = BoltBuffer_load_pointer(state->rx_buffer, chunk_size);
+            if (target==NULL) {
+                return BOLT_OUT_OF_MEMORY;
+            }
+            status = BoltConnection_receive(connection, target, chunk_size);
             if (status!=BOLT_SUCCESS) {
                 return -1;
             }
@@ -709,7 +793,11 @@ int BoltProtocolV1_fetch(struct BoltConnection* connection, BoltRequest request_
         }
         response_id = state->response_counter;
         TRY(BoltProtocolV1_unload(connection));
-        if (state->data_type!=BOLT_V1_RECORD) {
+        BoltAtomic_increment(&connection->metrics->messages_received);
+        if (state->data_type==BOLT_V1_RECORD) {
+            BoltAtomic_increment(&connection->metrics->records_received);
+        }
+        else {
             state->response_counter += 1;
 
             // Clean existing metadata
@@ -757,17 +845,19 @@ int BoltProtocolV1_goodbye_noop(struct BoltConnection* connection)
     return BOLT_SUCCESS;
 }
 
-struct BoltProtocol* BoltProtocolV1_create_protocol()
+struct BoltProtocol* BoltProtocolV1_create_protocol(struct BoltBufferPool* buffer_pool)
 {
     struct BoltProtocol* protocol = BoltMem_allocate(sizeof(struct BoltProtocol));
 
-    protocol->proto_state = BoltProtocolV1_create_state();
+    protocol->proto_state = BoltProtocolV1_create_state(buffer_pool);
 
     protocol->message_name = &BoltProtocolV1_message_name;
     protocol->structure_name = &BoltProtocolV1_structure_name;
 
     protocol->check_readable_struct = &BoltProtocolV1_check_readable_struct_signature;
     protocol->check_writable_struct = &BoltProtocolV1_check_writable_struct_signature;
+    protocol->check_lazy_struct = &BoltProtocolV1_check_lazy_struct_signature;
+    protocol->check_packed_struct = NULL;
 
     protocol->init = &BoltProtocolV1_init;
     protocol->goodbye = &BoltProtocolV1_goodbye_noop;
@@ -775,6 +865,10 @@ struct BoltProtocol* BoltProtocolV1_create_protocol()
     protocol->clear_run = &BoltProtocolV1_clear_load_run_request;
     protocol->set_run_cypher = &BoltProtocolV1_set_run_cypher;
     protocol->set_run_cypher_parameter = &BoltProtocolV1_set_run_cypher_parameter;
+    protocol->run_parameter_writer = &BoltProtocolV1_run_parameter_writer;
+    protocol->set_run_statement = &BoltProtocolV1_set_run_statement;
+    protocol->set_run_encoded_parameters = &BoltProtocolV1_set_run_encoded_parameters;
+    protocol->shrink_buffers = &BoltProtocolV1_shrink_buffers;
     protocol->set_run_bookmark = &BoltProtocolV1_set_tx_bookmark_ignore;
     protocol->set_run_tx_timeout = &BoltProtocolV1_set_tx_timeout_unsupported;
     protocol->set_run_tx_metadata = &BoltProtocolV1_set_tx_metadata_unsupported;
@@ -821,3 +915,39 @@ void BoltProtocolV1_destroy_protocol(struct BoltProtocol* protocol)
 
     BoltMem_deallocate(protocol, sizeof(struct BoltProtocol));
 }
+
+void BoltProtocolV1_recycle_protocol(struct BoltProtocol* protocol)
+{
+    struct BoltProtocolV1State* state = protocol->proto_state;
+
+    BoltBufferPool_release(state->buffer_pool, state->tx_buffer);
+    BoltBufferPool_release(state->buffer_pool, state->rx_buffer);
+    state->tx_buffer = NULL;
+    state->rx_buffer = NULL;
+
+    memset(state->server, 0, MAX_SERVER_SIZE);
+    BoltValue_format_as_Null(state->result_field_names);
+    BoltValue_format_as_Dictionary(state->result_metadata, 0);
+    if (state->failure_data!=NULL) {
+        BoltValue_destroy(state->failure_data);
+        state->failure_data = NULL;
+    }
+    memset(state->last_bookmark, 0, MAX_BOOKMARK_SIZE);
+
+    state->next_request_id = 0;
+    state->response_counter = 0;
+    state->record_counter = 0;
+
+    BoltValue_format_as_String(BoltMessage_param(state->run_request, 0), "", 0);
+    BoltValue_format_as_Dictionary(BoltMessage_param(state->run_request, 1), 0);
+    BoltRunEncoding_clear(&state->run_encoding);
+
+    state->data_type = BOLT_V1_RECORD;
+}
+
+void BoltProtocolV1_reuse_protocol(struct BoltProtocol* protocol)
+{
+    struct BoltProtocolV1State* state = protocol->proto_state;
+    state->tx_buffer = BoltBufferPool_acquire(state->buffer_pool, INITIAL_TX_BUFFER_SIZE);
+    state->rx_buffer = BoltBufferPool_acquire(state->buffer_pool, INITIAL_RX_BUFFER_SIZE);
+}
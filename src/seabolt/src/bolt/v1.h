@@ -26,6 +26,7 @@
 
 #include <stdint.h>
 
+#include "buffer-pool.h"
 #include "connection.h"
 #include "protocol.h"
 
@@ -50,6 +51,8 @@ struct BoltProtocolV1State {
     // These buffers exclude chunk headers.
     struct BoltBuffer* tx_buffer;
     struct BoltBuffer* rx_buffer;
+    /// Pool the buffers were taken from and are returned to, if any
+    struct BoltBufferPool* buffer_pool;
 
     /// The product name and version of the remote server
     char* server;
@@ -67,6 +70,8 @@ struct BoltProtocolV1State {
     unsigned long long record_counter;
 
     struct BoltMessage* run_request;
+    /// Pre-encoded statement and parameters of the next RUN
+    struct BoltRunEncoding run_encoding;
     struct BoltMessage* begin_request;
     struct BoltMessage* commit_request;
     struct BoltMessage* rollback_request;
@@ -84,12 +89,30 @@ int BoltProtocolV1_check_readable_struct_signature(int16_t signature);
 
 int BoltProtocolV1_check_writable_struct_signature(int16_t signature);
 
+int BoltProtocolV1_check_lazy_struct_signature(int16_t signature);
+
 const char* BoltProtocolV1_structure_name(int16_t code);
 
 struct BoltProtocolV1State* BoltProtocolV1_state(struct BoltConnection* connection);
 
-struct BoltProtocol* BoltProtocolV1_create_protocol();
+struct BoltProtocol* BoltProtocolV1_create_protocol(struct BoltBufferPool* buffer_pool);
 
 void BoltProtocolV1_destroy_protocol(struct BoltProtocol* protocol);
 
+/**
+ * Prepares the protocol of a closed connection for reuse, by returning its buffers to the pool and forgetting
+ * everything learned from the server.
+ *
+ * @param protocol
+ */
+void BoltProtocolV1_recycle_protocol(struct BoltProtocol* protocol);
+
+/**
+ * Takes the buffers of a protocol recycled by \ref BoltProtocolV1_recycle_protocol back from the pool, so it can
+ * serve a newly opened connection negotiating the same version.
+ *
+ * @param protocol
+ */
+void BoltProtocolV1_reuse_protocol(struct BoltProtocol* protocol);
+
 #endif // SEABOLT_PROTOCOL_V1
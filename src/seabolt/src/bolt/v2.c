@@ -64,6 +64,24 @@ int BoltProtocolV2_check_writable_struct_signature(int16_t signature)
     return 0;
 }
 
+int BoltProtocolV2_check_packed_struct_signature(int16_t signature)
+{
+    // Zoned date times are left out, as their zone id is a string
+    switch (signature) {
+    case BOLT_V2_POINT_2D:
+    case BOLT_V2_POINT_3D:
+    case BOLT_V2_LOCAL_DATE:
+    case BOLT_V2_LOCAL_DATE_TIME:
+    case BOLT_V2_LOCAL_TIME:
+    case BOLT_V2_OFFSET_TIME:
+    case BOLT_V2_OFFSET_DATE_TIME:
+    case BOLT_V2_DURATION:
+        return 1;
+    }
+
+    return 0;
+}
+
 const char* BoltProtocolV2_structure_name(int16_t code)
 {
     switch (code) {
@@ -90,14 +108,15 @@ const char* BoltProtocolV2_structure_name(int16_t code)
     }
 }
 
-struct BoltProtocol* BoltProtocolV2_create_protocol()
+struct BoltProtocol* BoltProtocolV2_create_protocol(struct BoltBufferPool* buffer_pool)
 {
-    struct BoltProtocol* v1_protocol = BoltProtocolV1_create_protocol();
+    struct BoltProtocol* v1_protocol = BoltProtocolV1_create_protocol(buffer_pool);
 
     // Overrides for new structure types
     v1_protocol->structure_name = &BoltProtocolV2_structure_name;
     v1_protocol->check_writable_struct = &BoltProtocolV2_check_writable_struct_signature;
     v1_protocol->check_readable_struct = &BoltProtocolV2_check_readable_struct_signature;
+    v1_protocol->check_packed_struct = &BoltProtocolV2_check_packed_struct_signature;
 
     return v1_protocol;
 }
@@ -107,3 +126,13 @@ void BoltProtocolV2_destroy_protocol(struct BoltProtocol* protocol)
     BoltProtocolV1_destroy_protocol(protocol);
 }
 
+void BoltProtocolV2_recycle_protocol(struct BoltProtocol* protocol)
+{
+    BoltProtocolV1_recycle_protocol(protocol);
+}
+
+void BoltProtocolV2_reuse_protocol(struct BoltProtocol* protocol)
+{
+    BoltProtocolV1_reuse_protocol(protocol);
+}
+
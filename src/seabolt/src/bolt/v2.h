@@ -20,6 +20,8 @@
 #ifndef SEABOLT_ALL_V2_H
 #define SEABOLT_ALL_V2_H
 
+#include "buffer-pool.h"
+
 #define BOLT_V2_POINT_2D            'X'
 #define BOLT_V2_POINT_3D            'Y'
 #define BOLT_V2_LOCAL_DATE          'D'
@@ -30,8 +32,26 @@
 #define BOLT_V2_ZONED_DATE_TIME     'f'
 #define BOLT_V2_DURATION            'E'
 
-struct BoltProtocol* BoltProtocolV2_create_protocol();
+int BoltProtocolV2_check_packed_struct_signature(int16_t signature);
+
+struct BoltProtocol* BoltProtocolV2_create_protocol(struct BoltBufferPool* buffer_pool);
 
 void BoltProtocolV2_destroy_protocol(struct BoltProtocol* protocol);
 
+/**
+ * Prepares the protocol of a closed connection for reuse, by returning its buffers to the pool and forgetting
+ * everything learned from the server.
+ *
+ * @param protocol
+ */
+void BoltProtocolV2_recycle_protocol(struct BoltProtocol* protocol);
+
+/**
+ * Takes the buffers of a protocol recycled by \ref BoltProtocolV2_recycle_protocol back from the pool, so it can
+ * serve a newly opened connection negotiating the same version.
+ *
+ * @param protocol
+ */
+void BoltProtocolV2_reuse_protocol(struct BoltProtocol* protocol);
+
 #endif //SEABOLT_ALL_V2_H
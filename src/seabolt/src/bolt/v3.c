@@ -17,13 +17,20 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_PROTOCOL
+
 #include "bolt-private.h"
+#include "atomic.h"
+#include "buffer-pool.h"
 #include "connection-private.h"
 #include "log-private.h"
 #include "mem.h"
+#include "packstream.h"
 #include "protocol.h"
+#include "statement-private.h"
 #include "v3.h"
 #include "values-private.h"
+#include "writer-private.h"
 
 #define MASK "********"
 #define MASK_SIZE 8
@@ -71,6 +78,10 @@ struct BoltProtocolV3State {
     // These buffers exclude chunk headers.
     struct BoltBuffer* tx_buffer;
     struct BoltBuffer* rx_buffer;
+    /// Pool the buffers were taken from and are returned to, if any
+    struct BoltBufferPool* buffer_pool;
+    /// Decodes incoming messages chunk by chunk
+    struct PackStreamDecoder* decoder;
 
     /// The product name and version of the remote server
     char* server;
@@ -90,6 +101,8 @@ struct BoltProtocolV3State {
     unsigned long long record_counter;
 
     struct BoltMessage* run_request;
+    /// Pre-encoded statement and parameters of the next RUN
+    struct BoltRunEncoding run_encoding;
     struct BoltMessage* begin_request;
     struct BoltMessage* commit_request;
     struct BoltMessage* rollback_request;
@@ -167,6 +180,37 @@ int BoltProtocolV3_check_readable_struct_signature(int16_t signature)
     return 0;
 }
 
+int BoltProtocolV3_check_lazy_struct_signature(int16_t signature)
+{
+    switch (signature) {
+    case BOLT_V3_NODE:
+    case BOLT_V3_RELATIONSHIP:
+    case BOLT_V3_UNBOUND_RELATIONSHIP:
+    case BOLT_V3_PATH:
+        return 1;
+    }
+
+    return 0;
+}
+
+int BoltProtocolV3_check_packed_struct_signature(int16_t signature)
+{
+    // Zoned date times are left out, as their zone id is a string
+    switch (signature) {
+    case BOLT_V3_POINT_2D:
+    case BOLT_V3_POINT_3D:
+    case BOLT_V3_LOCAL_DATE:
+    case BOLT_V3_LOCAL_DATE_TIME:
+    case BOLT_V3_LOCAL_TIME:
+    case BOLT_V3_OFFSET_TIME:
+    case BOLT_V3_OFFSET_DATE_TIME:
+    case BOLT_V3_DURATION:
+        return 1;
+    }
+
+    return 0;
+}
+
 int BoltProtocolV3_check_writable_struct_signature(int16_t signature)
 {
     switch (signature) {
@@ -267,12 +311,14 @@ struct BoltProtocolV3State* BoltProtocolV3_state(struct BoltConnection* connecti
     return (struct BoltProtocolV3State*) (connection->protocol->proto_state);
 }
 
-struct BoltProtocolV3State* BoltProtocolV3_create_state()
+struct BoltProtocolV3State* BoltProtocolV3_create_state(struct BoltBufferPool* buffer_pool)
 {
     struct BoltProtocolV3State* state = BoltMem_allocate(sizeof(struct BoltProtocolV3State));
 
-    state->tx_buffer = BoltBuffer_create(INITIAL_TX_BUFFER_SIZE);
-    state->rx_buffer = BoltBuffer_create(INITIAL_RX_BUFFER_SIZE);
+    state->buffer_pool = buffer_pool;
+    state->tx_buffer = BoltBufferPool_acquire(buffer_pool, INITIAL_TX_BUFFER_SIZE);
+    state->rx_buffer = BoltBufferPool_acquire(buffer_pool, INITIAL_RX_BUFFER_SIZE);
+    state->decoder = PackStreamDecoder_create(&BoltProtocolV3_check_readable_struct_signature);
 
     state->server = BoltMem_allocate(MAX_SERVER_SIZE);
     memset(state->server, 0, MAX_SERVER_SIZE);
@@ -294,6 +340,8 @@ struct BoltProtocolV3State* BoltProtocolV3_create_state()
 
     state->run_request = BoltMessage_create(BOLT_V3_RUN, 3);
     _clear_run(state->run_request);
+    state->run_encoding.writer = BoltWriter_create_with_check(&BoltProtocolV3_check_writable_struct_signature);
+    BoltRunEncoding_clear(&state->run_encoding);
 
     state->commit_request = BoltMessage_create(BOLT_V3_COMMIT, 0);
     state->rollback_request = BoltMessage_create(BOLT_V3_ROLLBACK, 0);
@@ -313,10 +361,12 @@ void BoltProtocolV3_destroy_state(struct BoltProtocolV3State* state)
 {
     if (state==NULL) return;
 
-    BoltBuffer_destroy(state->tx_buffer);
-    BoltBuffer_destroy(state->rx_buffer);
+    BoltBufferPool_release(state->buffer_pool, state->tx_buffer);
+    BoltBufferPool_release(state->buffer_pool, state->rx_buffer);
+    PackStreamDecoder_destroy(state->decoder);
 
     BoltMessage_destroy(state->run_request);
+    BoltWriter_destroy(state->run_encoding.writer);
     BoltMessage_destroy(state->begin_request);
     BoltMessage_destroy(state->commit_request);
     BoltMessage_destroy(state->rollback_request);
@@ -344,17 +394,27 @@ int BoltProtocolV3_load_message(struct BoltConnection* connection, struct BoltMe
 {
     struct BoltProtocolV3State* state = BoltProtocolV3_state(connection);
 
-    if (!quiet) {
+    if (!quiet && connection->log!=NULL && connection->log->debug_enabled) {
+        struct BoltValue* decoded = BoltMessage_decode_fields(message, connection->protocol->check_writable_struct,
+                connection->log);
         BoltLog_message(connection->log, BoltConnection_id(connection), "C", state->next_request_id, message->code,
-                message->fields, connection->protocol->structure_name, connection->protocol->message_name);
+                decoded!=NULL ? decoded : message->fields, connection->protocol->structure_name,
+                connection->protocol->message_name);
+        BoltValue_destroy(decoded);
     }
 
     int prev_cursor = state->tx_buffer->cursor;
     int prev_extent = state->tx_buffer->extent;
-    int status = write_message(message, connection->protocol->check_writable_struct, state->tx_buffer, connection->log);
+    // Large messages are sent chunk by chunk while being encoded rather than buffered whole
+    struct PackStreamSink sink = {&BoltConnection_send_chunks, connection, BOLT_MAX_CHUNK_SIZE};
+    int status = write_message(message, connection->protocol->check_writable_struct, state->tx_buffer, &sink,
+            connection->log);
+    if (status==BOLT_SUCCESS) {
+        status = push_to_transmission(state->tx_buffer, connection->tx_buffer);
+    }
     if (status==BOLT_SUCCESS) {
-        push_to_transmission(state->tx_buffer, connection->tx_buffer);
         state->next_request_id += 1;
+        connection->messages_loaded += 1;
     }
     else {
         // Reset buffer to its previous state
@@ -612,6 +672,7 @@ int BoltProtocolV3_load_rollback_tx(struct BoltConnection* connection)
 int BoltProtocolV3_clear_run(struct BoltConnection* connection)
 {
     struct BoltProtocolV3State* state = BoltProtocolV3_state(connection);
+    BoltRunEncoding_clear(&state->run_encoding);
     return _clear_run(state->run_request);
 }
 
@@ -646,6 +707,7 @@ int BoltProtocolV3_set_run_cypher(struct BoltConnection* connection, const char*
         struct BoltValue* params = BoltMessage_param(state->run_request, 1);
         BoltValue_format_as_String(statement, cypher, (int32_t) (cypher_size));
         BoltValue_format_as_Dictionary(params, n_parameter);
+        BoltRunEncoding_clear(&state->run_encoding);
         return BOLT_SUCCESS;
     }
 
@@ -662,11 +724,51 @@ BoltProtocolV3_set_run_cypher_parameter(struct BoltConnection* connection, int32
     return BoltDictionary_value(params, index);
 }
 
+struct BoltWriter* BoltProtocolV3_run_parameter_writer(struct BoltConnection* connection)
+{
+    struct BoltProtocolV3State* state = BoltProtocolV3_state(connection);
+    BoltValue_format_as_Dictionary(BoltMessage_param(state->run_request, 1), 0);
+    BoltWriter_reset(state->run_encoding.writer);
+    state->run_encoding.parameters_written = 1;
+    state->run_encoding.parameters = NULL;
+    return state->run_encoding.writer;
+}
+
+int BoltProtocolV3_set_run_statement(struct BoltConnection* connection, const struct BoltStatement* statement,
+        int32_t n_parameter)
+{
+    struct BoltProtocolV3State* state = BoltProtocolV3_state(connection);
+    struct BoltValue* cypher = BoltMessage_param(state->run_request, 0);
+    // the encoded statement is sent instead, and decoded from it should the message be logged
+    BoltValue_format_as_String(cypher, "", 0);
+    BoltValue_format_as_Dictionary(BoltMessage_param(state->run_request, 1), n_parameter);
+    BoltRunEncoding_clear(&state->run_encoding);
+    state->run_encoding.statement = statement;
+    return BOLT_SUCCESS;
+}
+
+void BoltProtocolV3_shrink_buffers(struct BoltConnection* connection)
+{
+    struct BoltProtocolV3State* state = BoltProtocolV3_state(connection);
+    BoltBuffer_shrink(state->tx_buffer, INITIAL_TX_BUFFER_SIZE);
+    BoltBuffer_shrink(state->rx_buffer, INITIAL_RX_BUFFER_SIZE);
+}
+
+int BoltProtocolV3_set_run_encoded_parameters(struct BoltConnection* connection, const char* data, int32_t size)
+{
+    struct BoltProtocolV3State* state = BoltProtocolV3_state(connection);
+    TRY(BoltRunEncoding_set_parameters(&state->run_encoding, connection->protocol->check_writable_struct, data,
+            size));
+    BoltValue_format_as_Dictionary(BoltMessage_param(state->run_request, 1), 0);
+    return BOLT_SUCCESS;
+}
+
 int BoltProtocolV3_load_run(struct BoltConnection* connection)
 {
     struct BoltProtocolV3State* state = BoltProtocolV3_state(connection);
     struct BoltValue* metadata = BoltMessage_param(state->run_request, 2);
     TRY(_set_access_mode(metadata, connection->access_mode));
+    TRY(BoltRunEncoding_apply(&state->run_encoding, state->run_request));
     TRY(BoltProtocolV3_load_message(connection, state->run_request, 0));
     return BOLT_SUCCESS;
 }
@@ -803,27 +905,14 @@ int16_t BoltProtocolV3_last_data_type(struct BoltConnection* connection)
 int BoltProtocolV3_unload(struct BoltConnection* connection)
 {
     struct BoltProtocolV3State* state = BoltProtocolV3_state(connection);
-    if (BoltBuffer_unloadable(state->rx_buffer)==0) {
-        return 0;
+    // The message fields have already been decoded into state->data by BoltProtocolV3_fetch
+    if (!PackStreamDecoder_done(state->decoder)) {
+        return PackStreamDecoder_message_code(state->decoder)==-1 ? 0 : BOLT_PROTOCOL_VIOLATION;
     }
 
-    uint8_t marker;
-    TRY(BoltBuffer_unload_u8(state->rx_buffer, &marker));
-    if (marker_type(marker)!=PACKSTREAM_STRUCTURE) {
-        return BOLT_PROTOCOL_VIOLATION;
-    }
-
-    uint8_t code;
-    TRY(BoltBuffer_unload_u8(state->rx_buffer, &code));
+    int16_t code = PackStreamDecoder_message_code(state->decoder);
     state->data_type = code;
 
-    int32_t
-            size = marker & 0x0F;
-    BoltValue_format_as_List(state->data, size);
-    for (int i = 0; i<size; i++) {
-        TRY(unload(connection->protocol->check_readable_struct, state->rx_buffer, BoltList_value(state->data, i),
-                connection->log));
-    }
     if (code==BOLT_V3_RECORD) {
         if (state->record_counter<MAX_LOGGED_RECORDS) {
             BoltLog_message(connection->log, BoltConnection_id(connection), "S", state->response_counter, code,
@@ -1016,12 +1105,24 @@ int BoltProtocolV3_fetch(struct BoltConnection* connection, BoltRequest request_
         }
         uint16_t chunk_size = char_to_uint16be(header);
         BoltBuffer_compact(state->rx_buffer);
+        PackStreamDecoder_reset_message(state->decoder, state->data);
+        PackStreamDecoder_set_lazy(state->decoder,
+                connection->lazy_decoding ? connection->protocol->check_lazy_struct : NULL);
+        PackStreamDecoder_set_pack_lists(state->decoder, connection->packed_lists);
+        PackStreamDecoder_set_packed(state->decoder,
+                connection->packed_structures ? connection->protocol->check_packed_struct : NULL);
         while (chunk_size!=0) {
-            status = BoltConnection_receive(connection, BoltBuffer_load_pointer(state->rx_buffer, chunk_size),
-                    chunk_size);
+            char* target = BoltBuffer_load_pointer(state->rx_buffer, chunk_size);
+            if (target==NULL) {
+                return BOLT_OUT_OF_MEMORY;
+            }
+            status = BoltConnection_receive(connection, target, chunk_size);
             if (status!=BOLT_SUCCESS) {
                 return -1;
             }
+            // Decode each chunk as it arrives, so that only the current chunk is ever buffered
+            TRY(PackStreamDecoder_feed(state->decoder, state->rx_buffer, connection->log));
+            BoltBuffer_compact(state->rx_buffer);
             status = BoltConnection_receive(connection, &header[0], 2);
             if (status!=BOLT_SUCCESS) {
                 return -1;
@@ -1030,7 +1131,11 @@ int BoltProtocolV3_fetch(struct BoltConnection* connection, BoltRequest request_
         }
         response_id = state->response_counter;
         TRY(BoltProtocolV3_unload(connection));
-        if (state->data_type!=BOLT_V3_RECORD) {
+        BoltAtomic_increment(&connection->metrics->messages_received);
+        if (state->data_type==BOLT_V3_RECORD) {
+            BoltAtomic_increment(&connection->metrics->records_received);
+        }
+        else {
             state->response_counter += 1;
 
             // Clean existing metadata
@@ -1050,17 +1155,19 @@ int BoltProtocolV3_fetch(struct BoltConnection* connection, BoltRequest request_
     return 1;
 }
 
-struct BoltProtocol* BoltProtocolV3_create_protocol()
+struct BoltProtocol* BoltProtocolV3_create_protocol(struct BoltBufferPool* buffer_pool)
 {
     struct BoltProtocol* protocol = BoltMem_allocate(sizeof(struct BoltProtocol));
 
-    protocol->proto_state = BoltProtocolV3_create_state();
+    protocol->proto_state = BoltProtocolV3_create_state(buffer_pool);
 
     protocol->message_name = &BoltProtocolV3_message_name;
     protocol->structure_name = &BoltProtocolV3_structure_name;
 
     protocol->check_readable_struct = &BoltProtocolV3_check_readable_struct_signature;
     protocol->check_writable_struct = &BoltProtocolV3_check_writable_struct_signature;
+    protocol->check_lazy_struct = &BoltProtocolV3_check_lazy_struct_signature;
+    protocol->check_packed_struct = &BoltProtocolV3_check_packed_struct_signature;
 
     protocol->init = &BoltProtocolV3_hello;
     protocol->goodbye = &BoltProtocolV3_goodbye;
@@ -1068,6 +1175,10 @@ struct BoltProtocol* BoltProtocolV3_create_protocol()
     protocol->clear_run = &BoltProtocolV3_clear_run;
     protocol->set_run_cypher = &BoltProtocolV3_set_run_cypher;
     protocol->set_run_cypher_parameter = &BoltProtocolV3_set_run_cypher_parameter;
+    protocol->run_parameter_writer = &BoltProtocolV3_run_parameter_writer;
+    protocol->set_run_statement = &BoltProtocolV3_set_run_statement;
+    protocol->set_run_encoded_parameters = &BoltProtocolV3_set_run_encoded_parameters;
+    protocol->shrink_buffers = &BoltProtocolV3_shrink_buffers;
     protocol->set_run_bookmark = &BoltProtocolV3_set_run_bookmark;
     protocol->set_run_tx_timeout = &BoltProtocolV3_set_run_tx_timeout;
     protocol->set_run_tx_metadata = &BoltProtocolV3_set_run_tx_metadata;
@@ -1114,3 +1225,40 @@ void BoltProtocolV3_destroy_protocol(struct BoltProtocol* protocol)
 
     BoltMem_deallocate(protocol, sizeof(struct BoltProtocol));
 }
+
+void BoltProtocolV3_recycle_protocol(struct BoltProtocol* protocol)
+{
+    struct BoltProtocolV3State* state = protocol->proto_state;
+
+    BoltBufferPool_release(state->buffer_pool, state->tx_buffer);
+    BoltBufferPool_release(state->buffer_pool, state->rx_buffer);
+    state->tx_buffer = NULL;
+    state->rx_buffer = NULL;
+
+    memset(state->server, 0, MAX_SERVER_SIZE);
+    memset(state->connection_id, 0, MAX_CONNECTION_ID_SIZE);
+    BoltValue_format_as_Null(state->result_field_names);
+    BoltValue_format_as_Dictionary(state->result_metadata, 0);
+    if (state->failure_data!=NULL) {
+        BoltValue_destroy(state->failure_data);
+        state->failure_data = NULL;
+    }
+    memset(state->last_bookmark, 0, MAX_BOOKMARK_SIZE);
+
+    state->next_request_id = 0;
+    state->response_counter = 0;
+    state->record_counter = 0;
+
+    _clear_begin_tx(state->begin_request);
+    _clear_run(state->run_request);
+    BoltRunEncoding_clear(&state->run_encoding);
+
+    state->data_type = BOLT_V3_RECORD;
+}
+
+void BoltProtocolV3_reuse_protocol(struct BoltProtocol* protocol)
+{
+    struct BoltProtocolV3State* state = protocol->proto_state;
+    state->tx_buffer = BoltBufferPool_acquire(state->buffer_pool, INITIAL_TX_BUFFER_SIZE);
+    state->rx_buffer = BoltBufferPool_acquire(state->buffer_pool, INITIAL_RX_BUFFER_SIZE);
+}
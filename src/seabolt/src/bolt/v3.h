@@ -19,6 +19,7 @@
 #ifndef SEABOLT_ALL_V3_H
 #define SEABOLT_ALL_V3_H
 
+#include "buffer-pool.h"
 #include "connection.h"
 
 #define BOLT_V3_HELLO 0x01
@@ -53,8 +54,28 @@
 
 void BoltProtocolV3_extract_metadata(struct BoltConnection* connection, struct BoltValue* metadata);
 
-struct BoltProtocol* BoltProtocolV3_create_protocol();
+int BoltProtocolV3_check_lazy_struct_signature(int16_t signature);
+
+int BoltProtocolV3_check_packed_struct_signature(int16_t signature);
+
+struct BoltProtocol* BoltProtocolV3_create_protocol(struct BoltBufferPool* buffer_pool);
 
 void BoltProtocolV3_destroy_protocol(struct BoltProtocol* protocol);
 
+/**
+ * Prepares the protocol of a closed connection for reuse, by returning its buffers to the pool and forgetting
+ * everything learned from the server.
+ *
+ * @param protocol
+ */
+void BoltProtocolV3_recycle_protocol(struct BoltProtocol* protocol);
+
+/**
+ * Takes the buffers of a protocol recycled by \ref BoltProtocolV3_recycle_protocol back from the pool, so it can
+ * serve a newly opened connection negotiating the same version.
+ *
+ * @param protocol
+ */
+void BoltProtocolV3_reuse_protocol(struct BoltProtocol* protocol);
+
 #endif //SEABOLT_ALL_V3_H
@@ -46,6 +46,8 @@ static const char HEX_DIGITS[] = {'0', '1', '2', '3', '4', '5', '6', '7',
 /**
  * For holding extended values that exceed the size of a single BoltValue.
  */
+struct BoltLazyFields;
+
 union BoltExtendedValue {
     void* as_ptr;
     char* as_char;
@@ -57,6 +59,21 @@ union BoltExtendedValue {
  * values that require more space than 128 bits, external memory is allocated and
  * a pointer to this is held in the inline data field.
  *
+ * Lists normally hold their elements as an external array of BoltValues. Packed
+ * lists instead set the subtype to the BoltType of their elements, and hold them
+ * as an external array of int64_t, double or char values.
+ *
+ * Shared values have BOLT_SHARED_FLAG set in their type, and hold a pointer to the
+ * reference count of their external data directly after the pointer to that data.
+ *
+ * Lazily decoded structures have BOLT_LAZY_FLAG set in their type, and hold a pointer
+ * to their encoded fields directly after the pointer to their fields. Fields that have
+ * not been decoded yet are null.
+ *
+ * Packed structures have BOLT_PACKED_FLAG set in their type, along with the float flag
+ * of each of their fields that holds a double rather than an int64_t. Their fields are
+ * held inline if there are at most two of them, and as an external array otherwise.
+ *
  * ```
  * +----+----+----+----+----+----+----+----+----+----+----+----+----+----+----+----+
  * |  type   | subtype |  (logical) size   |         (physical) data size          |
@@ -91,12 +108,62 @@ struct BoltValue {
         int64_t as_int64[2];
         double as_double[2];
         union BoltExtendedValue extended;
+        struct {
+            void* data;
+            volatile int64_t* references;
+        } shared;
+        struct {
+            void* data;
+            struct BoltLazyFields* fields;
+        } lazy;
     } data;
 
 };
 
+/// Set in the type of values whose external data is shared with other values
+#define BOLT_SHARED_FLAG 0x100
+
+/// Set in the type of structures whose fields are decoded on first access
+#define BOLT_LAZY_FLAG 0x200
+
+/// Set in the type of structures whose fields are packed
+#define BOLT_PACKED_FLAG 0x400
+
+/// Set in the type of packed structures whose field at _index_ is a float
+#define BOLT_PACKED_FLOAT_FLAG(index) (0x800 << (index))
+
+/// All the float flags of packed structures
+#define BOLT_PACKED_FLOAT_FLAGS 0x7800
+
+/// Lists of scalars with at least this many elements are decoded as packed lists
+#define PACKED_LIST_MIN_SIZE 16
+
 int BoltString_equals(struct BoltValue* value, const char* data, const size_t data_size);
 
+/**
+ * Makes the fields of the structure _value_, which must not have been accessed yet, decode from _fields_ when
+ * first accessed. The value takes ownership of _fields_.
+ *
+ * @param value
+ * @param fields
+ */
+void BoltStructure_set_lazy(struct BoltValue* value, struct BoltLazyFields* fields);
+
+/**
+ * @param value
+ * @return 1 if _value_ is a structure with fields that have not been decoded yet, 0 otherwise.
+ */
+int BoltValue_is_lazy(const struct BoltValue* value);
+
+/**
+ * Stores the scalar _element_ at _index_ of a packed list, which must be packed as the type of the element.
+ *
+ * @param value
+ * @param index
+ * @param element
+ */
+void BoltList_set_packed(struct BoltValue* value, int32_t index, const struct BoltValue* element);
+
 /**
  * Write a textual representation of a BoltValue to a FILE.
  *
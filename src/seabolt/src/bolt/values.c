@@ -17,11 +17,14 @@
  * limitations under the License.
  */
 
+#define BOLT_MEM_TAG BOLT_MEMORY_VALUES
 
 #include "bolt-private.h"
 #include "values-private.h"
+#include "atomic.h"
 #include "connection-private.h"
-#include "mem.h"
+#include "packstream.h"
+#include "slab.h"
 #include "protocol.h"
 
 #define STRING_QUOTE '"'
@@ -29,17 +32,44 @@
 
 #define IS_PRINTABLE_ASCII(ch) ((ch) >= ' ' && (ch) <= '~')
 
+void _set_type(struct BoltValue* value, enum BoltType type, int16_t subtype, int32_t size)
+{
+    assert(((int) type)<0x80);
+    value->type = (char) (type);
+    value->subtype = subtype;
+    value->size = size;
+}
+
 /**
  * Clean up a value for reuse.
  *
- * This sets any nested values to null.
+ * This sets any nested values to null. Shared values drop their reference instead, and are
+ * left as an empty null unless it was the last one. Lazily decoded structures drop the fields
+ * they have not decoded, and packed structures have no nested values.
  *
  * @param value
  */
 void _recycle(struct BoltValue* value)
 {
+    if (BoltValue_is_lazy(value)) {
+        BoltLazyFields_destroy(value->data.lazy.fields);
+        value->data.lazy.fields = NULL;
+        value->type = (int16_t) BoltValue_type(value);
+    }
+    if (BoltValue_is_shared(value)) {
+        volatile int64_t* references = value->data.shared.references;
+        value->type = (int16_t) BoltValue_type(value);
+        value->data.shared.references = NULL;
+        if (BoltAtomic_decrement(references)>0) {
+            value->data.extended.as_ptr = NULL;
+            value->data_size = 0;
+            _set_type(value, BOLT_NULL, 0, 0);
+            return;
+        }
+        BoltSlab_deallocate((void*) references, sizeof(int64_t));
+    }
     enum BoltType type = BoltValue_type(value);
-    if (type==BOLT_LIST || type==BOLT_STRUCTURE) {
+    if ((type==BOLT_LIST && value->subtype==BOLT_NULL) || (type==BOLT_STRUCTURE && !BoltStructure_is_packed(value))) {
         for (long i = 0; i<value->size; i++) {
             BoltValue_format_as_Null(&value->data.extended.as_value[i]);
         }
@@ -65,7 +95,7 @@ void _resize(struct BoltValue* value, int32_t size, int multiplier)
         size_t unit_size = sizeof(struct BoltValue);
         size_t new_data_size = multiplier*unit_size*size;
         size_t old_data_size = (size_t) value->data_size;
-        value->data.extended.as_ptr = BoltMem_adjust(value->data.extended.as_ptr, (size_t) value->data_size,
+        value->data.extended.as_ptr = BoltSlab_adjust(value->data.extended.as_ptr, (size_t) value->data_size,
                 new_data_size);
         value->data_size = new_data_size;
         // grow logically
@@ -80,7 +110,7 @@ void _resize(struct BoltValue* value, int32_t size, int multiplier)
         value->size = size;
         // shrink physically
         size_t new_data_size = multiplier*sizeof_n(struct BoltValue, size);
-        value->data.extended.as_ptr = BoltMem_adjust(value->data.extended.as_ptr, (size_t) value->data_size,
+        value->data.extended.as_ptr = BoltSlab_adjust(value->data.extended.as_ptr, (size_t) value->data_size,
                 new_data_size);
         value->data_size = new_data_size;
     }
@@ -89,19 +119,95 @@ void _resize(struct BoltValue* value, int32_t size, int multiplier)
     }
 }
 
-void _set_type(struct BoltValue* value, enum BoltType type, int16_t subtype, int32_t size)
+size_t _packed_element_size(enum BoltType type)
 {
-    assert(((int) type)<0x80);
-    value->type = (char) (type);
-    value->subtype = subtype;
-    value->size = size;
+    switch (type) {
+    case BOLT_INTEGER:
+        return sizeof(int64_t);
+    case BOLT_FLOAT:
+        return sizeof(double);
+    case BOLT_BOOLEAN:
+        return sizeof(char);
+    default:
+        assert(0);
+        return 0;
+    }
+}
+
+/**
+ * Convert a packed list to an ordinary list of BoltValues holding the same elements.
+ *
+ * @param value
+ */
+void _unpack(struct BoltValue* value)
+{
+    const enum BoltType type = (enum BoltType) value->subtype;
+    const int32_t size = value->size;
+    void* data = value->data.extended.as_ptr;
+    const size_t data_size = (size_t) value->data_size;
+
+    value->data.extended.as_ptr = NULL;
+    value->data_size = 0;
+    _set_type(value, BOLT_LIST, BOLT_NULL, 0);
+    _resize(value, size, 1);
+    for (int32_t i = 0; i<size; i++) {
+        struct BoltValue* element = &value->data.extended.as_value[i];
+        switch (type) {
+        case BOLT_INTEGER:
+            BoltValue_format_as_Integer(element, ((int64_t*) data)[i]);
+            break;
+        case BOLT_FLOAT:
+            BoltValue_format_as_Float(element, ((double*) data)[i]);
+            break;
+        default:
+            BoltValue_format_as_Boolean(element, ((char*) data)[i]);
+            break;
+        }
+    }
+    BoltSlab_deallocate(data, data_size);
+}
+
+/**
+ * Returns the fields of a packed structure, as int64_t values or the bits of double values.
+ *
+ * @param value
+ */
+int64_t* _packed_fields(const struct BoltValue* value)
+{
+    return value->size<=2 ? (int64_t*) value->data.as_int64 : (int64_t*) value->data.extended.as_ptr;
+}
+
+/**
+ * Convert a packed structure to an ordinary structure of BoltValues holding the same fields.
+ *
+ * @param value
+ */
+void _unpack_structure(struct BoltValue* value)
+{
+    const int16_t flags = value->type;
+    const int32_t size = value->size;
+    int64_t fields[BOLT_PACKED_STRUCTURE_MAX_SIZE];
+    memcpy(fields, _packed_fields(value), sizeof_n(int64_t, size));
+
+    BoltValue_format_as_Structure(value, value->subtype, size);
+    for (int32_t i = 0; i<size; i++) {
+        struct BoltValue* field = &value->data.extended.as_value[i];
+        if ((flags & BOLT_PACKED_FLOAT_FLAG(i))!=0) {
+            double x;
+            memcpy(&x, &fields[i], sizeof(x));
+            BoltValue_format_as_Float(field, x);
+        }
+        else {
+            BoltValue_format_as_Integer(field, fields[i]);
+        }
+    }
 }
 
 void
 _format(struct BoltValue* value, enum BoltType type, int16_t subtype, int32_t size, const void* data, size_t data_size)
 {
     _recycle(value);
-    value->data.extended.as_ptr = BoltMem_adjust(value->data.extended.as_ptr, (size_t) value->data_size, data_size);
+    value->data.extended.as_ptr = BoltSlab_adjust(value->data.extended.as_ptr, (size_t) value->data_size, data_size);
     value->data_size = data_size;
     if (data!=NULL && data_size>0) {
         memcpy(value->data.extended.as_char, data, data_size);
@@ -112,13 +218,34 @@ _format(struct BoltValue* value, enum BoltType type, int16_t subtype, int32_t si
 void _format_as_structure(struct BoltValue* value, enum BoltType type, int16_t code, int32_t size)
 {
     _recycle(value);
-    value->data.extended.as_ptr = BoltMem_adjust(value->data.extended.as_ptr, (size_t) value->data_size,
+    value->data.extended.as_ptr = BoltSlab_adjust(value->data.extended.as_ptr, (size_t) value->data_size,
             sizeof_n(struct BoltValue, size));
     value->data_size = sizeof_n(struct BoltValue, size);
     memset(value->data.extended.as_char, 0, (size_t) value->data_size);
     _set_type(value, type, code, size);
 }
 
+/**
+ * Decode the fields of a lazily decoded structure until the first _count_ of them are decoded. The
+ * structure becomes an ordinary one once all of its fields are decoded.
+ *
+ * Decoding does not change what the value represents, so it is also done for values accessed through
+ * const pointers.
+ *
+ * @param value
+ * @param count
+ */
+void _decode_fields(const struct BoltValue* value, int32_t count)
+{
+    struct BoltValue* structure = (struct BoltValue*) value;
+    struct BoltLazyFields* fields = structure->data.lazy.fields;
+    if (BoltLazyFields_decode(fields, structure->data.extended.as_value, count)==structure->size) {
+        BoltLazyFields_destroy(fields);
+        structure->data.lazy.fields = NULL;
+        structure->type = (int16_t) BoltValue_type(structure);
+    }
+}
+
 void _write_escaped_code_point(FILE* file, const uint32_t ch)
 {
     if (ch<0x10000) {
@@ -189,7 +316,7 @@ void _write_string(FILE* file, const char* data, size_t size)
 struct BoltValue* BoltValue_create()
 {
     size_t size = sizeof(struct BoltValue);
-    struct BoltValue* value = (struct BoltValue*) BoltMem_allocate(size);
+    struct BoltValue* value = (struct BoltValue*) BoltSlab_allocate(size);
     _set_type(value, BOLT_NULL, 0, 0);
     value->data_size = 0;
     value->data.as_int64[0] = 0;
@@ -205,7 +332,7 @@ void BoltValue_destroy(struct BoltValue* value)
     }
 
     BoltValue_format_as_Null(value);
-    BoltMem_deallocate(value, sizeof(struct BoltValue));
+    BoltSlab_deallocate(value, sizeof(struct BoltValue));
 }
 
 struct BoltValue* BoltValue_duplicate(const struct BoltValue* value)
@@ -219,14 +346,16 @@ struct BoltValue* BoltValue_duplicate(const struct BoltValue* value)
     return duplicate;
 }
 
-void BoltValue_copy(struct BoltValue* dest, const struct BoltValue* src)
+/**
+ * Deep copy the top level of _src_ to _dest_, which must have been recycled. Nested values are
+ * copied with BoltValue_copy, so shared ones are referenced rather than copied.
+ *
+ * @param dest
+ * @param src
+ */
+void _copy(struct BoltValue* dest, const struct BoltValue* src)
 {
-    assert(src!=NULL);
-    assert(dest!=NULL);
-
-    _recycle(dest);
-
-    switch (src->type) {
+    switch (BoltValue_type(src)) {
     case BOLT_NULL:
         BoltValue_format_as_Null(dest);
         break;
@@ -253,6 +382,11 @@ void BoltValue_copy(struct BoltValue* dest, const struct BoltValue* src)
         }
         break;
     case BOLT_LIST:
+        if (src->subtype!=BOLT_NULL) {
+            BoltValue_format_as_packed_List(dest, (enum BoltType) src->subtype, src->size);
+            memcpy(dest->data.extended.as_ptr, src->data.extended.as_ptr, (size_t) src->data_size);
+            break;
+        }
         BoltValue_format_as_List(dest, src->size);
         for (int i = 0; i<src->size; i++) {
             struct BoltValue* dest_element = BoltList_value(dest, i);
@@ -263,19 +397,132 @@ void BoltValue_copy(struct BoltValue* dest, const struct BoltValue* src)
     case BOLT_BYTES:
         BoltValue_format_as_Bytes(dest, BoltBytes_get_all(src), src->size);
         break;
-    case BOLT_STRUCTURE:
+    case BOLT_STRUCTURE: {
+        if (BoltStructure_is_packed(src)) {
+            BoltValue_format_as_packed_Structure(dest, src->subtype, src->size);
+            memcpy(_packed_fields(dest), _packed_fields(src), sizeof_n(int64_t, src->size));
+            dest->type = (int16_t) (dest->type | (src->type & BOLT_PACKED_FLOAT_FLAGS));
+            break;
+        }
+        // Lazily decoded structures are copied as they are, with the fields still to be decoded left encoded
+        int32_t decoded = BoltValue_is_lazy(src) ? BoltLazyFields_decoded(src->data.lazy.fields) : src->size;
         BoltValue_format_as_Structure(dest, src->subtype, src->size);
-        for (int i = 0; i<src->size; i++) {
+        for (int i = 0; i<decoded; i++) {
             struct BoltValue* dest_element = BoltStructure_value(dest, i);
 
-            BoltValue_copy(dest_element, BoltStructure_value(src, i));
+            BoltValue_copy(dest_element, &src->data.extended.as_value[i]);
+        }
+        if (BoltValue_is_lazy(src)) {
+            BoltStructure_set_lazy(dest, BoltLazyFields_duplicate(src->data.lazy.fields));
         }
         break;
+    }
     default:
         assert(0);
     }
 }
 
+void BoltValue_copy(struct BoltValue* dest, const struct BoltValue* src)
+{
+    assert(src!=NULL);
+    assert(dest!=NULL);
+
+    if (BoltValue_is_shared(src)) {
+        if (dest!=src) {
+            BoltAtomic_increment(src->data.shared.references);
+            BoltValue_format_as_Null(dest);
+            memcpy(dest, src, sizeof(struct BoltValue));
+        }
+        return;
+    }
+
+    _recycle(dest);
+    _copy(dest, src);
+}
+
+void BoltValue_share(struct BoltValue* value)
+{
+    if (BoltValue_is_shared(value)) {
+        return;
+    }
+
+    switch (BoltValue_type(value)) {
+    case BOLT_LIST:
+        if (value->subtype!=BOLT_NULL) {
+            // Unpacking changes the value in place, so shared lists are never packed
+            _unpack(value);
+        }
+        for (int32_t i = 0; i<value->size; i++) {
+            BoltValue_share(&value->data.extended.as_value[i]);
+        }
+        break;
+    case BOLT_STRUCTURE:
+        // Shared values are immutable, so lazily decoded fields are decoded up front
+        if (BoltValue_is_lazy(value)) {
+            _decode_fields(value, value->size);
+        }
+        // Unpacking changes the value in place, so shared structures are never packed
+        if (BoltStructure_is_packed(value)) {
+            _unpack_structure(value);
+        }
+        for (int32_t i = 0; i<value->size; i++) {
+            BoltValue_share(&value->data.extended.as_value[i]);
+        }
+        break;
+    case BOLT_DICTIONARY:
+        for (int32_t i = 0; i<2*value->size; i++) {
+            BoltValue_share(&value->data.extended.as_value[i]);
+        }
+        break;
+    case BOLT_STRING:
+    case BOLT_BYTES:
+        break;
+    default:
+        return;
+    }
+
+    // Values without external data are as cheap to copy as to reference
+    if (value->data_size==0) {
+        return;
+    }
+    volatile int64_t* references = (volatile int64_t*) BoltSlab_allocate(sizeof(int64_t));
+    *references = 1;
+    value->data.shared.references = references;
+    value->type = (int16_t) (value->type | BOLT_SHARED_FLAG);
+}
+
+void BoltValue_unshare(struct BoltValue* value)
+{
+    if (!BoltValue_is_shared(value)) {
+        return;
+    }
+
+    volatile int64_t* references = value->data.shared.references;
+    if (*references==1) {
+        // This is the only reference left, so the data can be taken over as it is
+        BoltSlab_deallocate((void*) references, sizeof(int64_t));
+        value->data.shared.references = NULL;
+        value->type = (int16_t) BoltValue_type(value);
+        return;
+    }
+
+    struct BoltValue copy;
+    memset(&copy, 0, sizeof(copy));
+    _copy(&copy, value);
+    BoltValue_format_as_Null(value);
+    memcpy(value, &copy, sizeof(struct BoltValue));
+}
+
+int BoltValue_is_shared(const struct BoltValue* value)
+{
+    return (value->type & BOLT_SHARED_FLAG)!=0;
+}
+
+int BoltValue_is_lazy(const struct BoltValue* value)
+{
+    return (value->type & BOLT_LAZY_FLAG)!=0;
+}
+
 int32_t BoltValue_size(const struct BoltValue* value)
 {
     return value->size;
@@ -283,7 +530,8 @@ int32_t BoltValue_size(const struct BoltValue* value)
 
 enum BoltType BoltValue_type(const struct BoltValue* value)
 {
-    return (enum BoltType) (value->type);
+    return (enum BoltType) (value->type
+            & ~(BOLT_SHARED_FLAG | BOLT_LAZY_FLAG | BOLT_PACKED_FLAG | BOLT_PACKED_FLOAT_FLAGS));
 }
 
 int32_t
@@ -362,9 +610,9 @@ void BoltValue_format_as_String(struct BoltValue* value, const char* data, int32
             memcpy(value->data.as_char, data, (size_t) (length));
         }
     }
-    else if (BoltValue_type(value)==BOLT_STRING) {
+    else if (BoltValue_type(value)==BOLT_STRING && !BoltValue_is_shared(value)) {
         // This is already a UTF-8 string so we can just tweak the value
-        value->data.extended.as_ptr = BoltMem_adjust(value->data.extended.as_ptr, (size_t) value->data_size, data_size);
+        value->data.extended.as_ptr = BoltSlab_adjust(value->data.extended.as_ptr, (size_t) value->data_size, data_size);
         value->data_size = data_size;
         value->size = length;
         if (data!=NULL) {
@@ -402,14 +650,15 @@ int BoltString_equals(struct BoltValue* value, const char* data, const size_t da
 
 void BoltValue_format_as_Dictionary(struct BoltValue* value, int32_t length)
 {
-    if (value->type==BOLT_DICTIONARY) {
+    if (BoltValue_type(value)==BOLT_DICTIONARY) {
+        BoltValue_unshare(value);
         _resize(value, length, 2);
     }
     else {
         size_t unit_size = sizeof(struct BoltValue);
         size_t data_size = 2*unit_size*length;
         _recycle(value);
-        value->data.extended.as_ptr = BoltMem_adjust(value->data.extended.as_ptr, (size_t) value->data_size, data_size);
+        value->data.extended.as_ptr = BoltSlab_adjust(value->data.extended.as_ptr, (size_t) value->data_size, data_size);
         value->data_size = data_size;
         memset(value->data.extended.as_char, 0, data_size);
         _set_type(value, BOLT_DICTIONARY, 0, length);
@@ -458,6 +707,7 @@ int32_t BoltDictionary_set_key(struct BoltValue* value, int32_t index, const cha
 {
     if (key_size<=INT32_MAX) {
         assert(BoltValue_type(value)==BOLT_DICTIONARY);
+        BoltValue_unshare(value);
         BoltValue_format_as_String(&value->data.extended.as_value[2*index], key, (int32_t) key_size);
         return 0;
     }
@@ -484,13 +734,13 @@ struct BoltValue* BoltDictionary_value_by_key(const struct BoltValue* value, con
 
 void BoltValue_format_as_List(struct BoltValue* value, int32_t length)
 {
-    if (BoltValue_type(value)==BOLT_LIST) {
+    if (BoltValue_type(value)==BOLT_LIST && value->subtype==BOLT_NULL) {
         BoltList_resize(value, length);
     }
     else {
         size_t data_size = sizeof(struct BoltValue)*length;
         _recycle(value);
-        value->data.extended.as_ptr = BoltMem_adjust(value->data.extended.as_ptr, (size_t) value->data_size, data_size);
+        value->data.extended.as_ptr = BoltSlab_adjust(value->data.extended.as_ptr, (size_t) value->data_size, data_size);
         value->data_size = data_size;
         memset(value->data.extended.as_char, 0, data_size);
         _set_type(value, BOLT_LIST, 0, length);
@@ -500,15 +750,83 @@ void BoltValue_format_as_List(struct BoltValue* value, int32_t length)
 void BoltList_resize(struct BoltValue* value, int32_t size)
 {
     assert(BoltValue_type(value)==BOLT_LIST);
+    BoltValue_unshare(value);
+    if (value->subtype!=BOLT_NULL) {
+        const size_t element_size = _packed_element_size((enum BoltType) value->subtype);
+        const size_t old_data_size = (size_t) value->data_size;
+        const size_t new_data_size = sizeof_n(char, size)*element_size;
+        value->data.extended.as_ptr = BoltSlab_adjust(value->data.extended.as_ptr, old_data_size, new_data_size);
+        if (new_data_size>old_data_size) {
+            memset(value->data.extended.as_char+old_data_size, 0, new_data_size-old_data_size);
+        }
+        value->data_size = new_data_size;
+        value->size = size;
+        return;
+    }
     _resize(value, size, 1);
 }
 
 struct BoltValue* BoltList_value(const struct BoltValue* value, int32_t index)
 {
     assert(BoltValue_type(value)==BOLT_LIST);
+    if (value->subtype!=BOLT_NULL) {
+        // Packed lists have no BoltValues to hand out until they are unpacked
+        _unpack((struct BoltValue*) value);
+    }
     return &value->data.extended.as_value[index];
 }
 
+void BoltValue_format_as_packed_List(struct BoltValue* value, enum BoltType type, int32_t length)
+{
+    const size_t data_size = sizeof_n(char, length)*_packed_element_size(type);
+    _recycle(value);
+    value->data.extended.as_ptr = BoltSlab_adjust(value->data.extended.as_ptr, (size_t) value->data_size, data_size);
+    value->data_size = data_size;
+    memset(value->data.extended.as_char, 0, data_size);
+    _set_type(value, BOLT_LIST, (int16_t) type, length);
+}
+
+enum BoltType BoltList_packed_type(const struct BoltValue* value)
+{
+    assert(BoltValue_type(value)==BOLT_LIST);
+    return (enum BoltType) value->subtype;
+}
+
+int64_t* BoltList_integers(const struct BoltValue* value)
+{
+    assert(BoltValue_type(value)==BOLT_LIST);
+    return value->subtype==BOLT_INTEGER ? (int64_t*) value->data.extended.as_ptr : NULL;
+}
+
+double* BoltList_floats(const struct BoltValue* value)
+{
+    assert(BoltValue_type(value)==BOLT_LIST);
+    return value->subtype==BOLT_FLOAT ? (double*) value->data.extended.as_ptr : NULL;
+}
+
+char* BoltList_booleans(const struct BoltValue* value)
+{
+    assert(BoltValue_type(value)==BOLT_LIST);
+    return value->subtype==BOLT_BOOLEAN ? value->data.extended.as_char : NULL;
+}
+
+void BoltList_set_packed(struct BoltValue* value, int32_t index, const struct BoltValue* element)
+{
+    assert(BoltValue_type(value)==BOLT_LIST && (enum BoltType) value->subtype==BoltValue_type(element));
+    assert(!BoltValue_is_shared(value));
+    switch (BoltValue_type(element)) {
+    case BOLT_INTEGER:
+        ((int64_t*) value->data.extended.as_ptr)[index] = BoltInteger_get(element);
+        break;
+    case BOLT_FLOAT:
+        ((double*) value->data.extended.as_ptr)[index] = BoltFloat_get(element);
+        break;
+    default:
+        value->data.extended.as_char[index] = BoltBoolean_get(element);
+        break;
+    }
+}
+
 void BoltValue_format_as_Bytes(struct BoltValue* value, char* data, int32_t length)
 {
     if (length<=(int32_t) (sizeof(value->data)/sizeof(char))) {
@@ -549,9 +867,86 @@ int16_t BoltStructure_code(const struct BoltValue* value)
 struct BoltValue* BoltStructure_value(const struct BoltValue* value, int32_t index)
 {
     assert(BoltValue_type(value)==BOLT_STRUCTURE);
+    if (BoltValue_is_lazy(value)) {
+        _decode_fields(value, index+1);
+    }
+    if (BoltStructure_is_packed(value)) {
+        // Packed structures have no BoltValues to hand out until they are unpacked
+        _unpack_structure((struct BoltValue*) value);
+    }
     return &value->data.extended.as_value[index];
 }
 
+void BoltValue_format_as_packed_Structure(struct BoltValue* value, int16_t code, int32_t length)
+{
+    assert(length>=0 && length<=BOLT_PACKED_STRUCTURE_MAX_SIZE);
+    // Up to two fields fit inline
+    const size_t data_size = length<=2 ? 0 : sizeof_n(int64_t, length);
+    _recycle(value);
+    value->data.extended.as_ptr = BoltSlab_adjust(value->data.extended.as_ptr, (size_t) value->data_size, data_size);
+    value->data_size = data_size;
+    _set_type(value, BOLT_STRUCTURE, code, length);
+    memset(_packed_fields(value), 0, sizeof_n(int64_t, length));
+    value->type = (int16_t) (value->type | BOLT_PACKED_FLAG);
+}
+
+int BoltStructure_is_packed(const struct BoltValue* value)
+{
+    return (value->type & BOLT_PACKED_FLAG)!=0;
+}
+
+int64_t BoltStructure_integer(const struct BoltValue* value, int32_t index)
+{
+    assert(BoltValue_type(value)==BOLT_STRUCTURE);
+    if (BoltStructure_is_packed(value)) {
+        return (value->type & BOLT_PACKED_FLOAT_FLAG(index))==0 ? _packed_fields(value)[index] : 0;
+    }
+    const struct BoltValue* field = BoltStructure_value(value, index);
+    return BoltValue_type(field)==BOLT_INTEGER ? BoltInteger_get(field) : 0;
+}
+
+double BoltStructure_float(const struct BoltValue* value, int32_t index)
+{
+    assert(BoltValue_type(value)==BOLT_STRUCTURE);
+    if (BoltStructure_is_packed(value)) {
+        double x = 0.0;
+        if ((value->type & BOLT_PACKED_FLOAT_FLAG(index))!=0) {
+            memcpy(&x, &_packed_fields(value)[index], sizeof(x));
+        }
+        return x;
+    }
+    const struct BoltValue* field = BoltStructure_value(value, index);
+    return BoltValue_type(field)==BOLT_FLOAT ? BoltFloat_get(field) : 0.0;
+}
+
+void BoltStructure_set_integer(struct BoltValue* value, int32_t index, int64_t field)
+{
+    assert(BoltValue_type(value)==BOLT_STRUCTURE);
+    if (BoltStructure_is_packed(value)) {
+        _packed_fields(value)[index] = field;
+        value->type = (int16_t) (value->type & ~BOLT_PACKED_FLOAT_FLAG(index));
+        return;
+    }
+    BoltValue_format_as_Integer(BoltStructure_value(value, index), field);
+}
+
+void BoltStructure_set_float(struct BoltValue* value, int32_t index, double field)
+{
+    assert(BoltValue_type(value)==BOLT_STRUCTURE);
+    if (BoltStructure_is_packed(value)) {
+        memcpy(&_packed_fields(value)[index], &field, sizeof(field));
+        value->type = (int16_t) (value->type | BOLT_PACKED_FLOAT_FLAG(index));
+        return;
+    }
+    BoltValue_format_as_Float(BoltStructure_value(value, index), field);
+}
+
+void BoltStructure_set_lazy(struct BoltValue* value, struct BoltLazyFields* fields)
+{
+    value->data.lazy.fields = fields;
+    value->type = (int16_t) (value->type | BOLT_LAZY_FLAG);
+}
+
 int
 BoltValue_write(struct StringBuilder* builder, const struct BoltValue* value, name_resolver_func struct_name_resolver)
 {
@@ -602,6 +997,24 @@ BoltValue_write(struct StringBuilder* builder, const struct BoltValue* value, na
         StringBuilder_append(builder, "[");
         for (int i = 0; i<value->size; i++) {
             if (i>0) StringBuilder_append(builder, ", ");
+            if (value->subtype!=BOLT_NULL) {
+                // Written through a scalar copy, so that writing does not unpack the list
+                struct BoltValue element;
+                memset(&element, 0, sizeof(element));
+                switch (value->subtype) {
+                case BOLT_INTEGER:
+                    BoltValue_format_as_Integer(&element, BoltList_integers(value)[i]);
+                    break;
+                case BOLT_FLOAT:
+                    BoltValue_format_as_Float(&element, BoltList_floats(value)[i]);
+                    break;
+                default:
+                    BoltValue_format_as_Boolean(&element, BoltList_booleans(value)[i]);
+                    break;
+                }
+                BoltValue_write(builder, &element, struct_name_resolver);
+                continue;
+            }
             BoltValue_write(builder, BoltList_value(value, i), struct_name_resolver);
         }
         StringBuilder_append(builder, "]");
@@ -629,6 +1042,19 @@ BoltValue_write(struct StringBuilder* builder, const struct BoltValue* value, na
         StringBuilder_append(builder, "(");
         for (int i = 0; i<value->size; i++) {
             if (i>0) StringBuilder_append(builder, ", ");
+            if (BoltStructure_is_packed(value)) {
+                // Written through a scalar copy, so that writing does not unpack the structure
+                struct BoltValue field;
+                memset(&field, 0, sizeof(field));
+                if ((value->type & BOLT_PACKED_FLOAT_FLAG(i))!=0) {
+                    BoltValue_format_as_Float(&field, BoltStructure_float(value, i));
+                }
+                else {
+                    BoltValue_format_as_Integer(&field, BoltStructure_integer(value, i));
+                }
+                BoltValue_write(builder, &field, struct_name_resolver);
+                continue;
+            }
             BoltValue_write(builder, BoltStructure_value(value, i), struct_name_resolver);
         }
         StringBuilder_append(builder, ")");
@@ -81,13 +81,46 @@ SEABOLT_EXPORT BoltValue* BoltValue_duplicate(const BoltValue* value);
 /**
  * Deep copies the passed \ref BoltValue instance to another one.
  *
- * Any existing information present in the _dest_ instance will be cleared out.
+ * Any existing information present in the _dest_ instance will be cleared out. Shared values, see
+ * \ref BoltValue_share, are not copied but referenced by _dest_ as well.
  *
  * @param dest the destination instance.
  * @param src the source instance.
  */
 SEABOLT_EXPORT void BoltValue_copy(BoltValue* dest, const BoltValue* src);
 
+/**
+ * Makes the passed \ref BoltValue and everything nested within it immutable and reference counted, so that
+ * copying it or any of its nested values only takes a new reference rather than duplicating the data.
+ *
+ * Sharing costs one small allocation for each nested value that holds external data, and pays off for values
+ * that are copied repeatedly, like authentication tokens. Packed lists are unpacked while being shared.
+ *
+ * Formatting a shared value, or resizing it, setting a key or otherwise changing it through the value itself
+ * leaves other references untouched; the value gets its own copy of the data first (copy-on-write). Values
+ * nested within a shared value must not be changed in place, call \ref BoltValue_unshare on the containing
+ * value first.
+ *
+ * @param value the instance to be shared.
+ */
+SEABOLT_EXPORT void BoltValue_share(BoltValue* value);
+
+/**
+ * Gives a shared \ref BoltValue its own copy of the data, so that the values directly nested within it can be
+ * changed in place. Does nothing if the value is not shared.
+ *
+ * @param value the instance to be unshared.
+ */
+SEABOLT_EXPORT void BoltValue_unshare(BoltValue* value);
+
+/**
+ * Checks whether the passed \ref BoltValue is shared, see \ref BoltValue_share.
+ *
+ * @param value the instance to be checked.
+ * @returns 1 if the value is shared, 0 otherwise.
+ */
+SEABOLT_EXPORT int BoltValue_is_shared(const BoltValue* value);
+
 /**
  * Returns the size of the passed \ref BoltValue instance.
  *
@@ -293,12 +326,62 @@ SEABOLT_EXPORT void BoltList_resize(BoltValue* value, int32_t size);
 /**
  * Returns an instance to a \ref BoltValue identifying the _value_ at _index_.
  *
+ * A packed list (see \ref BoltValue_format_as_packed_List) is first unpacked in place, which invalidates the
+ * arrays returned for it by \ref BoltList_integers, \ref BoltList_floats and \ref BoltList_booleans.
+ *
  * @param value the instance to be queried
  * @param index the index of the value.
  * @returns \ref BoltValue instance identifying the value, NULL if the index is out of bounds.
  */
 SEABOLT_EXPORT BoltValue* BoltList_value(const BoltValue* value, int32_t index);
 
+/**
+ * Sets the passed \ref BoltValue instance to a packed \ref BOLT_LIST, that stores its elements densely as a plain
+ * array of \ref BOLT_INTEGER "int64_t", \ref BOLT_FLOAT "double" or \ref BOLT_BOOLEAN "char" values rather than as
+ * \ref BoltValue "BoltValues". The elements are accessed through \ref BoltList_integers, \ref BoltList_floats and
+ * \ref BoltList_booleans and are initially zero.
+ *
+ * Long lists of such scalars are also decoded into this form if \ref BoltConfig_set_packed_lists is enabled. A
+ * packed list is otherwise an ordinary list, and is unpacked in place on the first call to \ref BoltList_value.
+ *
+ * @param value the instance to be updated
+ * @param type the type of the elements, one of \ref BOLT_INTEGER, \ref BOLT_FLOAT or \ref BOLT_BOOLEAN.
+ * @param length the number of entries.
+ */
+SEABOLT_EXPORT void BoltValue_format_as_packed_List(BoltValue* value, enum BoltType type, int32_t length);
+
+/**
+ * Returns the type of the elements of a packed \ref BoltValue "list" instance.
+ *
+ * @param value the instance to be queried
+ * @returns \ref BOLT_INTEGER, \ref BOLT_FLOAT or \ref BOLT_BOOLEAN for packed lists, \ref BOLT_NULL otherwise.
+ */
+SEABOLT_EXPORT enum BoltType BoltList_packed_type(const BoltValue* value);
+
+/**
+ * Returns the elements of a \ref BoltValue "list" instance packed as \ref BOLT_INTEGER.
+ *
+ * @param value the instance to be queried
+ * @returns the array of elements, NULL if the list is not packed as \ref BOLT_INTEGER.
+ */
+SEABOLT_EXPORT int64_t* BoltList_integers(const BoltValue* value);
+
+/**
+ * Returns the elements of a \ref BoltValue "list" instance packed as \ref BOLT_FLOAT.
+ *
+ * @param value the instance to be queried
+ * @returns the array of elements, NULL if the list is not packed as \ref BOLT_FLOAT.
+ */
+SEABOLT_EXPORT double* BoltList_floats(const BoltValue* value);
+
+/**
+ * Returns the elements of a \ref BoltValue "list" instance packed as \ref BOLT_BOOLEAN, 1 for TRUE, 0 for FALSE.
+ *
+ * @param value the instance to be queried
+ * @returns the array of elements, NULL if the list is not packed as \ref BOLT_BOOLEAN.
+ */
+SEABOLT_EXPORT char* BoltList_booleans(const BoltValue* value);
+
 /**
  * Sets the passed \ref BoltValue instance to \ref BOLT_BYTES.
  *
@@ -346,10 +429,78 @@ SEABOLT_EXPORT int16_t BoltStructure_code(const BoltValue* value);
 /**
  * Returns an instance to a \ref BoltValue identifying the _entry_ at _index_.
  *
+ * A packed structure (see \ref BoltValue_format_as_packed_Structure) is first unpacked in place, which allocates a
+ * \ref BoltValue per field and modifies the structure, so it must not be read concurrently by other threads.
+ *
  * @param value the instance to be queried
  * @param index the index of the entry.
  * @returns \ref BoltValue instance identifying the entry at _index_, NULL if the index is out of bounds.
  */
 SEABOLT_EXPORT BoltValue* BoltStructure_value(const BoltValue* value, int32_t index);
 
+/// The maximum number of fields of a packed \ref BOLT_STRUCTURE
+#define BOLT_PACKED_STRUCTURE_MAX_SIZE 4
+
+/**
+ * Sets the passed \ref BoltValue instance to a packed \ref BOLT_STRUCTURE, that stores its fields densely as plain
+ * \ref BOLT_INTEGER "int64_t" or \ref BOLT_FLOAT "double" values rather than as \ref BoltValue "BoltValues". Up to
+ * two fields are held inline in the value itself. The fields are accessed through \ref BoltStructure_integer,
+ * \ref BoltStructure_float and their setters and are initially integer zero.
+ *
+ * Temporal and spatial values (points, dates, times and durations) are also decoded into this form. A packed
+ * structure is otherwise an ordinary structure, and is unpacked in place on the first call to
+ * \ref BoltStructure_value.
+ *
+ * @param value the instance to be updated
+ * @param code the code of the structure.
+ * @param length the number of fields, at most \ref BOLT_PACKED_STRUCTURE_MAX_SIZE.
+ */
+SEABOLT_EXPORT void BoltValue_format_as_packed_Structure(BoltValue* value, int16_t code, int32_t length);
+
+/**
+ * Checks whether the fields of a \ref BoltValue "structure" instance are packed.
+ *
+ * @param value the instance to be queried
+ * @returns 1 if the structure is packed, 0 otherwise.
+ */
+SEABOLT_EXPORT int BoltStructure_is_packed(const BoltValue* value);
+
+/**
+ * Returns the \ref BOLT_INTEGER field at _index_ of a \ref BoltValue "structure" instance, packed or not, without
+ * unpacking it.
+ *
+ * @param value the instance to be queried
+ * @param index the index of the field.
+ * @returns the value of the field, 0 if it is not an integer.
+ */
+SEABOLT_EXPORT int64_t BoltStructure_integer(const BoltValue* value, int32_t index);
+
+/**
+ * Returns the \ref BOLT_FLOAT field at _index_ of a \ref BoltValue "structure" instance, packed or not, without
+ * unpacking it.
+ *
+ * @param value the instance to be queried
+ * @param index the index of the field.
+ * @returns the value of the field, 0.0 if it is not a float.
+ */
+SEABOLT_EXPORT double BoltStructure_float(const BoltValue* value, int32_t index);
+
+/**
+ * Sets the field at _index_ of a \ref BoltValue "structure" instance, packed or not, to a \ref BOLT_INTEGER.
+ *
+ * @param value the instance to be updated
+ * @param index the index of the field.
+ * @param field the value of the field.
+ */
+SEABOLT_EXPORT void BoltStructure_set_integer(BoltValue* value, int32_t index, int64_t field);
+
+/**
+ * Sets the field at _index_ of a \ref BoltValue "structure" instance, packed or not, to a \ref BOLT_FLOAT.
+ *
+ * @param value the instance to be updated
+ * @param index the index of the field.
+ * @param field the value of the field.
+ */
+SEABOLT_EXPORT void BoltStructure_set_float(BoltValue* value, int32_t index, double field);
+
 #endif // SEABOLT_VALUES
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEABOLT_WRITER_PRIVATE_H
+#define SEABOLT_WRITER_PRIVATE_H
+
+#include "writer.h"
+#include "buffering.h"
+#include "packstream.h"
+
+struct BoltWriterFrame {
+    /// Non-zero for maps, where keys and values alternate
+    int is_map;
+    /// The number of keys and values still to be written
+    int32_t remaining;
+};
+
+struct BoltWriter {
+    check_struct_signature_func check_struct_type;
+    /// The encoded data
+    struct BoltBuffer* buffer;
+    /// Containers that are currently open
+    struct BoltWriterFrame* stack;
+    int32_t depth;
+    int32_t capacity;
+    /// The number of top level values written
+    int32_t values;
+};
+
+/**
+ * Creates a writer that only accepts the structures allowed by _check_struct_type_.
+ */
+BoltWriter* BoltWriter_create_with_check(check_struct_signature_func check_struct_type);
+
+/**
+ * @returns 1 if exactly one top level value has been written and all containers have been closed, 0 otherwise.
+ */
+int BoltWriter_complete(const BoltWriter* writer);
+
+/**
+ * Discards the data written after _offset_, and allows a new top level value to be written from there.
+ */
+void BoltWriter_rewind(BoltWriter* writer, int32_t offset);
+
+#endif //SEABOLT_WRITER_PRIVATE_H
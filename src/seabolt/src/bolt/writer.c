@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define BOLT_MEM_TAG BOLT_MEMORY_PROTOCOL
+
+#include "bolt-private.h"
+#include "mem.h"
+#include "writer-private.h"
+
+#define INITIAL_WRITER_BUFFER_SIZE 1024
+#define INITIAL_WRITER_STACK_SIZE 8
+
+// Takes a value that did not fit back out of the buffer, so that the writer is left unchanged
+#define TRY_LOAD(writer, code) { int extent_try = (writer)->buffer->extent; int status_try = (code); \
+        if (status_try!=BOLT_SUCCESS) { (writer)->buffer->extent = extent_try; return status_try; } }
+
+static int _any_structure(int16_t code)
+{
+    UNUSED(code);
+    return 1;
+}
+
+BoltWriter* BoltWriter_create()
+{
+    return BoltWriter_create_with_check(&_any_structure);
+}
+
+BoltWriter* BoltWriter_create_with_check(check_struct_signature_func check_struct_type)
+{
+    BoltWriter* writer = BoltMem_allocate(sizeof(BoltWriter));
+    writer->check_struct_type = check_struct_type;
+    writer->buffer = BoltBuffer_create(INITIAL_WRITER_BUFFER_SIZE);
+    writer->capacity = INITIAL_WRITER_STACK_SIZE;
+    writer->stack = BoltMem_allocate(writer->capacity*sizeof(struct BoltWriterFrame));
+    writer->depth = 0;
+    writer->values = 0;
+    return writer;
+}
+
+void BoltWriter_destroy(BoltWriter* writer)
+{
+    if (writer==NULL) return;
+
+    BoltBuffer_destroy(writer->buffer);
+    BoltMem_deallocate(writer->stack, writer->capacity*sizeof(struct BoltWriterFrame));
+    BoltMem_deallocate(writer, sizeof(BoltWriter));
+}
+
+void BoltWriter_reset(BoltWriter* writer)
+{
+    writer->buffer->cursor = 0;
+    writer->buffer->extent = 0;
+    writer->depth = 0;
+    writer->values = 0;
+}
+
+void BoltWriter_rewind(BoltWriter* writer, int32_t offset)
+{
+    writer->buffer->extent = offset;
+    writer->depth = 0;
+    writer->values = 0;
+}
+
+int BoltWriter_complete(const BoltWriter* writer)
+{
+    return writer->depth==0 && writer->values==1;
+}
+
+const char* BoltWriter_data(const BoltWriter* writer)
+{
+    return writer->buffer->data+writer->buffer->cursor;
+}
+
+int32_t BoltWriter_size(const BoltWriter* writer)
+{
+    return BoltBuffer_unloadable(writer->buffer);
+}
+
+static int _can_write(const BoltWriter* writer, int key)
+{
+    if (writer->depth==0) {
+        return !key && writer->values==0;
+    }
+    const struct BoltWriterFrame* frame = &writer->stack[writer->depth-1];
+    if (frame->remaining==0) {
+        return 0;
+    }
+    // keys are expected at even positions of a map, and nowhere else
+    int key_expected = frame->is_map && frame->remaining%2==0;
+    return key==key_expected;
+}
+
+static void _written(BoltWriter* writer)
+{
+    if (writer->depth==0) {
+        writer->values += 1;
+    }
+    else {
+        writer->stack[writer->depth-1].remaining -= 1;
+    }
+}
+
+static void _push(BoltWriter* writer, int is_map, int32_t remaining)
+{
+    if (writer->depth==writer->capacity) {
+        int32_t capacity = writer->capacity*2;
+        writer->stack = BoltMem_reallocate(writer->stack, writer->capacity*sizeof(struct BoltWriterFrame),
+                capacity*sizeof(struct BoltWriterFrame));
+        writer->capacity = capacity;
+    }
+    writer->stack[writer->depth].is_map = is_map;
+    writer->stack[writer->depth].remaining = remaining;
+    writer->depth += 1;
+}
+
+int32_t BoltWriter_null(BoltWriter* writer)
+{
+    if (!_can_write(writer, 0)) return BOLT_PROTOCOL_VIOLATION;
+    TRY_LOAD(writer, load_null(writer->buffer));
+    _written(writer);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltWriter_boolean(BoltWriter* writer, char value)
+{
+    if (!_can_write(writer, 0)) return BOLT_PROTOCOL_VIOLATION;
+    TRY_LOAD(writer, load_boolean(writer->buffer, value));
+    _written(writer);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltWriter_integer(BoltWriter* writer, int64_t value)
+{
+    if (!_can_write(writer, 0)) return BOLT_PROTOCOL_VIOLATION;
+    TRY_LOAD(writer, load_integer(writer->buffer, value));
+    _written(writer);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltWriter_float(BoltWriter* writer, double value)
+{
+    if (!_can_write(writer, 0)) return BOLT_PROTOCOL_VIOLATION;
+    TRY_LOAD(writer, load_float(writer->buffer, value));
+    _written(writer);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltWriter_string(BoltWriter* writer, const char* string, int32_t size)
+{
+    if (size<0 || !_can_write(writer, 0)) return BOLT_PROTOCOL_VIOLATION;
+    TRY_LOAD(writer, load_string(writer->buffer, string, size));
+    _written(writer);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltWriter_bytes(BoltWriter* writer, const char* data, int32_t size)
+{
+    if (size<0 || !_can_write(writer, 0)) return BOLT_PROTOCOL_VIOLATION;
+    TRY_LOAD(writer, load_bytes(writer->buffer, data, size));
+    _written(writer);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltWriter_value(BoltWriter* writer, const BoltValue* value)
+{
+    if (!_can_write(writer, 0)) return BOLT_PROTOCOL_VIOLATION;
+    int extent = writer->buffer->extent;
+    int status = load(writer->check_struct_type, writer->buffer, (BoltValue*) value, NULL);
+    if (status!=BOLT_SUCCESS) {
+        writer->buffer->extent = extent;
+        return status==BOLT_OUT_OF_MEMORY ? status : BOLT_PROTOCOL_VIOLATION;
+    }
+    _written(writer);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltWriter_begin_list(BoltWriter* writer, int32_t size)
+{
+    if (size<0 || !_can_write(writer, 0)) return BOLT_PROTOCOL_VIOLATION;
+    TRY_LOAD(writer, load_list_header(writer->buffer, size));
+    _written(writer);
+    _push(writer, 0, size);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltWriter_begin_map(BoltWriter* writer, int32_t size)
+{
+    if (size<0 || size>INT32_MAX/2 || !_can_write(writer, 0)) return BOLT_PROTOCOL_VIOLATION;
+    TRY_LOAD(writer, load_map_header(writer->buffer, size));
+    _written(writer);
+    _push(writer, 1, 2*size);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltWriter_key(BoltWriter* writer, const char* key, int32_t key_size)
+{
+    if (key_size<0 || !_can_write(writer, 1)) return BOLT_PROTOCOL_VIOLATION;
+    TRY_LOAD(writer, load_string(writer->buffer, key, key_size));
+    _written(writer);
+    return BOLT_SUCCESS;
+}
+
+int32_t BoltWriter_end(BoltWriter* writer)
+{
+    if (writer->depth==0 || writer->stack[writer->depth-1].remaining!=0) return BOLT_PROTOCOL_VIOLATION;
+    writer->depth -= 1;
+    return BOLT_SUCCESS;
+}
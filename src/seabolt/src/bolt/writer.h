@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file
+ */
+
+#ifndef SEABOLT_WRITER_H
+#define SEABOLT_WRITER_H
+
+#include "bolt-public.h"
+#include "values.h"
+
+/**
+ * The type that writes values straight into the PackStream encoding of a request, without building a
+ * \ref BoltValue tree first.
+ *
+ * Containers are sized up front: \ref BoltWriter_begin_list and \ref BoltWriter_begin_map take the number of
+ * entries, which must then be written before the container is closed with \ref BoltWriter_end. Map entries are
+ * written as a \ref BoltWriter_key call followed by the value.
+ *
+ * All functions return \ref BOLT_SUCCESS, or \ref BOLT_PROTOCOL_VIOLATION (leaving the writer unchanged) if the
+ * call does not fit the structure written so far, or \ref BOLT_OUT_OF_MEMORY (also leaving the writer unchanged) if
+ * the encoding would grow past INT_MAX bytes.
+ */
+typedef struct BoltWriter BoltWriter;
+
+/**
+ * Creates a new instance of \ref BoltWriter, e.g. to prepare parameters for
+ * \ref BoltConnection_set_run_encoded_parameters.
+ *
+ * @returns the pointer to the newly allocated \ref BoltWriter instance.
+ */
+SEABOLT_EXPORT BoltWriter* BoltWriter_create();
+
+/**
+ * Destroys the passed \ref BoltWriter instance.
+ *
+ * @param writer the instance to be destroyed.
+ */
+SEABOLT_EXPORT void BoltWriter_destroy(BoltWriter* writer);
+
+/**
+ * Discards everything written so far.
+ *
+ * @param writer the writer instance.
+ */
+SEABOLT_EXPORT void BoltWriter_reset(BoltWriter* writer);
+
+/**
+ * Returns the PackStream encoded data written so far.
+ *
+ * @param writer the writer instance.
+ * @returns a pointer to the encoded data, valid until the writer is next modified.
+ */
+SEABOLT_EXPORT const char* BoltWriter_data(const BoltWriter* writer);
+
+/**
+ * Returns the size of the PackStream encoded data written so far.
+ *
+ * @param writer the writer instance.
+ * @returns the size in bytes.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_size(const BoltWriter* writer);
+
+/**
+ * Writes a null value.
+ *
+ * @param writer the writer instance.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_null(BoltWriter* writer);
+
+/**
+ * Writes a boolean value.
+ *
+ * @param writer the writer instance.
+ * @param value 0 for FALSE, anything else for TRUE.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_boolean(BoltWriter* writer, char value);
+
+/**
+ * Writes an integer value.
+ *
+ * @param writer the writer instance.
+ * @param value the value to write.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_integer(BoltWriter* writer, int64_t value);
+
+/**
+ * Writes a float value.
+ *
+ * @param writer the writer instance.
+ * @param value the value to write.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_float(BoltWriter* writer, double value);
+
+/**
+ * Writes a UTF-8 string value.
+ *
+ * @param writer the writer instance.
+ * @param string the string buffer.
+ * @param size the size of the string buffer.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_string(BoltWriter* writer, const char* string, int32_t size);
+
+/**
+ * Writes a byte array value.
+ *
+ * @param writer the writer instance.
+ * @param data the byte buffer.
+ * @param size the size of the byte buffer.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_bytes(BoltWriter* writer, const char* data, int32_t size);
+
+/**
+ * Writes an existing \ref BoltValue, e.g. a temporal or spatial structure.
+ *
+ * @param writer the writer instance.
+ * @param value the value to write.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_value(BoltWriter* writer, const BoltValue* value);
+
+/**
+ * Starts a list of _size_ entries.
+ *
+ * @param writer the writer instance.
+ * @param size the number of entries that will follow.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_begin_list(BoltWriter* writer, int32_t size);
+
+/**
+ * Starts a map of _size_ entries.
+ *
+ * @param writer the writer instance.
+ * @param size the number of key/value pairs that will follow.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_begin_map(BoltWriter* writer, int32_t size);
+
+/**
+ * Writes the key of the next map entry.
+ *
+ * @param writer the writer instance.
+ * @param key the key string buffer.
+ * @param key_size the size of the key string buffer.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_key(BoltWriter* writer, const char* key, int32_t key_size);
+
+/**
+ * Closes the innermost list or map, all of whose entries must have been written.
+ *
+ * @param writer the writer instance.
+ * @return \ref BOLT_SUCCESS on success, an error code on failure.
+ */
+SEABOLT_EXPORT int32_t BoltWriter_end(BoltWriter* writer);
+
+#endif //SEABOLT_WRITER_H
@@ -36,7 +36,9 @@ extern "C"
 #include "bolt/direct-pool.h"
 #include "bolt/v3.h"
 #include "bolt/communication.h"
+#include "bolt/communication-capture.h"
 #include "bolt/communication-mock.h"
+#include "bolt/mem.h"
 }
 
 #define SETTING(name, default_value) ((char*)((getenv(name) == nullptr) ? (default_value) : getenv(name)))
@@ -68,4 +70,8 @@ struct BoltValue* bolt_basic_auth(const char* username, const char* password);
 
 void bolt_close_and_destroy_b(struct BoltConnection* connection);
 
+int32_t bolt_use_counting_allocator();
+
+int64_t bolt_counting_allocator_mismatches();
+
 #endif // SEABOLT_TEST_INTEGRATION
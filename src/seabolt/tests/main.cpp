@@ -25,11 +25,23 @@
 
 int main(int argc, char* argv[])
 {
+    // Runs the suite with all memory going through a custom allocator that checks the sizes it is handed back
+    bool counting = strcmp(SETTING("SEABOLT_TEST_ALLOCATOR", ""), "counting")==0;
+    if (counting) {
+        bolt_use_counting_allocator();
+    }
+
     Bolt_startup();
 
     int result = Catch::Session().run(argc, argv);
 
     Bolt_shutdown();
 
+    if (counting && bolt_counting_allocator_mismatches()!=0) {
+        fprintf(stderr, "%lld blocks were freed with a size other than they were allocated with\n",
+                (long long) bolt_counting_allocator_mismatches());
+        result = 1;
+    }
+
     return result;
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include "integration.hpp"
+#include "catch.hpp"
+
+// Prefixes each block with the size it was allocated with, to check the sizes passed back on reallocation and free
+#define HEADER_SIZE 16
+
+struct CountingAllocator {
+    std::atomic<int64_t> allocations;
+    std::atomic<int64_t> reallocations;
+    std::atomic<int64_t> deallocations;
+    std::atomic<int64_t> size_mismatches;
+    bool installed;
+};
+
+static CountingAllocator counting_allocator;
+
+static void* counting_allocate(void* state, size_t size)
+{
+    CountingAllocator* allocator = (CountingAllocator*) state;
+    allocator->allocations++;
+    char* block = (char*) malloc(HEADER_SIZE+size);
+    *(size_t*) block = size;
+    return block+HEADER_SIZE;
+}
+
+static void* counting_reallocate(void* state, void* ptr, size_t old_size, size_t new_size)
+{
+    CountingAllocator* allocator = (CountingAllocator*) state;
+    allocator->reallocations++;
+    char* block = (char*) ptr-HEADER_SIZE;
+    if (*(size_t*) block!=old_size) {
+        allocator->size_mismatches++;
+    }
+    block = (char*) realloc(block, HEADER_SIZE+new_size);
+    *(size_t*) block = new_size;
+    return block+HEADER_SIZE;
+}
+
+static void counting_deallocate(void* state, void* ptr, size_t size)
+{
+    CountingAllocator* allocator = (CountingAllocator*) state;
+    allocator->deallocations++;
+    char* block = (char*) ptr-HEADER_SIZE;
+    if (*(size_t*) block!=size) {
+        allocator->size_mismatches++;
+    }
+    free(block);
+}
+
+int32_t bolt_use_counting_allocator()
+{
+    int32_t status = BoltAllocator_set(&counting_allocate, &counting_reallocate, &counting_deallocate,
+            &counting_allocator);
+    counting_allocator.installed = status==BOLT_SUCCESS;
+    return status;
+}
+
+int64_t bolt_counting_allocator_mismatches()
+{
+    return counting_allocator.size_mismatches;
+}
+
+TEST_CASE("BoltAllocator", "[unit]")
+{
+    SECTION("should not be replaced once memory has been allocated") {
+        BoltValue_destroy(BoltValue_create());
+        REQUIRE(BoltAllocator_set(&counting_allocate, &counting_reallocate, &counting_deallocate,
+                &counting_allocator)==BOLT_ALLOCATOR_IN_USE);
+        REQUIRE(BoltAllocator_set(NULL, NULL, NULL, NULL)==BOLT_ALLOCATOR_IN_USE);
+    }
+
+    SECTION("should reject an allocator missing some of its functions") {
+        REQUIRE(BoltAllocator_set(&counting_allocate, NULL, &counting_deallocate, &counting_allocator)
+                ==BOLT_ALLOCATOR_INCOMPLETE);
+        REQUIRE(BoltAllocator_set(NULL, &counting_reallocate, NULL, &counting_allocator)
+                ==BOLT_ALLOCATOR_INCOMPLETE);
+    }
+
+    SECTION("should route memory through the custom allocator") {
+        if (counting_allocator.installed) {
+            int64_t allocations = counting_allocator.allocations;
+            int64_t reallocations = counting_allocator.reallocations;
+            int64_t deallocations = counting_allocator.deallocations;
+            BoltBuffer* buffer = BoltBuffer_create(100);
+            BoltBuffer_load_pointer(buffer, 1000);
+            BoltBuffer_destroy(buffer);
+            REQUIRE(counting_allocator.allocations>allocations);
+            REQUIRE(counting_allocator.reallocations>reallocations);
+            REQUIRE(counting_allocator.deallocations>deallocations);
+            REQUIRE(counting_allocator.size_mismatches==0);
+        }
+    }
+}
+
+TEST_CASE("memory profile", "[unit]")
+{
+    SECTION("should account allocations to the subsystem making them") {
+        int64_t buffers = (int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_BUFFERS);
+        int64_t values = (int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_VALUES);
+        int64_t buffer_events = BoltStat_memory_tag_allocation_events(BOLT_MEMORY_BUFFERS);
+        int64_t value_events = BoltStat_memory_tag_allocation_events(BOLT_MEMORY_VALUES);
+
+        BoltBuffer* buffer = BoltBuffer_create(100000);
+        REQUIRE((int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_BUFFERS)>=buffers+100000);
+        REQUIRE((int64_t) BoltStat_memory_tag_allocation_peak(BOLT_MEMORY_BUFFERS)>=buffers+100000);
+        REQUIRE((int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_VALUES)==values);
+        BoltBuffer_destroy(buffer);
+        REQUIRE((int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_BUFFERS)==buffers);
+        REQUIRE(BoltStat_memory_tag_allocation_events(BOLT_MEMORY_BUFFERS)>buffer_events);
+
+        BoltValue* value = BoltValue_create();
+        BoltValue_format_as_String(value, "memory profile", 14);
+        REQUIRE((int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_VALUES)>values);
+        BoltValue_destroy(value);
+        REQUIRE((int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_VALUES)==values);
+        REQUIRE(BoltStat_memory_tag_allocation_events(BOLT_MEMORY_VALUES)>value_events);
+    }
+
+    SECTION("should keep the tagged and untagged allocation functions apart") {
+        int64_t other = (int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_OTHER);
+        int64_t routing = (int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_ROUTING);
+        void* untagged = BoltMem_allocate(64);
+        void* tagged = BoltMem_allocate_tagged(BOLT_MEMORY_ROUTING, 32);
+        REQUIRE((int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_OTHER)==other+64);
+        REQUIRE((int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_ROUTING)==routing+32);
+        BoltMem_deallocate(untagged, 64);
+        BoltMem_deallocate_tagged(BOLT_MEMORY_ROUTING, tagged, 32);
+        REQUIRE((int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_OTHER)==other);
+        REQUIRE((int64_t) BoltStat_memory_tag_allocation_current(BOLT_MEMORY_ROUTING)==routing);
+    }
+
+    SECTION("should free memory under the subsystem that allocated it") {
+        int64_t before[BOLT_MEMORY_TAGS];
+        for (int tag = 0; tag<BOLT_MEMORY_TAGS; tag++) {
+            before[tag] = (int64_t) BoltStat_memory_tag_allocation_current(tag);
+        }
+
+        // Nothing listens on the port, so the attempts stop after the TLS connection has been set up
+        BoltAddress* address = BoltAddress_create("127.0.0.1", "1");
+        BoltValue* auth_token = BoltAuth_basic("user", "password", NULL);
+        BoltConfig* config = BoltConfig_create();
+        BoltConfig_set_scheme(config, BOLT_SCHEME_DIRECT);
+        BoltConfig_set_transport(config, BOLT_TRANSPORT_ENCRYPTED);
+        BoltConfig_set_user_agent(config, "seabolt-test");
+        BoltConnector* connector = BoltConnector_create(address, auth_token, config);
+        BoltStatus* status = BoltStatus_create();
+        for (int i = 0; i<3; i++) {
+            REQUIRE(BoltConnector_acquire(connector, BOLT_ACCESS_MODE_READ, status)==NULL);
+        }
+        BoltStatus_destroy(status);
+        BoltConnector_destroy(connector);
+        BoltConfig_destroy(config);
+        BoltValue_destroy(auth_token);
+        BoltAddress_destroy(address);
+
+        for (int tag = 0; tag<BOLT_MEMORY_TAGS; tag++) {
+            INFO(BoltStat_memory_tag_name(tag));
+            REQUIRE((int64_t) BoltStat_memory_tag_allocation_current(tag)==before[tag]);
+        }
+    }
+
+    SECTION("should name the tags") {
+        REQUIRE(strcmp(BoltStat_memory_tag_name(BOLT_MEMORY_BUFFERS), "buffers")==0);
+        REQUIRE(strcmp(BoltStat_memory_tag_name(BOLT_MEMORY_TLS), "tls")==0);
+        REQUIRE(BoltStat_memory_tag_name(BOLT_MEMORY_TAGS)==NULL);
+        REQUIRE(BoltStat_memory_tag_name(-1)==NULL);
+        REQUIRE(BoltStat_memory_tag_allocation_current(BOLT_MEMORY_TAGS)==0);
+    }
+
+    SECTION("should write a row per subsystem and the totals") {
+        int32_t length = BoltStat_write_memory_profile(NULL, 0);
+        REQUIRE(length>0);
+
+        char* profile = (char*) malloc((size_t) length+1);
+        REQUIRE(BoltStat_write_memory_profile(profile, length+1)==length);
+        REQUIRE((int32_t) strlen(profile)==length);
+        for (BoltMemoryTag tag = 0; tag<BOLT_MEMORY_TAGS; tag++) {
+            REQUIRE(strstr(profile, BoltStat_memory_tag_name(tag))!=NULL);
+        }
+        REQUIRE(strstr(profile, "total")!=NULL);
+
+        // The current allocation of the total row is that of all subsystems, without the profile being written
+        int64_t sum = 0, total = -1;
+        for (const char* line = strchr(profile, '\n')+1; *line!=0; line = strchr(line, '\n')+1) {
+            char name[32];
+            long long current = 0;
+            REQUIRE(sscanf(line, "%31s %lld", name, &current)==2);
+            if (strcmp(name, "total")==0) {
+                total = current;
+            }
+            else {
+                sum += current;
+            }
+        }
+        REQUIRE(total==sum);
+
+        char truncated[16];
+        REQUIRE(BoltStat_write_memory_profile(truncated, sizeof(truncated))==length);
+        REQUIRE(strncmp(truncated, profile, sizeof(truncated))==0);
+        free(profile);
+    }
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "integration.hpp"
+#include "catch.hpp"
+
+#include <string>
+
+extern "C"
+{
+#include "bolt/communication-capture.h"
+#include "bolt/communication-mock.h"
+#include "bolt/connection-private.h"
+#include "bolt/mem.h"
+}
+
+static std::string chunked(const std::string& message)
+{
+    std::string chunk;
+    chunk += (char) (message.size() >> 8);
+    chunk += (char) (message.size() & 0xFF);
+    return chunk+message+std::string("\x00\x00", 2);
+}
+
+static const std::string SUCCESS = chunked(std::string("\xB1\x70\xA0", 3));
+static const std::string FAILURE = chunked(std::string("\xB1\x7F\xA2\x84" "code\x83X.Y\x87message\x83" "bad"));
+static const std::string IGNORED = chunked(std::string("\xB0\x7E", 2));
+static const char* CAPTURE_PATH = "seabolt-batch-test.bolt";
+
+// The stream is served as it is, and must outlive the connection
+static BoltConnection* open_replaying(const std::string& server_stream)
+{
+    BoltAddress* address = bolt_get_address("localhost", "7687");
+    BoltConnection* connection = BoltConnection_create();
+    connection->comm = BoltCommunication_create_capture(
+            BoltCommunication_create_replay(server_stream.data(), (int64_t) server_stream.size(), NULL, NULL),
+            CAPTURE_PATH);
+    BoltConnection_open(connection, BOLT_TRANSPORT_MOCKED, address, NULL, NULL, NULL);
+    connection->status->state = BOLT_CONNECTION_STATE_READY;
+    BoltAddress_destroy(address);
+    return connection;
+}
+
+static std::string close_and_load_sent(BoltConnection* connection)
+{
+    BoltConnection_close(connection);
+    BoltConnection_destroy(connection);
+    char* stream = NULL;
+    int64_t size = BoltCapture_load(CAPTURE_PATH, BOLT_CAPTURE_CLIENT, &stream);
+    REQUIRE(size>0);
+    std::string sent(stream, (size_t) size);
+    BoltCapture_release(stream, size);
+    remove(CAPTURE_PATH);
+    return sent;
+}
+
+static int32_t add_row(BoltBatch* batch, int64_t value)
+{
+    BoltWriter* row = BoltBatch_begin_row(batch);
+    BoltWriter_integer(row, value);
+    return BoltBatch_end_row(batch);
+}
+
+TEST_CASE("BoltBatch", "[unit]")
+{
+    const std::string handshake("\x00\x00\x00\x03", 4);
+    BoltStatement* statement = BoltStatement_create("UNWIND $rows AS row RETURN row", 30);
+
+    SECTION("should send full batches and wait for earlier ones") {
+        std::string server_stream = handshake;
+        for (int i = 0; i<6; i++) {
+            server_stream += SUCCESS;
+        }
+        BoltConnection* connection = open_replaying(server_stream);
+        BoltBatch* batch = BoltBatch_create(connection, statement, "rows", 4);
+        REQUIRE(BoltBatch_set_max_rows(batch, 2)==BOLT_SUCCESS);
+        REQUIRE(BoltBatch_set_max_in_flight(batch, 1)==BOLT_SUCCESS);
+
+        REQUIRE(add_row(batch, 1)==BOLT_SUCCESS);
+        REQUIRE(add_row(batch, 2)==BOLT_SUCCESS);
+        REQUIRE(BoltConnectionMetrics_get_messages_sent(BoltConnection_metrics(connection))==2);
+        REQUIRE(BoltBatch_rows_completed(batch)==0);
+        REQUIRE(BoltBatch_set_max_in_flight(batch, 2)==BOLT_PROTOCOL_VIOLATION);
+
+        REQUIRE(add_row(batch, 3)==BOLT_SUCCESS);
+        REQUIRE(add_row(batch, 4)==BOLT_SUCCESS);
+        REQUIRE(BoltBatch_rows_completed(batch)==2);
+        REQUIRE(add_row(batch, 5)==BOLT_SUCCESS);
+        REQUIRE(BoltBatch_finish(batch)==BOLT_SUCCESS);
+        REQUIRE(BoltBatch_rows_completed(batch)==5);
+        BoltBatch_destroy(batch);
+
+        std::string sent = close_and_load_sent(connection);
+        const std::string statement_and_key("\xD0\x1EUNWIND $rows AS row RETURN row\xA1\x84rows", 38);
+        REQUIRE(sent.find(statement_and_key+"\x92\x01\x02")!=std::string::npos);
+        REQUIRE(sent.find(statement_and_key+"\x92\x03\x04")!=std::string::npos);
+        REQUIRE(sent.find(statement_and_key+"\x91\x05")!=std::string::npos);
+    }
+
+    SECTION("should send a batch once the encoded rows reach the byte limit") {
+        const std::string server_stream = handshake+SUCCESS+SUCCESS;
+        BoltConnection* connection = open_replaying(server_stream);
+        BoltBatch* batch = BoltBatch_create(connection, statement, "rows", 4);
+        REQUIRE(BoltBatch_set_max_rows(batch, 0)==BOLT_SUCCESS);
+        REQUIRE(BoltBatch_set_max_bytes(batch, 9)==BOLT_SUCCESS);
+
+        REQUIRE(add_row(batch, 1000)==BOLT_SUCCESS);
+        REQUIRE(add_row(batch, 1000)==BOLT_SUCCESS);
+        REQUIRE(BoltConnectionMetrics_get_messages_sent(BoltConnection_metrics(connection))==0);
+        REQUIRE(add_row(batch, 1000)==BOLT_SUCCESS);
+        REQUIRE(BoltConnectionMetrics_get_messages_sent(BoltConnection_metrics(connection))==2);
+        REQUIRE(BoltBatch_finish(batch)==BOLT_SUCCESS);
+        REQUIRE(BoltBatch_rows_completed(batch)==3);
+        BoltBatch_destroy(batch);
+        close_and_load_sent(connection);
+    }
+
+    SECTION("should discard incomplete rows") {
+        const std::string server_stream = handshake+SUCCESS+SUCCESS;
+        BoltConnection* connection = open_replaying(server_stream);
+        BoltBatch* batch = BoltBatch_create(connection, statement, "rows", 4);
+
+        BoltWriter* row = BoltBatch_begin_row(batch);
+        BoltWriter_begin_list(row, 2);
+        BoltWriter_integer(row, 1);
+        REQUIRE(BoltBatch_end_row(batch)==BOLT_PROTOCOL_VIOLATION);
+        REQUIRE(add_row(batch, 7)==BOLT_SUCCESS);
+        REQUIRE(BoltBatch_finish(batch)==BOLT_SUCCESS);
+        REQUIRE(BoltBatch_rows_completed(batch)==1);
+        BoltBatch_destroy(batch);
+
+        std::string sent = close_and_load_sent(connection);
+        REQUIRE(sent.find(std::string("\xA1\x84rows\x91\x07", 7))!=std::string::npos);
+    }
+
+    SECTION("should report a failed batch") {
+        const std::string server_stream = handshake+SUCCESS+SUCCESS+FAILURE+IGNORED;
+        BoltConnection* connection = open_replaying(server_stream);
+        BoltBatch* batch = BoltBatch_create(connection, statement, "rows", 4);
+        REQUIRE(BoltBatch_set_max_rows(batch, 1)==BOLT_SUCCESS);
+
+        REQUIRE(add_row(batch, 1)==BOLT_SUCCESS);
+        REQUIRE(add_row(batch, 2)==BOLT_SUCCESS);
+        REQUIRE(BoltBatch_finish(batch)==BOLT_SERVER_FAILURE);
+        REQUIRE(BoltBatch_rows_completed(batch)==1);
+        REQUIRE(add_row(batch, 3)==BOLT_SERVER_FAILURE);
+        BoltBatch_destroy(batch);
+        close_and_load_sent(connection);
+    }
+
+    BoltStatement_destroy(statement);
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "integration.hpp"
+#include "catch.hpp"
+
+#include <string>
+
+extern "C"
+{
+#include "bolt/buffer-pool.h"
+#include "bolt/communication-mock.h"
+#include "bolt/connection-private.h"
+#include "bolt/mem.h"
+}
+
+TEST_CASE("BoltBufferPool", "[unit]")
+{
+    struct BoltBufferPool* pool = BoltBufferPool_create(4, 1 << 20, 1);
+
+    SECTION("should hand out released buffers again, keeping their capacity") {
+        BoltBuffer* buffer = BoltBufferPool_acquire(pool, 8192);
+        BoltBuffer_load_pointer(buffer, 100000);
+        BoltBufferPool_release(pool, buffer);
+        REQUIRE(BoltBufferPool_size(pool)==1);
+
+        int64_t events = BoltMem_allocation_events();
+        BoltBuffer* reused = BoltBufferPool_acquire(pool, 8192);
+        REQUIRE(BoltMem_allocation_events()==events);
+        REQUIRE(reused==buffer);
+        REQUIRE(reused->size>=100000);
+        REQUIRE(reused->extent==0);
+        REQUIRE(reused->cursor==0);
+        REQUIRE(BoltBufferPool_size(pool)==0);
+        BoltBufferPool_release(pool, reused);
+    }
+
+    SECTION("should only hand out buffers that fit") {
+        BoltBuffer* small = BoltBufferPool_acquire(pool, 8192);
+        BoltBufferPool_release(pool, small);
+        BoltBuffer* large = BoltBufferPool_acquire(pool, 65536);
+        REQUIRE(large!=small);
+        REQUIRE(large->size>=65536);
+        BoltBufferPool_release(pool, large);
+        REQUIRE(BoltBufferPool_acquire(pool, 16384)==large);
+        REQUIRE(BoltBufferPool_acquire(pool, 4096)==small);
+        BoltBufferPool_release(pool, small);
+        BoltBufferPool_release(pool, large);
+    }
+
+    SECTION("should not retain buffers beyond its limits") {
+        BoltBuffer* buffers[6];
+        for (int i = 0; i<6; i++) {
+            buffers[i] = BoltBufferPool_acquire(pool, 8192);
+        }
+        for (int i = 0; i<6; i++) {
+            BoltBufferPool_release(pool, buffers[i]);
+        }
+        REQUIRE(BoltBufferPool_size(pool)==4);
+
+        BoltBuffer* tiny = BoltBufferPool_acquire(pool, 16);
+        REQUIRE(tiny->size==8192);
+        BoltBufferPool_release(pool, BoltBuffer_create(16));
+        BoltBufferPool_release(pool, BoltBuffer_create(4*1024*1024));
+        REQUIRE(BoltBufferPool_size(pool)==3);
+        BoltBufferPool_release(pool, tiny);
+        REQUIRE(BoltBufferPool_size(pool)==4);
+    }
+
+    SECTION("should shrink buffers to what they recently needed") {
+        BoltBuffer* buffer = BoltBufferPool_acquire(pool, 8192);
+        BoltBuffer_load_pointer(buffer, 500000);
+        BoltBuffer_unload_pointer(buffer, 500000);
+        BoltBuffer_shrink(buffer, 8192);
+        BoltBuffer_load_pointer(buffer, 1000);
+        BoltBufferPool_release(pool, buffer);
+        REQUIRE(BoltBufferPool_size(pool)==1);
+        REQUIRE(buffer->size==65536);
+        REQUIRE(BoltBufferPool_acquire(pool, 65536)==buffer);
+        BoltBufferPool_release(pool, buffer);
+    }
+
+    SECTION("should not retain buffers beyond its size limit") {
+        BoltBuffer* large = BoltBufferPool_acquire(pool, 1 << 20);
+        BoltBuffer_load_pointer(large, 1 << 20);
+        BoltBuffer* small = BoltBufferPool_acquire(pool, 8192);
+        BoltBufferPool_release(pool, small);
+        BoltBufferPool_release(pool, large);
+        REQUIRE(BoltBufferPool_size(pool)==1);
+        REQUIRE(BoltBufferPool_acquire(pool, 8192)==small);
+        BoltBufferPool_release(pool, small);
+    }
+
+    SECTION("should hand out released rings again") {
+        BoltRing* ring = BoltBufferPool_acquire_ring(pool, 8192);
+        int64_t size;
+        BoltRing_load_pointer(ring, &size);
+        BoltRing_loaded(ring, 10);
+        BoltBufferPool_release_ring(pool, ring);
+        BoltBufferPool_release_ring(pool, BoltRing_create(8192));
+        REQUIRE(BoltBufferPool_size(pool)==1);
+
+        BoltRing* reused = BoltBufferPool_acquire_ring(pool, 8192);
+        REQUIRE(reused==ring);
+        REQUIRE(BoltRing_unloadable(reused)==0);
+        BoltBufferPool_release_ring(pool, reused);
+        BoltRing* large = BoltBufferPool_acquire_ring(pool, 16384);
+        REQUIRE(large!=ring);
+        REQUIRE(large->size==16384);
+        BoltBufferPool_release_ring(NULL, large);
+    }
+
+    SECTION("should be shared by connections across reopen") {
+        const std::string server_stream("\x00\x00\x00\x03", 4);
+        BoltAddress* address = bolt_get_address("localhost", "7687");
+        BoltConnection* connection = BoltConnection_create();
+        connection->buffer_pool = BoltBufferPool_create(3, 1 << 20, 1);
+
+        connection->comm = BoltCommunication_create_replay(server_stream.data(), (int64_t) server_stream.size(), NULL,
+                NULL);
+        BoltConnection_open(connection, BOLT_TRANSPORT_MOCKED, address, NULL, NULL, NULL);
+        BoltConnection_close(connection);
+        REQUIRE(BoltBufferPool_size(connection->buffer_pool)==4);
+
+        connection->comm = BoltCommunication_create_replay(server_stream.data(), (int64_t) server_stream.size(), NULL,
+                NULL);
+        BoltConnection_open(connection, BOLT_TRANSPORT_MOCKED, address, NULL, NULL, NULL);
+        REQUIRE(BoltBufferPool_size(connection->buffer_pool)==0);
+        REQUIRE(connection->protocol_version==3);
+        BoltConnection_close(connection);
+
+        BoltBufferPool_destroy(connection->buffer_pool);
+        BoltConnection_destroy(connection);
+        BoltAddress_destroy(address);
+    }
+
+    BoltBufferPool_destroy(pool);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "integration.hpp"
+#include "catch.hpp"
+
+#include <climits>
+#include <string>
+
+extern "C"
+{
+#include "bolt/buffering.h"
+#include "bolt/mem.h"
+}
+
+TEST_CASE("BoltBuffer", "[unit]")
+{
+    SECTION("should grow geometrically") {
+        BoltBuffer* buffer = BoltBuffer_create(16);
+        int64_t events = BoltMem_allocation_events();
+        for (int i = 0; i<65536; i++) {
+            BoltBuffer_load_u8(buffer, (uint8_t) i);
+        }
+        REQUIRE(BoltMem_allocation_events()-events<=12);
+        REQUIRE(buffer->extent==65536);
+        for (int i = 0; i<65536; i++) {
+            uint8_t x;
+            REQUIRE(BoltBuffer_unload_u8(buffer, &x)==0);
+            REQUIRE(x==(uint8_t) i);
+        }
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should grow to fit a large load at once") {
+        BoltBuffer* buffer = BoltBuffer_create(16);
+        BoltBuffer_load_pointer(buffer, 1000);
+        REQUIRE(buffer->size==1000);
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should refuse a load that would grow past INT_MAX") {
+        BoltBuffer* buffer = BoltBuffer_create(16);
+        // pretend to hold nearly INT_MAX bytes, the loads below must fail before touching the data
+        buffer->extent = INT_MAX-4;
+        REQUIRE(BoltBuffer_load_pointer(buffer, 8)==nullptr);
+        REQUIRE(BoltBuffer_load_i64be(buffer, 1)==-1);
+        REQUIRE(BoltBuffer_load(buffer, "data", -1)==-1);
+        REQUIRE(buffer->extent==INT_MAX-4);
+        REQUIRE(buffer->size==16);
+        buffer->extent = 0;
+        REQUIRE(BoltBuffer_load_i64be(buffer, 1)==8);
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should shrink once the high-water mark stays low") {
+        BoltBuffer* buffer = BoltBuffer_create(1024);
+        BoltBuffer_load_pointer(buffer, 100000);
+        BoltBuffer_unload_pointer(buffer, 100000);
+
+        // the large message was used since the last shrink
+        BoltBuffer_shrink(buffer, 1024);
+        REQUIRE(buffer->size==100000);
+
+        BoltBuffer_load_pointer(buffer, 2000);
+        BoltBuffer_unload_pointer(buffer, 2000);
+        BoltBuffer_shrink(buffer, 1024);
+        REQUIRE(buffer->size==4000);
+
+        BoltBuffer_shrink(buffer, 1024);
+        REQUIRE(buffer->size==1024);
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should not shrink while holding data") {
+        BoltBuffer* buffer = BoltBuffer_create(1024);
+        BoltBuffer_load_pointer(buffer, 100000);
+        BoltBuffer_unload_pointer(buffer, 100000);
+        BoltBuffer_shrink(buffer, 1024);
+        BoltBuffer_load_u8(buffer, 1);
+        BoltBuffer_shrink(buffer, 1024);
+        REQUIRE(buffer->size==100000);
+        BoltBuffer_destroy(buffer);
+    }
+}
+
+TEST_CASE("BoltRing", "[unit]")
+{
+    BoltRing* ring = BoltRing_create(1000);
+    REQUIRE(ring->size==1024);
+
+    SECTION("should wrap around") {
+        std::string loaded;
+        std::string unloaded;
+        char data[700];
+        for (int round = 0; round<20; round++) {
+            int64_t size;
+            char* target = BoltRing_load_pointer(ring, &size);
+            REQUIRE(size>0);
+            REQUIRE(size<=ring->size-BoltRing_unloadable(ring));
+            int64_t load = size<300 ? size : 300;
+            for (int64_t i = 0; i<load; i++) {
+                target[i] = (char) ('a'+(loaded.size()%26));
+                loaded += target[i];
+            }
+            BoltRing_loaded(ring, load);
+
+            int64_t unload = BoltRing_unload(ring, data, 250);
+            unloaded += std::string(data, (size_t) unload);
+        }
+        unloaded += std::string(data, (size_t) BoltRing_unload(ring, data, sizeof(data)));
+        REQUIRE(unloaded==loaded);
+        REQUIRE(BoltRing_unloadable(ring)==0);
+    }
+
+    SECTION("should offer the whole buffer once drained") {
+        int64_t size;
+        char data[100];
+        BoltRing_load_pointer(ring, &size);
+        BoltRing_loaded(ring, 100);
+        BoltRing_unload(ring, data, 100);
+        BoltRing_load_pointer(ring, &size);
+        REQUIRE(size==1024);
+    }
+
+    BoltRing_destroy(ring);
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "integration.hpp"
+#include "catch.hpp"
+
+extern "C"
+{
+#include "bolt/address-set-private.h"
+#include "bolt/circuit-breaker.h"
+#include "bolt/config-private.h"
+#include "bolt/routing-pool.h"
+#include "bolt/routing-table.h"
+#include "bolt/status-private.h"
+#include "bolt/time.h"
+}
+
+TEST_CASE("Circuit Breaker", "[unit]")
+{
+    BoltCircuitBreaker breaker;
+    BoltCircuitBreaker_init(&breaker);
+
+    SECTION("should stay closed below threshold") {
+        BoltCircuitBreaker_on_failure(&breaker, 3, 100);
+        BoltCircuitBreaker_on_failure(&breaker, 3, 100);
+
+        REQUIRE(breaker.state==BOLT_CIRCUIT_CLOSED);
+        REQUIRE(BoltCircuitBreaker_permit(&breaker, 1000, 100)==BOLT_SUCCESS);
+    }
+
+    SECTION("should reset failure count on success") {
+        BoltCircuitBreaker_on_failure(&breaker, 3, 100);
+        BoltCircuitBreaker_on_failure(&breaker, 3, 100);
+        BoltCircuitBreaker_on_success(&breaker);
+        BoltCircuitBreaker_on_failure(&breaker, 3, 100);
+
+        REQUIRE(breaker.state==BOLT_CIRCUIT_CLOSED);
+    }
+
+    SECTION("should open after consecutive failures") {
+        for (int i = 0; i<3; i++) {
+            BoltCircuitBreaker_on_failure(&breaker, 3, 100);
+        }
+
+        REQUIRE(breaker.state==BOLT_CIRCUIT_OPEN);
+        REQUIRE(BoltCircuitBreaker_is_available(&breaker, 1000, 500)==0);
+        REQUIRE(BoltCircuitBreaker_permit(&breaker, 1000, 500)==BOLT_ROUTING_CIRCUIT_OPEN);
+
+        SECTION("should hand out a single probe once reset time elapsed") {
+            REQUIRE(BoltCircuitBreaker_is_available(&breaker, 1000, 1100)==1);
+            REQUIRE(BoltCircuitBreaker_permit(&breaker, 1000, 1100)==BOLT_SUCCESS);
+            REQUIRE(breaker.state==BOLT_CIRCUIT_HALF_OPEN);
+            REQUIRE(BoltCircuitBreaker_permit(&breaker, 1000, 1100)==BOLT_ROUTING_CIRCUIT_OPEN);
+
+            SECTION("and close when the probe succeeds") {
+                BoltCircuitBreaker_on_success(&breaker);
+
+                REQUIRE(breaker.state==BOLT_CIRCUIT_CLOSED);
+                REQUIRE(breaker.failures==0);
+                REQUIRE(BoltCircuitBreaker_permit(&breaker, 1000, 1100)==BOLT_SUCCESS);
+            }
+
+            SECTION("and re-open when the probe fails") {
+                BoltCircuitBreaker_on_failure(&breaker, 3, 1200);
+
+                REQUIRE(breaker.state==BOLT_CIRCUIT_OPEN);
+                REQUIRE(BoltCircuitBreaker_permit(&breaker, 1000, 1500)==BOLT_ROUTING_CIRCUIT_OPEN);
+                REQUIRE(BoltCircuitBreaker_permit(&breaker, 1000, 2200)==BOLT_SUCCESS);
+            }
+        }
+    }
+}
+
+TEST_CASE("Routing Pool circuit breakers", "[unit]")
+{
+    BoltAddress* router = BoltAddress_create("localhost", "7687");
+    BoltAddress* reader = BoltAddress_create("reader", "7687");
+    BoltConfig* config = BoltConfig_create();
+    BoltConfig_set_scheme(config, BOLT_SCHEME_NEO4J);
+    BoltConfig_set_circuit_breaker_threshold(config, 3);
+    BoltConfig_set_circuit_breaker_reset_time(config, 60000);
+    struct BoltRoutingPool* pool = BoltRoutingPool_create(router, NULL, config);
+    BoltAddressSet_add(pool->routing_table->readers, reader);
+
+    SECTION("should forget a failing server and open its circuit after repeated failures") {
+        BoltRoutingPool_handle_connection_error_by_code(pool, reader, BOLT_CONNECTION_REFUSED);
+        REQUIRE(BoltAddressSet_index_of(pool->routing_table->readers, reader)<0);
+        REQUIRE(BoltRoutingPool_is_server_available(pool, reader));
+
+        // refreshed routing tables keep listing the server until the cluster notices it is gone
+        BoltAddressSet_add(pool->routing_table->readers, reader);
+        BoltRoutingPool_handle_connection_error_by_code(pool, reader, BOLT_CONNECTION_REFUSED);
+        BoltAddressSet_add(pool->routing_table->readers, reader);
+        BoltRoutingPool_handle_connection_error_by_code(pool, reader, BOLT_CONNECTION_REFUSED);
+        REQUIRE(!BoltRoutingPool_is_server_available(pool, reader));
+    }
+
+    SECTION("should expire the routing table when all candidates have their circuit open") {
+        BoltAddressSet_add(pool->routing_table->routers, router);
+        pool->routing_table->expires = BoltTime_get_time_ms()+60000;
+        for (int i = 0; i<3; i++) {
+            BoltRoutingPool_handle_connection_error_by_code(pool, reader, BOLT_CONNECTION_REFUSED);
+            BoltAddressSet_add(pool->routing_table->readers, reader);
+        }
+        REQUIRE(!RoutingTable_is_expired(pool->routing_table, BOLT_ACCESS_MODE_READ));
+
+        BoltStatus* status = BoltStatus_create();
+        REQUIRE(BoltRoutingPool_acquire(pool, BOLT_ACCESS_MODE_READ, status)==NULL);
+        REQUIRE(status->error==BOLT_ROUTING_CIRCUIT_OPEN);
+        REQUIRE(RoutingTable_is_expired(pool->routing_table, BOLT_ACCESS_MODE_READ));
+        BoltStatus_destroy(status);
+    }
+
+    SECTION("should drop the breaker of a server once it succeeds") {
+        BoltRoutingPool_handle_connection_error_by_code(pool, reader, BOLT_TIMED_OUT);
+        REQUIRE(pool->breaker_count==1);
+
+        BoltRoutingPool_record_server_success(pool, reader);
+        REQUIRE(pool->breaker_count==0);
+        REQUIRE(pool->breaker_servers->size==0);
+    }
+
+    SECTION("should drop the breakers of servers that left the routing table") {
+        BoltRoutingPool_handle_connection_error_by_code(pool, reader, BOLT_TIMED_OUT);
+        BoltAddressSet_add(pool->routing_table->readers, reader);
+        BoltRoutingPool_cleanup(pool);
+        REQUIRE(pool->breaker_count==1);
+
+        RoutingTable_forget_server(pool->routing_table, reader);
+        BoltRoutingPool_cleanup(pool);
+        REQUIRE(pool->breaker_count==0);
+        REQUIRE(pool->breaker_servers->size==0);
+    }
+
+    BoltRoutingPool_destroy(pool);
+    BoltConfig_destroy(config);
+    BoltAddress_destroy(reader);
+    BoltAddress_destroy(router);
+}
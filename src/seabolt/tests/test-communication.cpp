@@ -21,6 +21,7 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <sys/stat.h>
 #include "integration.hpp"
 #include "catch.hpp"
 #include "utils/test-context.h"
@@ -232,7 +233,8 @@ TEST_CASE("communication", "[unit]")
             REQUIRE(BoltAddress_resolve(remote2, NULL, NULL)==0);
             BoltAddress* remote = BoltAddress_create("127.0.0.1", "7687");
             remote->n_resolved_hosts = 2;
-            remote->resolved_hosts = (struct sockaddr_storage*) malloc(2*sizeof(struct sockaddr_storage));
+            remote->resolved_hosts = (struct sockaddr_storage*) BoltMem_allocate_tagged(BOLT_MEMORY_ROUTING,
+                    2*sizeof(struct sockaddr_storage));
             memcpy((void*) &remote->resolved_hosts[0], (void*) &remote1->resolved_hosts[0],
                     sizeof(struct sockaddr_storage));
             memcpy((void*) &remote->resolved_hosts[1], (void*) &remote2->resolved_hosts[0],
@@ -813,3 +815,153 @@ TEST_CASE("communication", "[unit]")
     BoltAddress_destroy(local);
 }
 
+
+TEST_CASE("wire capture and replay", "[unit]")
+{
+    const char server_stream[] = {
+            0x00, 0x00, 0x00, 0x03,
+            0x00, 0x03, (char) 0xB1, 0x70, (char) 0xA0, 0x00, 0x00,
+            0x00, 0x0D, (char) 0xB1, 0x70, (char) 0xA1, (char) 0x86, 'f', 'i', 'e', 'l', 'd', 's', (char) 0x91,
+            (char) 0x81, 'x', 0x00, 0x00,
+            0x00, 0x04, (char) 0xB1, 0x71, (char) 0x91, 0x01, 0x00, 0x00,
+            0x00, 0x03, (char) 0xB1, 0x70, (char) 0xA0, 0x00, 0x00
+    };
+    const char* path = "seabolt-capture-test.bolt";
+
+    BoltAddress* address = bolt_get_address("localhost", "7687");
+    BoltValue* auth_token = BoltAuth_basic("user", "capture-secret", NULL);
+    BoltConnection* connection = BoltConnection_create();
+    connection->comm = BoltCommunication_create_capture(
+            BoltCommunication_create_replay(server_stream, sizeof(server_stream), NULL, NULL), path);
+    BoltConnection_open(connection, BOLT_TRANSPORT_MOCKED, address, NULL, NULL, NULL);
+
+    REQUIRE(connection->protocol_version==3);
+    REQUIRE(BoltConnection_init(connection, "test", auth_token)==0);
+
+    const char* cypher = "RETURN 1";
+    BoltConnection_set_run_cypher(connection, cypher, strlen(cypher), 0);
+    BoltConnection_load_run_request(connection);
+    BoltConnection_load_pull_request(connection, -1);
+    BoltRequest pull = BoltConnection_last_request(connection);
+    REQUIRE(BoltConnection_send(connection)==BOLT_SUCCESS);
+
+    REQUIRE(BoltConnection_fetch(connection, pull)==1);
+    REQUIRE(BoltInteger_get(BoltList_value(BoltConnection_field_values(connection), 0))==1);
+    REQUIRE(BoltConnection_fetch(connection, pull)==0);
+    REQUIRE(BoltConnection_summary_success(connection)==1);
+    REQUIRE(BoltConnection_fetch(connection, pull+1)<0);
+
+    BoltConnection_close(connection);
+    BoltConnection_destroy(connection);
+
+    char* stream = NULL;
+    int64_t size = BoltCapture_load(path, BOLT_CAPTURE_SERVER, &stream);
+    REQUIRE(size==(int64_t) sizeof(server_stream));
+    REQUIRE(memcmp(stream, server_stream, sizeof(server_stream))==0);
+    BoltCapture_release(stream, size);
+
+    size = BoltCapture_load(path, BOLT_CAPTURE_CLIENT, &stream);
+    REQUIRE(size>4);
+    REQUIRE(memcmp(stream, "\x60\x60\xB0\x17", 4)==0);
+    std::string sent(stream, (size_t) size);
+    REQUIRE(sent.find("capture-secret")==std::string::npos);
+    REQUIRE(sent.find("RETURN 1")!=std::string::npos);
+    BoltCapture_release(stream, size);
+
+#ifndef _WIN32
+    struct stat capture_stat;
+    REQUIRE(stat(path, &capture_stat)==0);
+    REQUIRE((capture_stat.st_mode & 0777)==0600);
+#endif
+
+    REQUIRE(BoltCapture_load("no-such-capture.bolt", BOLT_CAPTURE_SERVER, &stream)==-1);
+
+    remove(path);
+    BoltValue_destroy(auth_token);
+    BoltAddress_destroy(address);
+}
+
+TEST_CASE("undecodable message", "[unit]")
+{
+    const char server_stream[] = {
+            0x00, 0x00, 0x00, 0x03,
+            0x00, 0x03, (char) 0xB1, 0x70, (char) 0xA0, 0x00, 0x00,
+            0x00, 0x04, (char) 0xB1, 0x71, (char) 0x91, (char) 0xE0, 0x00, 0x00,
+            0x00, 0x03, (char) 0xB1, 0x70, (char) 0xA0, 0x00, 0x00
+    };
+
+    BoltAddress* address = bolt_get_address("localhost", "7687");
+    BoltValue* auth_token = BoltAuth_none();
+    BoltConnection* connection = BoltConnection_create();
+    connection->comm = BoltCommunication_create_replay(server_stream, sizeof(server_stream), NULL, NULL);
+    BoltConnection_open(connection, BOLT_TRANSPORT_MOCKED, address, NULL, NULL, NULL);
+    REQUIRE(BoltConnection_init(connection, "test", auth_token)==0);
+
+    const char* cypher = "RETURN 1";
+    BoltConnection_set_run_cypher(connection, cypher, strlen(cypher), 0);
+    BoltConnection_load_run_request(connection);
+    BoltConnection_load_pull_request(connection, -1);
+    BoltRequest pull = BoltConnection_last_request(connection);
+    REQUIRE(BoltConnection_send(connection)==BOLT_SUCCESS);
+
+    // The rest of the stream cannot be trusted once a message fails to decode
+    REQUIRE(BoltConnection_fetch(connection, pull)==FETCH_ERROR);
+    REQUIRE(BoltConnection_status(connection)->state==BOLT_CONNECTION_STATE_DEFUNCT);
+    REQUIRE(BoltConnection_status(connection)->error==BOLT_PROTOCOL_UNEXPECTED_MARKER);
+
+    BoltConnection_close(connection);
+    BoltConnection_destroy(connection);
+    BoltValue_destroy(auth_token);
+    BoltAddress_destroy(address);
+}
+
+TEST_CASE("connection reopen", "[unit]")
+{
+    const char server_stream[] = {
+            0x00, 0x00, 0x00, 0x03,
+            0x00, 0x10, (char) 0xB1, 0x70, (char) 0xA1, (char) 0x86, 's', 'e', 'r', 'v', 'e', 'r', (char) 0x85,
+            'N', 'e', 'o', '/', '3', 0x00, 0x00
+    };
+
+    BoltAddress* address = bolt_get_address("localhost", "7687");
+    BoltValue* auth_token = BoltAuth_none();
+    BoltConnection* connection = BoltConnection_create();
+    connection->buffer_pool = BoltBufferPool_create(3, 1 << 20, 1);
+
+    connection->comm = BoltCommunication_create_replay(server_stream, sizeof(server_stream), NULL, NULL);
+    int64_t events = BoltMem_allocation_events();
+    BoltConnection_open(connection, BOLT_TRANSPORT_MOCKED, address, NULL, NULL, NULL);
+    int64_t open_events = BoltMem_allocation_events()-events;
+    REQUIRE(BoltConnection_init(connection, "test", auth_token)==0);
+    REQUIRE(strcmp(BoltConnection_server(connection), "Neo/3")==0);
+    struct BoltProtocol* protocol = connection->protocol;
+    BoltConnection_close(connection);
+
+    SECTION("should reuse the protocol state when the version is unchanged") {
+        connection->comm = BoltCommunication_create_replay(server_stream, sizeof(server_stream), NULL, NULL);
+        events = BoltMem_allocation_events();
+        BoltConnection_open(connection, BOLT_TRANSPORT_MOCKED, address, NULL, NULL, NULL);
+        // Only the endpoints reported by the socket are allocated anew
+        REQUIRE(BoltMem_allocation_events()-events<open_events/4);
+        REQUIRE(connection->protocol==protocol);
+        REQUIRE(connection->idle_protocol==nullptr);
+        REQUIRE(strcmp(BoltConnection_server(connection), "")==0);
+        REQUIRE(BoltConnection_init(connection, "test", auth_token)==0);
+        REQUIRE(strcmp(BoltConnection_server(connection), "Neo/3")==0);
+        BoltConnection_close(connection);
+    }
+
+    SECTION("should rebuild the protocol state when the version changes") {
+        const char v1_stream[] = {0x00, 0x00, 0x00, 0x01};
+        connection->comm = BoltCommunication_create_replay(v1_stream, sizeof(v1_stream), NULL, NULL);
+        BoltConnection_open(connection, BOLT_TRANSPORT_MOCKED, address, NULL, NULL, NULL);
+        REQUIRE(connection->protocol_version==1);
+        REQUIRE(connection->idle_protocol==nullptr);
+        BoltConnection_close(connection);
+    }
+
+    BoltBufferPool_destroy(connection->buffer_pool);
+    BoltConnection_destroy(connection);
+    BoltValue_destroy(auth_token);
+    BoltAddress_destroy(address);
+}
@@ -51,4 +51,42 @@ SCENARIO("BoltConnection")
 
         BoltConnection_destroy(connection);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("BoltConnectionMetrics", "[unit]")
+{
+    struct BoltConnection* connection = bolt_open_init_mocked(3, NULL);
+    const BoltConnectionMetrics* metrics = BoltConnection_metrics(connection);
+
+    SECTION("should count handshake traffic") {
+        REQUIRE(BoltConnectionMetrics_get_bytes_sent(metrics)==20);
+        REQUIRE(BoltConnectionMetrics_get_bytes_received(metrics)==4);
+        REQUIRE(BoltConnectionMetrics_get_messages_sent(metrics)==0);
+    }
+
+    SECTION("should count sent messages and bytes") {
+        BoltConnection_set_run_cypher(connection, "RETURN 1", 8, 0);
+        BoltConnection_load_run_request(connection);
+        BoltConnection_load_pull_request(connection, -1);
+        REQUIRE(BoltConnectionMetrics_get_messages_sent(metrics)==0);
+
+        BoltConnection_send(connection);
+        REQUIRE(BoltConnectionMetrics_get_messages_sent(metrics)==2);
+        REQUIRE(BoltConnectionMetrics_get_bytes_sent(metrics)>20);
+        REQUIRE(BoltConnectionMetrics_get_records_received(metrics)==0);
+    }
+
+    SECTION("should accumulate into another instance") {
+        BoltConnectionMetrics* total = BoltConnectionMetrics_create();
+        BoltConnectionMetrics_add(total, metrics);
+        BoltConnectionMetrics_add(total, metrics);
+
+        REQUIRE(BoltConnectionMetrics_get_bytes_sent(total)==40);
+        REQUIRE(BoltConnectionMetrics_get_bytes_received(total)==8);
+
+        BoltConnectionMetrics_destroy(total);
+    }
+
+    BoltConnection_close(connection);
+    BoltConnection_destroy(connection);
+}
@@ -20,6 +20,13 @@
 #include "integration.hpp"
 #include "catch.hpp"
 
+#include <thread>
+
+extern "C"
+{
+#include "bolt/sync.h"
+}
+
 TEST_CASE("Direct Pool", "[unit]")
 {
     BoltAddress* address = BoltAddress_create("localhost", "8888");
@@ -45,6 +52,43 @@ TEST_CASE("Direct Pool", "[unit]")
 
                 REQUIRE(connection==nullptr);
                 REQUIRE(status->error==BOLT_POOL_ACQUISITION_TIMED_OUT);
+
+                BoltPoolMetrics* metrics = BoltPoolMetrics_create();
+                BoltDirectPool_pool_metrics(pool, metrics);
+                REQUIRE(BoltPoolMetrics_get_acquisitions(metrics)==1);
+                REQUIRE(BoltPoolMetrics_get_acquisition_timeouts(metrics)==1);
+                REQUIRE(BoltPoolMetrics_get_pool_full_events(metrics)==1);
+                REQUIRE(BoltPoolMetrics_get_acquisition_time_max(metrics)>=1000000);
+                BoltPoolMetrics_destroy(metrics);
+            }
+
+            SECTION("should count a full pool once per acquisition") {
+                BoltConfig_set_max_pool_size(config, 1);
+                BoltConfig_set_max_connection_acquisition_time(config, 500);
+
+                pool = BoltDirectPool_create(address, auth_token, config);
+                pool->connections[0]->agent = "USED";
+
+                // wakes the waiting acquisition without releasing anything, so it finds the pool full again
+                std::thread waker([pool]() {
+                    BoltThread_sleep(100000);
+                    BoltSync_mutex_lock(&pool->mutex);
+                    BoltSync_cond_broadcast(&pool->released_cond);
+                    BoltSync_mutex_unlock(&pool->mutex);
+                });
+                BoltStatus* status = BoltStatus_create();
+                BoltConnection* connection = BoltDirectPool_acquire(pool, status);
+                waker.join();
+
+                REQUIRE(connection==nullptr);
+                REQUIRE(status->error==BOLT_POOL_ACQUISITION_TIMED_OUT);
+
+                BoltPoolMetrics* metrics = BoltPoolMetrics_create();
+                BoltDirectPool_pool_metrics(pool, metrics);
+                REQUIRE(BoltPoolMetrics_get_acquisitions(metrics)==1);
+                REQUIRE(BoltPoolMetrics_get_pool_full_events(metrics)==1);
+                BoltPoolMetrics_destroy(metrics);
+                BoltStatus_destroy(status);
             }
 
             BoltDirectPool_destroy(pool);
@@ -68,6 +112,14 @@ TEST_CASE("Direct Pool", "[unit]")
 
                 REQUIRE(connection==nullptr);
                 REQUIRE(status->error==BOLT_POOL_FULL);
+
+                BoltPoolMetrics* metrics = BoltPoolMetrics_create();
+                BoltDirectPool_pool_metrics(pool, metrics);
+                REQUIRE(BoltPoolMetrics_get_acquisitions(metrics)==1);
+                REQUIRE(BoltPoolMetrics_get_acquisition_timeouts(metrics)==0);
+                REQUIRE(BoltPoolMetrics_get_pool_full_events(metrics)==1);
+                REQUIRE(BoltPoolMetrics_get_connections_opened(metrics)==0);
+                BoltPoolMetrics_destroy(metrics);
             }
 
             BoltDirectPool_destroy(pool);
@@ -78,3 +130,88 @@ TEST_CASE("Direct Pool", "[unit]")
     BoltValue_destroy(auth_token);
     BoltAddress_destroy(address);
 }
+
+TEST_CASE("Direct Pool OpenMetrics export", "[unit]")
+{
+    BoltAddress* address = BoltAddress_create("localhost", "8888");
+    BoltValue* auth_token = BoltAuth_basic("user", "password", NULL);
+    BoltConfig* config = BoltConfig_create();
+    BoltConfig_set_scheme(config, BOLT_SCHEME_DIRECT);
+    BoltConfig_set_user_agent(config, "seabolt-test");
+    BoltConfig_set_max_pool_size(config, 10);
+
+    BoltConnector* connector = BoltConnector_create(address, auth_token, config);
+
+    SECTION("should render all families and terminate with EOF") {
+        int32_t length = BoltConnector_write_metrics(connector, NULL, 0);
+        REQUIRE(length>0);
+
+        char* text = (char*) malloc((size_t) length+1);
+        REQUIRE(BoltConnector_write_metrics(connector, text, length+1)==length);
+        REQUIRE(strlen(text)==(size_t) length);
+
+        std::string metrics(text);
+        REQUIRE(metrics.find("# TYPE seabolt_memory_allocated_bytes gauge\n")!=std::string::npos);
+        REQUIRE(metrics.find("seabolt_pool_size{host=\"localhost\",port=\"8888\"} 10\n")!=std::string::npos);
+        REQUIRE(metrics.find("seabolt_pool_connections_in_use{host=\"localhost\",port=\"8888\"} 0\n")
+                !=std::string::npos);
+        REQUIRE(metrics.find("seabolt_pool_acquisitions_total{host=\"localhost\",port=\"8888\"} 0\n")
+                !=std::string::npos);
+        REQUIRE(metrics.find("seabolt_pool_acquisition_seconds_bucket{host=\"localhost\",port=\"8888\",le=\"+Inf\"} 0\n")
+                !=std::string::npos);
+        REQUIRE(metrics.find("seabolt_connection_sent_bytes_total{host=\"localhost\",port=\"8888\"} 0\n")
+                !=std::string::npos);
+        REQUIRE(metrics.find("seabolt_routing_")==std::string::npos);
+        REQUIRE(metrics.substr(metrics.size()-6)=="# EOF\n");
+
+        free(text);
+    }
+
+    SECTION("should truncate to the provided buffer") {
+        char text[16];
+        int32_t length = BoltConnector_write_metrics(connector, text, sizeof(text));
+        REQUIRE(length>(int32_t) sizeof(text));
+        REQUIRE(std::string(text)=="# TYPE seabolt_");
+    }
+
+    SECTION("should hand out the text it reported the length of") {
+        int32_t length = BoltConnector_write_metrics(connector, NULL, 0);
+        // allocations in between change the exported memory statistics
+        BoltValue* values[8];
+        for (int i = 0; i<8; i++) {
+            values[i] = BoltValue_create();
+            BoltValue_format_as_String(values[i], "allocated in between", 20);
+        }
+
+        char* text = (char*) malloc((size_t) length+1);
+        REQUIRE(BoltConnector_write_metrics(connector, text, length+1)==length);
+        REQUIRE(strlen(text)==(size_t) length);
+        free(text);
+
+        for (int i = 0; i<8; i++) {
+            BoltValue_destroy(values[i]);
+        }
+    }
+
+    SECTION("should hand out kept text only once") {
+        std::string gauge = "seabolt_pool_acquisitions_total{host=\"localhost\",port=\"8888\"} ";
+        REQUIRE(BoltConnector_write_metrics(connector, NULL, 0)>0);
+        REQUIRE(BoltConnector_write_metrics(connector, NULL, 0)>0);
+
+        BoltStatus* status = BoltStatus_create();
+        BoltConnector_acquire(connector, BOLT_ACCESS_MODE_READ, status);
+        BoltStatus_destroy(status);
+
+        // the second query used up the text kept by the first, so this one renders the acquisition
+        int32_t length = BoltConnector_write_metrics(connector, NULL, 0);
+        char* text = (char*) malloc((size_t) length+1);
+        REQUIRE(BoltConnector_write_metrics(connector, text, length+1)==length);
+        REQUIRE(std::string(text).find(gauge+"1\n")!=std::string::npos);
+        free(text);
+    }
+
+    BoltConnector_destroy(connector);
+    BoltConfig_destroy(config);
+    BoltValue_destroy(auth_token);
+    BoltAddress_destroy(address);
+}
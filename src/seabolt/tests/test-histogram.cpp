@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "integration.hpp"
+#include "catch.hpp"
+
+extern "C"
+{
+#include "bolt/histogram.h"
+}
+
+TEST_CASE("BoltHistogram", "[unit]")
+{
+    BoltHistogram* histogram = new BoltHistogram;
+    BoltHistogram_init(histogram);
+
+    SECTION("should be empty") {
+        REQUIRE(histogram->count==0);
+        REQUIRE(BoltHistogram_value_at_percentile(histogram, 50.0)==0);
+    }
+
+    SECTION("should map values to contiguous buckets") {
+        int64_t previous = 0;
+        for (int64_t value = 1; value<((int64_t) 1 << 20); value = value*3/2+1) {
+            int index = BoltHistogram_bucket_index(value);
+            REQUIRE(index>=previous);
+            REQUIRE(BoltHistogram_bucket_upper_bound(index)>=value);
+            REQUIRE(BoltHistogram_bucket_upper_bound(index)-value<=value/BOLT_HISTOGRAM_SUB_BUCKET_COUNT);
+            previous = index;
+        }
+        REQUIRE(BoltHistogram_bucket_index(INT64_MAX)==BOLT_HISTOGRAM_BUCKET_COUNT-1);
+    }
+
+    SECTION("should report percentiles") {
+        for (int64_t value = 1; value<=1000; value++) {
+            BoltHistogram_record(histogram, value);
+        }
+
+        REQUIRE(histogram->count==1000);
+        REQUIRE(histogram->min==1);
+        REQUIRE(histogram->max==1000);
+        REQUIRE(histogram->sum==500500);
+        REQUIRE(BoltHistogram_value_at_percentile(histogram, 50.0)>=500);
+        REQUIRE(BoltHistogram_value_at_percentile(histogram, 50.0)<=516);
+        REQUIRE(BoltHistogram_value_at_percentile(histogram, 99.0)>=990);
+        REQUIRE(BoltHistogram_value_at_percentile(histogram, 100.0)==1000);
+
+        SECTION("and merge into another histogram") {
+            BoltHistogram* total = new BoltHistogram;
+            BoltHistogram_init(total);
+            BoltHistogram_record(total, 5000);
+            BoltHistogram_add(total, histogram);
+
+            REQUIRE(total->count==1001);
+            REQUIRE(total->min==1);
+            REQUIRE(total->max==5000);
+
+            delete total;
+        }
+    }
+
+    delete histogram;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "integration.hpp"
+#include "catch.hpp"
+
+extern "C"
+{
+#include "bolt/log-private.h"
+#include "bolt/log-async.h"
+}
+
+static void collect(void* state, const char* message)
+{
+    ((std::vector<std::string>*) state)->push_back(message);
+}
+
+TEST_CASE("Asynchronous logging", "[unit]")
+{
+    std::vector<std::string> messages;
+    BoltLog* log = BoltLog_create(&messages);
+    BoltLog_set_info_func(log, collect);
+    BoltLog_set_warning_func(log, collect);
+    BoltLog_set_async(log, 4096, 60000);
+
+    SECTION("should defer formatting until flushed") {
+        char peer[16];
+        strcpy(peer, "localhost:7687");
+        BoltLog_info(log, "[%s]: acquired %d of %" PRId64 " in %.2f ms, %5.1f%% %c %x %-4s|%*d|%.*s|",
+                peer, 3, (int64_t) 100, 1.5, 12.25, 'z', 255u, "ab", 4, 7, 2, "xyz");
+        // the original strings may change before the record is rendered
+        strcpy(peer, "changed");
+
+        REQUIRE(messages.empty());
+        BoltLog_flush(log);
+        REQUIRE(messages.size()==1);
+
+        REQUIRE(messages[0]=="[localhost:7687]: acquired 3 of 100 in 1.50 ms,  12.2% z ff ab  |   7|xy|");
+    }
+
+    SECTION("should only read strings up to their precision") {
+        // none of these are terminated within the precision
+        const char letters[4] = {'a', 'b', 'c', 'd'};
+        BoltLog_info(log, "%.3s|%.*s|%.0s|%-5.2s|", letters, 2, letters, letters, letters);
+        BoltLog_flush(log);
+
+        REQUIRE(messages.size()==1);
+        REQUIRE(messages[0]=="abc|ab||ab   |");
+    }
+
+    SECTION("should keep a ring per log on the same thread") {
+        std::vector<std::string> other_messages;
+        BoltLog* other = BoltLog_create(&other_messages);
+        BoltLog_set_info_func(other, collect);
+        BoltLog_set_async(other, 4096, 60000);
+        for (int i = 0; i<10; i++) {
+            BoltLog_info(log, "first %d", i);
+            BoltLog_info(other, "second %d", i);
+        }
+        BoltLog_flush(log);
+        BoltLog_flush(other);
+
+        REQUIRE(log->async->ring_count==1);
+        REQUIRE(other->async->ring_count==1);
+        REQUIRE(messages.size()==10);
+        REQUIRE(other_messages.size()==10);
+        REQUIRE(messages[9]=="first 9");
+        REQUIRE(other_messages[9]=="second 9");
+        BoltLog_destroy(other);
+    }
+
+    SECTION("should reclaim the rings of exited threads") {
+        for (int round = 0; round<3; round++) {
+            std::thread worker([log, round]() {
+                BoltLog_info(log, "worker %d", round);
+            });
+            worker.join();
+        }
+        BoltLog_flush(log);
+
+        REQUIRE(messages.size()==3);
+        REQUIRE(messages[2]=="worker 2");
+        REQUIRE(log->async->ring_count==0);
+    }
+
+    SECTION("should preserve order of messages per thread") {
+        std::thread other([log]() {
+            for (int i = 0; i<10; i++) {
+                BoltLog_info(log, "other %d", i);
+            }
+        });
+        for (int i = 0; i<10; i++) {
+            BoltLog_info(log, "main %d", i);
+        }
+        other.join();
+        BoltLog_flush(log);
+
+        REQUIRE(messages.size()==20);
+        int next_main = 0, next_other = 0;
+        for (const std::string& message : messages) {
+            if (message.rfind("main ", 0)==0) {
+                REQUIRE(message=="main "+std::to_string(next_main++));
+            }
+            else {
+                REQUIRE(message=="other "+std::to_string(next_other++));
+            }
+        }
+        REQUIRE(next_main==10);
+        REQUIRE(next_other==10);
+    }
+
+    SECTION("should wrap around the buffer") {
+        for (int round = 0; round<20; round++) {
+            for (int i = 0; i<20; i++) {
+                BoltLog_info(log, "message %d-%d with a somewhat longer payload %s", round, i, "to fill the buffer");
+            }
+            BoltLog_flush(log);
+        }
+
+        REQUIRE(messages.size()==400);
+        REQUIRE(messages[399]=="message 19-19 with a somewhat longer payload to fill the buffer");
+    }
+
+    SECTION("should drop and report messages when the buffer is full") {
+        for (int i = 0; i<1000; i++) {
+            BoltLog_info(log, "message %d", i);
+        }
+        BoltLog_flush(log);
+
+        REQUIRE(messages.size()<1000);
+        REQUIRE(messages[0]=="message 0");
+        REQUIRE(messages.back().find("log messages dropped")!=std::string::npos);
+    }
+
+    SECTION("should log unsupported conversions synchronously") {
+        BoltLog_info(log, "%Lf", (long double) 1.5);
+
+        REQUIRE(messages.size()==1);
+        REQUIRE(messages[0]=="1.500000");
+    }
+
+    SECTION("should deliver buffered messages on destroy") {
+        BoltLog_info(log, "pending");
+        BoltLog_destroy(log);
+        log = nullptr;
+
+        REQUIRE(messages.size()==1);
+        REQUIRE(messages[0]=="pending");
+    }
+
+    if (log!=nullptr) {
+        BoltLog_destroy(log);
+    }
+}
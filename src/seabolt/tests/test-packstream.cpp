@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "integration.hpp"
+#include "catch.hpp"
+
+#include <algorithm>
+#include <string>
+
+extern "C"
+{
+#include "bolt/packstream.h"
+#include "bolt/protocol.h"
+}
+
+static int any_structure(int16_t)
+{
+    return 1;
+}
+
+static int graph_structure(int16_t code)
+{
+    return code=='N' || code=='P';
+}
+
+static int temporal_structure(int16_t code)
+{
+    return code=='X' || code=='d';
+}
+
+static void populate(BoltValue* value)
+{
+    BoltValue_format_as_List(value, 9);
+    BoltValue_format_as_Null(BoltList_value(value, 0));
+    BoltValue_format_as_Boolean(BoltList_value(value, 1), 1);
+    BoltValue_format_as_Integer(BoltList_value(value, 2), -1234567890123LL);
+    BoltValue_format_as_Integer(BoltList_value(value, 3), -200);
+    BoltValue_format_as_Float(BoltList_value(value, 4), 3.25);
+    std::string text(70000, 'x');
+    BoltValue_format_as_String(BoltList_value(value, 5), text.c_str(), (int32_t) text.size());
+    BoltValue_format_as_Bytes(BoltList_value(value, 6), (char*) "\x01\x02\x03", 3);
+    struct BoltValue* map = BoltList_value(value, 7);
+    BoltValue_format_as_Dictionary(map, 2);
+    BoltDictionary_set_key(map, 0, "empty", 5);
+    BoltValue_format_as_List(BoltDictionary_value(map, 0), 0);
+    BoltDictionary_set_key(map, 1, "nested", 6);
+    BoltValue_format_as_List(BoltDictionary_value(map, 1), 1);
+    BoltValue_format_as_List(BoltList_value(BoltDictionary_value(map, 1), 0), 1);
+    BoltValue_format_as_Integer(BoltList_value(BoltList_value(BoltDictionary_value(map, 1), 0), 0), 42);
+    struct BoltValue* node = BoltList_value(value, 8);
+    BoltValue_format_as_Structure(node, 'N', 2);
+    BoltValue_format_as_Integer(BoltStructure_value(node, 0), 1);
+    BoltValue_format_as_String(BoltStructure_value(node, 1), "", 0);
+}
+
+static std::string encode(BoltValue* value)
+{
+    BoltBuffer* buffer = BoltBuffer_create(1024);
+    REQUIRE(load(&any_structure, buffer, value, NULL)==BOLT_SUCCESS);
+    std::string encoded(buffer->data, (size_t) buffer->extent);
+    BoltBuffer_destroy(buffer);
+    return encoded;
+}
+
+static int feed(PackStreamDecoder* decoder, const std::string& encoded, size_t slice)
+{
+    BoltBuffer* buffer = BoltBuffer_create(1024);
+    int status = BOLT_SUCCESS;
+    for (size_t offset = 0; offset<encoded.size() && status==BOLT_SUCCESS; offset += slice) {
+        REQUIRE(PackStreamDecoder_done(decoder)==0);
+        size_t size = std::min(slice, encoded.size()-offset);
+        BoltBuffer_load(buffer, encoded.data()+offset, (int) size);
+        status = PackStreamDecoder_feed(decoder, buffer, NULL);
+        BoltBuffer_compact(buffer);
+    }
+    BoltBuffer_destroy(buffer);
+    return status;
+}
+
+TEST_CASE("PackStreamDecoder", "[unit]")
+{
+    PackStreamDecoder* decoder = PackStreamDecoder_create(&any_structure);
+    BoltValue* expected = BoltValue_create();
+    BoltValue* actual = BoltValue_create();
+    populate(expected);
+    std::string encoded = encode(expected);
+
+    SECTION("should decode a value fed in slices of any size") {
+        for (size_t slice : {1, 2, 7, 4096, 1 << 20}) {
+            PackStreamDecoder_reset(decoder, actual);
+            REQUIRE(feed(decoder, encoded, slice)==BOLT_SUCCESS);
+            REQUIRE(PackStreamDecoder_done(decoder)==1);
+            REQUIRE(encode(actual)==encoded);
+        }
+    }
+
+    SECTION("should decode message fields and signature") {
+        std::string message = std::string("\xB2\x71", 2)+encoded+std::string("\x2A", 1);
+        PackStreamDecoder_reset_message(decoder, actual);
+        REQUIRE(feed(decoder, message, 3)==BOLT_SUCCESS);
+        REQUIRE(PackStreamDecoder_done(decoder)==1);
+        REQUIRE(PackStreamDecoder_message_code(decoder)==0x71);
+        REQUIRE(BoltValue_type(actual)==BOLT_LIST);
+        REQUIRE(actual->size==2);
+        REQUIRE(encode(BoltList_value(actual, 0))==encoded);
+        REQUIRE(BoltInteger_get(BoltList_value(actual, 1))==42);
+    }
+
+    SECTION("should leave data following a complete value in the buffer") {
+        BoltBuffer* buffer = BoltBuffer_create(16);
+        BoltBuffer_load(buffer, "\x01\x02", 2);
+        PackStreamDecoder_reset(decoder, actual);
+        REQUIRE(PackStreamDecoder_feed(decoder, buffer, NULL)==BOLT_SUCCESS);
+        REQUIRE(PackStreamDecoder_done(decoder)==1);
+        REQUIRE(BoltInteger_get(actual)==1);
+        REQUIRE(BoltBuffer_unloadable(buffer)==1);
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should pack long lists of scalars only if asked to") {
+        BoltValue_format_as_List(expected, 20);
+        for (int i = 0; i<20; i++) {
+            BoltValue_format_as_Integer(BoltList_value(expected, i), i*1000);
+        }
+        encoded = encode(expected);
+        PackStreamDecoder_reset(decoder, actual);
+        REQUIRE(feed(decoder, encoded, 4096)==BOLT_SUCCESS);
+        REQUIRE(BoltList_packed_type(actual)==BOLT_NULL);
+        REQUIRE(encode(actual)==encoded);
+
+        PackStreamDecoder_set_pack_lists(decoder, 1);
+        for (size_t slice : {1, 4096}) {
+            PackStreamDecoder_reset(decoder, actual);
+            REQUIRE(feed(decoder, encoded, slice)==BOLT_SUCCESS);
+            REQUIRE(BoltList_packed_type(actual)==BOLT_INTEGER);
+            REQUIRE(BoltList_integers(actual)[19]==19000);
+            REQUIRE(encode(actual)==encoded);
+        }
+
+        BoltBuffer* buffer = BoltBuffer_create(1024);
+        BoltBuffer_load(buffer, encoded.data(), (int) encoded.size());
+        REQUIRE(unload(&any_structure, buffer, actual, NULL)==BOLT_SUCCESS);
+        REQUIRE(BoltList_packed_type(actual)==BOLT_NULL);
+        BoltBuffer_load(buffer, encoded.data(), (int) encoded.size());
+        REQUIRE(unload_lazy(&any_structure, NULL, NULL, 1, buffer, actual, NULL)==BOLT_SUCCESS);
+        REQUIRE(BoltList_packed_type(actual)==BOLT_INTEGER);
+        REQUIRE(BoltList_integers(actual)[19]==19000);
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should unpack long lists once an element does not match") {
+        BoltValue_format_as_List(expected, 20);
+        for (int i = 0; i<20; i++) {
+            BoltValue_format_as_Float(BoltList_value(expected, i), i/4.0);
+        }
+        BoltValue_format_as_Integer(BoltList_value(expected, 17), 17);
+        encoded = encode(expected);
+        PackStreamDecoder_set_pack_lists(decoder, 1);
+        PackStreamDecoder_reset(decoder, actual);
+        REQUIRE(feed(decoder, encoded, 3)==BOLT_SUCCESS);
+        REQUIRE(BoltList_packed_type(actual)==BOLT_NULL);
+        REQUIRE(encode(actual)==encoded);
+
+        BoltBuffer* buffer = BoltBuffer_create(1024);
+        BoltBuffer_load(buffer, encoded.data(), (int) encoded.size());
+        REQUIRE(unload_lazy(&any_structure, NULL, NULL, 1, buffer, actual, NULL)==BOLT_SUCCESS);
+        REQUIRE(BoltList_packed_type(actual)==BOLT_NULL);
+        REQUIRE(encode(actual)==encoded);
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should decode graph structures lazily") {
+        BoltValue_format_as_List(expected, 2);
+        struct BoltValue* path = BoltList_value(expected, 0);
+        BoltValue_format_as_Structure(path, 'P', 2);
+        populate(BoltStructure_value(path, 0));
+        BoltValue_format_as_Integer(BoltStructure_value(path, 1), 3);
+        struct BoltValue* node = BoltList_value(expected, 1);
+        BoltValue_format_as_Structure(node, 'N', 3);
+        BoltValue_format_as_Integer(BoltStructure_value(node, 0), 7);
+        BoltValue_format_as_List(BoltStructure_value(node, 1), 1);
+        BoltValue_format_as_String(BoltList_value(BoltStructure_value(node, 1), 0), "Label", 5);
+        populate(BoltStructure_value(node, 2));
+        encoded = encode(expected);
+
+        BoltBuffer* buffer = BoltBuffer_create(1024);
+        for (size_t slice : {1, 3, 4096, 0}) {
+            if (slice==0) {
+                BoltBuffer_load(buffer, encoded.data(), (int) encoded.size());
+                REQUIRE(unload_lazy(&any_structure, &graph_structure, NULL, 0, buffer, actual, NULL)==BOLT_SUCCESS);
+                REQUIRE(BoltBuffer_unloadable(buffer)==0);
+            }
+            else {
+                PackStreamDecoder_reset(decoder, actual);
+                PackStreamDecoder_set_lazy(decoder, &graph_structure);
+                REQUIRE(feed(decoder, encoded, slice)==BOLT_SUCCESS);
+                REQUIRE(PackStreamDecoder_done(decoder)==1);
+            }
+            node = BoltList_value(actual, 1);
+            REQUIRE(BoltValue_is_lazy(BoltList_value(actual, 0))==1);
+            REQUIRE(BoltValue_is_lazy(node)==1);
+            REQUIRE(BoltValue_type(node)==BOLT_STRUCTURE);
+            REQUIRE(BoltStructure_code(node)=='N');
+            REQUIRE(BoltValue_size(node)==3);
+
+            // Only the fields up to the one accessed are decoded
+            REQUIRE(BoltInteger_get(BoltStructure_value(node, 0))==7);
+            REQUIRE(BoltValue_is_lazy(node)==1);
+            REQUIRE(BoltValue_type(node->data.extended.as_value+2)==BOLT_NULL);
+
+            BoltValue* copy = BoltValue_duplicate(node);
+            REQUIRE(BoltValue_is_lazy(copy)==1);
+            REQUIRE(encode(copy)==encode(BoltList_value(expected, 1)));
+            REQUIRE(BoltValue_is_lazy(copy)==0);
+            BoltValue_destroy(copy);
+
+            REQUIRE(encode(actual)==encoded);
+            REQUIRE(BoltValue_is_lazy(node)==0);
+        }
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should check the fields of lazily decoded structures as they are received") {
+        PackStreamDecoder_reset(decoder, actual);
+        PackStreamDecoder_set_lazy(decoder, &graph_structure);
+        REQUIRE(feed(decoder, std::string("\xB2\x4E\x01\xE0", 4), 1)==BOLT_PROTOCOL_UNEXPECTED_MARKER);
+
+        BoltBuffer* buffer = BoltBuffer_create(16);
+        BoltBuffer_load(buffer, "\xB2\x4E\x01\xE0", 4);
+        REQUIRE(unload_lazy(&any_structure, &graph_structure, NULL, 0, buffer, actual, NULL)
+                ==BOLT_PROTOCOL_UNEXPECTED_MARKER);
+        BoltBuffer_destroy(buffer);
+
+        // A truncated structure
+        buffer = BoltBuffer_create(16);
+        BoltBuffer_load(buffer, "\xB2\x4E\x01", 3);
+        REQUIRE(unload_lazy(&any_structure, &graph_structure, NULL, 0, buffer, actual, NULL)==BOLT_PROTOCOL_VIOLATION);
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should decode temporal and spatial structures packed") {
+        BoltValue_format_as_List(expected, 3);
+        struct BoltValue* point = BoltList_value(expected, 0);
+        BoltValue_format_as_Structure(point, 'X', 3);
+        BoltValue_format_as_Integer(BoltStructure_value(point, 0), 7203);
+        BoltValue_format_as_Float(BoltStructure_value(point, 1), 1.5);
+        BoltValue_format_as_Float(BoltStructure_value(point, 2), -2.5);
+        struct BoltValue* date_time = BoltList_value(expected, 1);
+        BoltValue_format_as_Structure(date_time, 'd', 2);
+        BoltValue_format_as_Integer(BoltStructure_value(date_time, 0), 1546300800);
+        BoltValue_format_as_Integer(BoltStructure_value(date_time, 1), 123456789);
+        // A field that is neither an integer nor a float is decoded as an ordinary structure
+        struct BoltValue* odd = BoltList_value(expected, 2);
+        BoltValue_format_as_Structure(odd, 'X', 3);
+        BoltValue_format_as_Integer(BoltStructure_value(odd, 0), 7203);
+        BoltValue_format_as_Null(BoltStructure_value(odd, 1));
+        BoltValue_format_as_Float(BoltStructure_value(odd, 2), 0.5);
+        encoded = encode(expected);
+
+        BoltBuffer* buffer = BoltBuffer_create(1024);
+        for (size_t slice : {1, 3, 4096, 0}) {
+            if (slice==0) {
+                BoltBuffer_load(buffer, encoded.data(), (int) encoded.size());
+                REQUIRE(unload_lazy(&any_structure, NULL, &temporal_structure, 0, buffer, actual, NULL)==BOLT_SUCCESS);
+                REQUIRE(BoltBuffer_unloadable(buffer)==0);
+            }
+            else {
+                PackStreamDecoder_reset(decoder, actual);
+                PackStreamDecoder_set_packed(decoder, &temporal_structure);
+                REQUIRE(feed(decoder, encoded, slice)==BOLT_SUCCESS);
+                REQUIRE(PackStreamDecoder_done(decoder)==1);
+            }
+            point = BoltList_value(actual, 0);
+            REQUIRE(BoltStructure_is_packed(point)==1);
+            REQUIRE(BoltStructure_integer(point, 0)==7203);
+            REQUIRE(BoltStructure_float(point, 1)==1.5);
+            REQUIRE(BoltStructure_float(point, 2)==-2.5);
+            date_time = BoltList_value(actual, 1);
+            REQUIRE(BoltStructure_is_packed(date_time)==1);
+            REQUIRE(date_time->data_size==0);
+            REQUIRE(BoltStructure_integer(date_time, 1)==123456789);
+            odd = BoltList_value(actual, 2);
+            REQUIRE(BoltStructure_is_packed(odd)==0);
+            REQUIRE(BoltStructure_integer(odd, 0)==7203);
+            REQUIRE(BoltValue_type(BoltStructure_value(odd, 1))==BOLT_NULL);
+            REQUIRE(BoltStructure_float(odd, 2)==0.5);
+
+            REQUIRE(encode(actual)==encoded);
+            REQUIRE(BoltStructure_is_packed(point)==1);
+        }
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should reject unknown markers") {
+        PackStreamDecoder_reset(decoder, actual);
+        REQUIRE(feed(decoder, std::string("\x91\xE0", 2), 1)==BOLT_PROTOCOL_UNEXPECTED_MARKER);
+    }
+
+    SECTION("should reject a message that is not a structure") {
+        PackStreamDecoder_reset_message(decoder, actual);
+        REQUIRE(feed(decoder, std::string("\x90", 1), 1)==BOLT_PROTOCOL_VIOLATION);
+    }
+
+    BoltValue_destroy(actual);
+    BoltValue_destroy(expected);
+    PackStreamDecoder_destroy(decoder);
+}
+
+struct SinkContext {
+    std::string flushed;
+    int flushes;
+    int max_buffered;
+};
+
+static int collect(void* context, BoltBuffer* buffer)
+{
+    SinkContext* sink_context = (SinkContext*) context;
+    int size = BoltBuffer_unloadable(buffer);
+    sink_context->max_buffered = std::max(sink_context->max_buffered, size);
+    sink_context->flushes += 1;
+    sink_context->flushed.append(BoltBuffer_unload_pointer(buffer, size), (size_t) size);
+    BoltBuffer_compact(buffer);
+    return BOLT_SUCCESS;
+}
+
+TEST_CASE("PackStream streaming encoder", "[unit]")
+{
+    BoltValue* value = BoltValue_create();
+    BoltValue_format_as_List(value, 3);
+    populate(BoltList_value(value, 0));
+    BoltValue_format_as_List(BoltList_value(value, 1), 50000);
+    for (int32_t i = 0; i<50000; i++) {
+        BoltValue_format_as_Integer(BoltList_value(BoltList_value(value, 1), i), (int64_t) i*i);
+    }
+    std::string bytes(200000, 'b');
+    BoltValue_format_as_Bytes(BoltList_value(value, 2), (char*) bytes.data(), (int32_t) bytes.size());
+    std::string encoded = encode(value);
+
+    SECTION("should hand over data whenever the threshold is reached") {
+        SinkContext context = {"", 0, 0};
+        PackStreamSink sink = {&collect, &context, 1000};
+        BoltBuffer* buffer = BoltBuffer_create(1024);
+        REQUIRE(load_streaming(&any_structure, buffer, value, &sink, NULL)==BOLT_SUCCESS);
+        context.flushed.append(BoltBuffer_unload_pointer(buffer, BoltBuffer_unloadable(buffer)),
+                (size_t) BoltBuffer_unloadable(buffer));
+        REQUIRE(context.flushes>100);
+        REQUIRE(context.max_buffered<2000);
+        REQUIRE(context.flushed==encoded);
+        BoltBuffer_destroy(buffer);
+    }
+
+    SECTION("should frame full chunks ahead of the rest of the message") {
+        BoltBuffer* msg_buffer = BoltBuffer_create(1024);
+        BoltBuffer* tx_buffer = BoltBuffer_create(1024);
+        BoltBuffer_load(msg_buffer, encoded.data(), (int) encoded.size());
+        push_chunks_to_transmission(msg_buffer, tx_buffer);
+        int full_chunks = (int) encoded.size()/BOLT_MAX_CHUNK_SIZE;
+        REQUIRE(BoltBuffer_unloadable(tx_buffer)==full_chunks*(BOLT_MAX_CHUNK_SIZE+2));
+        REQUIRE(BoltBuffer_unloadable(msg_buffer)==(int) encoded.size()%BOLT_MAX_CHUNK_SIZE);
+        push_to_transmission(msg_buffer, tx_buffer);
+
+        std::string dechunked;
+        while (BoltBuffer_unloadable(tx_buffer)>0) {
+            uint16_t chunk_size;
+            BoltBuffer_unload_u16be(tx_buffer, &chunk_size);
+            dechunked.append(BoltBuffer_unload_pointer(tx_buffer, chunk_size), chunk_size);
+        }
+        REQUIRE(dechunked==encoded);
+        BoltBuffer_destroy(tx_buffer);
+        BoltBuffer_destroy(msg_buffer);
+    }
+
+    BoltValue_destroy(value);
+}
@@ -29,7 +29,7 @@ SCENARIO("Test using a pooled connection", "[integration][ipv6][secure][pooling]
         struct BoltTrust trust{nullptr, 0, 1, 1};
         struct BoltConfig config{BOLT_SCHEME_DIRECT, BOLT_TRANSPORT_ENCRYPTED, &trust, BOLT_USER_AGENT, nullptr, nullptr,
                                  nullptr,
-                                 10, 0, 0, NULL};
+                                 10, 0, 0, NULL, 0, 0, NULL, 0, 0, 0, NULL};
         struct BoltConnector* connector = BoltConnector_create(&BOLT_IPV6_ADDRESS, auth_token, &config);
         WHEN("a connection is acquired") {
             BoltConnection* connection = BoltConnector_acquire(connector, BOLT_ACCESS_MODE_READ, status);
@@ -57,7 +57,7 @@ SCENARIO("Test reusing a pooled connection", "[integration][ipv6][secure][poolin
         struct BoltTrust trust{nullptr, 0, 1, 1};
         struct BoltConfig config{BOLT_SCHEME_DIRECT, BOLT_TRANSPORT_ENCRYPTED, &trust, BOLT_USER_AGENT, nullptr, nullptr,
                                  nullptr,
-                                 1, 0, 0, NULL};
+                                 1, 0, 0, NULL, 0, 0, NULL, 0, 0, 0, NULL};
         struct BoltConnector* connector = BoltConnector_create(&BOLT_IPV6_ADDRESS, auth_token, &config);
         WHEN("a connection is acquired, released and acquired again") {
             BoltConnection* connection1 = BoltConnector_acquire(connector, BOLT_ACCESS_MODE_READ, status1);
@@ -90,7 +90,7 @@ SCENARIO("Test reusing a pooled connection that was abandoned", "[integration][i
         const auto auth_token = BoltAuth_basic(BOLT_USER, BOLT_PASSWORD, NULL);
         struct BoltTrust trust{nullptr, 0, 1, 1};
         struct BoltConfig config{BOLT_SCHEME_DIRECT, BOLT_TRANSPORT_ENCRYPTED, &trust, BOLT_USER_AGENT, nullptr, nullptr,
-                                 nullptr, 1, 0, 0, NULL};
+                                 nullptr, 1, 0, 0, NULL, 0, 0, NULL, 0, 0, 0, NULL};
         struct BoltConnector* connector = BoltConnector_create(&BOLT_IPV6_ADDRESS, auth_token, &config);
         WHEN("a connection is acquired, released and acquired again") {
             BoltConnection* connection1 = BoltConnector_acquire(connector, BOLT_ACCESS_MODE_READ, status1);
@@ -136,7 +136,7 @@ SCENARIO("Test running out of connections", "[integration][ipv6][secure][pooling
         struct BoltTrust trust{nullptr, 0, 1, 1};
         struct BoltConfig config{BOLT_SCHEME_DIRECT, BOLT_TRANSPORT_ENCRYPTED, &trust, BOLT_USER_AGENT, nullptr, nullptr,
                                  nullptr,
-                                 1, 0, 0, NULL};
+                                 1, 0, 0, NULL, 0, 0, NULL, 0, 0, 0, NULL};
         struct BoltConnector* connector = BoltConnector_create(&BOLT_IPV6_ADDRESS, auth_token, &config);
         WHEN("two connections are acquired in turn") {
             BoltConnection* connection1 = BoltConnector_acquire(connector, BOLT_ACCESS_MODE_READ, status1);
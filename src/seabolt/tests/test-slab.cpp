@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "integration.hpp"
+#include "catch.hpp"
+
+extern "C"
+{
+#include "bolt/mem.h"
+#include "bolt/slab.h"
+#include "bolt/sync.h"
+}
+
+#define THREAD_BLOCKS 1000
+/// The size of the thread-local magazines in slab.c
+#define MAGAZINE_BLOCKS 32
+
+static void free_blocks(void* arg)
+{
+    void** blocks = (void**) arg;
+    for (int i = 0; i<THREAD_BLOCKS; i++) {
+        BoltSlab_deallocate(blocks[i], 3*BOLT_SLAB_GRANULE);
+    }
+}
+
+#define EXITING_THREAD_BLOCKS 8
+
+static void cycle_blocks(void* arg)
+{
+    void** blocks = (void**) arg;
+    for (int i = 0; i<EXITING_THREAD_BLOCKS; i++) {
+        blocks[i] = BoltSlab_allocate(5*BOLT_SLAB_GRANULE);
+    }
+    for (int i = 0; i<EXITING_THREAD_BLOCKS; i++) {
+        BoltSlab_deallocate(blocks[i], 5*BOLT_SLAB_GRANULE);
+    }
+}
+
+TEST_CASE("BoltSlab", "[unit]")
+{
+    int64_t allocation = BoltMem_current_allocation();
+
+    SECTION("should hand freed blocks out again") {
+        void* block = BoltSlab_allocate(40);
+        BoltSlab_deallocate(block, 40);
+        int64_t events = BoltMem_allocation_events();
+        void* reused = BoltSlab_allocate(2*BOLT_SLAB_GRANULE);
+        REQUIRE(reused==block);
+        REQUIRE(BoltMem_allocation_events()==events+1);
+        REQUIRE(BoltMem_current_allocation()==allocation+2*BOLT_SLAB_GRANULE);
+        BoltSlab_deallocate(reused, 2*BOLT_SLAB_GRANULE);
+    }
+
+    SECTION("should keep blocks that are adjusted within their size class") {
+        char* block = (char*) BoltSlab_adjust(NULL, 0, 33);
+        memset(block, 'x', 33);
+        REQUIRE(BoltSlab_adjust(block, 33, 64)==block);
+
+        char* larger = (char*) BoltSlab_adjust(block, 64, 65);
+        REQUIRE(larger!=block);
+        REQUIRE(larger[32]=='x');
+        char* huge = (char*) BoltSlab_adjust(larger, 65, 4096);
+        REQUIRE(huge[32]=='x');
+        char* smaller = (char*) BoltSlab_adjust(huge, 4096, 40);
+        REQUIRE(smaller[32]=='x');
+        REQUIRE(BoltSlab_adjust(smaller, 40, 0)==nullptr);
+    }
+
+    SECTION("should take back blocks freed by other threads") {
+        void* blocks[THREAD_BLOCKS];
+        for (int i = 0; i<THREAD_BLOCKS; i++) {
+            blocks[i] = BoltSlab_allocate(3*BOLT_SLAB_GRANULE);
+            memset(blocks[i], i, 3*BOLT_SLAB_GRANULE);
+        }
+        thread_t thread;
+        BoltThread_create(&thread, &free_blocks, blocks);
+        BoltThread_join(&thread);
+        for (int i = 0; i<THREAD_BLOCKS; i++) {
+            blocks[i] = BoltSlab_allocate(3*BOLT_SLAB_GRANULE);
+        }
+        for (int i = 0; i<THREAD_BLOCKS; i++) {
+            BoltSlab_deallocate(blocks[i], 3*BOLT_SLAB_GRANULE);
+        }
+    }
+
+    SECTION("should take back the blocks left in the magazines of exited threads") {
+        void* exited[EXITING_THREAD_BLOCKS];
+        thread_t thread;
+        BoltThread_create(&thread, &cycle_blocks, exited);
+        BoltThread_join(&thread);
+
+        // Draining this thread's magazine refills it from the depot, which the exited thread's blocks went to
+        void* blocks[4*MAGAZINE_BLOCKS];
+        int found = 0;
+        for (int i = 0; i<4*MAGAZINE_BLOCKS; i++) {
+            blocks[i] = BoltSlab_allocate(5*BOLT_SLAB_GRANULE);
+            for (int j = 0; j<EXITING_THREAD_BLOCKS; j++) {
+                found += blocks[i]==exited[j] ? 1 : 0;
+            }
+        }
+        REQUIRE(found==EXITING_THREAD_BLOCKS);
+        for (int i = 0; i<4*MAGAZINE_BLOCKS; i++) {
+            BoltSlab_deallocate(blocks[i], 5*BOLT_SLAB_GRANULE);
+        }
+    }
+
+    SECTION("should let blocks be freed after shutdown") {
+        void* block = BoltSlab_allocate(40);
+        BoltSlab_shutdown();
+        BoltSlab_deallocate(block, 40);
+        BoltSlab_startup();
+
+        block = BoltSlab_allocate(40);
+        REQUIRE(block!=NULL);
+        BoltSlab_deallocate(block, 40);
+    }
+
+    REQUIRE(BoltMem_current_allocation()==allocation);
+}
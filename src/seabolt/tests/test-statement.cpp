@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "integration.hpp"
+#include "catch.hpp"
+
+#include <string>
+
+extern "C"
+{
+#include "bolt/protocol.h"
+#include "bolt/statement-private.h"
+#include "bolt/writer-private.h"
+}
+
+static int writable(int16_t code)
+{
+    return code==0x10;
+}
+
+static std::string encode(struct BoltMessage* message)
+{
+    BoltBuffer* buffer = BoltBuffer_create(256);
+    REQUIRE(write_message(message, &writable, buffer, NULL, NULL)==BOLT_SUCCESS);
+    std::string encoded(buffer->data, (size_t) buffer->extent);
+    BoltBuffer_destroy(buffer);
+    return encoded;
+}
+
+TEST_CASE("BoltStatement", "[unit]")
+{
+    SECTION("should keep the cypher text") {
+        BoltStatement* statement = BoltStatement_create("RETURN 1", 8);
+        REQUIRE(std::string(BoltStatement_cypher(statement), (size_t) BoltStatement_cypher_size(statement))
+                =="RETURN 1");
+        BoltStatement_destroy(statement);
+    }
+
+    SECTION("should encode the same bytes as the cypher string") {
+        for (int32_t size : {0, 15, 16, 255, 256, 65535, 65536}) {
+            std::string cypher((size_t) size, 'x');
+            BoltStatement* statement = BoltStatement_create(cypher.data(), (uint64_t) size);
+            BoltValue* value = BoltValue_create();
+            BoltValue_format_as_String(value, cypher.data(), size);
+
+            BoltBuffer* buffer = BoltBuffer_create(256);
+            REQUIRE(load(&writable, buffer, value, NULL)==BOLT_SUCCESS);
+            REQUIRE(std::string(statement->encoded, (size_t) statement->encoded_size)
+                    ==std::string(buffer->data, (size_t) buffer->extent));
+
+            BoltBuffer_destroy(buffer);
+            BoltValue_destroy(value);
+            BoltStatement_destroy(statement);
+        }
+    }
+}
+
+TEST_CASE("BoltRunEncoding", "[unit]")
+{
+    struct BoltMessage* run = BoltMessage_create(0x10, 2);
+    BoltValue_format_as_String(BoltMessage_param(run, 0), "RETURN $x", 9);
+    BoltValue_format_as_Dictionary(BoltMessage_param(run, 1), 1);
+    BoltDictionary_set_key(BoltMessage_param(run, 1), 0, "x", 1);
+    BoltValue_format_as_Integer(BoltDictionary_value(BoltMessage_param(run, 1), 0), 1);
+    const std::string from_tree = encode(run);
+    const std::string parameters("\xA1\x81x\x01", 4);
+
+    BoltStatement* statement = BoltStatement_create("RETURN $x", 9);
+    struct BoltRunEncoding encoding = {NULL, NULL, 0, NULL, 0};
+
+    SECTION("should send the encoded statement and parameters") {
+        BoltValue_format_as_String(BoltMessage_param(run, 0), "", 0);
+        BoltValue_format_as_Dictionary(BoltMessage_param(run, 1), 0);
+        encoding.statement = statement;
+        REQUIRE(BoltRunEncoding_set_parameters(&encoding, &writable, parameters.data(), (int32_t) parameters.size())
+                ==BOLT_SUCCESS);
+        REQUIRE(BoltRunEncoding_apply(&encoding, run)==BOLT_SUCCESS);
+        REQUIRE(encode(run)==from_tree);
+    }
+
+    SECTION("should send the field values once cleared") {
+        encoding.statement = statement;
+        REQUIRE(BoltRunEncoding_apply(&encoding, run)==BOLT_SUCCESS);
+        BoltRunEncoding_clear(&encoding);
+        REQUIRE(BoltRunEncoding_apply(&encoding, run)==BOLT_SUCCESS);
+        REQUIRE(encode(run)==from_tree);
+    }
+
+    SECTION("should reject parameters that are not a map") {
+        REQUIRE(BoltRunEncoding_set_parameters(&encoding, &writable, "\x91\x01", 2)==BOLT_PROTOCOL_VIOLATION);
+        REQUIRE(BoltRunEncoding_set_parameters(&encoding, &writable, parameters.data(), 0)==BOLT_PROTOCOL_VIOLATION);
+        REQUIRE(encoding.parameters==NULL);
+    }
+
+    SECTION("should reject parameters that are incomplete or hold structures that cannot be sent") {
+        REQUIRE(BoltRunEncoding_set_parameters(&encoding, &writable, parameters.data(), 3)==BOLT_PROTOCOL_VIOLATION);
+        const std::string trailing = parameters+std::string("\x01", 1);
+        REQUIRE(BoltRunEncoding_set_parameters(&encoding, &writable, trailing.data(), (int32_t) trailing.size())
+                ==BOLT_PROTOCOL_VIOLATION);
+        const std::string node("\xA1\x81x\xB3\x4E\x01\x90\xA0", 8);
+        REQUIRE(BoltRunEncoding_set_parameters(&encoding, &writable, node.data(), (int32_t) node.size())
+                ==BOLT_PROTOCOL_UNEXPECTED_MARKER);
+        const std::string message("\xA1\x81x\xB2\x10\x80\xA0", 7);
+        REQUIRE(BoltRunEncoding_set_parameters(&encoding, &writable, message.data(), (int32_t) message.size())
+                ==BOLT_SUCCESS);
+        REQUIRE(encoding.parameters==message.data());
+    }
+
+    BoltStatement_destroy(statement);
+    BoltMessage_destroy(run);
+}
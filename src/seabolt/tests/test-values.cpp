@@ -712,4 +712,231 @@ TEST_CASE("BoltValue")
 
         BoltValue_destroy(value);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("packed BoltValue lists", "[unit]")
+{
+    BoltValue* value = BoltValue_create();
+
+    SECTION("should store elements densely") {
+        BoltValue_format_as_packed_List(value, BOLT_INTEGER, 1000);
+        REQUIRE_BOLT_LIST(value, 1000);
+        REQUIRE(BoltList_packed_type(value)==BOLT_INTEGER);
+        REQUIRE(value->data_size==1000*sizeof(int64_t));
+        REQUIRE(BoltList_floats(value)==nullptr);
+        int64_t* integers = BoltList_integers(value);
+        for (int i = 0; i<1000; i++) {
+            REQUIRE(integers[i]==0);
+            integers[i] = i;
+        }
+        BoltList_resize(value, 1001);
+        REQUIRE(BoltList_integers(value)[999]==999);
+        REQUIRE(BoltList_integers(value)[1000]==0);
+    }
+
+    SECTION("should unpack on access to an element") {
+        BoltValue_format_as_packed_List(value, BOLT_FLOAT, 3);
+        BoltList_floats(value)[1] = 2.5;
+        REQUIRE_BOLT_FLOAT(BoltList_value(value, 1), 2.5);
+        REQUIRE(BoltList_packed_type(value)==BOLT_NULL);
+        REQUIRE(BoltList_floats(value)==nullptr);
+        REQUIRE_BOLT_LIST(value, 3);
+        REQUIRE_BOLT_FLOAT(BoltList_value(value, 0), 0.0);
+    }
+
+    SECTION("should copy and write without unpacking") {
+        BoltValue_format_as_packed_List(value, BOLT_BOOLEAN, 2);
+        BoltList_booleans(value)[1] = 1;
+        BoltValue* copy = BoltValue_duplicate(value);
+        REQUIRE(BoltList_packed_type(copy)==BOLT_BOOLEAN);
+        REQUIRE(BoltList_booleans(copy)[1]==1);
+        char buffer[32];
+        REQUIRE(BoltValue_to_string(copy, buffer, sizeof(buffer), nullptr)==13);
+        REQUIRE(strcmp(buffer, "[false, true]")==0);
+        REQUIRE(BoltList_packed_type(copy)==BOLT_BOOLEAN);
+        BoltValue_destroy(copy);
+    }
+
+    SECTION("should be reformatted as an ordinary value") {
+        BoltValue_format_as_packed_List(value, BOLT_INTEGER, 10);
+        BoltValue_format_as_List(value, 2);
+        REQUIRE(BoltList_packed_type(value)==BOLT_NULL);
+        REQUIRE_BOLT_NULL(BoltList_value(value, 1));
+        BoltValue_format_as_packed_List(value, BOLT_INTEGER, 10);
+        BoltValue_format_as_String(value, "x", 1);
+        REQUIRE_BOLT_STRING(value, "x", 1);
+    }
+
+    BoltValue_destroy(value);
+}
+
+TEST_CASE("packed BoltValue structures", "[unit]")
+{
+    BoltValue* value = BoltValue_create();
+
+    SECTION("should store up to two fields inline") {
+        BoltValue_format_as_packed_Structure(value, 'd', 2);
+        REQUIRE_BOLT_STRUCTURE(value, 'd', 2);
+        REQUIRE(BoltStructure_is_packed(value)==1);
+        REQUIRE(value->data_size==0);
+        REQUIRE(BoltStructure_integer(value, 1)==0);
+        BoltStructure_set_integer(value, 0, 1546300800);
+        BoltStructure_set_integer(value, 1, 999999999);
+        REQUIRE(BoltStructure_integer(value, 0)==1546300800);
+        REQUIRE(BoltStructure_integer(value, 1)==999999999);
+
+        BoltValue_format_as_packed_Structure(value, 'Y', 4);
+        REQUIRE(value->data_size==4*sizeof(int64_t));
+        REQUIRE(BoltStructure_integer(value, 3)==0);
+    }
+
+    SECTION("should keep the type of each field") {
+        BoltValue_format_as_packed_Structure(value, 'X', 3);
+        BoltStructure_set_integer(value, 0, 7203);
+        BoltStructure_set_float(value, 1, 1.5);
+        BoltStructure_set_float(value, 2, -2.25);
+        REQUIRE(BoltStructure_integer(value, 0)==7203);
+        REQUIRE(BoltStructure_float(value, 0)==0.0);
+        REQUIRE(BoltStructure_float(value, 1)==1.5);
+        REQUIRE(BoltStructure_integer(value, 1)==0);
+        BoltStructure_set_integer(value, 2, 4);
+        REQUIRE(BoltStructure_integer(value, 2)==4);
+        REQUIRE(BoltValue_type(value)==BOLT_STRUCTURE);
+    }
+
+    SECTION("should unpack on access to a field") {
+        BoltValue_format_as_packed_Structure(value, 'X', 3);
+        BoltStructure_set_integer(value, 0, 7203);
+        BoltStructure_set_float(value, 2, 2.5);
+        REQUIRE_BOLT_FLOAT(BoltStructure_value(value, 2), 2.5);
+        REQUIRE(BoltStructure_is_packed(value)==0);
+        REQUIRE_BOLT_STRUCTURE(value, 'X', 3);
+        REQUIRE_BOLT_INTEGER(BoltStructure_value(value, 0), 7203);
+        REQUIRE_BOLT_INTEGER(BoltStructure_value(value, 1), 0);
+        // The typed accessors also read ordinary structures
+        REQUIRE(BoltStructure_integer(value, 0)==7203);
+        REQUIRE(BoltStructure_float(value, 2)==2.5);
+        BoltStructure_set_float(value, 1, 0.5);
+        REQUIRE_BOLT_FLOAT(BoltStructure_value(value, 1), 0.5);
+    }
+
+    SECTION("should copy and write without unpacking") {
+        BoltValue_format_as_packed_Structure(value, 'X', 3);
+        BoltStructure_set_integer(value, 0, 7203);
+        BoltStructure_set_float(value, 1, 1.5);
+        BoltStructure_set_float(value, 2, 3.0);
+        BoltValue* copy = BoltValue_duplicate(value);
+        REQUIRE(BoltStructure_is_packed(copy)==1);
+        REQUIRE(BoltStructure_float(copy, 1)==1.5);
+        char buffer[64];
+        REQUIRE(BoltValue_to_string(copy, buffer, sizeof(buffer), nullptr)==32);
+        REQUIRE(strcmp(buffer, "$#0058(7203, 1.500000, 3.000000)")==0);
+        REQUIRE(BoltStructure_is_packed(copy)==1);
+        BoltValue_destroy(copy);
+    }
+
+    SECTION("should be unpacked when shared") {
+        BoltValue_format_as_packed_Structure(value, 'E', 4);
+        BoltStructure_set_integer(value, 3, 500);
+        BoltValue_share(value);
+        REQUIRE(BoltStructure_is_packed(value)==0);
+        REQUIRE(BoltValue_is_shared(value)==1);
+        REQUIRE(BoltStructure_integer(value, 3)==500);
+    }
+
+    SECTION("should be reformatted as an ordinary value") {
+        BoltValue_format_as_packed_Structure(value, 'E', 4);
+        BoltValue_format_as_Structure(value, 'N', 2);
+        REQUIRE(BoltStructure_is_packed(value)==0);
+        REQUIRE_BOLT_NULL(BoltStructure_value(value, 1));
+        BoltValue_format_as_packed_Structure(value, 'D', 1);
+        BoltValue_format_as_String(value, "x", 1);
+        REQUIRE_BOLT_STRING(value, "x", 1);
+    }
+
+    BoltValue_destroy(value);
+}
+
+TEST_CASE("shared BoltValues", "[unit]")
+{
+    const char* name = "a name too long to be held inline";
+    const int32_t name_size = (int32_t) strlen(name);
+    int64_t allocation = BoltMem_current_allocation();
+    BoltValue* value = BoltValue_create();
+    BoltValue_format_as_Dictionary(value, 2);
+    BoltDictionary_set_key(value, 0, "name", 4);
+    BoltValue_format_as_String(BoltDictionary_value(value, 0), name, name_size);
+    BoltDictionary_set_key(value, 1, "items", 5);
+    BoltValue_format_as_List(BoltDictionary_value(value, 1), 3);
+    for (int i = 0; i<3; i++) {
+        BoltValue_format_as_Integer(BoltList_value(BoltDictionary_value(value, 1), i), i);
+    }
+    BoltValue_share(value);
+
+    SECTION("should share nested values") {
+        REQUIRE(BoltValue_is_shared(value));
+        REQUIRE_BOLT_DICTIONARY(value, 2);
+        REQUIRE(BoltValue_is_shared(BoltDictionary_value(value, 0)));
+        REQUIRE(BoltValue_is_shared(BoltDictionary_value(value, 1)));
+        REQUIRE(!BoltValue_is_shared(BoltDictionary_key(value, 0)));
+        REQUIRE_BOLT_STRING(BoltDictionary_value(value, 0), name, name_size);
+        REQUIRE_BOLT_INTEGER(BoltList_value(BoltDictionary_value(value, 1), 2), 2);
+    }
+
+    SECTION("should reference the data on copy") {
+        int64_t events = BoltMem_allocation_events();
+        BoltValue* copy = BoltValue_duplicate(value);
+        BoltValue* name_copy = BoltValue_duplicate(BoltDictionary_value(value, 0));
+        REQUIRE(BoltMem_allocation_events()==events+2);
+        REQUIRE(BoltDictionary_value(copy, 1)==BoltDictionary_value(value, 1));
+        REQUIRE(BoltString_get(name_copy)==BoltString_get(BoltDictionary_value(value, 0)));
+        BoltValue_destroy(name_copy);
+        BoltValue_destroy(copy);
+        REQUIRE_BOLT_STRING(BoltDictionary_value(value, 0), name, name_size);
+    }
+
+    SECTION("should copy on write") {
+        BoltValue* copy = BoltValue_duplicate(value);
+        BoltDictionary_set_key(copy, 0, "other", 5);
+        REQUIRE(!BoltValue_is_shared(copy));
+        REQUIRE(strncmp(BoltDictionary_get_key(value, 0), "name", 4)==0);
+        REQUIRE(strncmp(BoltDictionary_get_key(copy, 0), "other", 5)==0);
+
+        BoltValue_format_as_Dictionary(copy, 3);
+        REQUIRE_BOLT_DICTIONARY(value, 2);
+        BoltList_resize(BoltDictionary_value(copy, 1), 1);
+        REQUIRE_BOLT_LIST(BoltDictionary_value(copy, 1), 1);
+        REQUIRE_BOLT_LIST(BoltDictionary_value(value, 1), 3);
+        BoltValue_format_as_String(BoltDictionary_value(copy, 0), "x", 1);
+        REQUIRE_BOLT_STRING(BoltDictionary_value(value, 0), name, name_size);
+        BoltValue_destroy(copy);
+    }
+
+    SECTION("should allow nested values to be changed once unshared") {
+        BoltValue* copy = BoltValue_duplicate(value);
+        BoltValue_unshare(copy);
+        REQUIRE(!BoltValue_is_shared(copy));
+        REQUIRE(BoltValue_is_shared(BoltDictionary_value(copy, 1)));
+        BoltValue_format_as_Integer(BoltDictionary_value(copy, 1), 42);
+        REQUIRE_BOLT_LIST(BoltDictionary_value(value, 1), 3);
+        BoltValue_destroy(copy);
+
+        BoltValue_unshare(value);
+        REQUIRE(!BoltValue_is_shared(value));
+        REQUIRE_BOLT_STRING(BoltDictionary_value(value, 0), name, name_size);
+    }
+
+    SECTION("should unpack packed lists") {
+        BoltValue* list = BoltValue_create();
+        BoltValue_format_as_packed_List(list, BOLT_INTEGER, 20);
+        BoltList_integers(list)[19] = 19;
+        BoltValue_share(list);
+        REQUIRE(BoltValue_is_shared(list));
+        REQUIRE(BoltList_packed_type(list)==BOLT_NULL);
+        REQUIRE_BOLT_INTEGER(BoltList_value(list, 19), 19);
+        BoltValue_destroy(list);
+    }
+
+    BoltValue_destroy(value);
+    REQUIRE(BoltMem_current_allocation()==allocation);
+}
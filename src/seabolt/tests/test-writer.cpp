@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2002-2019 "Neo4j,"
+ * Neo4j Sweden AB [http://neo4j.com]
+ *
+ * This file is part of Neo4j.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "integration.hpp"
+#include "catch.hpp"
+
+#include <climits>
+#include <string>
+
+extern "C"
+{
+#include "bolt/packstream.h"
+#include "bolt/protocol.h"
+#include "bolt/writer-private.h"
+}
+
+static int writable(int16_t code)
+{
+    return code=='X' || code==0x10;
+}
+
+static std::string encode(BoltValue* value)
+{
+    BoltBuffer* buffer = BoltBuffer_create(256);
+    REQUIRE(load(&writable, buffer, value, NULL)==BOLT_SUCCESS);
+    std::string encoded(buffer->data, (size_t) buffer->extent);
+    BoltBuffer_destroy(buffer);
+    return encoded;
+}
+
+static std::string written(BoltWriter* writer)
+{
+    return std::string(BoltWriter_data(writer), (size_t) BoltWriter_size(writer));
+}
+
+struct FlushedData {
+    std::string flushed;
+    int max_buffered;
+};
+
+static int flush(void* context, BoltBuffer* buffer)
+{
+    FlushedData* data = (FlushedData*) context;
+    int size = BoltBuffer_unloadable(buffer);
+    data->max_buffered = size>data->max_buffered ? size : data->max_buffered;
+    data->flushed.append(BoltBuffer_unload_pointer(buffer, size), (size_t) size);
+    BoltBuffer_compact(buffer);
+    return BOLT_SUCCESS;
+}
+
+TEST_CASE("BoltWriter", "[unit]")
+{
+    BoltWriter* writer = BoltWriter_create_with_check(&writable);
+    BoltValue* expected = BoltValue_create();
+
+    SECTION("should encode the same bytes as the equivalent value tree") {
+        BoltValue_format_as_Dictionary(expected, 3);
+        BoltDictionary_set_key(expected, 0, "id", 2);
+        BoltValue_format_as_Integer(BoltDictionary_value(expected, 0), -70000);
+        BoltDictionary_set_key(expected, 1, "tags", 4);
+        struct BoltValue* tags = BoltDictionary_value(expected, 1);
+        BoltValue_format_as_List(tags, 5);
+        BoltValue_format_as_String(BoltList_value(tags, 0), "a", 1);
+        BoltValue_format_as_Null(BoltList_value(tags, 1));
+        BoltValue_format_as_Boolean(BoltList_value(tags, 2), 1);
+        BoltValue_format_as_Float(BoltList_value(tags, 3), 1.5);
+        BoltValue_format_as_Bytes(BoltList_value(tags, 4), (char*) "\x00\x01", 2);
+        BoltDictionary_set_key(expected, 2, "point", 5);
+        struct BoltValue* point = BoltDictionary_value(expected, 2);
+        BoltValue_format_as_Structure(point, 'X', 3);
+        BoltValue_format_as_Integer(BoltStructure_value(point, 0), 7203);
+        BoltValue_format_as_Float(BoltStructure_value(point, 1), 1.0);
+        BoltValue_format_as_Float(BoltStructure_value(point, 2), 2.0);
+
+        REQUIRE(BoltWriter_begin_map(writer, 3)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_key(writer, "id", 2)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_integer(writer, -70000)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_key(writer, "tags", 4)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_begin_list(writer, 5)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_string(writer, "a", 1)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_null(writer)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_boolean(writer, 1)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_float(writer, 1.5)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_bytes(writer, "\x00\x01", 2)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_complete(writer)==0);
+        REQUIRE(BoltWriter_end(writer)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_key(writer, "point", 5)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_value(writer, point)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_end(writer)==BOLT_SUCCESS);
+
+        REQUIRE(BoltWriter_complete(writer)==1);
+        REQUIRE(written(writer)==encode(expected));
+
+        SECTION("and be reusable after a reset") {
+            BoltWriter_reset(writer);
+            REQUIRE(BoltWriter_size(writer)==0);
+            REQUIRE(BoltWriter_begin_map(writer, 0)==BOLT_SUCCESS);
+            REQUIRE(BoltWriter_end(writer)==BOLT_SUCCESS);
+            REQUIRE(written(writer)=="\xA0");
+        }
+    }
+
+    SECTION("should reject calls that do not fit the structure") {
+        REQUIRE(BoltWriter_key(writer, "x", 1)==BOLT_PROTOCOL_VIOLATION);
+        REQUIRE(BoltWriter_end(writer)==BOLT_PROTOCOL_VIOLATION);
+        REQUIRE(BoltWriter_begin_map(writer, 1)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_integer(writer, 1)==BOLT_PROTOCOL_VIOLATION);
+        REQUIRE(BoltWriter_end(writer)==BOLT_PROTOCOL_VIOLATION);
+        REQUIRE(BoltWriter_key(writer, "x", 1)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_key(writer, "y", 1)==BOLT_PROTOCOL_VIOLATION);
+        BoltValue_format_as_Structure(expected, 'N', 0);
+        REQUIRE(BoltWriter_value(writer, expected)==BOLT_PROTOCOL_VIOLATION);
+        REQUIRE(BoltWriter_integer(writer, 1)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_integer(writer, 2)==BOLT_PROTOCOL_VIOLATION);
+        REQUIRE(BoltWriter_end(writer)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_null(writer)==BOLT_PROTOCOL_VIOLATION);
+        REQUIRE(written(writer)=="\xA1\x81x\x01");
+    }
+
+    SECTION("should refuse values that would grow the encoding past INT_MAX") {
+        REQUIRE(BoltWriter_begin_list(writer, 1)==BOLT_SUCCESS);
+        // pretend the buffer is full, so that nothing more can be loaded
+        writer->buffer->extent = INT_MAX;
+        REQUIRE(BoltWriter_string(writer, "abc", 3)==BOLT_OUT_OF_MEMORY);
+        REQUIRE(BoltWriter_integer(writer, 1)==BOLT_OUT_OF_MEMORY);
+        REQUIRE(writer->buffer->extent==INT_MAX);
+        writer->buffer->extent = 1;
+        REQUIRE(BoltWriter_integer(writer, 1)==BOLT_SUCCESS);
+        REQUIRE(BoltWriter_end(writer)==BOLT_SUCCESS);
+        REQUIRE(written(writer)=="\x91\x01");
+    }
+
+    SECTION("should replace a message field") {
+        struct BoltMessage* message = BoltMessage_create(0x10, 2);
+        BoltValue_format_as_String(BoltMessage_param(message, 0), "RETURN $x", 9);
+        BoltValue_format_as_Dictionary(BoltMessage_param(message, 1), 1);
+        BoltDictionary_set_key(BoltMessage_param(message, 1), 0, "x", 1);
+        BoltValue_format_as_Integer(BoltDictionary_value(BoltMessage_param(message, 1), 0), 1);
+
+        BoltBuffer* buffer = BoltBuffer_create(256);
+        REQUIRE(write_message(message, &writable, buffer, NULL, NULL)==BOLT_SUCCESS);
+        std::string from_tree(buffer->data, (size_t) buffer->extent);
+
+        struct BoltRunEncoding encoding = {NULL, writer, 1, NULL, 0};
+        BoltValue_format_as_Dictionary(BoltMessage_param(message, 1), 0);
+        REQUIRE(BoltRunEncoding_apply(&encoding, message)==BOLT_PROTOCOL_VIOLATION);
+        BoltWriter_begin_map(writer, 1);
+        BoltWriter_key(writer, "x", 1);
+        BoltWriter_integer(writer, 1);
+        BoltWriter_end(writer);
+        REQUIRE(BoltRunEncoding_apply(&encoding, message)==BOLT_SUCCESS);
+
+        buffer->cursor = 0;
+        buffer->extent = 0;
+        REQUIRE(write_message(message, &writable, buffer, NULL, NULL)==BOLT_SUCCESS);
+        REQUIRE(std::string(buffer->data, (size_t) buffer->extent)==from_tree);
+
+        BoltRunEncoding_clear(&encoding);
+        REQUIRE(BoltRunEncoding_apply(&encoding, message)==BOLT_SUCCESS);
+        buffer->cursor = 0;
+        buffer->extent = 0;
+        REQUIRE(write_message(message, &writable, buffer, NULL, NULL)==BOLT_SUCCESS);
+        REQUIRE(std::string(buffer->data, (size_t) buffer->extent)==std::string("\xB2\x10\x89RETURN $x\xA0", 13));
+
+        BoltBuffer_destroy(buffer);
+        BoltMessage_destroy(message);
+    }
+
+    SECTION("should hand over large encoded fields in pieces") {
+        std::string text(100000, 't');
+        BoltWriter_begin_map(writer, 1);
+        BoltWriter_key(writer, "text", 4);
+        BoltWriter_string(writer, text.data(), (int32_t) text.size());
+        BoltWriter_end(writer);
+        struct BoltMessage* message = BoltMessage_create(0x10, 2);
+        BoltValue_format_as_String(BoltMessage_param(message, 0), "RETURN $text", 12);
+        BoltMessage_set_encoded_param(message, 1, BoltWriter_data(writer), BoltWriter_size(writer));
+
+        FlushedData data = {"", 0};
+        PackStreamSink sink = {&flush, &data, 1000};
+        BoltBuffer* buffer = BoltBuffer_create(1024);
+        REQUIRE(write_message(message, &writable, buffer, &sink, NULL)==BOLT_SUCCESS);
+        data.flushed.append(BoltBuffer_unload_pointer(buffer, BoltBuffer_unloadable(buffer)),
+                (size_t) BoltBuffer_unloadable(buffer));
+        REQUIRE(data.max_buffered<2000);
+        REQUIRE(data.flushed==std::string("\xB2\x10\x8CRETURN $text", 15)+written(writer));
+
+        BoltBuffer_destroy(buffer);
+        BoltMessage_destroy(message);
+    }
+
+    SECTION("should decode encoded fields for logging") {
+        struct BoltMessage* message = BoltMessage_create(0x10, 2);
+        BoltValue_format_as_String(BoltMessage_param(message, 0), "RETURN $x", 9);
+        BoltValue_format_as_Dictionary(BoltMessage_param(message, 1), 0);
+        REQUIRE(BoltMessage_decode_fields(message, &writable, NULL)==nullptr);
+
+        BoltWriter_begin_map(writer, 1);
+        BoltWriter_key(writer, "x", 1);
+        BoltWriter_integer(writer, 42);
+        BoltWriter_end(writer);
+        BoltMessage_set_encoded_param(message, 1, BoltWriter_data(writer), BoltWriter_size(writer));
+        BoltValue* decoded = BoltMessage_decode_fields(message, &writable, NULL);
+        REQUIRE(decoded!=nullptr);
+        BoltValue* parameters = BoltList_value(decoded, 1);
+        REQUIRE(BoltValue_type(parameters)==BOLT_DICTIONARY);
+        REQUIRE(parameters->size==1);
+        REQUIRE(BoltInteger_get(BoltDictionary_value(parameters, 0))==42);
+
+        BoltValue_destroy(decoded);
+        BoltMessage_destroy(message);
+    }
+
+    BoltValue_destroy(expected);
+    BoltWriter_destroy(writer);
+}